@@ -46,7 +46,7 @@ mips_reloc_simple_type (Ebl *ebl, int type,
 			   int *addsub __attribute__ ((unused)))
 {
   int typeNew = type;
-  if(ebl->elf->class == ELFCLASS64)
+  if(ebl->class == ELFCLASS64)
     typeNew = ELF64_MIPS_R_TYPE1(type);
   switch (typeNew)
     {
@@ -69,7 +69,10 @@ ppc64_init (Elf *elf __attribute__ ((unused)),
   HOOK (eh, unwind);
   HOOK (eh, resolve_sym_value);
 
-  /* Find the function descriptor .opd table for resolve_sym_value.  */
+  /* Find the function descriptor .opd table for resolve_sym_value.
+     A handle opened without a file must not be cached either, or a
+     later handle for a file would be copied from it without .opd.  */
+  eh->per_elf = true;
   if (elf != NULL)
     {
       GElf_Ehdr ehdr_mem, *ehdr = gelf_getehdr (elf, &ehdr_mem);
@@ -60,6 +60,7 @@ riscv_init (Elf *elf,
   HOOK (eh, register_info);
   HOOK (eh, abi_cfi);
   HOOK (eh, disasm);
+  HOOK (eh, disasm_decode);
   /* gcc/config/ #define DWARF_FRAME_REGISTERS.  */
   eh->frame_nregs = 66;
   HOOK (eh, check_special_symbol);
@@ -75,6 +76,8 @@ riscv_init (Elf *elf,
     HOOK (eh, core_note);
   if (eh->class == ELFCLASS64)
     {
+      /* The float ABI comes from the file.  */
+      eh->per_elf = true;
       if ((elf->state.elf64.ehdr->e_flags & EF_RISCV_FLOAT_ABI)
           == EF_RISCV_FLOAT_ABI_DOUBLE)
         eh->return_value_location = riscv_return_value_location_lp64d;
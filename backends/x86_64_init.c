@@ -58,6 +58,7 @@ x86_64_init (Elf *elf __attribute__ ((unused)),
   HOOK (eh, register_info);
   HOOK (eh, auxv_info);
   HOOK (eh, disasm);
+  HOOK (eh, disasm_decode);
   HOOK (eh, abi_cfi);
   /* gcc/config/ #define DWARF_FRAME_REGISTERS.  */
   eh->frame_nregs = 17;
@@ -80,6 +80,7 @@ extern "C" {
 #include <netdb.h>
 #include <math.h>
 #include <float.h>
+#include <limits.h>
 #include <fnmatch.h>
 
 
@@ -479,6 +480,14 @@ static const struct argp_option options[] =
 #define ARGP_KEY_METADATA_MAXTIME 0x100C
    { "metadata-maxtime", ARGP_KEY_METADATA_MAXTIME, "SECONDS", 0,
      "Number of seconds to limit metadata query run time, 0=unlimited.", 0 },
+#define ARGP_KEY_EXPORT_INDEX 0x100D
+   { "export-index", ARGP_KEY_EXPORT_INDEX, "FILE", 0,
+     "Write a snapshot of the index relative to the PATHs to FILE, then exit.", 0 },
+#define ARGP_KEY_IMPORT_INDEX 0x100E
+   { "import-index", ARGP_KEY_IMPORT_INDEX, "FILE", 0,
+     "Import the unchanged files of an index snapshot before scanning.", 0 },
+#define ARGP_KEY_SHARDS 0x100F
+   { "shards", ARGP_KEY_SHARDS, "NUM", 0, "Split the index over NUM database files, default 1.", 0 },
    { NULL, 0, NULL, 0, NULL, 0 },
   };
 
@@ -501,8 +510,10 @@ static struct argp argp =
 
 
 static string db_path;
-static sqlite3 *db;  // single connection, serialized across all our threads!
-static sqlite3 *dbq; // webapi query-servicing readonly connection, serialized ditto!
+static sqlite3 *db;  // first shard connection, serialized across all our threads!
+static sqlite3 *dbq; // webapi query-servicing readonly connection, all shards attached, serialized ditto!
+static unsigned db_shards = 1;
+static vector<sqlite3*> shard_dbs; // one read-write connection per shard, [0] is db
 static unsigned verbose;
 static volatile sig_atomic_t interrupted = 0;
 static volatile sig_atomic_t forced_rescan_count = 0;
@@ -518,6 +529,8 @@ static int connection_pool = 0;
 static set<string> source_paths;
 static bool scan_files = false;
 static map<string,string> scan_archives;
+// The decoder for -U archives.  It is not run, see archive_reader.
+static const string deb_archive_decoder = "(bsdtar -O -x -f - data.tar\\*)<";
 static vector<string> extra_ddl;
 static regex_t file_include_regex;
 static regex_t file_exclude_regex;
@@ -535,6 +548,8 @@ static long scan_checkpoint = 256;
 static bool requires_koji_sigcache_mapping = false;
 #endif
 static unsigned metadata_maxtime_s = 5;
+static string export_index_path;
+static string import_index_path;
 
 static void set_metric(const string& key, double value);
 static void inc_metric(const string& key);
@@ -619,9 +634,9 @@ parse_opt (int key, char *arg,
       scan_archives[".rpm"]="cat"; // libarchive groks rpm natively
       break;
     case 'U':
-      scan_archives[".deb"]="(bsdtar -O -x -f - data.tar\\*)<";
-      scan_archives[".ddeb"]="(bsdtar -O -x -f - data.tar\\*)<";
-      scan_archives[".ipk"]="(bsdtar -O -x -f - data.tar\\*)<";
+      scan_archives[".deb"]=deb_archive_decoder;
+      scan_archives[".ddeb"]=deb_archive_decoder;
+      scan_archives[".ipk"]=deb_archive_decoder;
       // .udeb too?
       break;
     case 'Z':
@@ -727,7 +742,8 @@ parse_opt (int key, char *arg,
       if (source_paths.size() > 0
           || maxigroom
           || extra_ddl.size() > 0
-          || traverse_logical)
+          || traverse_logical
+          || import_index_path != "")
         // other conflicting options tricky to check
         argp_failure(state, 1, EINVAL, "inconsistent options with passive mode");
       break;
@@ -742,6 +758,24 @@ parse_opt (int key, char *arg,
     case ARGP_KEY_METADATA_MAXTIME:
       metadata_maxtime_s = (unsigned) atoi(arg);
       break;
+    case ARGP_KEY_EXPORT_INDEX:
+      export_index_path = string(arg);
+      break;
+    case ARGP_KEY_IMPORT_INDEX:
+      if (passive_p)
+        argp_failure(state, 1, EINVAL, "--import-index option inconsistent with passive mode");
+      import_index_path = string(arg);
+      break;
+    case ARGP_KEY_SHARDS:
+      {
+        char *end;
+        errno = 0;
+        unsigned long n = strtoul (arg, &end, 10);
+        if (errno != 0 || end == arg || *end != '\0' || n < 1 || n > UINT_MAX)
+          argp_failure(state, 1, EINVAL, "shards");
+        db_shards = (unsigned) n;
+      }
+      break;
 #ifdef ENABLE_IMA_VERIFICATION
     case ARGP_KEY_KOJI_SIGCACHE:
       requires_koji_sigcache_mapping = true;
@@ -1213,13 +1247,75 @@ struct sqlite_checkpoint_pb: public periodic_barrier
   
   void periodic_barrier_work() noexcept
   {
-    (void) sqlite3_exec (db, "pragma wal_checkpoint(truncate);", NULL, NULL, NULL);
+    for (auto&& shard_db : shard_dbs)
+      (void) sqlite3_exec (shard_db, "pragma wal_checkpoint(truncate);", NULL, NULL, NULL);
   }
 };
   
 static periodic_barrier* scan_barrier = 0; // initialized in main()
 
 
+////////////////////////////////////////////////////////////////////////
+
+// With --shards=N, the index is split over N database files.  All that
+// the scan of one file or archive records goes into the shard its name
+// hashes to, so each shard is consistent on its own, and scanner threads
+// working on different shards don't wait for each other's write locks.
+// The other shards are attached to the webapi connection dbq, where
+// queries go over all of them.
+
+static string
+shard_path (unsigned shard)
+{
+  if (shard == 0)
+    return db_path;
+  if (db_path == "file::memory:?cache=shared")
+    return "file:debuginfod-shard" + to_string(shard) + "?mode=memory&cache=shared";
+  return db_path + ".shard" + to_string(shard);
+}
+
+
+// The schema name of the shard on dbq.
+static string
+shard_schema (unsigned shard)
+{
+  return shard == 0 ? "main" : "shard" + to_string(shard);
+}
+
+
+// FNV-1a, which unlike std::hash is the same for every build, so that
+// files stay in their shard across restarts.
+static unsigned
+shard_of (const string& name)
+{
+  uint32_t h = 2166136261U;
+  for (unsigned char c: name)
+    h = (h ^ c) * 16777619U;
+  return h % db_shards;
+}
+
+
+// Glue together the select statements SHARD_SQL makes for each shard,
+// given its number and the prefix for its tables on dbq.  Parameters
+// must be numbered, as in ?1, to be shared by all of them.
+template <typename ShardSql>
+static string
+shards_union_all (ShardSql shard_sql)
+{
+  if (db_shards == 1)
+    return shard_sql (0, "");
+
+  string sql;
+  for (unsigned i = 0; i < db_shards; i++)
+    {
+      if (i > 0)
+        sql += "\nunion all\n";
+      sql += shard_sql (i, shard_schema(i) + ".");
+    }
+  return sql;
+}
+
+
 ////////////////////////////////////////////////////////////////////////
 
 // RAII style templated autocloser
@@ -1361,6 +1457,138 @@ shell_escape(const string& str)
 }
 
 
+// A libarchive reader for the archive file at PATH, as the scan_archives
+// DECODER for its extension says.  "cat" reads the file as is, the
+// deb_archive_decoder reads the data.tar* member of the ar (or tar) file
+// with a second, nested reader, and anything else is a shell command
+// whose output is read.  The archive_open_total metric counts each way.
+class archive_reader
+{
+  FILE* fp;
+  int (*fp_close) (FILE*);
+  struct archive* outer;
+  struct archive* a;
+
+  static struct archive* new_reader ()
+  {
+    struct archive* a = archive_read_new();
+    if (a == NULL)
+      throw archive_exception("cannot create archive reader");
+    if (archive_read_support_format_all(a) != ARCHIVE_OK)
+      {
+        archive_exception e (a, "cannot select all formats");
+        archive_read_free (a);
+        throw e;
+      }
+    if (archive_read_support_filter_all(a) != ARCHIVE_OK)
+      {
+        archive_exception e (a, "cannot select all filters");
+        archive_read_free (a);
+        throw e;
+      }
+    return a;
+  }
+
+  // Hand out the blocks of the current entry of the outer archive as
+  // they are, without copying them.
+  static la_ssize_t read_member (struct archive* inner, void* data,
+                                 const void** buf)
+  {
+    struct archive* outer = (struct archive*) data;
+    size_t size;
+    la_int64_t offset;
+    int rc = archive_read_data_block (outer, buf, &size, &offset);
+    if (rc == ARCHIVE_EOF)
+      return 0;
+    if (rc != ARCHIVE_OK)
+      {
+        archive_set_error (inner, archive_errno (outer) ?: EIO, "%s",
+                           archive_error_string (outer) ?: "?");
+        return -1;
+      }
+    return size;
+  }
+
+  void close_all ()
+  {
+    if (a != NULL)
+      archive_read_free (a);
+    if (outer != NULL)
+      archive_read_free (outer);
+    if (fp != NULL)
+      fp_close (fp);
+  }
+
+public:
+  archive_reader (const string& path, const string& decoder):
+    fp(NULL), fp_close(fclose), outer(NULL), a(NULL)
+  {
+    try
+      {
+        if (decoder == "cat" || decoder == deb_archive_decoder)
+          {
+            fp = fopen (path.c_str(), "r");
+            if (fp == NULL)
+              throw libc_exception (errno, string("fopen ") + path);
+            inc_metric ("archive_open_total", "decoder",
+                        decoder == "cat" ? "file" : "data.tar member");
+          }
+        else
+          {
+            string popen_cmd = decoder + " " + shell_escape(path);
+            fp = popen (popen_cmd.c_str(), "r"); // "e" O_CLOEXEC?
+            if (fp == NULL)
+              throw libc_exception (errno, string("popen ") + popen_cmd);
+            fp_close = pclose;
+            inc_metric ("archive_open_total", "decoder", "pipe");
+          }
+
+        if (decoder != deb_archive_decoder)
+          {
+            a = new_reader ();
+            if (archive_read_open_FILE (a, fp) != ARCHIVE_OK)
+              {
+                obatched(clog) << "cannot open archive from pipe " << path << endl;
+                throw archive_exception(a, "cannot open archive from pipe");
+              }
+            return;
+          }
+
+        outer = new_reader ();
+        if (archive_read_open_FILE (outer, fp) != ARCHIVE_OK)
+          throw archive_exception(outer, "cannot open archive");
+        struct archive_entry *e;
+        int rc;
+        while ((rc = archive_read_next_header (outer, &e)) == ARCHIVE_OK)
+          {
+            const char* fn = archive_entry_pathname (e);
+            if (fn != NULL && startswith (fn, "./"))
+              fn += 2;
+            if (fn != NULL && fnmatch ("data.tar*", fn, 0) == 0)
+              break;
+          }
+        if (rc == ARCHIVE_EOF)
+          throw archive_exception("no data.tar member in " + path);
+        if (rc != ARCHIVE_OK)
+          throw archive_exception(outer, "cannot read archive header");
+
+        a = new_reader ();
+        if (archive_read_open (a, outer, NULL, read_member, NULL) != ARCHIVE_OK)
+          throw archive_exception(a, "cannot open data.tar member");
+      }
+    catch (...)
+      {
+        close_all ();
+        throw;
+      }
+  }
+
+  ~archive_reader () { close_all (); }
+
+  struct archive* get () { return a; }
+};
+
+
 // PR25548: Perform POSIX / RFC3986 style path canonicalization on the input string.
 //
 // Namely:
@@ -2553,6 +2781,7 @@ handle_buildid_r_match (bool internal_req_p,
                         const string& b_source1,
                         int64_t b_id0,
                         int64_t b_id1,
+                        unsigned b_shard,
                         const string& section,
                         int *result_fd)
 {
@@ -2741,9 +2970,11 @@ handle_buildid_r_match (bool internal_req_p,
 
   // no match ... look for a seekable entry
   bool populate_seekable = ! passive_p;
-  unique_ptr<sqlite_ps> pp (new sqlite_ps (internal_req_p ? db : dbq,
+  // NB: the ids are those of the shard the query found them in.
+  string shard_prefix = (db_shards == 1) ? "" : shard_schema(b_shard) + ".";
+  unique_ptr<sqlite_ps> pp (new sqlite_ps ((internal_req_p && db_shards == 1) ? db : dbq,
                                            "rpm-seekable-query",
-                                           "select type, size, offset, mtime from " BUILDIDS "_r_seekable "
+                                           "select type, size, offset, mtime from " + shard_prefix + BUILDIDS "_r_seekable "
                                            "where file = ? and content = ?"));
   rc = pp->reset().bind(1, b_id0).bind(2, b_id1).step();
   if (rc != SQLITE_DONE)
@@ -2804,45 +3035,8 @@ handle_buildid_r_match (bool internal_req_p,
         archive_extension = arch.first;
         archive_decoder = arch.second;
       }
-  FILE* fp;
-  
-  defer_dtor<FILE*,int>::dtor_fn dfn;
-  if (archive_decoder != "cat")
-    {
-      string popen_cmd = archive_decoder + " " + shell_escape(b_source0);
-      fp = popen (popen_cmd.c_str(), "r"); // "e" O_CLOEXEC?
-      dfn = pclose;
-      if (fp == NULL)
-        throw libc_exception (errno, string("popen ") + popen_cmd);
-    }
-  else
-    {
-      fp = fopen (b_source0.c_str(), "r");
-      dfn = fclose;
-      if (fp == NULL)
-        throw libc_exception (errno, string("fopen ") + b_source0);
-    }
-  defer_dtor<FILE*,int> fp_closer (fp, dfn);
-
-  struct archive *a;
-  a = archive_read_new();
-  if (a == NULL)
-    throw archive_exception("cannot create archive reader");
-  defer_dtor<struct archive*,int> archive_closer (a, archive_read_free);
-
-  rc = archive_read_support_format_all(a);
-  if (rc != ARCHIVE_OK)
-    throw archive_exception(a, "cannot select all format");
-  rc = archive_read_support_filter_all(a);
-  if (rc != ARCHIVE_OK)
-    throw archive_exception(a, "cannot select all filters");
-
-  rc = archive_read_open_FILE (a, fp);
-  if (rc != ARCHIVE_OK)
-    {
-      obatched(clog) << "cannot open archive from pipe " << b_source0 << endl;
-      throw archive_exception(a, "cannot open archive from pipe");
-    }
+  archive_reader reader (b_source0, archive_decoder);
+  struct archive *a = reader.get();
 
   // If the archive was scanned in a version without _r_seekable, then we may
   // need to populate _r_seekable now.  This can be removed the next time
@@ -2853,7 +3047,7 @@ handle_buildid_r_match (bool internal_req_p,
       if (populate_seekable)
         {
           // NB: the names are already interned
-          pp.reset(new sqlite_ps (db, "rpm-seekable-insert2",
+          pp.reset(new sqlite_ps (shard_dbs[b_shard], "rpm-seekable-insert2",
                                   "insert or ignore into " BUILDIDS "_r_seekable (file, content, type, size, offset, mtime) "
                                   "values (?, "
                                   "(select id from " BUILDIDS "_files "
@@ -3056,6 +3250,7 @@ handle_buildid_match (bool internal_req_p,
                       const string& b_source1,
                       int64_t b_id0,
                       int64_t b_id1,
+                      unsigned b_shard,
                       const string& section,
                       int *result_fd)
 {
@@ -3066,7 +3261,7 @@ handle_buildid_match (bool internal_req_p,
 				      section, result_fd);
       else if (b_stype == "R")
         return handle_buildid_r_match(internal_req_p, b_mtime, b_source0,
-				      b_source1, b_id0, b_id1, section,
+				      b_source1, b_id0, b_id1, b_shard, section,
 				      result_fd);
     }
   catch (const reportable_exception &e)
@@ -3176,23 +3371,20 @@ handle_buildid (MHD_Connection* conn,
 
   // If invoked from the scanner threads, use the scanners' read-write
   // connection.  Otherwise use the web query threads' read-only connection.
-  sqlite3 *thisdb = (conn == 0) ? db : dbq;
+  // Only the latter has all the shards attached.
+  sqlite3 *thisdb = (conn == 0 && db_shards == 1) ? db : dbq;
 
   sqlite_ps *pp = 0;
 
-  if (atype_code == "D")
-    {
-      pp = new sqlite_ps (thisdb, "mhd-query-d",
-                          "select mtime, sourcetype, source0, source1, id0, id1 from " BUILDIDS "_query_d2 where buildid = ? "
-                          "order by mtime desc");
-      pp->reset();
-      pp->bind(1, buildid);
-    }
-  else if (atype_code == "E")
+  if (atype_code == "D" || atype_code == "E")
     {
-      pp = new sqlite_ps (thisdb, "mhd-query-e",
-                          "select mtime, sourcetype, source0, source1, id0, id1 from " BUILDIDS "_query_e2 where buildid = ? "
-                          "order by mtime desc");
+      string view = (atype_code == "D") ? BUILDIDS "_query_d2" : BUILDIDS "_query_e2";
+      pp = new sqlite_ps (thisdb, atype_code == "D" ? "mhd-query-d" : "mhd-query-e",
+                          shards_union_all ([&](unsigned shard, const string& p) {
+                              return "select mtime, sourcetype, source0, source1, id0, id1, "
+                                + to_string(shard) + " as shard from " + p + view + " where buildid = ?1";
+                            })
+                          + " order by mtime desc");
       pp->reset();
       pp->bind(1, buildid);
     }
@@ -3202,9 +3394,52 @@ handle_buildid (MHD_Connection* conn,
       // Incoming source queries may come in with either dwarf-level OR canonicalized paths.
       // We let the query pass with either one.
 
-      pp = new sqlite_ps (thisdb, "mhd-query-s",
-                          "select mtime, sourcetype, source0, source1 from " BUILDIDS "_query_s where buildid = ? and artifactsrc in (?,?) "
-                          "order by sharedprefix(source0,source0ref) desc, mtime desc");
+      if (db_shards == 1)
+        pp = new sqlite_ps (thisdb, "mhd-query-s",
+                            "select mtime, sourcetype, source0, source1 from " BUILDIDS "_query_s where buildid = ?1 and artifactsrc in (?2,?3) "
+                            "order by sharedprefix(source0,source0ref) desc, mtime desc");
+      else
+        {
+          // The _r_sref, _r_sdef and _r_de rows that _query_s joins
+          // come from different archives, so may be in different shards.
+          // Join them by name instead of id, over all the shards.
+          string sql =
+            "select mtime, sourcetype, source0, source1 from (\n"
+            + shards_union_all ([](unsigned, const string& p) {
+                return "select n.mtime as mtime, 'F' as sourcetype, f0.name as source0, "
+                  "null as source1, null as source0ref\n"
+                  "from " + p + BUILDIDS "_buildids b, " + p + BUILDIDS "_files_v f0, "
+                  + p + BUILDIDS "_files_v fs, " + p + BUILDIDS "_f_s n\n"
+                  "where b.hex = ?1 and b.id = n.buildid and f0.id = n.file and fs.id = n.artifactsrc "
+                  "and fs.name in (?2,?3)";
+              })
+            + "\nunion all\n"
+            "select sd.mtime, 'R', sd.source0, sd.source1, sde.source0ref from (\n"
+            + shards_union_all ([](unsigned, const string& p) {
+                return "select f0.name as source0, sd.mtime as mtime, f1.name as source1\n"
+                  "from " + p + BUILDIDS "_r_sdef sd, " + p + BUILDIDS "_files_v f0, "
+                  + p + BUILDIDS "_files_v f1\n"
+                  "where f0.id = sd.file and f1.id = sd.content and f1.name in (?2,?3)";
+              })
+            + ") sd, (\n"
+            + shards_union_all ([](unsigned, const string& p) {
+                return "select f.name as name\n"
+                  "from " + p + BUILDIDS "_buildids b, " + p + BUILDIDS "_r_sref sr, "
+                  + p + BUILDIDS "_files_v f\n"
+                  "where b.hex = ?1 and b.id = sr.buildid and f.id = sr.artifactsrc";
+              })
+            + ") sr, (\n"
+            + shards_union_all ([](unsigned, const string& p) {
+                return "select f.name as source0ref\n"
+                  "from " + p + BUILDIDS "_buildids b, " + p + BUILDIDS "_r_de sde, "
+                  + p + BUILDIDS "_files_v f\n"
+                  "where b.hex = ?1 and b.id = sde.buildid and f.id = sde.file";
+              })
+            + ") sde\n"
+            "where sd.source1 = sr.name)\n"
+            "order by sharedprefix(source0,source0ref) desc, mtime desc";
+          pp = new sqlite_ps (thisdb, "mhd-query-s", sql);
+        }
       pp->reset();
       pp->bind(1, buildid);
       // NB: we don't store the non-canonicalized path names any more, but old databases
@@ -3215,13 +3450,16 @@ handle_buildid (MHD_Connection* conn,
   else if (atype_code == "I")
     {
       pp = new sqlite_ps (thisdb, "mhd-query-i",
-	"select mtime, sourcetype, source0, source1, 1 as debug_p from " BUILDIDS "_query_d2 where buildid = ? "
-	"union all "
-	"select mtime, sourcetype, source0, source1, 0 as debug_p from " BUILDIDS "_query_e2 where buildid = ? "
-	"order by debug_p desc, mtime desc");
+                          shards_union_all ([](unsigned shard, const string& p) {
+                              return "select mtime, sourcetype, source0, source1, 1 as debug_p, "
+                                + to_string(shard) + " as shard from " + p + BUILDIDS "_query_d2 where buildid = ?1 "
+                                "union all "
+                                "select mtime, sourcetype, source0, source1, 0 as debug_p, "
+                                + to_string(shard) + " as shard from " + p + BUILDIDS "_query_e2 where buildid = ?1";
+                            })
+                          + " order by debug_p desc, mtime desc");
       pp->reset();
       pp->bind(1, buildid);
-      pp->bind(2, buildid);
     }
   unique_ptr<sqlite_ps> ps_closer(pp); // release pp if exception or return
 
@@ -3240,10 +3478,12 @@ handle_buildid (MHD_Connection* conn,
       string b_source0 = string((const char*) sqlite3_column_text (*pp, 2) ?: ""); /* may be NULL */
       string b_source1 = string((const char*) sqlite3_column_text (*pp, 3) ?: ""); /* may be NULL */
       int64_t b_id0 = 0, b_id1 = 0;
+      unsigned b_shard = 0;
       if (atype_code == "D" || atype_code == "E")
         {
           b_id0 = sqlite3_column_int64 (*pp, 4);
           b_id1 = sqlite3_column_int64 (*pp, 5);
+          b_shard = sqlite3_column_int (*pp, 6);
         }
 
       if (verbose > 1)
@@ -3254,7 +3494,7 @@ handle_buildid (MHD_Connection* conn,
       // XXX: in case of multiple matches, attempt them in parallel?
       auto r = handle_buildid_match (conn ? false : true,
                                      b_mtime, b_stype, b_source0, b_source1,
-				     b_id0, b_id1, section, result_fd);
+				     b_id0, b_id1, b_shard, section, result_fd);
       if (r)
         return r;
 
@@ -3541,23 +3781,27 @@ handle_metadata (MHD_Connection* conn,
   string dop = (op == "glob" && dirname.find_first_of(metacharacters) == string::npos) ? "=" : op;
   string bop = (op == "glob" && bname.find_first_of(metacharacters) == string::npos) ? "=" : op;
   
-  string sql = string(
+  string sql = shards_union_all ([&](unsigned, const string& p) {
+      return string(
                       // explicit query r_de and f_de once here, rather than the query_d and query_e
                       // separately, because they scan the same tables, so we'd double the work
                       "select d1.executable_p, d1.debuginfo_p, 0 as source_p, "
                       "       b1.hex, f1d.name || '/' || f1b.name as file, a1.name as archive "
-                      "from " BUILDIDS "_r_de d1, " BUILDIDS "_files f1, " BUILDIDS "_fileparts f1b, " BUILDIDS "_fileparts f1d, "
-                      BUILDIDS "_buildids b1, " BUILDIDS "_files_v a1 "
+                      "from ") + p + BUILDIDS "_r_de d1, " + p + BUILDIDS "_files f1, "
+                      + p + BUILDIDS "_fileparts f1b, " + p + BUILDIDS "_fileparts f1d, "
+                      + p + BUILDIDS "_buildids b1, " + p + BUILDIDS "_files_v a1 "
                       "where f1.id = d1.content and a1.id = d1.file and d1.buildid = b1.id "
-                      "      and f1d.name " + dop + " ? and f1b.name " + bop + " ? and f1.dirname = f1d.id and f1.basename = f1b.id "
+                      "      and f1d.name " + dop + " ?1 and f1b.name " + bop + " ?2 and f1.dirname = f1d.id and f1.basename = f1b.id "
                       "union all \n"
                       "select d2.executable_p, d2.debuginfo_p, 0, "
                       "       b2.hex, f2d.name || '/' || f2b.name, NULL "
-                      "from " BUILDIDS "_f_de d2, " BUILDIDS "_files f2, " BUILDIDS "_fileparts f2b, " BUILDIDS "_fileparts f2d, "
-                      BUILDIDS "_buildids b2 "
+                      "from " + p + BUILDIDS "_f_de d2, " + p + BUILDIDS "_files f2, "
+                      + p + BUILDIDS "_fileparts f2b, " + p + BUILDIDS "_fileparts f2d, "
+                      + p + BUILDIDS "_buildids b2 "
                       "where f2.id = d2.file and d2.buildid = b2.id "
-                      "      and f2d.name " + dop + " ? and f2b.name " + bop + " ? "
-                      "      and f2.dirname = f2d.id and f2.basename = f2b.id");
+                      "      and f2d.name " + dop + " ?1 and f2b.name " + bop + " ?2 "
+                      "      and f2.dirname = f2d.id and f2.basename = f2b.id";
+    });
   
   // NB: we could query source file names too, thusly:
   //
@@ -3576,8 +3820,6 @@ handle_metadata (MHD_Connection* conn,
   pp->reset();
   pp->bind(1, dirname);
   pp->bind(2, bname);
-  pp->bind(3, dirname);
-  pp->bind(4, bname);
   unique_ptr<sqlite_ps> ps_closer(pp); // release pp if exception or return
 
   json_object *metadata = json_object_new_object();
@@ -4467,44 +4709,9 @@ archive_classify (const string& rps, string& archive_extension, int64_t archivei
         archive_decoder = arch.second;
       }
 
-  FILE* fp;
-  defer_dtor<FILE*,int>::dtor_fn dfn;
-  if (archive_decoder != "cat")
-    {
-      string popen_cmd = archive_decoder + " " + shell_escape(rps);
-      fp = popen (popen_cmd.c_str(), "r"); // "e" O_CLOEXEC?
-      dfn = pclose;
-      if (fp == NULL)
-        throw libc_exception (errno, string("popen ") + popen_cmd);
-    }
-  else
-    {
-      fp = fopen (rps.c_str(), "r");
-      dfn = fclose;
-      if (fp == NULL)
-        throw libc_exception (errno, string("fopen ") + rps);
-    }
-  defer_dtor<FILE*,int> fp_closer (fp, dfn);
-
-  struct archive *a;
-  a = archive_read_new();
-  if (a == NULL)
-    throw archive_exception("cannot create archive reader");
-  defer_dtor<struct archive*,int> archive_closer (a, archive_read_free);
-
-  int rc = archive_read_support_format_all(a);
-  if (rc != ARCHIVE_OK)
-    throw archive_exception(a, "cannot select all formats");
-  rc = archive_read_support_filter_all(a);
-  if (rc != ARCHIVE_OK)
-    throw archive_exception(a, "cannot select all filters");
-
-  rc = archive_read_open_FILE (a, fp);
-  if (rc != ARCHIVE_OK)
-    {
-      obatched(clog) << "cannot open archive from pipe " << rps << endl;
-      throw archive_exception(a, "cannot open archive from pipe");
-    }
+  archive_reader reader (rps, archive_decoder);
+  struct archive *a = reader.get();
+  int rc;
 
   if (verbose > 3)
     obatched(clog) << "libarchive scanning " << rps << " id " << archiveid << endl;
@@ -4785,69 +4992,98 @@ scan_archive_file (const string& rps, const stat_t& st,
 
 
 
-// The thread that consumes file names off of the scanq.  We hold
-// the persistent sqlite_ps's at this level and delegate file/archive
-// scanning to other functions.
-static void
-scan ()
+// The prepared statements of a scanner thread for one shard.  We hold
+// them at this level and delegate file/archive scanning to other
+// functions.
+struct scan_statements
 {
   // all the prepared statements fit to use, the _f_ set:
-  sqlite_ps ps_f_upsert_buildids (db, "file-buildids-intern", "insert or ignore into " BUILDIDS "_buildids VALUES (NULL, ?);");
-  sqlite_ps ps_f_upsert_fileparts (db, "file-fileparts-intern", "insert or ignore into " BUILDIDS "_fileparts VALUES (NULL, ?);");
-  sqlite_ps ps_f_upsert_file (db, "file-file-intern", "insert or ignore into " BUILDIDS "_files VALUES (NULL, \n"
-                              "(select id from " BUILDIDS "_fileparts where name = ?),\n"
-                              "(select id from " BUILDIDS "_fileparts where name = ?));");
-  sqlite_ps ps_f_lookup_file (db, "file-file-lookup",
-                              "select f.id\n"
-                              " from " BUILDIDS "_files f, " BUILDIDS "_fileparts p1, " BUILDIDS "_fileparts p2 \n"
-                              " where f.dirname = p1.id and f.basename = p2.id and p1.name = ? and p2.name = ?;\n");
-  sqlite_ps ps_f_upsert_de (db, "file-de-upsert",
-                          "insert or ignore into " BUILDIDS "_f_de "
-                          "(buildid, debuginfo_p, executable_p, file, mtime) "
-                          "values ((select id from " BUILDIDS "_buildids where hex = ?),"
-                            "        ?,?,?,?);");
-  sqlite_ps ps_f_upsert_s (db, "file-s-upsert",
-                         "insert or ignore into " BUILDIDS "_f_s "
-                         "(buildid, artifactsrc, file, mtime) "
-                         "values ((select id from " BUILDIDS "_buildids where hex = ?),"
-                         "      ?,?,?);");
-  sqlite_ps ps_f_query (db, "file-negativehit-find",
-                        "select 1 from " BUILDIDS "_file_mtime_scanned where sourcetype = 'F' "
-                        "and file = ? and mtime = ?;");
-  sqlite_ps ps_f_scan_done (db, "file-scanned",
-                          "insert or ignore into " BUILDIDS "_file_mtime_scanned (sourcetype, file, mtime, size)"
-                          "values ('F', ?,?,?);");
+  sqlite_ps ps_f_upsert_buildids;
+  sqlite_ps ps_f_upsert_fileparts;
+  sqlite_ps ps_f_upsert_file;
+  sqlite_ps ps_f_lookup_file;
+  sqlite_ps ps_f_upsert_de;
+  sqlite_ps ps_f_upsert_s;
+  sqlite_ps ps_f_query;
+  sqlite_ps ps_f_scan_done;
 
   // and now for the _r_ set
-  sqlite_ps ps_r_upsert_buildids (db, "rpm-buildid-intern", "insert or ignore into " BUILDIDS "_buildids VALUES (NULL, ?);");
-  sqlite_ps ps_r_upsert_fileparts (db, "rpm-fileparts-intern", "insert or ignore into " BUILDIDS "_fileparts VALUES (NULL, ?);");
-  sqlite_ps ps_r_upsert_file (db, "rpm-file-intern", "insert or ignore into " BUILDIDS "_files VALUES (NULL, \n"
-                              "(select id from " BUILDIDS "_fileparts where name = ?),\n"
-                              "(select id from " BUILDIDS "_fileparts where name = ?));");
-  sqlite_ps ps_r_lookup_file (db, "rpm-file-lookup",
-                              "select f.id\n"
-                              " from " BUILDIDS "_files f, " BUILDIDS "_fileparts p1, " BUILDIDS "_fileparts p2 \n"
-                              " where f.dirname = p1.id and f.basename = p2.id and p1.name = ? and p2.name = ?;\n");
-  sqlite_ps ps_r_upsert_de (db, "rpm-de-insert",
-                          "insert or ignore into " BUILDIDS "_r_de (buildid, debuginfo_p, executable_p, file, mtime, content) values ("
-                          "(select id from " BUILDIDS "_buildids where hex = ?), ?, ?, ?, ?, ?);");
-  sqlite_ps ps_r_upsert_sref (db, "rpm-sref-insert",
-                            "insert or ignore into " BUILDIDS "_r_sref (buildid, artifactsrc) values ("
-                            "(select id from " BUILDIDS "_buildids where hex = ?), "
-                            "?);");
-  sqlite_ps ps_r_upsert_sdef (db, "rpm-sdef-insert",
-                            "insert or ignore into " BUILDIDS "_r_sdef (file, mtime, content) values ("
-                            "?, ?, ?);");
-  sqlite_ps ps_r_upsert_seekable (db, "rpm-seekable-insert",
-                                  "insert or ignore into " BUILDIDS "_r_seekable (file, content, type, size, offset, mtime) "
-                                  "values (?, ?, 'xz', ?, ?, ?);");
-  sqlite_ps ps_r_query (db, "rpm-negativehit-query",
-                      "select 1 from " BUILDIDS "_file_mtime_scanned where "
-                      "sourcetype = 'R' and file = ? and mtime = ?;");
-  sqlite_ps ps_r_scan_done (db, "rpm-scanned",
-                          "insert or ignore into " BUILDIDS "_file_mtime_scanned (sourcetype, file, mtime, size)"
-                          "values ('R', ?, ?, ?);");
-  
+  sqlite_ps ps_r_upsert_buildids;
+  sqlite_ps ps_r_upsert_fileparts;
+  sqlite_ps ps_r_upsert_file;
+  sqlite_ps ps_r_lookup_file;
+  sqlite_ps ps_r_upsert_de;
+  sqlite_ps ps_r_upsert_sref;
+  sqlite_ps ps_r_upsert_sdef;
+  sqlite_ps ps_r_upsert_seekable;
+  sqlite_ps ps_r_query;
+  sqlite_ps ps_r_scan_done;
+
+  scan_statements (sqlite3 *shard_db):
+    ps_f_upsert_buildids (shard_db, "file-buildids-intern", "insert or ignore into " BUILDIDS "_buildids VALUES (NULL, ?);"),
+    ps_f_upsert_fileparts (shard_db, "file-fileparts-intern", "insert or ignore into " BUILDIDS "_fileparts VALUES (NULL, ?);"),
+    ps_f_upsert_file (shard_db, "file-file-intern", "insert or ignore into " BUILDIDS "_files VALUES (NULL, \n"
+                      "(select id from " BUILDIDS "_fileparts where name = ?),\n"
+                      "(select id from " BUILDIDS "_fileparts where name = ?));"),
+    ps_f_lookup_file (shard_db, "file-file-lookup",
+                      "select f.id\n"
+                      " from " BUILDIDS "_files f, " BUILDIDS "_fileparts p1, " BUILDIDS "_fileparts p2 \n"
+                      " where f.dirname = p1.id and f.basename = p2.id and p1.name = ? and p2.name = ?;\n"),
+    ps_f_upsert_de (shard_db, "file-de-upsert",
+                    "insert or ignore into " BUILDIDS "_f_de "
+                    "(buildid, debuginfo_p, executable_p, file, mtime) "
+                    "values ((select id from " BUILDIDS "_buildids where hex = ?),"
+                    "        ?,?,?,?);"),
+    ps_f_upsert_s (shard_db, "file-s-upsert",
+                   "insert or ignore into " BUILDIDS "_f_s "
+                   "(buildid, artifactsrc, file, mtime) "
+                   "values ((select id from " BUILDIDS "_buildids where hex = ?),"
+                   "      ?,?,?);"),
+    ps_f_query (shard_db, "file-negativehit-find",
+                "select 1 from " BUILDIDS "_file_mtime_scanned where sourcetype = 'F' "
+                "and file = ? and mtime = ?;"),
+    ps_f_scan_done (shard_db, "file-scanned",
+                    "insert or ignore into " BUILDIDS "_file_mtime_scanned (sourcetype, file, mtime, size)"
+                    "values ('F', ?,?,?);"),
+    ps_r_upsert_buildids (shard_db, "rpm-buildid-intern", "insert or ignore into " BUILDIDS "_buildids VALUES (NULL, ?);"),
+    ps_r_upsert_fileparts (shard_db, "rpm-fileparts-intern", "insert or ignore into " BUILDIDS "_fileparts VALUES (NULL, ?);"),
+    ps_r_upsert_file (shard_db, "rpm-file-intern", "insert or ignore into " BUILDIDS "_files VALUES (NULL, \n"
+                      "(select id from " BUILDIDS "_fileparts where name = ?),\n"
+                      "(select id from " BUILDIDS "_fileparts where name = ?));"),
+    ps_r_lookup_file (shard_db, "rpm-file-lookup",
+                      "select f.id\n"
+                      " from " BUILDIDS "_files f, " BUILDIDS "_fileparts p1, " BUILDIDS "_fileparts p2 \n"
+                      " where f.dirname = p1.id and f.basename = p2.id and p1.name = ? and p2.name = ?;\n"),
+    ps_r_upsert_de (shard_db, "rpm-de-insert",
+                    "insert or ignore into " BUILDIDS "_r_de (buildid, debuginfo_p, executable_p, file, mtime, content) values ("
+                    "(select id from " BUILDIDS "_buildids where hex = ?), ?, ?, ?, ?, ?);"),
+    ps_r_upsert_sref (shard_db, "rpm-sref-insert",
+                      "insert or ignore into " BUILDIDS "_r_sref (buildid, artifactsrc) values ("
+                      "(select id from " BUILDIDS "_buildids where hex = ?), "
+                      "?);"),
+    ps_r_upsert_sdef (shard_db, "rpm-sdef-insert",
+                      "insert or ignore into " BUILDIDS "_r_sdef (file, mtime, content) values ("
+                      "?, ?, ?);"),
+    ps_r_upsert_seekable (shard_db, "rpm-seekable-insert",
+                          "insert or ignore into " BUILDIDS "_r_seekable (file, content, type, size, offset, mtime) "
+                          "values (?, ?, 'xz', ?, ?, ?);"),
+    ps_r_query (shard_db, "rpm-negativehit-query",
+                "select 1 from " BUILDIDS "_file_mtime_scanned where "
+                "sourcetype = 'R' and file = ? and mtime = ?;"),
+    ps_r_scan_done (shard_db, "rpm-scanned",
+                    "insert or ignore into " BUILDIDS "_file_mtime_scanned (sourcetype, file, mtime, size)"
+                    "values ('R', ?, ?, ?);")
+  {}
+};
+
+
+// The thread that consumes file names off of the scanq.
+static void
+scan ()
+{
+  vector<unique_ptr<scan_statements>> shards;
+  for (auto&& shard_db : shard_dbs)
+    shards.emplace_back (new scan_statements (shard_db));
 
   unsigned fts_cached = 0, fts_executable = 0, fts_debuginfo = 0, fts_sourcefiles = 0;
   unsigned fts_sref = 0, fts_sdef = 0;
@@ -4869,6 +5105,7 @@ scan ()
 
       try
         {
+          scan_statements& ps = *shards[shard_of (p.first)];
           bool scan_archive = false;
           for (auto&& arch : scan_archives)
             if (string_endswith(p.first, arch.first))
@@ -4876,16 +5113,16 @@ scan ()
 
           if (scan_archive)
             scan_archive_file (p.first, p.second,
-                               ps_r_upsert_buildids,
-                               ps_r_upsert_fileparts,
-                               ps_r_upsert_file,
-                               ps_r_lookup_file,
-                               ps_r_upsert_de,
-                               ps_r_upsert_sref,
-                               ps_r_upsert_sdef,
-                               ps_r_upsert_seekable,
-                               ps_r_query,
-                               ps_r_scan_done,
+                               ps.ps_r_upsert_buildids,
+                               ps.ps_r_upsert_fileparts,
+                               ps.ps_r_upsert_file,
+                               ps.ps_r_lookup_file,
+                               ps.ps_r_upsert_de,
+                               ps.ps_r_upsert_sref,
+                               ps.ps_r_upsert_sdef,
+                               ps.ps_r_upsert_seekable,
+                               ps.ps_r_query,
+                               ps.ps_r_scan_done,
                                fts_cached,
                                fts_executable,
                                fts_debuginfo,
@@ -4894,14 +5131,14 @@ scan ()
 
           if (scan_files) // NB: maybe "else if" ?
             scan_source_file (p.first, p.second,
-                              ps_f_upsert_buildids,
-                              ps_f_upsert_fileparts,
-                              ps_f_upsert_file,
-                              ps_f_lookup_file,
-                              ps_f_upsert_de,
-                              ps_f_upsert_s,
-                              ps_f_query,
-                              ps_f_scan_done,
+                              ps.ps_f_upsert_buildids,
+                              ps.ps_f_upsert_fileparts,
+                              ps.ps_f_upsert_file,
+                              ps.ps_f_lookup_file,
+                              ps.ps_f_upsert_de,
+                              ps.ps_f_upsert_s,
+                              ps.ps_f_query,
+                              ps.ps_f_scan_done,
                               fts_cached, fts_executable, fts_debuginfo, fts_sourcefiles);
         }
       catch (const reportable_exception& e)
@@ -4925,6 +5162,464 @@ scan ()
 }
 
 
+////////////////////////////////////////////////////////////////////////
+
+// Index snapshots let a new server start from the index of another one
+// that scans a copy of the same files.  The snapshot is a separate sqlite
+// file with denormalized tables.  The names of scanned files are relative
+// to the source path they were found under, and root is the position of
+// that source path on the command line.  The rows describing a file refer
+// to it by its id in the files table, so files with the same relative
+// name under two source paths stay apart.  The importer looks for a file
+// under its own source path at the same position, or under any of them
+// if it has fewer, and accepts it only with the same mtime and size.
+// Anything else is left to the normal scan.
+
+static const char DEBUGINFOD_SNAPSHOT_DDL[] =
+  "create table files (id integer primary key not null, root integer not null,\n"
+  "        sourcetype text(1) not null, name text not null, mtime integer not null,\n"
+  "        size integer not null);\n"
+  "create table f_de (file integer not null, buildid text not null,\n"
+  "        debuginfo_p integer not null, executable_p integer not null);\n"
+  "create table f_s (buildid text not null, artifactsrc text not null,\n"
+  "        source text not null, mtime integer not null);\n"
+  "create table r_de (file integer not null, buildid text not null,\n"
+  "        debuginfo_p integer not null, executable_p integer not null, content text not null);\n"
+  "create table r_sref (buildid text not null, artifactsrc text not null);\n"
+  "create table r_sdef (file integer not null, content text not null);\n"
+  "create table r_seekable (file integer not null, content text not null,\n"
+  "        type text not null, size integer not null, offset integer not null);\n"
+  // The files of the shard being exported, with their ids in files.
+  "create temp table fileids (id integer primary key not null, file integer not null,\n"
+  "        mtime integer not null, root integer not null, sourcetype text(1) not null,\n"
+  "        name text not null, size integer not null);\n"
+  "create index temp.fileids_idx on fileids (file, mtime);\n"
+  ;
+
+// Created after filling the tables, for the lookups of import_index.
+static const char DEBUGINFOD_SNAPSHOT_INDEX_DDL[] =
+  "create index f_de_idx on f_de (file);\n"
+  "create index r_de_idx on r_de (file);\n"
+  "create index r_sdef_idx on r_sdef (file);\n"
+  "create index r_seekable_idx on r_seekable (file);\n"
+  ;
+
+// The source paths as they prefix the file names in the index, with a
+// trailing slash, in command line order.  A missing one is left empty.
+static vector<string>
+source_path_roots ()
+{
+  vector<string> roots;
+  for (auto&& sp: source_paths)
+    {
+      string rps;
+      char *rp = realpath(sp.c_str(), NULL);
+      if (rp != NULL)
+        {
+          rps = string(rp);
+          free (rp);
+          if (rps.back() != '/')
+            rps += "/";
+        }
+      roots.push_back(rps);
+    }
+  return roots;
+}
+
+
+// Copy the attached shard idx into the snapshot tables.
+static void
+export_index_shard (sqlite3 *snap, const vector<string>& roots)
+{
+  // Number the scanned files under each root.  The ids continue from the
+  // previous shards, ?1 is the first one of this shard.
+  sqlite_ps ps_fileids (snap, "snapshot-fileids",
+                        "insert into temp.fileids (file, mtime, root, sourcetype, name, size) "
+                        "select s.file, s.mtime, ?2, s.sourcetype, substr(f.name, length(?1) + 1), s.size "
+                        "from idx." BUILDIDS "_file_mtime_scanned s, idx." BUILDIDS "_files_v f "
+                        "where s.file = f.id and substr(f.name, 1, length(?1)) = ?1;");
+  sqlite_ps ps_first (snap, "snapshot-first-id",
+                      "select ifnull(max(id), 0) + 1 from temp.fileids;");
+  int64_t first = 1;
+  if (ps_first.reset().step() == SQLITE_ROW)
+    first = sqlite3_column_int64 (ps_first, 0);
+  ps_first.reset();
+  for (unsigned i = 0; i < roots.size(); i++)
+    if (roots[i] != "")
+      ps_fileids.reset().bind(1, roots[i]).bind(2, (int64_t) i).step_ok_done();
+
+  // A file under two nested roots is there twice, with each name.
+  sqlite_ps ps_files (snap, "snapshot-files",
+                      "insert into files (id, root, sourcetype, name, mtime, size) "
+                      "select id, root, sourcetype, name, mtime, size from temp.fileids where id >= ?1;");
+  sqlite_ps ps_f_de (snap, "snapshot-f-de",
+                     "insert into f_de (file, buildid, debuginfo_p, executable_p) "
+                     "select i.id, b.hex, n.debuginfo_p, n.executable_p "
+                     "from temp.fileids i, idx." BUILDIDS "_f_de n, idx." BUILDIDS "_buildids b "
+                     "where i.id >= ?1 and i.sourcetype = 'F' "
+                     "and n.file = i.file and n.mtime = i.mtime and n.buildid = b.id;");
+  sqlite_ps ps_r_de (snap, "snapshot-r-de",
+                     "insert into r_de (file, buildid, debuginfo_p, executable_p, content) "
+                     "select i.id, b.hex, n.debuginfo_p, n.executable_p, c.name "
+                     "from temp.fileids i, idx." BUILDIDS "_r_de n, idx." BUILDIDS "_buildids b, "
+                     "idx." BUILDIDS "_files_v c "
+                     "where i.id >= ?1 and i.sourcetype = 'R' "
+                     "and n.file = i.file and n.mtime = i.mtime and n.buildid = b.id and n.content = c.id;");
+  sqlite_ps ps_r_sdef (snap, "snapshot-r-sdef",
+                       "insert into r_sdef (file, content) "
+                       "select i.id, c.name "
+                       "from idx." BUILDIDS "_r_sdef n, temp.fileids i, idx." BUILDIDS "_files_v c "
+                       "where i.id >= ?1 and i.sourcetype = 'R' "
+                       "and n.file = i.file and n.mtime = i.mtime and n.content = c.id;");
+  sqlite_ps ps_r_seekable (snap, "snapshot-r-seekable",
+                           "insert into r_seekable (file, content, type, size, offset) "
+                           "select i.id, c.name, n.type, n.size, n.offset "
+                           "from idx." BUILDIDS "_r_seekable n, temp.fileids i, idx." BUILDIDS "_files_v c "
+                           "where i.id >= ?1 and i.sourcetype = 'R' "
+                           "and n.file = i.file and n.mtime = i.mtime and n.content = c.id;");
+  ps_files.reset().bind(1, first).step_ok_done();
+  ps_f_de.reset().bind(1, first).step_ok_done();
+  ps_r_de.reset().bind(1, first).step_ok_done();
+  ps_r_sdef.reset().bind(1, first).step_ok_done();
+  ps_r_seekable.reset().bind(1, first).step_ok_done();
+
+  // The source file references are absolute names, not under the roots.
+  sqlite_ps ps_f_s (snap, "snapshot-f-s",
+                    "insert into f_s (buildid, artifactsrc, source, mtime) "
+                    "select b.hex, a.name, f.name, n.mtime "
+                    "from idx." BUILDIDS "_f_s n, idx." BUILDIDS "_buildids b, "
+                    "idx." BUILDIDS "_files_v a, idx." BUILDIDS "_files_v f "
+                    "where n.buildid = b.id and n.artifactsrc = a.id and n.file = f.id;");
+  ps_f_s.reset().step_ok_done();
+  sqlite_ps ps_r_sref (snap, "snapshot-r-sref",
+                       "insert into r_sref (buildid, artifactsrc) "
+                       "select b.hex, a.name "
+                       "from idx." BUILDIDS "_r_sref n, idx." BUILDIDS "_buildids b, "
+                       "idx." BUILDIDS "_files_v a "
+                       "where n.buildid = b.id and n.artifactsrc = a.id;");
+  ps_r_sref.reset().step_ok_done();
+}
+
+
+static void
+export_index (const string& path)
+{
+  (void) unlink (path.c_str());
+  sqlite3 *snap;
+  int rc = sqlite3_open_v2 (path.c_str(), &snap, (SQLITE_OPEN_READWRITE
+                                                  |SQLITE_OPEN_CREATE
+                                                  |SQLITE_OPEN_URI), NULL);
+  if (rc != SQLITE_OK)
+    {
+      sqlite3_close (snap);
+      throw sqlite_exception(rc, "cannot create index snapshot " + path);
+    }
+  defer_dtor<sqlite3*,int> snap_closer (snap, sqlite3_close);
+
+  rc = sqlite3_exec (snap, DEBUGINFOD_SNAPSHOT_DDL, NULL, NULL, NULL);
+  if (rc != SQLITE_OK)
+    throw sqlite_exception(rc, "snapshot ddl");
+
+  // Read the index through the snapshot connection, so this works just as
+  // well with a passive server or while another one is scanning.  The
+  // shards are attached in turn, which cannot be done in a transaction.
+  vector<string> roots = source_path_roots();
+  for (unsigned shard = 0; shard < db_shards; shard++)
+    {
+      {
+        sqlite_ps ps_attach (snap, "snapshot-attach", "attach database ? as idx;");
+        ps_attach.reset().bind(1, shard_path(shard)).step_ok_done();
+      }
+      rc = sqlite3_exec (snap, "begin;", NULL, NULL, NULL);
+      if (rc != SQLITE_OK)
+        throw sqlite_exception(rc, "snapshot begin");
+
+      export_index_shard (snap, roots);
+
+      rc = sqlite3_exec (snap, "commit;", NULL, NULL, NULL);
+      if (rc != SQLITE_OK)
+        throw sqlite_exception(rc, "snapshot commit");
+      rc = sqlite3_exec (snap, "detach database idx;", NULL, NULL, NULL);
+      if (rc != SQLITE_OK)
+        throw sqlite_exception(rc, "snapshot detach");
+    }
+
+  rc = sqlite3_exec (snap, DEBUGINFOD_SNAPSHOT_INDEX_DDL, NULL, NULL, NULL);
+  if (rc != SQLITE_OK)
+    throw sqlite_exception(rc, "snapshot index ddl");
+
+  sqlite_ps ps_count (snap, "snapshot-count", "select count(*) from files;");
+  int64_t nfiles = 0;
+  if (ps_count.reset().step() == SQLITE_ROW)
+    nfiles = sqlite3_column_int64 (ps_count, 0);
+  ps_count.reset();
+  obatched(clog) << "exported index snapshot " << path << ", files=" << nfiles << endl;
+}
+
+
+static void
+import_index (const string& path)
+{
+  sqlite3 *snap;
+  int rc = sqlite3_open_v2 (path.c_str(), &snap, (SQLITE_OPEN_READONLY
+                                                  |SQLITE_OPEN_URI), NULL);
+  if (rc != SQLITE_OK)
+    {
+      sqlite3_close (snap);
+      throw sqlite_exception(rc, "cannot open index snapshot " + path);
+    }
+  defer_dtor<sqlite3*,int> snap_closer (snap, sqlite3_close);
+
+  struct timespec ts_start, ts_end;
+  clock_gettime (CLOCK_MONOTONIC, &ts_start);
+
+  vector<string> roots = source_path_roots();
+  unsigned imported = 0, mismatched = 0;
+
+  // Each file goes to the shard a scanner would have put it in.  A shard
+  // is written in a transaction begun when it is first needed, and all of
+  // them are committed every import_batch files, so the scanners and
+  // groomers of another server on the same index are not locked out for
+  // the whole import.  Each file is committed with its scan_done row.
+  const unsigned import_batch = 1000;
+  vector<unique_ptr<scan_statements>> shards;
+  vector<unique_ptr<sqlite_ps>> shard_buildids;
+  vector<bool> begun (shard_dbs.size(), false);
+  for (auto&& shard_db: shard_dbs)
+    {
+      shards.emplace_back (new scan_statements (shard_db));
+      shard_buildids.emplace_back (new sqlite_ps (shard_db, "import-buildid-lookup",
+                                                  "select 1 from " BUILDIDS "_buildids where hex = ?;"));
+    }
+  auto shard_ps = [&] (unsigned i) -> scan_statements& {
+    if (! begun[i])
+      {
+        rc = sqlite3_exec (shard_dbs[i], "begin immediate;", NULL, NULL, NULL);
+        if (rc != SQLITE_OK)
+          throw sqlite_exception(rc, "import begin");
+        begun[i] = true;
+      }
+    return *shards[i];
+  };
+  auto commit_all = [&] () {
+    for (unsigned i = 0; i < shard_dbs.size(); i++)
+      if (begun[i])
+        {
+          rc = sqlite3_exec (shard_dbs[i], "commit;", NULL, NULL, NULL);
+          if (rc != SQLITE_OK)
+            throw sqlite_exception(rc, "import commit");
+          begun[i] = false;
+        }
+  };
+  // The source references go with the elf/archive rows of their buildid,
+  // so grooming does not drop them.
+  auto buildid_shard = [&] (const string& buildid) -> unsigned {
+    for (unsigned i = 0; i < shard_dbs.size(); i++)
+      {
+        sqlite_ps& ps = *shard_buildids[i];
+        bool found = ps.reset().bind(1, buildid).step() == SQLITE_ROW;
+        ps.reset();
+        if (found)
+          return i;
+      }
+    return shard_of (buildid);
+  };
+
+  try
+    {
+      sqlite_ps ps_snap_f_de (snap, "import-snapshot-f-de",
+                              "select buildid, debuginfo_p, executable_p from f_de where file = ?;");
+      sqlite_ps ps_snap_r_de (snap, "import-snapshot-r-de",
+                              "select buildid, debuginfo_p, executable_p, content from r_de where file = ?;");
+      sqlite_ps ps_snap_r_sdef (snap, "import-snapshot-r-sdef",
+                                "select content from r_sdef where file = ?;");
+      sqlite_ps ps_snap_r_seekable (snap, "import-snapshot-r-seekable",
+                                    "select content, type, size, offset from r_seekable where file = ?;");
+      sqlite_ps ps_files (snap, "import-snapshot-files",
+                          "select id, root, sourcetype, name, mtime, size from files;");
+      // A file found through two source paths is imported once.
+      unordered_set<string> done;
+      ps_files.reset();
+      while (! interrupted && ps_files.step() == SQLITE_ROW)
+        {
+          int64_t id = sqlite3_column_int64 (ps_files, 0);
+          int64_t root = sqlite3_column_int64 (ps_files, 1);
+          string sourcetype = (const char*) sqlite3_column_text (ps_files, 2);
+          string name = (const char*) sqlite3_column_text (ps_files, 3);
+          int64_t mtime = sqlite3_column_int64 (ps_files, 4);
+          int64_t size = sqlite3_column_int64 (ps_files, 5);
+
+          // Just stat it, the scan will look at anything not imported.
+          // Only the source path at the same position is tried, unless
+          // this server has no such one.
+          bool anyroot = (uint64_t) root >= roots.size() || roots[root] == "";
+          string rps;
+          for (unsigned r = 0; r < roots.size() && rps == ""; r++)
+            {
+              if (roots[r] == "" || (! anyroot && r != root))
+                continue;
+              struct stat st;
+              string candidate = roots[r] + name;
+              if (stat (candidate.c_str(), &st) != 0 || ! S_ISREG (st.st_mode)
+                  || st.st_mtime != mtime || st.st_size != size)
+                continue;
+              // Named as the scanner would, with any symlinks resolved.
+              char *rp = realpath (candidate.c_str(), NULL);
+              if (rp == NULL)
+                continue;
+              candidate = string(rp);
+              free (rp);
+              if (done.find(candidate) == done.end())
+                rps = candidate;
+            }
+          if (rps == "")
+            {
+              if (verbose > 2)
+                obatched(clog) << "import mismatch " << name << endl;
+              mismatched ++;
+              continue;
+            }
+          done.insert(rps);
+
+          scan_statements& ps = shard_ps (shard_of (rps));
+          if (sourcetype == "F")
+            {
+              int64_t fileid = register_file_name (ps.ps_f_upsert_fileparts, ps.ps_f_upsert_file, ps.ps_f_lookup_file, rps);
+              ps_snap_f_de.reset().bind(1, id);
+              while (ps_snap_f_de.step() == SQLITE_ROW)
+                {
+                  string buildid = (const char*) sqlite3_column_text (ps_snap_f_de, 0);
+                  ps.ps_f_upsert_buildids.reset().bind(1, buildid).step_ok_done();
+                  ps.ps_f_upsert_de
+                    .reset()
+                    .bind(1, buildid)
+                    .bind(2, sqlite3_column_int64 (ps_snap_f_de, 1))
+                    .bind(3, sqlite3_column_int64 (ps_snap_f_de, 2))
+                    .bind(4, fileid)
+                    .bind(5, mtime)
+                    .step_ok_done();
+                }
+              ps_snap_f_de.reset();
+              ps.ps_f_scan_done.reset().bind(1, fileid).bind(2, mtime).bind(3, size).step_ok_done();
+            }
+          else
+            {
+              int64_t fileid = register_file_name (ps.ps_r_upsert_fileparts, ps.ps_r_upsert_file, ps.ps_r_lookup_file, rps);
+              ps_snap_r_de.reset().bind(1, id);
+              while (ps_snap_r_de.step() == SQLITE_ROW)
+                {
+                  string buildid = (const char*) sqlite3_column_text (ps_snap_r_de, 0);
+                  string content = (const char*) sqlite3_column_text (ps_snap_r_de, 3);
+                  ps.ps_r_upsert_buildids.reset().bind(1, buildid).step_ok_done();
+                  int64_t contentid = register_file_name (ps.ps_r_upsert_fileparts, ps.ps_r_upsert_file, ps.ps_r_lookup_file, content);
+                  ps.ps_r_upsert_de
+                    .reset()
+                    .bind(1, buildid)
+                    .bind(2, sqlite3_column_int64 (ps_snap_r_de, 1))
+                    .bind(3, sqlite3_column_int64 (ps_snap_r_de, 2))
+                    .bind(4, fileid)
+                    .bind(5, mtime)
+                    .bind(6, contentid)
+                    .step_ok_done();
+                }
+              ps_snap_r_de.reset();
+
+              ps_snap_r_sdef.reset().bind(1, id);
+              while (ps_snap_r_sdef.step() == SQLITE_ROW)
+                {
+                  string content = (const char*) sqlite3_column_text (ps_snap_r_sdef, 0);
+                  int64_t contentid = register_file_name (ps.ps_r_upsert_fileparts, ps.ps_r_upsert_file, ps.ps_r_lookup_file, content);
+                  ps.ps_r_upsert_sdef.reset().bind(1, fileid).bind(2, mtime).bind(3, contentid).step_ok_done();
+                }
+              ps_snap_r_sdef.reset();
+
+              // Only xz archives are indexed as seekable.
+              ps_snap_r_seekable.reset().bind(1, id);
+              while (ps_snap_r_seekable.step() == SQLITE_ROW)
+                {
+                  string content = (const char*) sqlite3_column_text (ps_snap_r_seekable, 0);
+                  string type = (const char*) sqlite3_column_text (ps_snap_r_seekable, 1);
+                  if (type != "xz")
+                    continue;
+                  int64_t contentid = register_file_name (ps.ps_r_upsert_fileparts, ps.ps_r_upsert_file, ps.ps_r_lookup_file, content);
+                  ps.ps_r_upsert_seekable
+                    .reset()
+                    .bind(1, fileid)
+                    .bind(2, contentid)
+                    .bind(3, sqlite3_column_int64 (ps_snap_r_seekable, 2))
+                    .bind(4, sqlite3_column_int64 (ps_snap_r_seekable, 3))
+                    .bind(5, mtime)
+                    .step_ok_done();
+                }
+              ps_snap_r_seekable.reset();
+              ps.ps_r_scan_done.reset().bind(1, fileid).bind(2, mtime).bind(3, size).step_ok_done();
+            }
+          if (++imported % import_batch == 0)
+            commit_all();
+        }
+      ps_files.reset();
+      commit_all();
+
+      // The source file references of elf files, if still there.
+      sqlite_ps ps_snap_f_s (snap, "import-snapshot-f-s",
+                             "select buildid, artifactsrc, source, mtime from f_s;");
+      ps_snap_f_s.reset();
+      while (! interrupted && ps_snap_f_s.step() == SQLITE_ROW)
+        {
+          string buildid = (const char*) sqlite3_column_text (ps_snap_f_s, 0);
+          string artifactsrc = (const char*) sqlite3_column_text (ps_snap_f_s, 1);
+          string source = (const char*) sqlite3_column_text (ps_snap_f_s, 2);
+          int64_t mtime = sqlite3_column_int64 (ps_snap_f_s, 3);
+          struct stat st;
+          if (stat (source.c_str(), &st) != 0 || st.st_mtime != mtime)
+            continue;
+          scan_statements& ps = shard_ps (buildid_shard (buildid));
+          ps.ps_f_upsert_buildids.reset().bind(1, buildid).step_ok_done();
+          int64_t fileid1 = register_file_name (ps.ps_f_upsert_fileparts, ps.ps_f_upsert_file, ps.ps_f_lookup_file, artifactsrc);
+          int64_t fileid2 = register_file_name (ps.ps_f_upsert_fileparts, ps.ps_f_upsert_file, ps.ps_f_lookup_file, source);
+          ps.ps_f_upsert_s
+            .reset()
+            .bind(1, buildid)
+            .bind(2, fileid1)
+            .bind(3, fileid2)
+            .bind(4, mtime)
+            .step_ok_done();
+        }
+      ps_snap_f_s.reset();
+
+      // The source file references of archives.
+      sqlite_ps ps_snap_r_sref (snap, "import-snapshot-r-sref",
+                                "select buildid, artifactsrc from r_sref;");
+      ps_snap_r_sref.reset();
+      while (! interrupted && ps_snap_r_sref.step() == SQLITE_ROW)
+        {
+          string buildid = (const char*) sqlite3_column_text (ps_snap_r_sref, 0);
+          string artifactsrc = (const char*) sqlite3_column_text (ps_snap_r_sref, 1);
+          scan_statements& ps = shard_ps (buildid_shard (buildid));
+          ps.ps_r_upsert_buildids.reset().bind(1, buildid).step_ok_done();
+          int64_t fileid = register_file_name (ps.ps_r_upsert_fileparts, ps.ps_r_upsert_file, ps.ps_r_lookup_file, artifactsrc);
+          ps.ps_r_upsert_sref.reset().bind(1, buildid).bind(2, fileid).step_ok_done();
+        }
+      ps_snap_r_sref.reset();
+      commit_all();
+    }
+  catch (...)
+    {
+      for (unsigned i = 0; i < shard_dbs.size(); i++)
+        if (begun[i])
+          (void) sqlite3_exec (shard_dbs[i], "rollback;", NULL, NULL, NULL);
+      throw;
+    }
+
+  clock_gettime (CLOCK_MONOTONIC, &ts_end);
+  double deltas = (ts_end.tv_sec - ts_start.tv_sec) + (ts_end.tv_nsec - ts_start.tv_nsec)/1.e9;
+  add_metric("index_import_files_total", "result", "imported", imported);
+  add_metric("index_import_files_total", "result", "mismatched", mismatched);
+  obatched(clog) << "imported index snapshot " << path << " in " << deltas << "s, imported="
+                 << imported << ", mismatched=" << mismatched << endl;
+}
+
+
 // Use this function as the thread entry point, so it can catch our
 // fleet of exceptions (incl. the sqlite_ps ctors) and report.
 static void*
@@ -5113,44 +5808,49 @@ thread_main_fts_source_paths (void* arg)
 static void
 database_stats_report()
 {
-  sqlite_ps ps_query (db, "database-overview",
-                      "select label,quantity from " BUILDIDS "_stats");
-
-  obatched(clog) << "database record counts:" << endl;
-  while (1)
+  // The sums over all the shards, in the order of the _stats view.
+  vector<pair<string,int64_t>> stats;
+  for (size_t shard = 0; shard < shard_dbs.size(); shard++)
     {
-      if (interrupted) break;
-      if (sigusr1 != forced_rescan_count) // stop early if scan triggered
-        break;
-
-      int rc = ps_query.step();
-      if (rc == SQLITE_DONE) break;
-      if (rc != SQLITE_ROW)
-        throw sqlite_exception(rc, "step");
+      sqlite_ps ps_query (shard_dbs[shard], "database-overview",
+                          "select label,quantity from " BUILDIDS "_stats");
 
-      obatched(clog)
-        << ((const char*) sqlite3_column_text(ps_query, 0) ?: (const char*) "NULL")
-        << " "
-        << (sqlite3_column_text(ps_query, 1) ?: (const unsigned char*) "NULL")
-        << endl;
+      for (size_t i = 0; ; i++)
+        {
+          if (interrupted) return;
+          if (sigusr1 != forced_rescan_count) // stop early if scan triggered
+            return;
+
+          int rc = ps_query.step();
+          if (rc == SQLITE_DONE) break;
+          if (rc != SQLITE_ROW)
+            throw sqlite_exception(rc, "step");
+
+          string label = (const char*) sqlite3_column_text(ps_query, 0) ?: (const char*) "NULL";
+          int64_t quantity = sqlite3_column_int64(ps_query, 1);
+          if (shard == 0)
+            stats.push_back(make_pair(label, quantity));
+          else if (i < stats.size())
+            stats[i].second += quantity;
+        }
+    }
 
-      set_metric("groom", "statistic",
-                 ((const char*) sqlite3_column_text(ps_query, 0) ?: (const char*) "NULL"),
-                 (sqlite3_column_double(ps_query, 1)));
+  obatched(clog) << "database record counts:" << endl;
+  for (auto&& stat : stats)
+    {
+      obatched(clog) << stat.first << " " << stat.second << endl;
+      set_metric("groom", "statistic", stat.first, stat.second);
     }
 }
 
 
-// Do a round of database grooming that might take many minutes to run.
-void groom()
+// Groom one shard of the database, as far as rescan_s after TIME_START
+// permits.
+static void
+groom_shard (sqlite3 *shard_db, time_t time_start)
 {
-  obatched(clog) << "grooming database" << endl;
-
-  struct timespec ts_start, ts_end;
-  clock_gettime (CLOCK_MONOTONIC, &ts_start);
-
   // scan for files that have disappeared
-  sqlite_ps files (db, "check old files",
+  sqlite_ps files (shard_db, "check old files",
                    "select distinct s.mtime, s.file, f.name from "
                    BUILDIDS "_file_mtime_scanned s, " BUILDIDS "_files_v f "
                    "where f.id = s.file");
@@ -5162,7 +5862,6 @@ void groom()
   // DECISION TIME - we enumerate stale fileids/mtimes
   deque<pair<int64_t,int64_t> > stale_fileid_mtime;
   
-  time_t time_start = time(NULL);
   while(1)
     {
       // PR28514: limit grooming iteration to O(rescan time), to avoid
@@ -5222,9 +5921,9 @@ void groom()
   // of just starting over.  But it doesn't matter much either way,
   // as long as we make progress.
 
-  sqlite_ps files_del_f_de (db, "nuke f_de", "delete from " BUILDIDS "_f_de where file = ? and mtime = ?");
-  sqlite_ps files_del_r_de (db, "nuke r_de", "delete from " BUILDIDS "_r_de where file = ? and mtime = ?");
-  sqlite_ps files_del_scan (db, "nuke f_m_s", "delete from " BUILDIDS "_file_mtime_scanned "
+  sqlite_ps files_del_f_de (shard_db, "nuke f_de", "delete from " BUILDIDS "_f_de where file = ? and mtime = ?");
+  sqlite_ps files_del_r_de (shard_db, "nuke r_de", "delete from " BUILDIDS "_r_de where file = ? and mtime = ?");
+  sqlite_ps files_del_scan (shard_db, "nuke f_m_s", "delete from " BUILDIDS "_file_mtime_scanned "
                             "where file = ? and mtime = ?");
 
   while (! stale_fileid_mtime.empty())
@@ -5260,7 +5959,7 @@ void groom()
       
   // delete buildids with no references in _r_de or _f_de tables;
   // cascades to _r_sref & _f_s records
-  sqlite_ps buildids_del (db, "nuke orphan buildids",
+  sqlite_ps buildids_del (shard_db, "nuke orphan buildids",
                           "delete from " BUILDIDS "_buildids "
                           "where not exists (select 1 from " BUILDIDS "_f_de d where " BUILDIDS "_buildids.id = d.buildid) "
                           "and not exists (select 1 from " BUILDIDS "_r_de d where " BUILDIDS "_buildids.id = d.buildid)");
@@ -5269,20 +5968,38 @@ void groom()
   if (interrupted) return;
 
   // NB: "vacuum" is too heavy for even daily runs: it rewrites the entire db, so is done as maxigroom -G
-  { sqlite_ps g (db, "incremental vacuum", "pragma incremental_vacuum"); g.reset().step_ok_done(); }
+  { sqlite_ps g (shard_db, "incremental vacuum", "pragma incremental_vacuum"); g.reset().step_ok_done(); }
   // https://www.sqlite.org/lang_analyze.html#approx
-  { sqlite_ps g (db, "analyze setup", "pragma analysis_limit = 1000;\n"); g.reset().step_ok_done(); }
-  { sqlite_ps g (db, "analyze", "analyze"); g.reset().step_ok_done(); }
-  { sqlite_ps g (db, "analyze reload", "analyze sqlite_schema"); g.reset().step_ok_done(); } 
-  { sqlite_ps g (db, "optimize", "pragma optimize"); g.reset().step_ok_done(); }
-  { sqlite_ps g (db, "wal checkpoint", "pragma wal_checkpoint=truncate"); g.reset().step_ok_done(); }
+  { sqlite_ps g (shard_db, "analyze setup", "pragma analysis_limit = 1000;\n"); g.reset().step_ok_done(); }
+  { sqlite_ps g (shard_db, "analyze", "analyze"); g.reset().step_ok_done(); }
+  { sqlite_ps g (shard_db, "analyze reload", "analyze sqlite_schema"); g.reset().step_ok_done(); } 
+  { sqlite_ps g (shard_db, "optimize", "pragma optimize"); g.reset().step_ok_done(); }
+  { sqlite_ps g (shard_db, "wal checkpoint", "pragma wal_checkpoint=truncate"); g.reset().step_ok_done(); }
+
+  sqlite3_db_release_memory(shard_db); // shrink the process if possible
+}
+
+
+// Do a round of database grooming that might take many minutes to run.
+void groom()
+{
+  obatched(clog) << "grooming database" << endl;
+
+  struct timespec ts_start, ts_end;
+  clock_gettime (CLOCK_MONOTONIC, &ts_start);
+
+  time_t time_start = time(NULL);
+  for (auto&& shard_db : shard_dbs)
+    {
+      groom_shard (shard_db, time_start);
+      if (interrupted) return;
+    }
 
   database_stats_report();
 
   (void) statfs_free_enough_p(db_path, "database"); // report sqlite filesystem size
 
-  sqlite3_db_release_memory(db); // shrink the process if possible
-  sqlite3_db_release_memory(dbq); // ... for both connections
+  sqlite3_db_release_memory(dbq); // shrink the process if possible, for the webapi connection too
   debuginfod_pool_groom(); // and release any debuginfod_client objects we've been holding onto
 #if HAVE_MALLOC_TRIM
   malloc_trim(0); // PR31103: release memory allocated for temporary purposes
@@ -5357,14 +6074,30 @@ signal_handler (int /* sig */)
 {
   interrupted ++;
 
-  if (db)
-    sqlite3_interrupt (db);
+  for (auto&& shard_db : shard_dbs)
+    if (shard_db)
+      sqlite3_interrupt (shard_db);
   if (dbq)
     sqlite3_interrupt (dbq);
 
   // NB: don't do anything else in here
 }
 
+
+static void
+close_databases ()
+{
+  sqlite3 *databaseq = dbq;
+  db = dbq = 0; // for signal_handler not to freak
+  (void) sqlite3_close (databaseq);
+  for (auto&& shard_db : shard_dbs)
+    {
+      sqlite3 *database = shard_db;
+      shard_db = 0;
+      (void) sqlite3_close (database);
+    }
+}
+
 static void
 sigusr1_handler (int /* sig */)
 {
@@ -5527,25 +6260,30 @@ main (int argc, char *argv[])
 
   /* Get database ready. */
   if (! passive_p)
-    {
-      rc = sqlite3_open_v2 (db_path.c_str(), &db, (SQLITE_OPEN_READWRITE
-                                                   |SQLITE_OPEN_URI
-                                                   |SQLITE_OPEN_PRIVATECACHE
-                                                   |SQLITE_OPEN_CREATE
-                                                   |SQLITE_OPEN_FULLMUTEX), /* thread-safe */
-                            NULL);
-      if (rc == SQLITE_CORRUPT)
-        {
-          (void) unlink (db_path.c_str());
-          error (EXIT_FAILURE, 0,
-                 "cannot open %s, deleted database: %s", db_path.c_str(), sqlite3_errmsg(db));
-        }
-      else if (rc)
-        {
-          error (EXIT_FAILURE, 0,
-                 "cannot open %s, consider deleting database: %s", db_path.c_str(), sqlite3_errmsg(db));
-        }
-    }
+    for (unsigned shard = 0; shard < db_shards; shard++)
+      {
+        string path = shard_path(shard);
+        sqlite3 *shard_db;
+        rc = sqlite3_open_v2 (path.c_str(), &shard_db, (SQLITE_OPEN_READWRITE
+                                                        |SQLITE_OPEN_URI
+                                                        |SQLITE_OPEN_PRIVATECACHE
+                                                        |SQLITE_OPEN_CREATE
+                                                        |SQLITE_OPEN_FULLMUTEX), /* thread-safe */
+                              NULL);
+        if (rc == SQLITE_CORRUPT)
+          {
+            (void) unlink (path.c_str());
+            error (EXIT_FAILURE, 0,
+                   "cannot open %s, deleted database: %s", path.c_str(), sqlite3_errmsg(shard_db));
+          }
+        else if (rc)
+          {
+            error (EXIT_FAILURE, 0,
+                   "cannot open %s, consider deleting database: %s", path.c_str(), sqlite3_errmsg(shard_db));
+          }
+        shard_dbs.push_back(shard_db);
+      }
+  db = shard_dbs.empty() ? 0 : shard_dbs[0];
 
   // open the readonly query variant
   // NB: PRIVATECACHE allows web queries to operate in parallel with
@@ -5561,9 +6299,25 @@ main (int argc, char *argv[])
              "cannot open %s, consider deleting database: %s", db_path.c_str(), sqlite3_errmsg(dbq));
     }
 
+  // ... which sees the other shards too
+  if (db_shards - 1 > (unsigned) sqlite3_limit (dbq, SQLITE_LIMIT_ATTACHED, -1))
+    error (EXIT_FAILURE, 0, "too many shards, sqlite allows at most %d",
+           sqlite3_limit (dbq, SQLITE_LIMIT_ATTACHED, -1) + 1);
+  for (unsigned shard = 1; shard < db_shards; shard++)
+    {
+      char *sql = sqlite3_mprintf ("attach database %Q as %s;", shard_path(shard).c_str(),
+                                   shard_schema(shard).c_str());
+      rc = sqlite3_exec (dbq, sql, NULL, NULL, NULL);
+      sqlite3_free (sql);
+      if (rc != SQLITE_OK)
+        error (EXIT_FAILURE, 0,
+               "cannot attach %s: %s", shard_path(shard).c_str(), sqlite3_errmsg(dbq));
+    }
 
   obatched(clog) << "opened database " << db_path
                  << (db?" rw":"") << (dbq?" ro":"") << endl;
+  if (db_shards > 1)
+    obatched(clog) << "database shards " << db_shards << endl;
   obatched(clog) << "sqlite version " << sqlite3_version << endl;
   obatched(clog) << "service mode " << (passive_p ? "passive":"active") << endl;
 
@@ -5578,11 +6332,43 @@ main (int argc, char *argv[])
     {
       if (verbose > 3)
         obatched(clog) << "ddl: " << DEBUGINFOD_SQLITE_DDL << endl;
-      rc = sqlite3_exec (db, DEBUGINFOD_SQLITE_DDL, NULL, NULL, NULL);
-      if (rc != SQLITE_OK)
+      for (auto&& shard_db : shard_dbs)
         {
-          error (EXIT_FAILURE, 0,
-                 "cannot run database schema ddl: %s", sqlite3_errmsg(db));
+          rc = sqlite3_exec (shard_db, DEBUGINFOD_SQLITE_DDL, NULL, NULL, NULL);
+          if (rc != SQLITE_OK)
+            {
+              error (EXIT_FAILURE, 0,
+                     "cannot run database schema ddl: %s", sqlite3_errmsg(shard_db));
+            }
+        }
+    }
+
+  if (export_index_path != "")
+    {
+      int status = EXIT_SUCCESS;
+      try
+        {
+          export_index (export_index_path);
+        }
+      catch (const reportable_exception& e)
+        {
+          e.report(cerr);
+          status = EXIT_FAILURE;
+        }
+      close_databases ();
+      return status;
+    }
+
+  if (import_index_path != "")
+    {
+      try
+        {
+          import_index (import_index_path);
+        }
+      catch (const reportable_exception& e)
+        {
+          // Not fatal, the files will just be scanned.
+          e.report(cerr);
         }
     }
 
@@ -5642,11 +6428,7 @@ main (int argc, char *argv[])
 			     MHD_OPTION_END);
       if (d4 == NULL)
 	{
-	  sqlite3 *database = db;
-	  sqlite3 *databaseq = dbq;
-	  db = dbq = 0; // for signal_handler not to freak
-	  sqlite3_close (databaseq);
-	  sqlite3_close (database);
+	  close_databases ();
 	  error (EXIT_FAILURE, 0, "cannot start http server at port %d",
 		 http_port);
 	}
@@ -5662,9 +6444,13 @@ main (int argc, char *argv[])
       obatched(clog) << "maxigrooming database, please wait." << endl;
       // NB: this index alone can nearly double the database size!
       // NB: this index would be necessary to run source-file metadata searches fast
-      extra_ddl.push_back("create index if not exists " BUILDIDS "_r_sref_arc on " BUILDIDS "_r_sref(artifactsrc);");
-      extra_ddl.push_back("delete from " BUILDIDS "_r_sdef where not exists (select 1 from " BUILDIDS "_r_sref b where " BUILDIDS "_r_sdef.content = b.artifactsrc);");
-      extra_ddl.push_back("drop index if exists " BUILDIDS "_r_sref_arc;");
+      // NB: with shards, the _r_sref rows of an _r_sdef may be in another one.
+      if (db_shards == 1)
+        {
+          extra_ddl.push_back("create index if not exists " BUILDIDS "_r_sref_arc on " BUILDIDS "_r_sref(artifactsrc);");
+          extra_ddl.push_back("delete from " BUILDIDS "_r_sdef where not exists (select 1 from " BUILDIDS "_r_sref b where " BUILDIDS "_r_sdef.content = b.artifactsrc);");
+          extra_ddl.push_back("drop index if exists " BUILDIDS "_r_sref_arc;");
+        }
 
       // NB: we don't maxigroom the _files interning table.  It'd require a temp index on all the
       // tables that have file foreign-keys, which is a lot.
@@ -5683,10 +6469,13 @@ main (int argc, char *argv[])
       {
         if (verbose > 1)
           obatched(clog) << "extra ddl:\n" << i << endl;
-        rc = sqlite3_exec (db, i.c_str(), NULL, NULL, NULL);
-        if (rc != SQLITE_OK && rc != SQLITE_DONE && rc != SQLITE_ROW)
-          error (0, 0,
-                 "warning: cannot run database extra ddl %s: %s", i.c_str(), sqlite3_errmsg(db));
+        for (auto&& shard_db : shard_dbs)
+          {
+            rc = sqlite3_exec (shard_db, i.c_str(), NULL, NULL, NULL);
+            if (rc != SQLITE_OK && rc != SQLITE_DONE && rc != SQLITE_ROW)
+              error (0, 0,
+                     "warning: cannot run database extra ddl %s: %s", i.c_str(), sqlite3_errmsg(shard_db));
+          }
 
         if (maxigroom)
           obatched(clog) << "maxigroomed database" << endl;
@@ -5784,11 +6573,14 @@ main (int argc, char *argv[])
   if (! passive_p)
     {
       /* With all threads known dead, we can clean up the global resources. */
-      rc = sqlite3_exec (db, DEBUGINFOD_SQLITE_CLEANUP_DDL, NULL, NULL, NULL);
-      if (rc != SQLITE_OK)
+      for (auto&& shard_db : shard_dbs)
         {
-          error (0, 0,
-                 "warning: cannot run database cleanup ddl: %s", sqlite3_errmsg(db));
+          rc = sqlite3_exec (shard_db, DEBUGINFOD_SQLITE_CLEANUP_DDL, NULL, NULL, NULL);
+          if (rc != SQLITE_OK)
+            {
+              error (0, 0,
+                     "warning: cannot run database cleanup ddl: %s", sqlite3_errmsg(shard_db));
+            }
         }
     }
 
@@ -5799,12 +6591,7 @@ main (int argc, char *argv[])
   (void) regfree (& file_include_regex);
   (void) regfree (& file_exclude_regex);
 
-  sqlite3 *database = db;
-  sqlite3 *databaseq = dbq;
-  db = dbq = 0; // for signal_handler not to freak
-  (void) sqlite3_close (databaseq);
-  if (! passive_p)
-    (void) sqlite3_close (database);
+  close_databases ();
 
   return 0;
 }
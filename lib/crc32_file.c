@@ -32,11 +32,84 @@
 
 #include "libeu.h"
 #include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
 #include <unistd.h>
 #include <sys/stat.h>
 #include <sys/mman.h>
 #include "system.h"
 
+/* Files at least this big are checksummed by several threads when the
+   whole file could be mapped, each thread taking at least
+   CRC32_SEGMENT_MIN bytes.  */
+#define CRC32_PARALLEL_MIN (64 * 1024 * 1024)
+#define CRC32_SEGMENT_MIN (16 * 1024 * 1024)
+
+struct crc32_segment
+{
+  unsigned char *buf;
+  size_t len;
+  uint32_t crc;
+};
+
+static void *
+crc32_segment_worker (void *arg)
+{
+  struct crc32_segment *seg = arg;
+  seg->crc = crc32 (0, seg->buf, seg->len);
+  return NULL;
+}
+
+/* Compute the CRC of the LEN bytes at BUF by splitting them into
+   segments whose CRCs are computed in parallel and then combined.  */
+static uint32_t
+crc32_parallel (unsigned char *buf, size_t len)
+{
+  long int ncpus = sysconf (_SC_NPROCESSORS_ONLN);
+  size_t nsegs = MIN ((size_t) MAX (ncpus, 1), len / CRC32_SEGMENT_MIN);
+  if (nsegs < 2)
+    return crc32 (0, buf, len);
+
+  struct crc32_segment *segs = malloc (nsegs * sizeof segs[0]);
+  pthread_t *threads = malloc (nsegs * sizeof threads[0]);
+  if (segs == NULL || threads == NULL)
+    {
+      free (segs);
+      free (threads);
+      return crc32 (0, buf, len);
+    }
+
+  /* Segment lengths are multiples of 64 bytes, the last one takes the
+     remainder.  The first segment is done by the calling thread, as is
+     any segment for which no thread can be created.  */
+  size_t seglen = (len / nsegs) & ~(size_t) 63;
+  for (size_t i = 0; i < nsegs; ++i)
+    {
+      segs[i].buf = buf + i * seglen;
+      segs[i].len = i + 1 < nsegs ? seglen : len - i * seglen;
+    }
+  size_t nthreads = 1;
+  while (nthreads < nsegs
+	 && pthread_create (&threads[nthreads], NULL, crc32_segment_worker,
+			    &segs[nthreads]) == 0)
+    ++nthreads;
+  for (size_t i = nthreads; i < nsegs; ++i)
+    crc32_segment_worker (&segs[i]);
+  crc32_segment_worker (&segs[0]);
+
+  uint32_t crc = segs[0].crc;
+  for (size_t i = 1; i < nsegs; ++i)
+    {
+      if (i < nthreads)
+	pthread_join (threads[i], NULL);
+      crc = crc32_combine (crc, segs[i].crc, segs[i].len);
+    }
+
+  free (segs);
+  free (threads);
+  return crc;
+}
+
 int
 crc32_file (int fd, uint32_t *resp)
 {
@@ -64,6 +137,13 @@ crc32_file (int fd, uint32_t *resp)
 	{
 	  do
 	    {
+	      if (off == 0 && st.st_size >= CRC32_PARALLEL_MIN
+		  && st.st_size <= (off_t) mapsize)
+		{
+		  *resp = crc32_parallel (mapped, st.st_size);
+		  munmap (mapped, mapsize);
+		  return 0;
+		}
 	      if (st.st_size <= (off_t) mapsize)
 		{
 		  *resp = crc32 (crc, mapped, st.st_size);
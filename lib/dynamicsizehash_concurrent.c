@@ -39,6 +39,156 @@
  */
 
 
+#ifdef SWISS
+/* Control bytes.  A used entry has the top seven bits of its mixed
+   hash value as control byte, which leaves the top bit clear.  BUSY
+   marks an entry which an inserter has claimed but not yet filled in.  */
+#define CTRL_EMPTY 0x80u
+#define CTRL_BUSY 0xfeu
+
+#define GROUP_SIZE 8
+#define LSBS UINT64_C (0x0101010101010101)
+#define MSBS UINT64_C (0x8080808080808080)
+
+/* Spread the bits of HVAL, which for DWARF abbreviation codes are
+   small consecutive numbers, over the whole word.  */
+static inline uint64_t
+mix (HASHTYPE hval)
+{
+  uint64_t h = hval;
+  h ^= h >> 33;
+  h *= UINT64_C (0xff51afd7ed558ccd);
+  h ^= h >> 33;
+  return h;
+}
+
+/* Bytes of WORD equal to TAG have their top bit set in the result.  A
+   byte above a matching one can be reported as well, so candidates must
+   be checked.  Only used entries are reported.  */
+static inline uint64_t
+match_tag (uint64_t word, unsigned int tag)
+{
+  uint64_t x = word ^ (LSBS * tag);
+  return (x - LSBS) & ~x & ~word & MSBS;
+}
+
+/* Empty bytes of WORD have their top bit set in the result.  */
+static inline uint64_t
+match_empty (uint64_t word)
+{
+  return word & ~(word << 6) & MSBS;
+}
+
+/* Claimed bytes of WORD have their top bit set in the result.  */
+static inline uint64_t
+match_busy (uint64_t word)
+{
+  return word & (word << 6) & MSBS;
+}
+
+/* Index of the entry of the lowest byte set in MATCH.  */
+static inline size_t
+match_index (uint64_t match)
+{
+  return __builtin_ctzll (match) / 8;
+}
+
+#define NAME_TABLE(name) _NAME_TABLE (name)
+#define _NAME_TABLE(name) name##_table
+#define NAME_ENT(name) _NAME_ENT (name)
+#define _NAME_ENT(name) name##_ent
+
+/* Allocate a table with NGROUPS groups, which must be a power of two.
+   The control words are left uninitialized.  */
+static NAME_TABLE (NAME) *
+alloc_table (size_t ngroups)
+{
+  NAME_TABLE (NAME) *t = malloc (sizeof *t
+				 + ngroups * sizeof (t->ctrl[0])
+				 + ngroups * GROUP_SIZE * sizeof (t->ent[0]));
+  if (t == NULL)
+    return NULL;
+  t->ngroups = ngroups;
+  t->ctrl = (atomic_uint_least64_t *) (t + 1);
+  t->ent = (NAME_ENT (NAME) *) (t->ctrl + ngroups);
+  t->retired = NULL;
+  return t;
+}
+
+static TYPE
+lookup (NAME_TABLE (NAME) *t, HASHTYPE hval)
+{
+  uint64_t h = mix (hval);
+  unsigned int tag = h >> 57;
+  size_t group = h & (t->ngroups - 1);
+
+  /* Triangular probing visits every group once if NGROUPS is a power
+     of two.  The table always has empty entries.  */
+  for (size_t step = 1; ; ++step)
+    {
+      uint64_t word = atomic_load_explicit (&t->ctrl[group],
+					    memory_order_acquire);
+      for (uint64_t m = match_tag (word, tag); m != 0; m &= m - 1)
+	{
+	  NAME_ENT (NAME) *ent = &t->ent[group * GROUP_SIZE + match_index (m)];
+	  if (ent->hashval == hval)
+	    return ent->val;
+	}
+      if (match_empty (word) != 0)
+	return NULL;
+      group = (group + step) & (t->ngroups - 1);
+    }
+}
+
+static int
+insert_helper (NAME_TABLE (NAME) *t, HASHTYPE hval, TYPE val)
+{
+  uint64_t h = mix (hval);
+  unsigned int tag = h >> 57;
+  size_t group = h & (t->ngroups - 1);
+
+  for (size_t step = 1; ; ++step)
+    {
+      uint64_t word = atomic_load_explicit (&t->ctrl[group],
+					    memory_order_acquire);
+      for (;;)
+	{
+	  /* Another thread might be inserting the same value.  Wait
+	     until its entry is complete.  */
+	  while (match_busy (word) != 0)
+	    word = atomic_load_explicit (&t->ctrl[group],
+					 memory_order_acquire);
+
+	  for (uint64_t m = match_tag (word, tag); m != 0; m &= m - 1)
+	    if (t->ent[group * GROUP_SIZE + match_index (m)].hashval == hval)
+	      return -1;
+
+	  uint64_t empty = match_empty (word);
+	  if (empty == 0)
+	    break;
+
+	  /* Claim the first empty entry, then fill it in and publish
+	     its tag.  */
+	  size_t i = match_index (empty);
+	  uint64_t busy = word ^ ((uint64_t) (CTRL_EMPTY ^ CTRL_BUSY) << (8 * i));
+	  if (atomic_compare_exchange_weak_explicit (&t->ctrl[group], &word,
+						     busy,
+						     memory_order_acquire,
+						     memory_order_acquire))
+	    {
+	      t->ent[group * GROUP_SIZE + i].hashval = hval;
+	      t->ent[group * GROUP_SIZE + i].val = val;
+	      atomic_fetch_xor_explicit (&t->ctrl[group],
+					 (uint64_t) (CTRL_BUSY ^ tag) << (8 * i),
+					 memory_order_release);
+	      return 0;
+	    }
+	}
+      group = (group + step) & (t->ngroups - 1);
+    }
+}
+#else
+
 static size_t
 lookup (NAME *htab, HASHTYPE hval)
 {
@@ -160,6 +310,8 @@ insert_helper (NAME *htab, HASHTYPE hval, TYPE val)
     }
 }
 
+#endif
+
 #define NO_RESIZING 0u
 #define ALLOCATING_MEMORY 1u
 #define MOVING_DATA 3u
@@ -178,6 +330,120 @@ insert_helper (NAME *htab, HASHTYPE hval, TYPE val)
 #define MOVE_BLOCK_SIZE 256
 #define CEIL(A, B) (((A) + (B) - 1) / (B))
 
+#ifdef SWISS
+/* Initializes the control words of the new table and copies the data
+   from the current one.  It can share work with other threads.  Only
+   the coordinator will pass blocking as 1, other worker threads pass
+   0.  */
+static void resize_helper(NAME *htab, int blocking)
+{
+  NAME_TABLE (NAME) *old = (NAME_TABLE (NAME) *)
+    atomic_load_explicit(&htab->table, memory_order_relaxed);
+  NAME_TABLE (NAME) *new = htab->new_table;
+  size_t num_old_blocks = CEIL(old->ngroups, MOVE_BLOCK_SIZE);
+  size_t num_new_blocks = CEIL(new->ngroups, INITIALIZATION_BLOCK_SIZE);
+
+  size_t my_block;
+  size_t num_finished_blocks = 0;
+
+  while ((my_block = atomic_fetch_add_explicit(&htab->next_init_block, 1,
+                                                memory_order_acquire))
+                                                    < num_new_blocks)
+    {
+      size_t group = my_block * INITIALIZATION_BLOCK_SIZE;
+      size_t group_end = MIN (group + INITIALIZATION_BLOCK_SIZE,
+			      new->ngroups);
+      for (; group < group_end; ++group)
+	atomic_init(&new->ctrl[group], LSBS * CTRL_EMPTY);
+
+      num_finished_blocks++;
+    }
+
+  atomic_fetch_add_explicit(&htab->num_initialized_blocks,
+                            num_finished_blocks, memory_order_release);
+  while (atomic_load_explicit(&htab->num_initialized_blocks,
+                              memory_order_acquire) != num_new_blocks);
+
+  /* All block are initialized, start moving */
+  num_finished_blocks = 0;
+  while ((my_block = atomic_fetch_add_explicit(&htab->next_move_block, 1,
+                                                memory_order_acquire))
+                                                    < num_old_blocks)
+    {
+      size_t group = my_block * MOVE_BLOCK_SIZE;
+      size_t group_end = MIN (group + MOVE_BLOCK_SIZE, old->ngroups);
+      for (; group < group_end; ++group)
+	{
+	  uint64_t word = atomic_load_explicit(&old->ctrl[group],
+					       memory_order_acquire);
+	  for (uint64_t m = ~word & MSBS; m != 0; m &= m - 1)
+	    {
+	      NAME_ENT (NAME) *ent = &old->ent[group * GROUP_SIZE
+					       + match_index (m)];
+	      insert_helper(new, ent->hashval, ent->val);
+	    }
+	}
+
+      num_finished_blocks++;
+    }
+
+  atomic_fetch_add_explicit(&htab->num_moved_blocks, num_finished_blocks,
+                            memory_order_release);
+
+  /* The coordinating thread will block here waiting for all blocks to
+     be moved.  */
+  if (blocking)
+      while (atomic_load_explicit(&htab->num_moved_blocks,
+                                  memory_order_acquire) != num_old_blocks);
+}
+
+/* Called by the main thread holding the htab->resize_rwl lock to
+   coordinate the moving of hash table data.  Allocates the new hash
+   table and makes it the current one when moving all data is done.
+   Readers might still use the old table, so it is only freed together
+   with the hash table.  */
+static void
+resize_coordinator(NAME *htab)
+{
+  NAME_TABLE (NAME) *old = (NAME_TABLE (NAME) *)
+    atomic_load_explicit(&htab->table, memory_order_relaxed);
+  htab->new_table = alloc_table(old->ngroups * 2);
+  assert(htab->new_table);
+  htab->new_table->retired = old;
+
+  /* Change state from ALLOCATING_MEMORY to MOVING_DATA */
+  atomic_fetch_xor_explicit(&htab->resizing_state,
+                            ALLOCATING_MEMORY ^ MOVING_DATA,
+                            memory_order_release);
+
+  resize_helper(htab, 1);
+
+  /* Change state from MOVING_DATA to CLEANING */
+  size_t resize_state = atomic_fetch_xor_explicit(&htab->resizing_state,
+                                                  MOVING_DATA ^ CLEANING,
+                                                  memory_order_acq_rel);
+  while (GET_ACTIVE_WORKERS(resize_state) != 0)
+      resize_state = atomic_load_explicit(&htab->resizing_state,
+                                          memory_order_acquire);
+
+  /* There are no more active workers */
+  atomic_store_explicit(&htab->next_init_block, 0, memory_order_relaxed);
+  atomic_store_explicit(&htab->num_initialized_blocks, 0,
+                        memory_order_relaxed);
+
+  atomic_store_explicit(&htab->next_move_block, 0, memory_order_relaxed);
+  atomic_store_explicit(&htab->num_moved_blocks, 0, memory_order_relaxed);
+
+  atomic_store_explicit(&htab->table, (uintptr_t) htab->new_table,
+			memory_order_release);
+  htab->new_table = NULL;
+
+  /* Change state to NO_RESIZING */
+  atomic_fetch_xor_explicit(&htab->resizing_state, CLEANING ^ NO_RESIZING,
+                            memory_order_relaxed);
+
+}
+#else
 /* Initializes records and copies the data from the old table.
    It can share work with other threads.  Only the coordinator
    will pass blocking as 1, other worker threads pass 0.  */
@@ -295,6 +561,7 @@ resize_coordinator(NAME *htab)
                             memory_order_relaxed);
 
 }
+#endif
 
 /* Called by any thread that wants to do an insert or find operation
    but notices it cannot get the htab->resize_rwl lock because another
@@ -349,11 +616,28 @@ int
   name##_init
 INIT(NAME) (NAME *htab, size_t init_size)
 {
+#ifdef SWISS
+  /* Round up to a power of two number of groups which holds INIT_SIZE
+     entries without resizing.  */
+  size_t ngroups = 1;
+  while (7 * ngroups < init_size)
+    ngroups *= 2;
+
+  NAME_TABLE (NAME) *t = alloc_table (ngroups);
+  if (t == NULL)
+    return -1;
+  for (size_t i = 0; i < ngroups; i++)
+    atomic_init(&t->ctrl[i], LSBS * CTRL_EMPTY);
+
+  atomic_init(&htab->table, (uintptr_t) t);
+  htab->new_table = NULL;
+#else
   /* We need the size to be a prime.  */
   init_size = next_prime (init_size);
 
   /* Initialize the data structure.  */
   htab->size = init_size;
+#endif
   atomic_init(&htab->filled, 0);
   atomic_init(&htab->resizing_state, 0);
 
@@ -365,6 +649,7 @@ INIT(NAME) (NAME *htab, size_t init_size)
 
   pthread_rwlock_init(&htab->resize_rwl, NULL);
 
+#ifndef SWISS
   htab->table = malloc ((init_size + 1) * sizeof (htab->table[0]));
   if (htab->table == NULL)
       return -1;
@@ -374,6 +659,7 @@ INIT(NAME) (NAME *htab, size_t init_size)
       atomic_init(&htab->table[i].hashval, (uintptr_t) NULL);
       atomic_init(&htab->table[i].val_ptr, (uintptr_t) NULL);
     }
+#endif
 
   return 0;
 }
@@ -386,7 +672,18 @@ name##_free
 FREE(NAME) (NAME *htab)
 {
   pthread_rwlock_destroy(&htab->resize_rwl);
+#ifdef SWISS
+  NAME_TABLE (NAME) *t = (NAME_TABLE (NAME) *)
+    atomic_load_explicit(&htab->table, memory_order_relaxed);
+  while (t != NULL)
+    {
+      NAME_TABLE (NAME) *retired = t->retired;
+      free (t);
+      t = retired;
+    }
+#else
   free (htab->table);
+#endif
   return 0;
 }
 
@@ -398,6 +695,9 @@ name##_insert
 INSERT(NAME) (NAME *htab, HASHTYPE hval, TYPE data)
 {
   int incremented = 0;
+#ifdef SWISS
+  NAME_TABLE (NAME) *t;
+#endif
 
   for(;;)
     {
@@ -420,9 +720,16 @@ INSERT(NAME) (NAME *htab, HASHTYPE hval, TYPE data)
         }
 
 
+#ifdef SWISS
+      t = (NAME_TABLE (NAME) *) atomic_load_explicit(&htab->table,
+                                                     memory_order_acquire);
+      if (8 * filled > 7 * GROUP_SIZE * t->ngroups)
+#else
       if (100 * filled > 90 * htab->size)
+#endif
         {
-          /* Table is filled more than 90%.  Resize the table.  */
+          /* Table is filled more than 90% (87.5% for SWISS).  Resize
+             the table.  */
 
           size_t resizing_state = atomic_load_explicit(&htab->resizing_state,
                                                         memory_order_acquire);
@@ -455,7 +762,11 @@ INSERT(NAME) (NAME *htab, HASHTYPE hval, TYPE data)
         }
     }
 
+#ifdef SWISS
+  int ret_val = insert_helper(t, hval, data);
+#else
   int ret_val = insert_helper(htab, hval, data);
+#endif
   if (ret_val == -1)
       atomic_fetch_sub_explicit(&htab->filled, 1, memory_order_relaxed);
   pthread_rwlock_unlock(&htab->resize_rwl);
@@ -470,6 +781,13 @@ TYPE
   name##_find
 FIND(NAME) (NAME *htab, HASHTYPE hval)
 {
+#ifdef SWISS
+  /* Readers need no lock.  A table replaced while we search it stays
+     valid and holds everything inserted before the search started.  */
+  NAME_TABLE (NAME) *t = (NAME_TABLE (NAME) *)
+    atomic_load_explicit(&htab->table, memory_order_acquire);
+  return lookup(t, hval);
+#else
   /* If we cannot get the resize_rwl lock someone is resizing
      the hash table, try to help out by moving table data.  */
   while (pthread_rwlock_tryrdlock(&htab->resize_rwl) != 0)
@@ -493,4 +811,5 @@ FIND(NAME) (NAME *htab, HASHTYPE hval)
 
   pthread_rwlock_unlock(&htab->resize_rwl);
   return ret_val;
+#endif
 }
@@ -28,6 +28,7 @@
    not, see <http://www.gnu.org/licenses/>.  */
 
 #include <stddef.h>
+#include <stdint.h>
 #include <pthread.h>
 #include "atomics.h"
 /* Before including this file the following macros must be defined:
@@ -39,6 +40,9 @@
 
    ITERATE   iterating over the table entries is possible
    HASHTYPE  integer type for hash values, default unsigned long int
+   SWISS     use a power-of-two sized table with a control byte per
+	     entry, probed a group of eight entries at a time, which
+	     readers search without taking a lock
  */
 
 
@@ -55,6 +59,52 @@
 extern size_t next_prime (size_t seed);
 
 
+#ifdef SWISS
+/* Table entry type.  An entry is only read after loading the control
+   byte which marks it as used, so it need not be atomic.  */
+#define _DYNHASHCONENTTYPE(name)       \
+  typedef struct name##_ent         \
+  {                                 \
+    HASHTYPE hashval;               \
+    TYPE val;                       \
+  } name##_ent
+#define DYNHASHENTTYPE(name) _DYNHASHCONENTTYPE (name)
+DYNHASHENTTYPE (NAME);
+
+/* One generation of the table.  CTRL has one word per group of eight
+   entries, holding a control byte for each of them.  Tables replaced
+   by a bigger one are kept on the RETIRED list until the hash table is
+   freed since readers might still use them.  */
+#define _DYNHASHCONTABTYPE(name)                    \
+typedef struct name##_table                         \
+{                                                   \
+  size_t ngroups;                                   \
+  atomic_uint_least64_t *ctrl;                      \
+  name##_ent *ent;                                  \
+  struct name##_table *retired;                     \
+} name##_table
+#define DYNHASHTABTYPE(name) _DYNHASHCONTABTYPE (name)
+DYNHASHTABTYPE (NAME);
+
+/* Type of the dynamic hash table data structure.  TABLE is the
+   current generation, NEW_TABLE the one being filled while
+   resizing.  */
+#define _DYNHASHCONTYPE(name) \
+typedef struct                                     \
+{                                                  \
+  atomic_uintptr_t table;                          \
+  name##_table *new_table;                         \
+  atomic_size_t filled;                            \
+  atomic_size_t resizing_state;                    \
+  atomic_size_t next_init_block;                   \
+  atomic_size_t num_initialized_blocks;            \
+  atomic_size_t next_move_block;                   \
+  atomic_size_t num_moved_blocks;                  \
+  pthread_rwlock_t resize_rwl;                     \
+} name
+#define DYNHASHTYPE(name) _DYNHASHCONTYPE (name)
+DYNHASHTYPE (NAME);
+#else
 /* Table entry type.  */
 #define _DYNHASHCONENTTYPE(name)       \
   typedef struct name##_ent         \
@@ -83,6 +133,7 @@ typedef struct                                     \
 } name
 #define DYNHASHTYPE(name) _DYNHASHCONTYPE (name)
 DYNHASHTYPE (NAME);
+#endif
 
 
 
@@ -105,6 +156,10 @@ FUNCTIONS (NAME)
 #ifndef NO_UNDEF
 # undef DYNHASHENTTYPE
 # undef DYNHASHTYPE
+# undef DYNHASHTABTYPE
+# undef _DYNHASHCONENTTYPE
+# undef _DYNHASHCONTABTYPE
+# undef _DYNHASHCONTYPE
 # undef FUNCTIONS
 # undef _FUNCTIONS
 # undef XFUNCTIONS
@@ -115,4 +170,5 @@ FUNCTIONS (NAME)
 # undef COMPARE
 # undef FIRST
 # undef NEXT
+# undef SWISS
 #endif
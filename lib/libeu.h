@@ -43,6 +43,7 @@ extern char *xasprintf(const char *fmt, ...)
 	__attribute__ ((format (printf, 1, 2))) __attribute__ ((__malloc__));
 
 extern uint32_t crc32 (uint32_t crc, unsigned char *buf, size_t len);
+extern uint32_t crc32_combine (uint32_t crc1, uint32_t crc2, uint64_t len2);
 extern int crc32_file (int fd, uint32_t *resp);
 
 #endif
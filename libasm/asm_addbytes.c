@@ -0,0 +1,79 @@
+/* Add a block of raw bytes to a section.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of either
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at
+       your option) any later version
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at
+       your option) any later version
+
+   or both in parallel, as here.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <string.h>
+
+#include <libasmP.h>
+
+
+int
+asm_addbytes (AsmScn_t *asmscn, const void *bytes, size_t len)
+{
+  if (asmscn == NULL)
+    return -1;
+
+  if (unlikely (asmscn->ctx->textp))
+    {
+      for (size_t cnt = 0; cnt < len; ++cnt)
+	if (INTUSE(asm_addint8) (asmscn, ((const int8_t *) bytes)[cnt]) != 0)
+	  return -1;
+      return 0;
+    }
+
+  if (asmscn->type == SHT_NOBITS)
+    {
+      /* Only zeros can be added to a NOBITS section.  */
+      for (size_t cnt = 0; cnt < len; ++cnt)
+	if (unlikely (((const char *) bytes)[cnt] != '\0'))
+	  {
+	    __libasm_seterrno (ASM_E_TYPE);
+	    return -1;
+	  }
+    }
+
+  if (len == 0)
+    return 0;
+
+  /* Make sure we have enough room.  */
+  if (__libasm_ensure_section_space (asmscn, len) != 0)
+    return -1;
+
+  if (asmscn->type != SHT_NOBITS)
+    memcpy (&asmscn->content->data[asmscn->content->len], bytes, len);
+
+  /* Adjust the pointer in the data buffer.  */
+  asmscn->content->len += len;
+
+  /* Increment the offset in the (sub)section.  */
+  asmscn->offset += len;
+
+  return 0;
+}
@@ -0,0 +1,113 @@
+/* Add an array of integers in target byte order to a section.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of either
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at
+       your option) any later version
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at
+       your option) any later version
+
+   or both in parallel, as here.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <byteswap.h>
+#include <endian.h>
+#include <string.h>
+
+#include <libasmP.h>
+
+#ifndef SIZE
+# define SIZE 16
+#endif
+
+#define VFCT(size) _VFCT(size)
+#define _VFCT(size) asm_adduint##size##v
+#define FCT(size) _FCT(size)
+#define _FCT(size) asm_addint##size
+#define UTYPE(size) _UTYPE(size)
+#define _UTYPE(size) uint##size##_t
+#define TYPE(size) _TYPE(size)
+#define _TYPE(size) int##size##_t
+#define BSWAP(size) _BSWAP(size)
+#define _BSWAP(size) bswap_##size
+
+
+int
+VFCT(SIZE) (AsmScn_t *asmscn, const UTYPE(SIZE) *nums, size_t n)
+{
+  if (asmscn == NULL)
+    return -1;
+
+  if (unlikely (asmscn->ctx->textp))
+    {
+      for (size_t cnt = 0; cnt < n; ++cnt)
+	if (INTUSE(FCT(SIZE)) (asmscn, (TYPE(SIZE)) nums[cnt]) != 0)
+	  return -1;
+      return 0;
+    }
+
+  if (asmscn->type == SHT_NOBITS)
+    {
+      /* Only zeros can be added to a NOBITS section.  */
+      for (size_t cnt = 0; cnt < n; ++cnt)
+	if (unlikely (nums[cnt] != 0))
+	  {
+	    __libasm_seterrno (ASM_E_TYPE);
+	    return -1;
+	  }
+    }
+
+  if (n == 0)
+    return 0;
+
+  size_t len = n * (SIZE / 8);
+
+  /* Make sure we have enough room.  */
+  if (__libasm_ensure_section_space (asmscn, len) != 0)
+    return -1;
+
+  if (asmscn->type != SHT_NOBITS)
+    {
+      char *dest = &asmscn->content->data[asmscn->content->len];
+      bool is_leb = (elf_getident (asmscn->ctx->out.elf, NULL)[EI_DATA]
+		     == ELFDATA2LSB);
+
+      if ((BYTE_ORDER == LITTLE_ENDIAN) == is_leb)
+	memcpy (dest, nums, len);
+      else
+	/* A simple loop the compiler can vectorize.  The destination
+	   need not be aligned.  */
+	for (size_t cnt = 0; cnt < n; ++cnt)
+	  {
+	    UTYPE(SIZE) var = BSWAP(SIZE) (nums[cnt]);
+	    memcpy (dest + cnt * (SIZE / 8), &var, SIZE / 8);
+	  }
+    }
+
+  /* Adjust the pointer in the data buffer.  */
+  asmscn->content->len += len;
+
+  /* Increment the offset in the (sub)section.  */
+  asmscn->offset += len;
+
+  return 0;
+}
@@ -134,38 +134,39 @@ int
 internal_function
 __libasm_ensure_section_space (AsmScn_t *asmscn, size_t len)
 {
-  /* The blocks with the section content are kept in a circular
-     single-linked list.  */
-  size_t size;
-
   if (asmscn->content == NULL)
-    {
-      /* This is the first block.  */
-      size = MAX (2 * len, 960);
+    /* This is the first block.  */
+    return __libasm_new_section_block (asmscn, MAX (2 * len, 960));
 
-      asmscn->content = calloc (1, sizeof (struct AsmData) + size);
-      if (asmscn->content == NULL)
-	return -1;
+  if (asmscn->content->maxlen - asmscn->content->len >= len)
+    /* Nothing to do, there is enough space.  */
+    return 0;
 
-      asmscn->content->next = asmscn->content;
-    }
-  else
-    {
-      struct AsmData *newp;
-
-      if (asmscn->content->maxlen - asmscn->content->len >= len)
-	/* Nothing to do, there is enough space.  */
-	return 0;
+  return __libasm_new_section_block (asmscn,
+				     MAX (2 *len,
+					  MIN (32768, 2 * asmscn->offset)));
+}
 
-      size = MAX (2 *len, MIN (32768, 2 * asmscn->offset));
 
-      newp = calloc (1, sizeof (struct AsmData) + size);
-      if (newp == NULL)
-	return -1;
+/* Append a new block of SIZE bytes to the content of ASMSCN.  */
+int
+internal_function
+__libasm_new_section_block (AsmScn_t *asmscn, size_t size)
+{
+  /* The blocks with the section content are kept in a circular
+     single-linked list.  */
+  struct AsmData *newp = calloc (1, sizeof (struct AsmData) + size);
+  if (newp == NULL)
+    return -1;
 
+  if (asmscn->content == NULL)
+    newp->next = newp;
+  else
+    {
       newp->next = asmscn->content->next;
-      asmscn->content = asmscn->content->next = newp;
+      asmscn->content->next = newp;
     }
+  asmscn->content = newp;
 
   asmscn->content->len = 0;
   asmscn->content->maxlen = size;
@@ -167,6 +167,11 @@ asm_begin (const char *fname, Ebl *ebl, bool textp)
   /* Initialize the counter for temporary symbols.  */
   result->tempsym_count = 0;
 
+  /* No section was flushed so far.  */
+  result->spill_fd = -1;
+  result->spill_size = 0;
+  result->spill_map = NULL;
+
   /* Now we differentiate between textual and binary output.   */
   result->textp = textp;
   if (textp)
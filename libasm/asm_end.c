@@ -35,6 +35,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 
 #include <libasmP.h>
@@ -78,6 +79,19 @@ binary_end (AsmCtx_t *ctx)
   AsmScn_t *asmscn;
   int result = 0;
 
+  /* The content of flushed sections is read from the spill file.  */
+  if (ctx->spill_size > 0)
+    {
+      ctx->spill_map = mmap (NULL, ctx->spill_size, PROT_READ | PROT_WRITE,
+			     MAP_PRIVATE, ctx->spill_fd, 0);
+      if (ctx->spill_map == MAP_FAILED)
+	{
+	  ctx->spill_map = NULL;
+	  __libasm_seterrno (ASM_E_IOERROR);
+	  return -1;
+	}
+    }
+
   /* Iterate over the created sections and compute the offsets of the
      various subsections and fill in the content.  */
   for (asmscn = ctx->section_list; asmscn != NULL; asmscn = asmscn->allnext)
@@ -102,10 +116,13 @@ binary_end (AsmCtx_t *ctx)
 	     stores the offset of the first by in this subsection.  */
 	  asmsubscn->offset = offset;
 
-	  /* Note that the content list is circular.  */
+	  /* Note that the content list is circular and CONTENT points to
+	     the last block.  */
 	  if (content != NULL)
 	    do
 	      {
+		content = content->next;
+
 		Elf_Data *newdata = elf_newdata (scn);
 
 		if (newdata == NULL)
@@ -114,15 +131,18 @@ binary_end (AsmCtx_t *ctx)
 		    return -1;
 		  }
 
-		newdata->d_buf = content->data;
+		newdata->d_buf = (content->flushed
+				  ? ctx->spill_map + content->spill_off
+				  : content->data);
 		newdata->d_type = ELF_T_BYTE;
 		newdata->d_size = content->len;
 		newdata->d_off = offset;
 		newdata->d_align = first ? asmsubscn->max_align : 1;
+		first = false;
 
 		offset += content->len;
 	      }
-	    while ((content = content->next) != asmsubscn->content);
+	    while (content != asmsubscn->content);
 	}
       while ((asmsubscn = asmsubscn->subnext) != NULL);
     }
@@ -606,6 +626,12 @@ __libasm_finictx (AsmCtx_t *ctx)
       /* And the string tables.  */
       dwelf_strtab_free (ctx->section_strtab);
       dwelf_strtab_free (ctx->symbol_strtab);
+
+      /* The content of flushed sections.  */
+      if (ctx->spill_map != NULL)
+	(void) munmap (ctx->spill_map, ctx->spill_size);
+      if (ctx->spill_fd != -1)
+	(void) close (ctx->spill_fd);
     }
 
   /* Initialize the lock.  */
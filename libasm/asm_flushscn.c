@@ -0,0 +1,181 @@
+/* Move the content of a finished section out of memory.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of either
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at
+       your option) any later version
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at
+       your option) any later version
+
+   or both in parallel, as here.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <libasmP.h>
+#include <system.h>
+
+
+/* Create the spill file next to the output file.  It is unlinked right
+   away, it only lives as long as the descriptor.  */
+static int
+open_spill_file (AsmCtx_t *ctx)
+{
+  size_t fname_len = strlen (ctx->fname);
+  char *tmpname = malloc (fname_len + sizeof (".XXXXXX"));
+  if (tmpname == NULL)
+    {
+      __libasm_seterrno (ASM_E_NOMEM);
+      return -1;
+    }
+  strcpy (mempcpy (tmpname, ctx->fname, fname_len), ".XXXXXX");
+
+  ctx->spill_fd = mkstemp (tmpname);
+  if (ctx->spill_fd != -1)
+    (void) unlink (tmpname);
+  free (tmpname);
+
+  if (ctx->spill_fd == -1)
+    {
+      __libasm_seterrno (ASM_E_CANNOT_CREATE);
+      return -1;
+    }
+
+  return 0;
+}
+
+
+/* Write the content blocks of the subsection ASMSCN to the spill file
+   and replace them with flushed blocks.  */
+static int
+flush_subsection (AsmScn_t *asmscn)
+{
+  AsmCtx_t *ctx = asmscn->ctx;
+  int result = 0;
+
+  if (asmscn->content == NULL)
+    return 0;
+
+  /* Rebuild the circular list, the first block follows the last.
+     Blocks are freed or reallocated on the way, so count them first.  */
+  size_t nblocks = 0;
+  struct AsmData *runp = asmscn->content;
+  do
+    ++nblocks;
+  while ((runp = runp->next) != asmscn->content);
+
+  struct AsmData *newfirst = NULL;
+  struct AsmData *last = NULL;
+  runp = asmscn->content->next;
+  while (nblocks-- > 0)
+    {
+      struct AsmData *next = runp->next;
+
+      if (! runp->flushed && result == 0)
+	{
+	  if (pwrite_retry (ctx->spill_fd, runp->data, runp->len,
+			    ctx->spill_size) != (ssize_t) runp->len)
+	    {
+	      __libasm_seterrno (ASM_E_IOERROR);
+	      result = -1;
+	    }
+	  else if (last != NULL && last->flushed
+		   && last->spill_off + (off_t) last->len == ctx->spill_size)
+	    {
+	      /* Extend the previous block.  */
+	      last->len += runp->len;
+	      last->maxlen = last->len;
+	      ctx->spill_size += runp->len;
+	      free (runp);
+	      runp = NULL;
+	    }
+	  else
+	    {
+	      /* Keep only the header.  Failing to shrink is harmless.  */
+	      struct AsmData *newp = realloc (runp, sizeof (struct AsmData));
+	      if (newp != NULL)
+		runp = newp;
+	      runp->flushed = true;
+	      runp->spill_off = ctx->spill_size;
+	      runp->maxlen = runp->len;
+	      ctx->spill_size += runp->len;
+	    }
+	}
+
+      if (runp != NULL)
+	{
+	  if (newfirst == NULL)
+	    newfirst = runp;
+	  else
+	    last->next = runp;
+	  last = runp;
+	}
+
+      runp = next;
+    }
+
+  /* The first block is never merged away.  */
+  assert (last != NULL);
+  last->next = newfirst;
+  asmscn->content = last;
+
+  return result;
+}
+
+
+int
+asm_flushscn (AsmScn_t *asmscn)
+{
+  if (asmscn == NULL)
+    /* An earlier error.  */
+    return -1;
+
+  AsmCtx_t *ctx = asmscn->ctx;
+  if (unlikely (ctx->textp))
+    /* Text output is written right away.  */
+    return 0;
+
+  /* Flush all subsections of the section.  */
+  if (asmscn->subsection_id != 0)
+    asmscn = asmscn->data.up;
+
+  if (asmscn->type == SHT_NOBITS)
+    /* There is nothing to write.  */
+    return 0;
+
+  rwlock_wrlock (ctx->lock);
+
+  int result = 0;
+  if (ctx->spill_fd == -1)
+    result = open_spill_file (ctx);
+
+  for (; result == 0 && asmscn != NULL; asmscn = asmscn->subnext)
+    result = flush_subsection (asmscn);
+
+  rwlock_unlock (ctx->lock);
+
+  return result;
+}
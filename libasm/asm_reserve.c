@@ -0,0 +1,60 @@
+/* Reserve space for the content of a section.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of either
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at
+       your option) any later version
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at
+       your option) any later version
+
+   or both in parallel, as here.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <libasmP.h>
+
+
+int
+asm_reserve (AsmScn_t *asmscn, size_t len)
+{
+  if (asmscn == NULL)
+    /* An earlier error.  */
+    return -1;
+
+  if (unlikely (asmscn->ctx->textp) || len == 0)
+    return 0;
+
+  rwlock_wrlock (asmscn->ctx->lock);
+
+  /* Allocate exactly the requested size, the caller knows best.  */
+  int result = 0;
+  if (asmscn->content == NULL
+      || asmscn->content->maxlen - asmscn->content->len < len)
+    {
+      result = __libasm_new_section_block (asmscn, len);
+      if (result != 0)
+	__libasm_seterrno (ASM_E_NOMEM);
+    }
+
+  rwlock_unlock (asmscn->ctx->lock);
+
+  return result;
+}
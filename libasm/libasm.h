@@ -63,6 +63,59 @@ typedef int (*DisasmGetSymCB_t) (GElf_Addr, Elf32_Word, GElf_Addr, char **,
 typedef int (*DisasmOutputCB_t) (char *, size_t, void *);
 
 
+/* Control flow class of a decoded instruction.  */
+typedef enum
+  {
+    DISASM_INSN_OTHER = 0,	/* Execution continues with the next insn.  */
+    DISASM_INSN_JUMP,		/* Unconditional jump.  */
+    DISASM_INSN_COND_JUMP,	/* Conditional jump.  */
+    DISASM_INSN_CALL,		/* Subroutine call.  */
+    DISASM_INSN_RETURN,		/* Return from subroutine or interrupt.  */
+    DISASM_INSN_INVALID		/* Bytes do not form a valid instruction.  */
+  } DisasmInsnClass;
+
+/* Kind of an operand of a decoded instruction.  */
+typedef enum
+  {
+    DISASM_OP_NONE = 0,
+    DISASM_OP_REG,		/* Register.  */
+    DISASM_OP_IMM,		/* Immediate, VALUE is the constant.  */
+    DISASM_OP_MEM,		/* Memory reference relative to registers,
+				   VALUE is the displacement.  */
+    DISASM_OP_MEMADDR,		/* Memory reference at a known address
+				   (absolute or PC-relative), VALUE is the
+				   address.  */
+    DISASM_OP_TARGET		/* Direct branch or call target, VALUE is
+				   the address.  */
+  } DisasmOpKind;
+
+/* Maximum number of operands reported for one instruction.  */
+#define DISASM_MAX_OPS 4
+
+/* Result of decoding a single instruction with disasm_decode.  */
+typedef struct
+{
+  /* Number of bytes used by the instruction, including prefixes.  */
+  unsigned int length;
+  /* Control flow class.  */
+  DisasmInsnClass insn_class;
+  /* NUL-terminated mnemonic.  */
+  char mnemonic[16];
+  /* Target address of a direct jump or call, valid if HAS_TARGET.  */
+  bool has_target;
+  GElf_Addr target;
+  /* Set if one of the operands references memory.  */
+  bool has_memop;
+  /* Operands in the order of the instruction encoding.  */
+  unsigned int nops;
+  struct
+  {
+    DisasmOpKind kind;
+    int64_t value;
+  } ops[DISASM_MAX_OPS];
+} DisasmInsn;
+
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -134,6 +187,22 @@ extern int asm_addint64 (AsmScn_t *asmscn, int64_t num);
 extern int asm_adduint64 (AsmScn_t *asmscn, uint64_t num);
 
 
+/* Add LEN bytes starting at BYTES to (sub)section ASMSCN.  */
+extern int asm_addbytes (AsmScn_t *asmscn, const void *bytes, size_t len);
+
+/* Add the N 16-bit unsigned integers in NUMS to (sub)section ASMSCN,
+   converted to the byte order of the output file.  */
+extern int asm_adduint16v (AsmScn_t *asmscn, const uint16_t *nums, size_t n);
+
+/* Add the N 32-bit unsigned integers in NUMS to (sub)section ASMSCN,
+   converted to the byte order of the output file.  */
+extern int asm_adduint32v (AsmScn_t *asmscn, const uint32_t *nums, size_t n);
+
+/* Add the N 64-bit unsigned integers in NUMS to (sub)section ASMSCN,
+   converted to the byte order of the output file.  */
+extern int asm_adduint64v (AsmScn_t *asmscn, const uint64_t *nums, size_t n);
+
+
 /* Add signed little endian base 128 integer NUM to (sub)section ASMSCN.  */
 extern int asm_addsleb128 (AsmScn_t *asmscn, int32_t num);
 
@@ -162,6 +231,15 @@ extern int asm_align (AsmScn_t *asmscn, GElf_Word value);
 /* Set the byte pattern used to fill gaps created by alignment.  */
 extern int asm_fill (AsmScn_t *asmscn, void *bytes, size_t len);
 
+/* Make room for LEN more bytes in (sub)section ASMSCN, so that adding
+   that much content does not need further allocations.  */
+extern int asm_reserve (AsmScn_t *asmscn, size_t len);
+
+/* Declare the content of section ASMSCN and all its subsections added
+   so far as final.  It is moved to a temporary file and no longer kept
+   in memory.  More content can still be added afterwards.  */
+extern int asm_flushscn (AsmScn_t *asmscn);
+
 
 /* Return ELF descriptor created for the output file of the given context.  */
 extern Elf *asm_getelf (AsmCtx_t *ctx);
@@ -196,6 +274,16 @@ extern int disasm_cb (DisasmCtx_t *ctx, const uint8_t **startp,
 		      const uint8_t *end, GElf_Addr addr, const char *fmt,
 		      DisasmOutputCB_t outcb, void *outcbarg, void *symcbarg);
 
+/* Decode the instruction at *STARTP, which is located at ADDR, into
+   INSN without producing any text.  On success *STARTP is advanced past
+   the instruction and zero is returned.  Bytes which do not form a valid
+   instruction are reported with class DISASM_INSN_INVALID.  If no
+   complete instruction is available before END, or the backend has no
+   decoder, -1 is returned and *STARTP is unchanged.  */
+extern int disasm_decode (DisasmCtx_t *ctx, const uint8_t **startp,
+			  const uint8_t *end, GElf_Addr addr,
+			  DisasmInsn *insn);
+
 #ifdef __cplusplus
 }
 #endif
@@ -115,6 +115,11 @@ struct AsmScn
     /* Pointer to the next block.  */
     struct AsmData *next;
 
+    /* Set if the content was moved to the spill file by asm_flushscn.
+       DATA is then empty and the LEN bytes are at SPILL_OFF.  */
+    bool flushed;
+    off_t spill_off;
+
     /* The actual data.  */
     char data[flexarr_size];
   } *content;
@@ -182,6 +187,14 @@ struct AsmCtx
   /* Counter for temporary symbols.  */
   unsigned int tempsym_count;
 
+  /* Unlinked temporary file with the content of flushed sections, or
+     -1 if no section was flushed yet.  */
+  int spill_fd;
+  /* Number of bytes written to the spill file.  */
+  off_t spill_size;
+  /* Mapping of the spill file while the output is written.  */
+  char *spill_map;
+
   /* Name of the output file.  */
   char *fname;
   /* The name of the temporary file.  */
@@ -267,6 +280,10 @@ extern const struct FillPattern *__libasm_default_pattern
 extern int __libasm_ensure_section_space (AsmScn_t *asmscn, size_t len)
      internal_function;
 
+/* Append a new block of SIZE bytes to the content of ASMSCN.  */
+extern int __libasm_new_section_block (AsmScn_t *asmscn, size_t size)
+     internal_function;
+
 /* Free all resources associated with the assembler context.  */
 extern void __libasm_finictx (AsmCtx_t *ctx) internal_function;
 
@@ -87,6 +87,169 @@ bswap_bpf_insn (struct bpf_insn *p)
   CONVERT (p->imm);
 }
 
+/* Read the instruction at P in host byte order.  */
+static void
+read_bpf_insn (struct bpf_insn *i, const uint8_t *p, bool need_bswap)
+{
+  memcpy (i, p, sizeof (struct bpf_insn));
+  if (need_bswap)
+    bswap_bpf_insn (i);
+}
+
+/* How the fields of an instruction are used, both for the arguments
+   of its format and for the operands reported by bpf_disasm_decode.  */
+enum bpf_args
+  {
+    ARGS_INVALID = 0,
+    ARGS_EXIT,			/* No arguments.  */
+    ARGS_JA,			/* Target.  */
+    ARGS_CALL,			/* Imm.  */
+    ARGS_DST,			/* Dst.  */
+    ARGS_DST_IMM,		/* Dst, imm.  */
+    ARGS_DST_SRC,		/* Dst, src.  */
+    ARGS_DST_IMM_JMP,		/* Dst, imm, target.  */
+    ARGS_DST_SRC_JMP,		/* Dst, src, target.  */
+    ARGS_LOAD,			/* Dst, src, off.  */
+    ARGS_STORE_REG,		/* Dst, src, off.  */
+    ARGS_STORE_IMM,		/* Dst, imm, off.  */
+    ARGS_LD_ABS,		/* Imm.  */
+    ARGS_LD_IND,		/* Src, imm.  */
+    ARGS_LD_IMM64		/* Dst, the 64-bit imm, src.  */
+  };
+
+/* The one table of all known opcodes, indexed by the code byte.  */
+static const struct bpf_opcode
+{
+  const char *fmt;
+  char mnemonic[8];
+  unsigned char args;
+} bpf_opcodes[256] =
+  {
+#define OPC(CODE, FMT, MNE, ARGS)	[CODE] = { FMT, MNE, ARGS }
+    OPC (BPF_LD | BPF_IMM | BPF_DW, NULL, "lddw", ARGS_LD_IMM64),
+
+    OPC (BPF_JMP | BPF_EXIT, "exit", "exit", ARGS_EXIT),
+    OPC (BPF_JMP | BPF_JA, "goto " JMP(1), "ja", ARGS_JA),
+    OPC (BPF_JMP | BPF_CALL, "call " IMMS(1), "call", ARGS_CALL),
+
+    /* The imm field contains {16,32,64}.  */
+    OPC (BPF_ALU | BPF_END | BPF_TO_LE, REG(1) " = le" IMMS(2) "(" REG(1) ")",
+	 "le", ARGS_DST_IMM),
+    OPC (BPF_ALU | BPF_END | BPF_TO_BE, REG(1) " = be" IMMS(2) "(" REG(1) ")",
+	 "be", ARGS_DST_IMM),
+
+#define ALU(OP, MNE, FMT32K, FMT32X, FMT64K, FMT64X)			\
+    OPC (BPF_ALU | OP | BPF_K, FMT32K, MNE "32", ARGS_DST_IMM),		\
+    OPC (BPF_ALU | OP | BPF_X, FMT32X, MNE "32", ARGS_DST_SRC),		\
+    OPC (BPF_ALU64 | OP | BPF_K, FMT64K, MNE, ARGS_DST_IMM),		\
+    OPC (BPF_ALU64 | OP | BPF_X, FMT64X, MNE, ARGS_DST_SRC)
+#define ALUOP(OP, MNE, O, IMM32)					\
+    ALU (OP, MNE, A32(O, IMM32(2)), A32(O, REGU(2)),			\
+	 A64(O, IMMS(2)), A64(O, REG(2)))
+    ALUOP (BPF_ADD, "add", +, IMMS),
+    ALUOP (BPF_SUB, "sub", -, IMMS),
+    ALUOP (BPF_MUL, "mul", *, IMMS),
+    ALUOP (BPF_DIV, "div", /, IMMS),
+    ALUOP (BPF_OR, "or", |, IMMX),
+    ALUOP (BPF_AND, "and", &, IMMX),
+    ALUOP (BPF_LSH, "lsh", <<, IMMS),
+    ALUOP (BPF_RSH, "rsh", >>, IMMS),
+    ALUOP (BPF_MOD, "mod", %%, IMMS),
+    ALUOP (BPF_XOR, "xor", ^, IMMX),
+    ALU (BPF_MOV, "mov", REG(1) " = " IMMX(2), REG(1) " = " REGU(2),
+	 REG(1) " = " IMMS(2), REG(1) " = " REG(2)),
+    ALU (BPF_ARSH, "arsh",
+	 REG(1) " = (u32)((s32)" REG(1) " >> " IMMS(2) ")",
+	 REG(1) " = (u32)((s32)" REG(1) " >> " REG(2) ")",
+	 REG(1) " = (s64)" REG(1) " >> " IMMS(2),
+	 REG(1) " = (s64)" REG(1) " >> " REG(2)),
+#undef ALUOP
+#undef ALU
+
+    OPC (BPF_ALU | BPF_NEG, REG(1) " = (u32)-" REG(1), "neg32", ARGS_DST),
+    OPC (BPF_ALU64 | BPF_NEG, REG(1) " = -" REG(1), "neg", ARGS_DST),
+
+#define JCC(OP, MNE, O, DST, SRC)					\
+    OPC (BPF_JMP | OP | BPF_K, J64(DST(1), O, IMMS(2)), MNE,		\
+	 ARGS_DST_IMM_JMP),						\
+    OPC (BPF_JMP | OP | BPF_X, J64(DST(1), O, SRC(2)), MNE,		\
+	 ARGS_DST_SRC_JMP)
+    JCC (BPF_JEQ, "jeq", ==, REG, REG),
+    JCC (BPF_JGT, "jgt", >, REG, REG),
+    JCC (BPF_JGE, "jge", >=, REG, REG),
+    JCC (BPF_JSET, "jset", &, REG, REG),
+    JCC (BPF_JNE, "jne", !=, REG, REG),
+    JCC (BPF_JSGT, "jsgt", >, REGS, REGS),
+    JCC (BPF_JSGE, "jsge", >=, REGS, REGS),
+    JCC (BPF_JLT, "jlt", <, REG, REG),
+    JCC (BPF_JLE, "jle", <=, REG, REG),
+    JCC (BPF_JSLT, "jslt", <, REGS, REGS),
+    JCC (BPF_JSLE, "jsle", <=, REGS, REGS),
+#undef JCC
+
+#define MEM(SIZE, T, SUFFIX)						\
+    OPC (BPF_LDX | BPF_MEM | SIZE, LOAD(T), "ldx" SUFFIX, ARGS_LOAD),	\
+    OPC (BPF_STX | BPF_MEM | SIZE, STORE(T, REG(2)), "stx" SUFFIX,	\
+	 ARGS_STORE_REG),						\
+    OPC (BPF_ST | BPF_MEM | SIZE, STORE(T, IMMS(2)), "st" SUFFIX,	\
+	 ARGS_STORE_IMM)
+    MEM (BPF_B, u8, "b"),
+    MEM (BPF_H, u16, "h"),
+    MEM (BPF_W, u32, "w"),
+    MEM (BPF_DW, u64, "dw"),
+#undef MEM
+
+    OPC (BPF_STX | BPF_XADD | BPF_W, XADD(u32, REG(2)), "xaddw",
+	 ARGS_STORE_REG),
+    OPC (BPF_STX | BPF_XADD | BPF_DW, XADD(u64, REG(2)), "xadddw",
+	 ARGS_STORE_REG),
+
+#define LDSKB_OPS(SIZE, T, SUFFIX)					\
+    OPC (BPF_LD | BPF_ABS | SIZE, LDSKB(T, IMMS(1)), "ldabs" SUFFIX,	\
+	 ARGS_LD_ABS),							\
+    OPC (BPF_LD | BPF_IND | SIZE, LDSKB(T, REG(1) "+" IMMS(2)),	\
+	 "ldind" SUFFIX, ARGS_LD_IND)
+    LDSKB_OPS (BPF_B, u8, "b"),
+    LDSKB_OPS (BPF_H, u16, "h"),
+    LDSKB_OPS (BPF_W, u32, "w"),
+#undef LDSKB_OPS
+#undef OPC
+  };
+
+/* One instruction, as looked up in bpf_opcodes.  */
+struct bpf_decoded
+{
+  struct bpf_insn i;
+  const struct bpf_opcode *op;	/* NULL if invalid.  */
+  uint64_t imm64;		/* For ARGS_LD_IMM64.  */
+  GElf_Addr jmp;
+  unsigned int length;
+};
+
+/* Decode the instruction at START for ADDR.  Returns false if the
+   second half of a 16-byte instruction is missing.  */
+static bool
+bpf_decode (const uint8_t *start, const uint8_t *end, GElf_Addr addr,
+	    bool need_bswap, struct bpf_decoded *d)
+{
+  read_bpf_insn (&d->i, start, need_bswap);
+  d->length = sizeof (struct bpf_insn);
+  d->jmp = addr + sizeof (struct bpf_insn) + d->i.off * sizeof (struct bpf_insn);
+  d->op = &bpf_opcodes[d->i.code];
+  if (d->op->args == ARGS_INVALID)
+    d->op = NULL;
+  else if (d->op->args == ARGS_LD_IMM64)
+    {
+      struct bpf_insn i2;
+      if (start + 2 * sizeof (struct bpf_insn) > end)
+	return false;
+      read_bpf_insn (&i2, start + sizeof (struct bpf_insn), need_bswap);
+      d->length += sizeof (struct bpf_insn);
+      d->imm64 = (uint32_t) d->i.imm | ((uint64_t) i2.imm << 32);
+    }
+  return true;
+}
+
 int
 bpf_disasm (Ebl *ebl, const uint8_t **startp, const uint8_t *end,
 	    GElf_Addr addr, const char *fmt __attribute__((unused)),
@@ -102,403 +265,190 @@ bpf_disasm (Ebl *ebl, const uint8_t **startp, const uint8_t *end,
 
   while (start + sizeof(struct bpf_insn) <= end)
     {
-      struct bpf_insn i;
-      unsigned code, class, jmp;
-      const char *code_fmt;
+      struct bpf_decoded d;
+      if (! bpf_decode (start, end, addr, need_bswap, &d))
+	break;
 
-      memcpy(&i, start, sizeof(struct bpf_insn));
-      if (need_bswap)
-	bswap_bpf_insn (&i);
+      start += d.length;
+      addr += d.length;
 
-      start += sizeof(struct bpf_insn);
-      addr += sizeof(struct bpf_insn);
-      jmp = addr + i.off * sizeof(struct bpf_insn);
-
-      code = i.code;
-      switch (code)
+      const struct bpf_insn *i = &d.i;
+      const char *code_fmt = d.op == NULL ? NULL : d.op->fmt;
+      switch (d.op == NULL ? ARGS_INVALID : d.op->args)
 	{
-	case BPF_LD | BPF_IMM | BPF_DW:
-	  {
-	    struct bpf_insn i2;
-	    uint64_t imm64;
-
-	    if (start + sizeof(struct bpf_insn) > end)
-	      {
-		start -= sizeof(struct bpf_insn);
-		*startp = start;
-		goto done;
-	      }
-	    memcpy(&i2, start, sizeof(struct bpf_insn));
-	    if (need_bswap)
-	      bswap_bpf_insn (&i2);
-	    start += sizeof(struct bpf_insn);
-	    addr += sizeof(struct bpf_insn);
-
-	    imm64 = (uint32_t)i.imm | ((uint64_t)i2.imm << 32);
-	    switch (i.src_reg)
-	      {
-	      case 0:
-		code_fmt = REG(1) " = %2$#" PRIx64;
-		break;
-	      case BPF_PSEUDO_MAP_FD:
-		code_fmt = REG(1) " = map_fd(%2$#" PRIx64 ")";
-		break;
-	      default:
-		code_fmt = REG(1) " = ld_pseudo(%3$d, %2$#" PRIx64 ")";
-		break;
-	      }
-	    len = snprintf(buf, sizeof(buf), code_fmt,
-			   i.dst_reg, imm64, i.src_reg);
-	  }
+	case ARGS_LD_IMM64:
+	  switch (i->src_reg)
+	    {
+	    case 0:
+	      code_fmt = REG(1) " = %2$#" PRIx64;
+	      break;
+	    case BPF_PSEUDO_MAP_FD:
+	      code_fmt = REG(1) " = map_fd(%2$#" PRIx64 ")";
+	      break;
+	    default:
+	      code_fmt = REG(1) " = ld_pseudo(%3$d, %2$#" PRIx64 ")";
+	      break;
+	    }
+	  len = snprintf(buf, sizeof(buf), code_fmt,
+			 i->dst_reg, d.imm64, i->src_reg);
 	  break;
 
-	case BPF_JMP | BPF_EXIT:
-	  len = snprintf(buf, sizeof(buf), "exit");
+	case ARGS_EXIT:
+	  len = snprintf(buf, sizeof(buf), "%s", code_fmt);
 	  break;
-	case BPF_JMP | BPF_JA:
-	  len = snprintf(buf, sizeof(buf), "goto " JMP(1), jmp);
+	case ARGS_JA:
+	  len = snprintf(buf, sizeof(buf), code_fmt, (unsigned) d.jmp);
 	  break;
-	case BPF_JMP | BPF_CALL:
-	  code_fmt = "call " IMMS(1);
-	  goto do_imm;
-
-	case BPF_ALU | BPF_END | BPF_TO_LE:
-	  /* The imm field contains {16,32,64}.  */
-	  code_fmt = REG(1) " = le" IMMS(2) "(" REG(1) ")";
-	  goto do_dst_imm;
-	case BPF_ALU | BPF_END | BPF_TO_BE:
-	  code_fmt = REG(1) " = be" IMMS(2) "(" REG(1) ")";
-	  goto do_dst_imm;
-
-	case BPF_ALU | BPF_ADD | BPF_K:
-	  code_fmt = A32(+, IMMS(2));
-	  goto do_dst_imm;
-	case BPF_ALU | BPF_SUB | BPF_K:
-	  code_fmt = A32(-, IMMS(2));
-	  goto do_dst_imm;
-	case BPF_ALU | BPF_MUL | BPF_K:
-	  code_fmt = A32(*, IMMS(2));
-	  goto do_dst_imm;
-	case BPF_ALU | BPF_DIV | BPF_K:
-	  code_fmt = A32(/, IMMS(2));
-	  goto do_dst_imm;
-	case BPF_ALU | BPF_OR | BPF_K:
-	  code_fmt = A32(|, IMMX(2));
-	  goto do_dst_imm;
-	case BPF_ALU | BPF_AND | BPF_K:
-	  code_fmt = A32(&, IMMX(2));
-	  goto do_dst_imm;
-	case BPF_ALU | BPF_LSH | BPF_K:
-	  code_fmt = A32(<<, IMMS(2));
-	  goto do_dst_imm;
-	case BPF_ALU | BPF_RSH | BPF_K:
-	  code_fmt = A32(>>, IMMS(2));
-	  goto do_dst_imm;
-	case BPF_ALU | BPF_MOD | BPF_K:
-	  code_fmt = A32(%%, IMMS(2));
-	  goto do_dst_imm;
-	case BPF_ALU | BPF_XOR | BPF_K:
-	  code_fmt = A32(^, IMMX(2));
-	  goto do_dst_imm;
-	case BPF_ALU | BPF_MOV | BPF_K:
-	  code_fmt = REG(1) " = " IMMX(2);
-	  goto do_dst_imm;
-	case BPF_ALU | BPF_ARSH | BPF_K:
-	  code_fmt = REG(1) " = (u32)((s32)" REG(1) " >> " IMMS(2) ")";
-	  goto do_dst_imm;
-
-	case BPF_ALU | BPF_ADD | BPF_X:
-	  code_fmt = A32(+, REGU(2));
-	  goto do_dst_src;
-	case BPF_ALU | BPF_SUB | BPF_X:
-	  code_fmt = A32(-, REGU(2));
-	  goto do_dst_src;
-	case BPF_ALU | BPF_MUL | BPF_X:
-	  code_fmt = A32(*, REGU(2));
-	  goto do_dst_src;
-	case BPF_ALU | BPF_DIV | BPF_X:
-	  code_fmt = A32(/, REGU(2));
-	  goto do_dst_src;
-	case BPF_ALU | BPF_OR | BPF_X:
-	  code_fmt = A32(|, REGU(2));
-	  goto do_dst_src;
-	case BPF_ALU | BPF_AND | BPF_X:
-	  code_fmt = A32(&, REGU(2));
-	  goto do_dst_src;
-	case BPF_ALU | BPF_LSH | BPF_X:
-	  code_fmt = A32(<<, REGU(2));
-	  goto do_dst_src;
-	case BPF_ALU | BPF_RSH | BPF_X:
-	  code_fmt = A32(>>, REGU(2));
-	  goto do_dst_src;
-	case BPF_ALU | BPF_MOD | BPF_X:
-	  code_fmt = A32(%%, REGU(2));
-	  goto do_dst_src;
-	case BPF_ALU | BPF_XOR | BPF_X:
-	  code_fmt = A32(^, REGU(2));
-	  goto do_dst_src;
-	case BPF_ALU | BPF_MOV | BPF_X:
-	  code_fmt = REG(1) " = " REGU(2);
-	  goto do_dst_src;
-	case BPF_ALU | BPF_ARSH | BPF_X:
-	  code_fmt = REG(1) " = (u32)((s32)" REG(1) " >> " REG(2) ")";
-	  goto do_dst_src;
-
-	case BPF_ALU64 | BPF_ADD | BPF_K:
-	  code_fmt = A64(+, IMMS(2));
-	  goto do_dst_imm;
-	case BPF_ALU64 | BPF_SUB | BPF_K:
-	  code_fmt = A64(-, IMMS(2));
-	  goto do_dst_imm;
-	case BPF_ALU64 | BPF_MUL | BPF_K:
-	  code_fmt = A64(*, IMMS(2));
-	  goto do_dst_imm;
-	case BPF_ALU64 | BPF_DIV | BPF_K:
-	  code_fmt = A64(/, IMMS(2));
-	  goto do_dst_imm;
-	case BPF_ALU64 | BPF_OR | BPF_K:
-	  code_fmt = A64(|, IMMS(2));
-	  goto do_dst_imm;
-	case BPF_ALU64 | BPF_AND | BPF_K:
-	  code_fmt = A64(&, IMMS(2));
-	  goto do_dst_imm;
-	case BPF_ALU64 | BPF_LSH | BPF_K:
-	  code_fmt = A64(<<, IMMS(2));
-	  goto do_dst_imm;
-	case BPF_ALU64 | BPF_RSH | BPF_K:
-	  code_fmt = A64(>>, IMMS(2));
-	  goto do_dst_imm;
-	case BPF_ALU64 | BPF_MOD | BPF_K:
-	  code_fmt = A64(%%, IMMS(2));
-	  goto do_dst_imm;
-	case BPF_ALU64 | BPF_XOR | BPF_K:
-	  code_fmt = A64(^, IMMS(2));
-	  goto do_dst_imm;
-	case BPF_ALU64 | BPF_MOV | BPF_K:
-	  code_fmt = REG(1) " = " IMMS(2);
-	  goto do_dst_imm;
-	case BPF_ALU64 | BPF_ARSH | BPF_K:
-	  code_fmt = REG(1) " = (s64)" REG(1) " >> " IMMS(2);
-	  goto do_dst_imm;
-
-	case BPF_ALU64 | BPF_ADD | BPF_X:
-	  code_fmt = A64(+, REG(2));
-	  goto do_dst_src;
-	case BPF_ALU64 | BPF_SUB | BPF_X:
-	  code_fmt = A64(-, REG(2));
-	  goto do_dst_src;
-	case BPF_ALU64 | BPF_MUL | BPF_X:
-	  code_fmt = A64(*, REG(2));
-	  goto do_dst_src;
-	case BPF_ALU64 | BPF_DIV | BPF_X:
-	  code_fmt = A64(/, REG(2));
-	  goto do_dst_src;
-	case BPF_ALU64 | BPF_OR | BPF_X:
-	  code_fmt = A64(|, REG(2));
-	  goto do_dst_src;
-	case BPF_ALU64 | BPF_AND | BPF_X:
-	  code_fmt = A64(&, REG(2));
-	  goto do_dst_src;
-	case BPF_ALU64 | BPF_LSH | BPF_X:
-	  code_fmt = A64(<<, REG(2));
-	  goto do_dst_src;
-	case BPF_ALU64 | BPF_RSH | BPF_X:
-	  code_fmt = A64(>>, REG(2));
-	  goto do_dst_src;
-	case BPF_ALU64 | BPF_MOD | BPF_X:
-	  code_fmt = A64(%%, REG(2));
-	  goto do_dst_src;
-	case BPF_ALU64 | BPF_XOR | BPF_X:
-	  code_fmt = A64(^, REG(2));
-	  goto do_dst_src;
-	case BPF_ALU64 | BPF_MOV | BPF_X:
-	  code_fmt = REG(1) " = " REG(2);
-	  goto do_dst_src;
-	case BPF_ALU64 | BPF_ARSH | BPF_X:
-	  code_fmt = REG(1) " = (s64)" REG(1) " >> " REG(2);
-	  goto do_dst_src;
-
-	case BPF_ALU | BPF_NEG:
-	  code_fmt = REG(1) " = (u32)-" REG(1);
-	  goto do_dst_src;
-	case BPF_ALU64 | BPF_NEG:
-	  code_fmt = REG(1) " = -" REG(1);
-	  goto do_dst_src;
-
-	case BPF_JMP | BPF_JEQ | BPF_K:
-	  code_fmt = J64(REG(1), ==, IMMS(2));
-	  goto do_dst_imm_jmp;
-	case BPF_JMP | BPF_JGT | BPF_K:
-	  code_fmt = J64(REG(1), >, IMMS(2));
-	  goto do_dst_imm_jmp;
-	case BPF_JMP | BPF_JGE | BPF_K:
-	  code_fmt = J64(REG(1), >=, IMMS(2));
-	  goto do_dst_imm_jmp;
-	case BPF_JMP | BPF_JSET | BPF_K:
-	  code_fmt = J64(REG(1), &, IMMS(2));
-	  goto do_dst_imm_jmp;
-	case BPF_JMP | BPF_JNE | BPF_K:
-	  code_fmt = J64(REG(1), !=, IMMS(2));
-	  goto do_dst_imm_jmp;
-	case BPF_JMP | BPF_JSGT | BPF_K:
-	  code_fmt = J64(REGS(1), >, IMMS(2));
-	  goto do_dst_imm_jmp;
-	case BPF_JMP | BPF_JSGE | BPF_K:
-	  code_fmt = J64(REGS(1), >=, IMMS(2));
-	  goto do_dst_imm_jmp;
-	case BPF_JMP | BPF_JLT | BPF_K:
-	  code_fmt = J64(REG(1), <, IMMS(2));
-	  goto do_dst_imm_jmp;
-	case BPF_JMP | BPF_JLE | BPF_K:
-	  code_fmt = J64(REG(1), <=, IMMS(2));
-	  goto do_dst_imm_jmp;
-	case BPF_JMP | BPF_JSLT | BPF_K:
-	  code_fmt = J64(REGS(1), <, IMMS(2));
-	  goto do_dst_imm_jmp;
-	case BPF_JMP | BPF_JSLE | BPF_K:
-	  code_fmt = J64(REGS(1), <=, IMMS(2));
-	  goto do_dst_imm_jmp;
-
-	case BPF_JMP | BPF_JEQ | BPF_X:
-	  code_fmt = J64(REG(1), ==, REG(2));
-	  goto do_dst_src_jmp;
-	case BPF_JMP | BPF_JGT | BPF_X:
-	  code_fmt = J64(REG(1), >, REG(2));
-	  goto do_dst_src_jmp;
-	case BPF_JMP | BPF_JGE | BPF_X:
-	  code_fmt = J64(REG(1), >=, REG(2));
-	  goto do_dst_src_jmp;
-	case BPF_JMP | BPF_JSET | BPF_X:
-	  code_fmt = J64(REG(1), &, REG(2));
-	  goto do_dst_src_jmp;
-	case BPF_JMP | BPF_JNE | BPF_X:
-	  code_fmt = J64(REG(1), !=, REG(2));
-	  goto do_dst_src_jmp;
-	case BPF_JMP | BPF_JSGT | BPF_X:
-	  code_fmt = J64(REGS(1), >, REGS(2));
-	  goto do_dst_src_jmp;
-	case BPF_JMP | BPF_JSGE | BPF_X:
-	  code_fmt = J64(REGS(1), >=, REGS(2));
-	  goto do_dst_src_jmp;
-	case BPF_JMP | BPF_JLT | BPF_X:
-	  code_fmt = J64(REG(1), <, REG(2));
-	  goto do_dst_src_jmp;
-	case BPF_JMP | BPF_JLE | BPF_X:
-	  code_fmt = J64(REG(1), <=, REG(2));
-	  goto do_dst_src_jmp;
-	case BPF_JMP | BPF_JSLT | BPF_X:
-	  code_fmt = J64(REGS(1), <, REGS(2));
-	  goto do_dst_src_jmp;
-	case BPF_JMP | BPF_JSLE | BPF_X:
-	  code_fmt = J64(REGS(1), <=, REGS(2));
-	  goto do_dst_src_jmp;
-
-	case BPF_LDX | BPF_MEM | BPF_B:
-	  code_fmt = LOAD(u8);
-	  goto do_dst_src_off;
-	case BPF_LDX | BPF_MEM | BPF_H:
-	  code_fmt = LOAD(u16);
-	  goto do_dst_src_off;
-	case BPF_LDX | BPF_MEM | BPF_W:
-	  code_fmt = LOAD(u32);
-	  goto do_dst_src_off;
-	case BPF_LDX | BPF_MEM | BPF_DW:
-	  code_fmt = LOAD(u64);
-	  goto do_dst_src_off;
-
-	case BPF_STX | BPF_MEM | BPF_B:
-	  code_fmt = STORE(u8, REG(2));
-	  goto do_dst_src_off;
-	case BPF_STX | BPF_MEM | BPF_H:
-	  code_fmt = STORE(u16, REG(2));
-	  goto do_dst_src_off;
-	case BPF_STX | BPF_MEM | BPF_W:
-	  code_fmt = STORE(u32, REG(2));
-	  goto do_dst_src_off;
-	case BPF_STX | BPF_MEM | BPF_DW:
-	  code_fmt = STORE(u64, REG(2));
-	  goto do_dst_src_off;
-
-	case BPF_STX | BPF_XADD | BPF_W:
-	  code_fmt = XADD(u32, REG(2));
-	  goto do_dst_src_off;
-	case BPF_STX | BPF_XADD | BPF_DW:
-	  code_fmt = XADD(u64, REG(2));
-	  goto do_dst_src_off;
-
-	case BPF_ST | BPF_MEM | BPF_B:
-	  code_fmt = STORE(u8, IMMS(2));
-	  goto do_dst_imm_off;
-	case BPF_ST | BPF_MEM | BPF_H:
-	  code_fmt = STORE(u16, IMMS(2));
-	  goto do_dst_imm_off;
-	case BPF_ST | BPF_MEM | BPF_W:
-	  code_fmt = STORE(u32, IMMS(2));
-	  goto do_dst_imm_off;
-	case BPF_ST | BPF_MEM | BPF_DW:
-	  code_fmt = STORE(u64, IMMS(2));
-	  goto do_dst_imm_off;
-
-	case BPF_LD | BPF_ABS | BPF_B:
-	  code_fmt = LDSKB(u8, IMMS(1));
-	  goto do_imm;
-	case BPF_LD | BPF_ABS | BPF_H:
-	  code_fmt = LDSKB(u16, IMMS(1));
-	  goto do_imm;
-	case BPF_LD | BPF_ABS | BPF_W:
-	  code_fmt = LDSKB(u32, IMMS(1));
-	  goto do_imm;
-
-	case BPF_LD | BPF_IND | BPF_B:
-	  code_fmt = LDSKB(u8, REG(1) "+" IMMS(2));
-	  goto do_src_imm;
-	case BPF_LD | BPF_IND | BPF_H:
-	  code_fmt = LDSKB(u16, REG(1) "+" IMMS(2));
-	  goto do_src_imm;
-	case BPF_LD | BPF_IND | BPF_W:
-	  code_fmt = LDSKB(u32, REG(1) "+" IMMS(2));
-	  goto do_src_imm;
-
-	do_imm:
-	  len = snprintf(buf, sizeof(buf), code_fmt, i.imm);
+	case ARGS_CALL:
+	case ARGS_LD_ABS:
+	  len = snprintf(buf, sizeof(buf), code_fmt, i->imm);
 	  break;
-	do_dst_imm:
-	  len = snprintf(buf, sizeof(buf), code_fmt, i.dst_reg, i.imm);
+	case ARGS_DST_IMM:
+	  len = snprintf(buf, sizeof(buf), code_fmt, i->dst_reg, i->imm);
 	  break;
-	do_src_imm:
-	  len = snprintf(buf, sizeof(buf), code_fmt, i.src_reg, i.imm);
+	case ARGS_LD_IND:
+	  len = snprintf(buf, sizeof(buf), code_fmt, i->src_reg, i->imm);
 	  break;
-	do_dst_src:
-	  len = snprintf(buf, sizeof(buf), code_fmt, i.dst_reg, i.src_reg);
+	case ARGS_DST:
+	case ARGS_DST_SRC:
+	  len = snprintf(buf, sizeof(buf), code_fmt, i->dst_reg, i->src_reg);
 	  break;
-	do_dst_imm_jmp:
-	  len = snprintf(buf, sizeof(buf), code_fmt, i.dst_reg, i.imm, jmp);
+	case ARGS_DST_IMM_JMP:
+	  len = snprintf(buf, sizeof(buf), code_fmt,
+			 i->dst_reg, i->imm, (unsigned) d.jmp);
 	  break;
-	do_dst_src_jmp:
+	case ARGS_DST_SRC_JMP:
 	  len = snprintf(buf, sizeof(buf), code_fmt,
-			 i.dst_reg, i.src_reg, jmp);
+			 i->dst_reg, i->src_reg, (unsigned) d.jmp);
 	  break;
-	do_dst_imm_off:
-	  len = snprintf(buf, sizeof(buf), code_fmt, i.dst_reg, i.imm, i.off);
+	case ARGS_STORE_IMM:
+	  len = snprintf(buf, sizeof(buf), code_fmt,
+			 i->dst_reg, i->imm, i->off);
 	  break;
-	do_dst_src_off:
+	case ARGS_LOAD:
+	case ARGS_STORE_REG:
 	  len = snprintf(buf, sizeof(buf), code_fmt,
-			 i.dst_reg, i.src_reg, i.off);
+			 i->dst_reg, i->src_reg, i->off);
 	  break;
 
 	default:
-	  class = BPF_CLASS(code);
 	  len = snprintf(buf, sizeof(buf), "invalid class %s",
-			 class_string[class]);
+			 class_string[BPF_CLASS(i->code)]);
 	  break;
-        }
+	}
 
       *startp = start;
       retval = outcb (buf, len, outcbarg);
       if (retval != 0)
-	goto done;
+	break;
     }
 
- done:
   return retval;
 }
+
+
+static void
+add_operand (DisasmInsn *insn, DisasmOpKind kind, int64_t value)
+{
+  insn->ops[insn->nops].kind = kind;
+  insn->ops[insn->nops].value = value;
+  ++insn->nops;
+  if (kind == DISASM_OP_MEM)
+    insn->has_memop = true;
+}
+
+int
+bpf_disasm_decode (Ebl *ebl, const uint8_t **startp, const uint8_t *end,
+		   GElf_Addr addr, DisasmInsn *insn)
+{
+  const bool need_bswap = MY_ELFDATA != ebl->data;
+  const uint8_t *start = *startp;
+  struct bpf_decoded d;
+
+  if (start + sizeof (struct bpf_insn) > end
+      || ! bpf_decode (start, end, addr, need_bswap, &d))
+    return -1;
+
+  const struct bpf_insn *i = &d.i;
+  insn->nops = 0;
+  insn->has_target = false;
+  insn->has_memop = false;
+  insn->insn_class = DISASM_INSN_OTHER;
+
+  switch (d.op == NULL ? ARGS_INVALID : d.op->args)
+    {
+    case ARGS_EXIT:
+      insn->insn_class = DISASM_INSN_RETURN;
+      break;
+    case ARGS_JA:
+      insn->insn_class = DISASM_INSN_JUMP;
+      add_operand (insn, DISASM_OP_TARGET, d.jmp);
+      break;
+    case ARGS_CALL:
+      insn->insn_class = DISASM_INSN_CALL;
+      add_operand (insn, DISASM_OP_IMM, i->imm);
+      break;
+    case ARGS_DST:
+      add_operand (insn, DISASM_OP_REG, i->dst_reg);
+      break;
+    case ARGS_DST_IMM:
+      add_operand (insn, DISASM_OP_REG, i->dst_reg);
+      add_operand (insn, DISASM_OP_IMM, i->imm);
+      break;
+    case ARGS_DST_SRC:
+      add_operand (insn, DISASM_OP_REG, i->dst_reg);
+      add_operand (insn, DISASM_OP_REG, i->src_reg);
+      break;
+    case ARGS_DST_IMM_JMP:
+      insn->insn_class = DISASM_INSN_COND_JUMP;
+      add_operand (insn, DISASM_OP_REG, i->dst_reg);
+      add_operand (insn, DISASM_OP_IMM, i->imm);
+      add_operand (insn, DISASM_OP_TARGET, d.jmp);
+      break;
+    case ARGS_DST_SRC_JMP:
+      insn->insn_class = DISASM_INSN_COND_JUMP;
+      add_operand (insn, DISASM_OP_REG, i->dst_reg);
+      add_operand (insn, DISASM_OP_REG, i->src_reg);
+      add_operand (insn, DISASM_OP_TARGET, d.jmp);
+      break;
+    case ARGS_LOAD:
+      add_operand (insn, DISASM_OP_REG, i->dst_reg);
+      add_operand (insn, DISASM_OP_MEM, i->off);
+      break;
+    case ARGS_STORE_REG:
+      add_operand (insn, DISASM_OP_MEM, i->off);
+      add_operand (insn, DISASM_OP_REG, i->src_reg);
+      break;
+    case ARGS_STORE_IMM:
+      add_operand (insn, DISASM_OP_MEM, i->off);
+      add_operand (insn, DISASM_OP_IMM, i->imm);
+      break;
+    case ARGS_LD_ABS:
+      add_operand (insn, DISASM_OP_REG, 0);
+      add_operand (insn, DISASM_OP_MEM, i->imm);
+      break;
+    case ARGS_LD_IND:
+      add_operand (insn, DISASM_OP_REG, 0);
+      add_operand (insn, DISASM_OP_REG, i->src_reg);
+      add_operand (insn, DISASM_OP_MEM, i->imm);
+      break;
+    case ARGS_LD_IMM64:
+      add_operand (insn, DISASM_OP_REG, i->dst_reg);
+      add_operand (insn, DISASM_OP_IMM, d.imm64);
+      break;
+    default:
+      insn->insn_class = DISASM_INSN_INVALID;
+      break;
+    }
+
+  if (insn->nops > 0 && insn->ops[insn->nops - 1].kind == DISASM_OP_TARGET)
+    {
+      insn->has_target = true;
+      insn->target = d.jmp;
+    }
+
+  strcpy (insn->mnemonic, d.op == NULL ? "invalid" : d.op->mnemonic);
+  insn->length = d.length;
+  *startp = start + d.length;
+  return 0;
+}
@@ -84,8 +84,77 @@ struct instr_enc
 typedef int (*opfct_t) (struct output_data *);
 
 
+/* The operands are formatted without printf, its parsing of the format
+   strings cost more than the rest of the formatting.  */
+
+/* Append the LEN bytes at STR.  Returns zero, or the number of bytes
+   missing in the buffer.  */
 static int
-data_prefix (struct output_data *d)
+add_out (struct output_data *d, const char *str, size_t len)
+{
+  size_t *bufcntp = d->bufcntp;
+  if (*bufcntp + len > d->bufsize)
+    return *bufcntp + len - d->bufsize;
+  memcpy (&d->bufp[*bufcntp], str, len);
+  *bufcntp += len;
+  return 0;
+}
+
+/* Write VAL like "0x%" PRIx64 to CP and return the end.  */
+static char *
+put_hex (char *cp, uint64_t val)
+{
+  *cp++ = '0';
+  *cp++ = 'x';
+  int shift = 60;
+  while (shift > 0 && (val >> shift) == 0)
+    shift -= 4;
+  for (; shift >= 0; shift -= 4)
+    *cp++ = "0123456789abcdef"[(val >> shift) & 0xf];
+  return cp;
+}
+
+/* Likewise, but a negative VAL as a minus sign and its magnitude.  */
+static char *
+put_shex (char *cp, int32_t val)
+{
+  if (val >= 0)
+    return put_hex (cp, val);
+  *cp++ = '-';
+  return put_hex (cp, -(uint32_t) val);
+}
+
+/* Append VAL as an immediate operand, like "$0x%" PRIx64.  */
+static int
+add_imm (struct output_data *d, uint64_t val)
+{
+  char tmpbuf[sizeof ("$0x1234567812345678")];
+  tmpbuf[0] = '$';
+  char *cp = put_hex (tmpbuf + 1, val);
+  return add_out (d, tmpbuf, cp - tmpbuf);
+}
+
+#ifdef X86_64
+/* Write the name of register N, r8 to r15, to CP and return the end.  */
+static char *
+put_rnum (char *cp, unsigned int n)
+{
+  *cp++ = 'r';
+  if (n >= 10)
+    {
+      *cp++ = '1';
+      n -= 10;
+    }
+  *cp++ = '0' + n;
+  return cp;
+}
+#endif
+
+
+/* Remove the first segment override from the prefixes and return the
+   letter naming the segment register, or zero if there is none.  */
+static char
+take_data_prefix (struct output_data *d)
 {
   char ch = '\0';
   if (*d->prefixes & has_cs)
@@ -118,7 +187,14 @@ data_prefix (struct output_data *d)
       ch = 's';
       *d->prefixes &= ~has_ss;
     }
-  else
+  return ch;
+}
+
+static int
+data_prefix (struct output_data *d)
+{
+  char ch = take_data_prefix (d);
+  if (ch == '\0')
     return 0;
 
   if (*d->bufcntp + 4 > d->bufsize)
@@ -162,9 +238,6 @@ general_mod$r_m (struct output_data *d)
 
   int prefixes = *d->prefixes;
   const uint8_t *data = &d->data[d->opoff1 / 8];
-  char *bufp = d->bufp;
-  size_t *bufcntp = d->bufcntp;
-  size_t bufsize = d->bufsize;
 
   uint_fast8_t modrm = data[0];
 #ifndef X86_64
@@ -183,29 +256,34 @@ general_mod$r_m (struct output_data *d)
 	nodisp = true;
 
       char tmpbuf[sizeof ("-0x1234(%rr,%rr)")];
-      int n;
+      char *cp = tmpbuf;
       if ((modrm & 0xc7) == 6)
-	n = snprintf (tmpbuf, sizeof (tmpbuf), "0x%" PRIx16, disp);
+	cp = put_hex (cp, (uint32_t) disp);
       else
 	{
-	  n = 0;
 	  if (!nodisp)
-	    n = snprintf (tmpbuf, sizeof (tmpbuf), "%s0x%" PRIx16,
-			  disp < 0 ? "-" : "", disp < 0 ? -disp : disp);
+	    cp = put_shex (cp, disp);
 
+	  *cp++ = '(';
+	  *cp++ = '%';
 	  if ((modrm & 0x4) == 0)
-	    n += snprintf (tmpbuf + n, sizeof (tmpbuf) - n, "(%%b%c,%%%ci)",
-			   "xp"[(modrm >> 1) & 1], "sd"[modrm & 1]);
+	    {
+	      *cp++ = 'b';
+	      *cp++ = "xp"[(modrm >> 1) & 1];
+	      *cp++ = ',';
+	      *cp++ = '%';
+	      *cp++ = "sd"[modrm & 1];
+	      *cp++ = 'i';
+	    }
 	  else
-	    n += snprintf (tmpbuf + n, sizeof (tmpbuf) - n, "(%%%s)",
-			   ((const char [4][3]) { "si", "di", "bp", "bx" })[modrm & 3]);
+	    cp = stpcpy (cp, ((const char [4][3])
+			      { "si", "di", "bp", "bx" })[modrm & 3]);
+	  *cp++ = ')';
 	}
 
-      if (*bufcntp + n + 1 > bufsize)
-	return *bufcntp + n + 1 - bufsize;
-
-      memcpy (&bufp[*bufcntp], tmpbuf, n + 1);
-      *bufcntp += n;
+      r = add_out (d, tmpbuf, cp - tmpbuf);
+      if (r != 0)
+	return r;
     }
   else
 #endif
@@ -224,62 +302,48 @@ general_mod$r_m (struct output_data *d)
 	  else if ((modrm & 0xc0) == 0)
 	    nodisp = true;
 
-	  char tmpbuf[sizeof ("-0x12345678(%rrrr)")];
-	  int n;
-	  if (nodisp)
+	  char tmpbuf[sizeof ("-0x12345678(%rrrr)d")];
+	  char *cp = tmpbuf;
+	  if ((modrm & 0xc7) != 5)
 	    {
-	      n = snprintf (tmpbuf, sizeof (tmpbuf), "(%%%s)",
-#ifdef X86_64
-			    (prefixes & has_rex_b) ? hiregs[modrm & 7] :
-#endif
-			    aregs[modrm & 7]);
+	      if (!nodisp)
+		cp = put_shex (cp, disp);
+	      *cp++ = '(';
+	      *cp++ = '%';
 #ifdef X86_64
-	      if (prefixes & has_addr16)
-		{
-		  if (prefixes & has_rex_b)
-		    tmpbuf[n++] = 'd';
-		  else
-		    tmpbuf[2] = 'e';
-		}
+	      char *reg = cp;
 #endif
-	    }
-	  else if ((modrm & 0xc7) != 5)
-	    {
-	      int p;
-	      n = snprintf (tmpbuf, sizeof (tmpbuf), "%s0x%" PRIx32 "(%%%n%s)",
-			    disp < 0 ? "-" : "", disp < 0 ? -disp : disp, &p,
+	      cp = stpcpy (cp,
 #ifdef X86_64
-			    (prefixes & has_rex_b) ? hiregs[modrm & 7] :
+			   (prefixes & has_rex_b) ? hiregs[modrm & 7] :
 #endif
-			    aregs[modrm & 7]);
+			   aregs[modrm & 7]);
+	      *cp++ = ')';
 #ifdef X86_64
 	      if (prefixes & has_addr16)
 		{
 		  if (prefixes & has_rex_b)
-		    tmpbuf[n++] = 'd';
+		    *cp++ = 'd';
 		  else
-		    tmpbuf[p] = 'e';
+		    *reg = 'e';
 		}
 #endif
 	    }
 	  else
 	    {
 #ifdef X86_64
-	      n = snprintf (tmpbuf, sizeof (tmpbuf), "%s0x%" PRIx32 "(%%rip)",
-			    disp < 0 ? "-" : "", disp < 0 ? -disp : disp);
+	      cp = stpcpy (put_shex (cp, disp), "(%rip)");
 
 	      d->symaddr_use = addr_rel_always;
 	      d->symaddr = disp;
 #else
-	      n = snprintf (tmpbuf, sizeof (tmpbuf), "0x%" PRIx32, disp);
+	      cp = put_hex (cp, (uint32_t) disp);
 #endif
 	    }
 
-	  if (*bufcntp + n + 1 > bufsize)
-	    return *bufcntp + n + 1 - bufsize;
-
-	  memcpy (&bufp[*bufcntp], tmpbuf, n + 1);
-	  *bufcntp += n;
+	  r = add_out (d, tmpbuf, cp - tmpbuf);
+	  if (r != 0)
+	    return r;
 	}
       else
 	{
@@ -300,7 +364,6 @@ general_mod$r_m (struct output_data *d)
 
 	  char tmpbuf[sizeof ("-0x12345678(%rrrr,%rrrr,N)")];
 	  char *cp = tmpbuf;
-	  int n;
 	  if ((modrm & 0xc0) != 0 || (sib & 0x3f) != 0x25
 #ifdef X86_64
 	      || (prefixes & has_rex_x) != 0
@@ -308,11 +371,7 @@ general_mod$r_m (struct output_data *d)
 	      )
 	    {
 	      if (!nodisp)
-		{
-		  n = snprintf (cp, sizeof (tmpbuf), "%s0x%" PRIx32,
-				disp < 0 ? "-" : "", disp < 0 ? -disp : disp);
-		  cp += n;
-		}
+		cp = put_shex (cp, disp);
 
 	      *cp++ = '(';
 
@@ -365,19 +424,15 @@ general_mod$r_m (struct output_data *d)
 	      assert (! nodisp);
 #ifdef X86_64
 	      if ((prefixes & has_addr16) == 0)
-		n = snprintf (cp, sizeof (tmpbuf), "0x%" PRIx64,
-			      (int64_t) disp);
+		cp = put_hex (cp, (int64_t) disp);
 	      else
 #endif
-		n = snprintf (cp, sizeof (tmpbuf), "0x%" PRIx32, disp);
-	      cp += n;
+		cp = put_hex (cp, (uint32_t) disp);
 	    }
 
-	  if (*bufcntp + (cp - tmpbuf) > bufsize)
-	    return *bufcntp + (cp - tmpbuf) - bufsize;
-
-	  memcpy (&bufp[*bufcntp], tmpbuf, cp - tmpbuf);
-	  *bufcntp += cp - tmpbuf;
+	  r = add_out (d, tmpbuf, cp - tmpbuf);
+	  if (r != 0)
+	    return r;
 	}
     }
   return 0;
@@ -396,18 +451,18 @@ FCT_MOD$R_M (struct output_data *d)
       //uint_fast8_t byte = d->data[d->opoff2 / 8] & 7;
       uint_fast8_t byte = modrm & 7;
 
-      size_t *bufcntp = d->bufcntp;
-      char *buf = d->bufp + *bufcntp;
-      size_t avail = d->bufsize - *bufcntp;
-      int needed;
+      char tmpbuf[sizeof ("%eax")];
+      char *cp = tmpbuf;
+      *cp++ = '%';
       if (*d->prefixes & (has_rep | has_repne))
-	needed = snprintf (buf, avail, "%%%s", dregs[byte]);
+	cp = stpcpy (cp, dregs[byte]);
       else
-	needed = snprintf (buf, avail, "%%mm%" PRIxFAST8, byte);
-      if ((size_t) needed > avail)
-	return needed - avail;
-      *bufcntp += needed;
-      return 0;
+	{
+	  *cp++ = 'm';
+	  *cp++ = 'm';
+	  *cp++ = '0' + byte;
+	}
+      return add_out (d, tmpbuf, cp - tmpbuf);
     }
 
   return general_mod$r_m (d);
@@ -426,14 +481,9 @@ FCT_Mod$R_m (struct output_data *d)
       //uint_fast8_t byte = data[opoff2 / 8] & 7;
       uint_fast8_t byte = modrm & 7;
 
-      size_t *bufcntp = d->bufcntp;
-      size_t avail = d->bufsize - *bufcntp;
-      int needed = snprintf (&d->bufp[*bufcntp], avail, "%%xmm%" PRIxFAST8,
-			     byte);
-      if ((size_t) needed > avail)
-	return needed - avail;
-      *d->bufcntp += needed;
-      return 0;
+      char tmpbuf[] = "%xmmN";
+      tmpbuf[4] = '0' + byte;
+      return add_out (d, tmpbuf, 5);
     }
 
   return general_mod$r_m (d);
@@ -459,23 +509,16 @@ generic_abs (struct output_data *d, const char *absstring
   *d->param_start += abslen;
 #ifndef X86_64
   uint32_t absval;
-# define ABSPRIFMT PRIx32
 #else
   uint64_t absval;
-# define ABSPRIFMT PRIx64
   if (abslen == 8)
     absval = read_8ubyte_unaligned (&d->data[1]);
   else
 #endif
     absval = read_4ubyte_unaligned (&d->data[1]);
-  size_t *bufcntp = d->bufcntp;
-  size_t avail = d->bufsize - *bufcntp;
-  int needed = snprintf (&d->bufp[*bufcntp], avail, "%s0x%" ABSPRIFMT,
-			 absstring, absval);
-  if ((size_t) needed > avail)
-    return needed - avail;
-  *bufcntp += needed;
-  return 0;
+  char tmpbuf[sizeof ("$0x1234567812345678")];
+  char *cp = put_hex (stpcpy (tmpbuf, absstring), absval);
+  return add_out (d, tmpbuf, cp - tmpbuf);
 }
 
 
@@ -553,18 +596,15 @@ FCT_crdb (struct output_data *d, const char *regstr)
   if (*d->prefixes & has_data16)
     return -1;
 
-  size_t *bufcntp = d->bufcntp;
-
   // XXX If this assert is true, use absolute offset below
   assert (d->opoff1 / 8 == 2);
   assert (d->opoff1 % 8 == 2);
-  size_t avail = d->bufsize - *bufcntp;
-  int needed = snprintf (&d->bufp[*bufcntp], avail, "%%%s%" PRIx32,
-			 regstr, (uint32_t) (d->data[d->opoff1 / 8] >> 3) & 7);
-  if ((size_t) needed > avail)
-    return needed - avail;
-  *bufcntp += needed;
-  return 0;
+  char tmpbuf[sizeof ("%crN")];
+  char *cp = tmpbuf;
+  *cp++ = '%';
+  cp = stpcpy (cp, regstr);
+  *cp++ = '0' + ((d->data[d->opoff1 / 8] >> 3) & 7);
+  return add_out (d, tmpbuf, cp - tmpbuf);
 }
 
 
@@ -590,15 +630,11 @@ FCT_disp8 (struct output_data *d)
     return -1;
   int32_t offset = *(const int8_t *) (*d->param_start)++;
 
-  size_t *bufcntp = d->bufcntp;
-  size_t avail = d->bufsize - *bufcntp;
-  int needed = snprintf (&d->bufp[*bufcntp], avail, "0x%" PRIx32,
-			 (uint32_t) (d->addr + (*d->param_start - d->data)
-				     + offset));
-  if ((size_t) needed > avail)
-    return needed - avail;
-  *bufcntp += needed;
-  return 0;
+  char tmpbuf[sizeof ("0x12345678")];
+  char *cp = put_hex (tmpbuf, (uint32_t) (d->addr
+					   + (*d->param_start - d->data)
+					   + offset));
+  return add_out (d, tmpbuf, cp - tmpbuf);
 }
 
 
@@ -621,20 +657,19 @@ FCT_ds_xx (struct output_data *d, const char *reg)
   if (r != 0)
     return r;
 
-  size_t *bufcntp = d->bufcntp;
-  size_t avail = d->bufsize - *bufcntp;
-  int needed = snprintf (&d->bufp[*bufcntp], avail, "(%%%s%s)",
+  char tmpbuf[sizeof ("(%rbx)")];
+  char *cp = tmpbuf;
+  *cp++ = '(';
+  *cp++ = '%';
 #ifdef X86_64
-			 *d->prefixes & idx_addr16 ? "e" : "r",
+  *cp++ = *d->prefixes & idx_addr16 ? 'e' : 'r';
 #else
-			 *d->prefixes & idx_addr16 ? "" : "e",
+  if ((*d->prefixes & idx_addr16) == 0)
+    *cp++ = 'e';
 #endif
-			 reg);
-  if ((size_t) needed > avail)
-    return (size_t) needed - avail;
-  *bufcntp += needed;
-
-  return 0;
+  cp = stpcpy (cp, reg);
+  *cp++ = ')';
+  return add_out (d, tmpbuf, cp - tmpbuf);
 }
 
 
@@ -670,53 +705,38 @@ FCT_dx (struct output_data *d)
 static int
 FCT_es_di (struct output_data *d)
 {
-  size_t *bufcntp = d->bufcntp;
-  size_t avail = d->bufsize - *bufcntp;
-  int needed = snprintf (&d->bufp[*bufcntp], avail, "%%es:(%%%sdi)",
+  char tmpbuf[sizeof ("%es:(%rdi)")];
+  char *cp = stpcpy (tmpbuf, "%es:(%");
 #ifdef X86_64
-			 *d->prefixes & idx_addr16 ? "e" : "r"
+  *cp++ = *d->prefixes & idx_addr16 ? 'e' : 'r';
 #else
-			 *d->prefixes & idx_addr16 ? "" : "e"
+  if ((*d->prefixes & idx_addr16) == 0)
+    *cp++ = 'e';
 #endif
-			 );
-  if ((size_t) needed > avail)
-    return (size_t) needed - avail;
-  *bufcntp += needed;
-
-  return 0;
+  cp = stpcpy (cp, "di)");
+  return add_out (d, tmpbuf, cp - tmpbuf);
 }
 
 
 static int
 FCT_imm (struct output_data *d)
 {
-  size_t *bufcntp = d->bufcntp;
-  size_t avail = d->bufsize - *bufcntp;
-  int needed;
   if (*d->prefixes & has_data16)
     {
       if (*d->param_start + 2 > d->end)
 	return -1;
       uint16_t word = read_2ubyte_unaligned_inc (*d->param_start);
-      needed = snprintf (&d->bufp[*bufcntp], avail, "$0x%" PRIx16, word);
+      return add_imm (d, word);
     }
-  else
-    {
-      if (*d->param_start + 4 > d->end)
-	return -1;
-      int32_t word = read_4sbyte_unaligned_inc (*d->param_start);
+
+  if (*d->param_start + 4 > d->end)
+    return -1;
+  int32_t word = read_4sbyte_unaligned_inc (*d->param_start);
 #ifdef X86_64
-      if (*d->prefixes & has_rex_w)
-	needed = snprintf (&d->bufp[*bufcntp], avail, "$0x%" PRIx64,
-			   (int64_t) word);
-      else
+  if (*d->prefixes & has_rex_w)
+    return add_imm (d, (int64_t) word);
 #endif
-	needed = snprintf (&d->bufp[*bufcntp], avail, "$0x%" PRIx32, word);
-    }
-  if ((size_t) needed > avail)
-    return (size_t) needed - avail;
-  *bufcntp += needed;
-  return 0;
+  return add_imm (d, (uint32_t) word);
 }
 
 
@@ -726,16 +746,10 @@ FCT_imm$w (struct output_data *d)
   if ((d->data[d->opoff2 / 8] & (1 << (7 - (d->opoff2 & 7)))) != 0)
     return FCT_imm (d);
 
-  size_t *bufcntp = d->bufcntp;
-  size_t avail = d->bufsize - *bufcntp;
   if (*d->param_start>= d->end)
     return -1;
   uint_fast8_t word = *(*d->param_start)++;
-  int needed = snprintf (&d->bufp[*bufcntp], avail, "$0x%" PRIxFAST8, word);
-  if ((size_t) needed > avail)
-    return (size_t) needed - avail;
-  *bufcntp += needed;
-  return 0;
+  return add_imm (d, word);
 }
 
 
@@ -747,27 +761,18 @@ FCT_imm64$w (struct output_data *d)
       || (*d->prefixes & has_data16) != 0)
     return FCT_imm$w (d);
 
-  size_t *bufcntp = d->bufcntp;
-  size_t avail = d->bufsize - *bufcntp;
-  int needed;
   if (*d->prefixes & has_rex_w)
     {
       if (*d->param_start + 8 > d->end)
 	return -1;
       uint64_t word = read_8ubyte_unaligned_inc (*d->param_start);
-      needed = snprintf (&d->bufp[*bufcntp], avail, "$0x%" PRIx64, word);
-    }
-  else
-    {
-      if (*d->param_start + 4 > d->end)
-	return -1;
-      int32_t word = read_4sbyte_unaligned_inc (*d->param_start);
-      needed = snprintf (&d->bufp[*bufcntp], avail, "$0x%" PRIx32, word);
+      return add_imm (d, word);
     }
-  if ((size_t) needed > avail)
-    return (size_t) needed - avail;
-  *bufcntp += needed;
-  return 0;
+
+  if (*d->param_start + 4 > d->end)
+    return -1;
+  int32_t word = read_4sbyte_unaligned_inc (*d->param_start);
+  return add_imm (d, (uint32_t) word);
 }
 #endif
 
@@ -775,22 +780,14 @@ FCT_imm64$w (struct output_data *d)
 static int
 FCT_imms (struct output_data *d)
 {
-  size_t *bufcntp = d->bufcntp;
-  size_t avail = d->bufsize - *bufcntp;
   if (*d->param_start>= d->end)
     return -1;
   int8_t byte = *(*d->param_start)++;
 #ifdef X86_64
-  int needed = snprintf (&d->bufp[*bufcntp], avail, "$0x%" PRIx64,
-			 (int64_t) byte);
+  return add_imm (d, (int64_t) byte);
 #else
-  int needed = snprintf (&d->bufp[*bufcntp], avail, "$0x%" PRIx32,
-			 (int32_t) byte);
+  return add_imm (d, (uint32_t) (int32_t) byte);
 #endif
-  if ((size_t) needed > avail)
-    return (size_t) needed - avail;
-  *bufcntp += needed;
-  return 0;
 }
 
 
@@ -798,8 +795,6 @@ static int
 FCT_imm$s (struct output_data *d)
 {
   uint_fast8_t opcode = d->data[d->opoff2 / 8];
-  size_t *bufcntp = d->bufcntp;
-  size_t avail = d->bufsize - *bufcntp;
   if ((opcode & 2) != 0)
     return FCT_imms (d);
 
@@ -809,26 +804,16 @@ FCT_imm$s (struct output_data *d)
 	return -1;
       int32_t word = read_4sbyte_unaligned_inc (*d->param_start);
 #ifdef X86_64
-      int needed = snprintf (&d->bufp[*bufcntp], avail, "$0x%" PRIx64,
-			     (int64_t) word);
+      return add_imm (d, (int64_t) word);
 #else
-      int needed = snprintf (&d->bufp[*bufcntp], avail, "$0x%" PRIx32, word);
+      return add_imm (d, (uint32_t) word);
 #endif
-      if ((size_t) needed > avail)
-	return (size_t) needed - avail;
-      *bufcntp += needed;
     }
-  else
-    {
-      if (*d->param_start + 2 > d->end)
-	return -1;
-      uint16_t word = read_2ubyte_unaligned_inc (*d->param_start);
-      int needed = snprintf (&d->bufp[*bufcntp], avail, "$0x%" PRIx16, word);
-      if ((size_t) needed > avail)
-	return (size_t) needed - avail;
-      *bufcntp += needed;
-    }
-  return 0;
+
+  if (*d->param_start + 2 > d->end)
+    return -1;
+  uint16_t word = read_2ubyte_unaligned_inc (*d->param_start);
+  return add_imm (d, word);
 }
 
 
@@ -838,78 +823,49 @@ FCT_imm16 (struct output_data *d)
   if (*d->param_start + 2 > d->end)
     return -1;
   uint16_t word = read_2ubyte_unaligned_inc (*d->param_start);
-  size_t *bufcntp = d->bufcntp;
-  size_t avail = d->bufsize - *bufcntp;
-  int needed = snprintf (&d->bufp[*bufcntp], avail, "$0x%" PRIx16, word);
-  if ((size_t) needed > avail)
-    return (size_t) needed - avail;
-  *bufcntp += needed;
-  return 0;
+  return add_imm (d, word);
 }
 
 
 static int
 FCT_imms8 (struct output_data *d)
 {
-  size_t *bufcntp = d->bufcntp;
-  size_t avail = d->bufsize - *bufcntp;
   if (*d->param_start >= d->end)
     return -1;
   int_fast8_t byte = *(*d->param_start)++;
-  int needed;
 #ifdef X86_64
   if (*d->prefixes & has_rex_w)
-    needed = snprintf (&d->bufp[*bufcntp], avail, "$0x%" PRIx64,
-		       (int64_t) byte);
-  else
+    return add_imm (d, (int64_t) byte);
 #endif
-    needed = snprintf (&d->bufp[*bufcntp], avail, "$0x%" PRIx32,
-		       (int32_t) byte);
-  if ((size_t) needed > avail)
-    return (size_t) needed - avail;
-  *bufcntp += needed;
-  return 0;
+  return add_imm (d, (uint32_t) (int32_t) byte);
 }
 
 
 static int
 FCT_imm8 (struct output_data *d)
 {
-  size_t *bufcntp = d->bufcntp;
-  size_t avail = d->bufsize - *bufcntp;
   if (*d->param_start >= d->end)
     return -1;
   uint_fast8_t byte = *(*d->param_start)++;
-  int needed = snprintf (&d->bufp[*bufcntp], avail, "$0x%" PRIx32,
-			 (uint32_t) byte);
-  if ((size_t) needed > avail)
-    return (size_t) needed - avail;
-  *bufcntp += needed;
-  return 0;
+  return add_imm (d, byte);
 }
 
 
 static int
 FCT_rel (struct output_data *d)
 {
-  size_t *bufcntp = d->bufcntp;
-  size_t avail = d->bufsize - *bufcntp;
   if (*d->param_start + 4 > d->end)
     return -1;
   int32_t rel = read_4sbyte_unaligned_inc (*d->param_start);
+  char tmpbuf[sizeof ("0x1234567812345678")];
 #ifdef X86_64
-  int needed = snprintf (&d->bufp[*bufcntp], avail, "0x%" PRIx64,
-			 (uint64_t) (d->addr + rel
-				     + (*d->param_start - d->data)));
+  char *cp = put_hex (tmpbuf, (uint64_t) (d->addr + rel
+					   + (*d->param_start - d->data)));
 #else
-  int needed = snprintf (&d->bufp[*bufcntp], avail, "0x%" PRIx32,
-			 (uint32_t) (d->addr + rel
-				     + (*d->param_start - d->data)));
+  char *cp = put_hex (tmpbuf, (uint32_t) (d->addr + rel
+					   + (*d->param_start - d->data)));
 #endif
-  if ((size_t) needed > avail)
-    return (size_t) needed - avail;
-  *bufcntp += needed;
-  return 0;
+  return add_out (d, tmpbuf, cp - tmpbuf);
 }
 
 
@@ -919,13 +875,9 @@ FCT_mmxreg (struct output_data *d)
   uint_fast8_t byte = d->data[d->opoff1 / 8];
   assert (d->opoff1 % 8 == 2 || d->opoff1 % 8 == 5);
   byte = (byte >> (5 - d->opoff1 % 8)) & 7;
-  size_t *bufcntp =  d->bufcntp;
-  size_t avail = d->bufsize - *bufcntp;
-  int needed = snprintf (&d->bufp[*bufcntp], avail, "%%mm%" PRIxFAST8, byte);
-  if ((size_t) needed > avail)
-    return needed - avail;
-  *bufcntp += needed;
-  return 0;
+  char tmpbuf[] = "%mmN";
+  tmpbuf[3] = '0' + byte;
+  return add_out (d, tmpbuf, 4);
 }
 
 
@@ -1034,8 +986,11 @@ FCT_mod$r_m$w (struct output_data *d)
 	  if (prefixes & has_rex)
 	    {
 	      if (prefixes & has_rex_r)
-		*bufcntp += snprintf (bufp + *bufcntp, d->bufsize - *bufcntp,
-				      "r%db", 8 + (modrm & 7));
+		{
+		  char *cp = put_rnum (bufp + *bufcntp, 8 + (modrm & 7));
+		  *cp++ = 'b';
+		  *bufcntp = cp - bufp;
+		}
 	      else
 		{
 		  char *cp = stpcpy (bufp + *bufcntp, hiregs[modrm & 7]);
@@ -1172,8 +1127,7 @@ FCT_reg (struct output_data *d)
 #ifdef X86_64
   if ((*d->prefixes & has_rex_r) != 0 && !is_16bit)
     {
-      *bufcntp += snprintf (&d->bufp[*bufcntp], d->bufsize - *bufcntp, "r%d",
-			    8 + byte);
+      *bufcntp = put_rnum (&d->bufp[*bufcntp], 8 + byte) - d->bufp;
       if ((*d->prefixes & has_rex_w) == 0)
 	d->bufp[(*bufcntp)++] = 'd';
     }
@@ -1227,8 +1181,7 @@ FCT_reg64 (struct output_data *d)
 #ifdef X86_64
   if ((*d->prefixes & has_rex_r) != 0)
     {
-      *bufcntp += snprintf (&d->bufp[*bufcntp], d->bufsize - *bufcntp, "r%d",
-			    8 + byte);
+      *bufcntp = put_rnum (&d->bufp[*bufcntp], 8 + byte) - d->bufp;
       if ((*d->prefixes & has_rex_w) == 0)
 	d->bufp[(*bufcntp)++] = 'd';
     }
@@ -1254,8 +1207,8 @@ FCT_reg$w (struct output_data *d)
   byte &= 7;
 
   size_t *bufcntp = d->bufcntp;
-  if (*bufcntp + 4 > d->bufsize)
-    return *bufcntp + 4 - d->bufsize;
+  if (*bufcntp + 5 > d->bufsize)
+    return *bufcntp + 5 - d->bufsize;
 
   d->bufp[(*bufcntp)++] = '%';
 
@@ -1263,8 +1216,11 @@ FCT_reg$w (struct output_data *d)
   if (*d->prefixes & has_rex)
     {
       if (*d->prefixes & has_rex_r)
-	*bufcntp += snprintf (d->bufp + *bufcntp, d->bufsize - *bufcntp,
-			      "r%db", 8 + byte);
+	{
+	  char *cp = put_rnum (d->bufp + *bufcntp, 8 + byte);
+	  *cp++ = 'b';
+	  *bufcntp = cp - d->bufp;
+	}
       else
 	{
 	  char* cp = stpcpy (d->bufp + *bufcntp, rex_8bit[byte]);
@@ -1307,14 +1263,9 @@ FCT_freg (struct output_data *d)
 {
   assert (d->opoff1 / 8 == 1);
   assert (d->opoff1 % 8 == 5);
-  size_t *bufcntp = d->bufcntp;
-  size_t avail = d->bufsize - *bufcntp;
-  int needed = snprintf (&d->bufp[*bufcntp], avail, "%%st(%" PRIx32 ")",
-			 (uint32_t) (d->data[1] & 7));
-  if ((size_t) needed > avail)
-    return (size_t) needed - avail;
-  *bufcntp += needed;
-  return 0;
+  char tmpbuf[] = "%st(N)";
+  tmpbuf[4] = '0' + (d->data[1] & 7);
+  return add_out (d, tmpbuf, 6);
 }
 
 
@@ -1340,14 +1291,7 @@ FCT_sel (struct output_data *d)
     return -1;
   *d->param_start += 2;
   uint16_t absval = read_2ubyte_unaligned (&d->data[5]);
-
-  size_t *bufcntp = d->bufcntp;
-  size_t avail = d->bufsize - *bufcntp;
-  int needed = snprintf (&d->bufp[*bufcntp], avail, "$0x%" PRIx16, absval);
-  if ((size_t) needed > avail)
-    return needed - avail;
-  *bufcntp += needed;
-  return 0;
+  return add_imm (d, absval);
 }
 
 
@@ -1407,12 +1351,408 @@ FCT_xmmreg (struct output_data *d)
   uint_fast8_t byte = d->data[d->opoff1 / 8];
   assert (d->opoff1 % 8 == 2 || d->opoff1 % 8 == 5);
   byte = (byte >> (5 - d->opoff1 % 8)) & 7;
+  char tmpbuf[] = "%xmmN";
+  tmpbuf[4] = '0' + byte;
+  return add_out (d, tmpbuf, 5);
+}
 
-  size_t *bufcntp = d->bufcntp;
-  size_t avail = d->bufsize - *bufcntp;
-  int needed = snprintf (&d->bufp[*bufcntp], avail, "%%xmm%" PRIxFAST8, byte);
-  if ((size_t) needed > avail)
-    return needed - avail;
-  *bufcntp += needed;
+
+/* The DEC_* functions correspond to the FCT_* functions above.  They
+   consume the same bytes and fail in the same situations but record the
+   operand in D->insn instead of printing it.  */
+
+static int
+dec_operand (struct output_data *d, DisasmOpKind kind, int64_t value)
+{
+  DisasmInsn *insn = d->insn;
+  assert (insn->nops < DISASM_MAX_OPS);
+  insn->ops[insn->nops].kind = kind;
+  insn->ops[insn->nops].value = value;
+  ++insn->nops;
+
+  if (kind == DISASM_OP_MEM || kind == DISASM_OP_MEMADDR)
+    insn->has_memop = true;
+  else if (kind == DISASM_OP_TARGET)
+    {
+      insn->has_target = true;
+      insn->target = value;
+    }
+  return 0;
+}
+
+
+static int
+dec_general_mod$r_m (struct output_data *d)
+{
+  take_data_prefix (d);
+
+  int prefixes = *d->prefixes;
+  const uint8_t *data = &d->data[d->opoff1 / 8];
+  uint_fast8_t modrm = data[0];
+  int32_t disp = 0;
+  int64_t value;
+  bool absolute;
+
+#ifndef X86_64
+  if (unlikely ((prefixes & has_addr16) != 0))
+    {
+      if ((modrm & 0xc7) == 6 || (modrm & 0xc0) == 0x80)
+	/* 16 bit displacement.  */
+	disp = read_2sbyte_unaligned (&data[1]);
+      else if ((modrm & 0xc0) == 0x40)
+	/* 8 bit displacement.  */
+	disp = *(const int8_t *) &data[1];
+
+      absolute = (modrm & 0xc7) == 6;
+      value = absolute ? (uint16_t) disp : disp;
+    }
+  else
+#endif
+    {
+      int dispoff = 1;
+      bool disp32 = (modrm & 0xc7) == 5 || (modrm & 0xc0) == 0x80;
+      if ((modrm & 7) != 4)
+	absolute = (modrm & 0xc7) == 5;
+      else
+	{
+	  /* SIB.  Without base and index register the displacement is
+	     the address.  */
+	  uint_fast8_t sib = data[1];
+	  dispoff = 2;
+	  disp32 |= (modrm & 0xc7) == 0x4 && (sib & 0x7) == 0x5;
+	  absolute = ((modrm & 0xc0) == 0 && (sib & 0x3f) == 0x25
+#ifdef X86_64
+		      && (prefixes & has_rex_x) == 0
+#endif
+		      );
+	}
+
+      if (disp32)
+	/* 32 bit displacement.  */
+	disp = read_4sbyte_unaligned (&data[dispoff]);
+      else if ((modrm & 0xc0) == 0x40)
+	/* 8 bit displacement.  */
+	disp = *(const int8_t *) &data[dispoff];
+
+      value = disp;
+#ifdef X86_64
+      if ((modrm & 0xc7) == 5)
+	{
+	  /* RIP-relative.  The caller adds the address of the next
+	     instruction once its length is known.  */
+	  d->symaddr_use = addr_rel_always;
+	  d->symaddr = disp;
+	}
+      else if (absolute && (prefixes & has_addr16) != 0)
+	value = (uint32_t) disp;
+#else
+      if (absolute)
+	value = (uint32_t) disp;
+#endif
+    }
+
+  return dec_operand (d, absolute ? DISASM_OP_MEMADDR : DISASM_OP_MEM, value);
+}
+
+
+static int
+DEC_reg (struct output_data *d)
+{
+  return dec_operand (d, DISASM_OP_REG, 0);
+}
+
+#define DEC_ax DEC_reg
+#define DEC_ax$w DEC_reg
+#define DEC_dx DEC_reg
+#define DEC_freg DEC_reg
+#define DEC_mmxreg DEC_reg
+#define DEC_reg$w DEC_reg
+#define DEC_sreg2 DEC_reg
+#define DEC_xmmreg DEC_reg
+#ifdef X86_64
+# define DEC_oreg DEC_reg
+# define DEC_oreg$w DEC_reg
+#endif
+
+
+/* Register operands which are invalid with the operand size prefix.  */
+static int
+DEC_reg64 (struct output_data *d)
+{
+  if (*d->prefixes & has_data16)
+    return -1;
+  return DEC_reg (d);
+}
+
+#define DEC_ccc DEC_reg64
+#define DEC_ddd DEC_reg64
+
+
+#ifndef X86_64
+static int
+DEC_reg16 (struct output_data *d)
+{
+  if (*d->prefixes & has_data16)
+    return -1;
+
+  *d->prefixes |= has_data16;
+  return DEC_reg (d);
+}
+#endif
+
+
+static int
+DEC_sreg3 (struct output_data *d)
+{
+  uint_fast8_t byte = d->data[d->opoff1 / 8];
+  byte >>= 8 - (d->opoff1 % 8 + 3);
+
+  if ((byte & 7) >= 6)
+    return -1;
+  return DEC_reg (d);
+}
+
+
+static int
+DEC_string (struct output_data *d __attribute__ ((unused)))
+{
   return 0;
 }
+
+
+/* Operands which are a register or a memory location.  */
+static int
+DEC_MOD$R_M (struct output_data *d)
+{
+  if ((d->data[d->opoff1 / 8] & 0xc0) == 0xc0)
+    return DEC_reg (d);
+  return dec_general_mod$r_m (d);
+}
+
+#define DEC_Mod$R_m DEC_MOD$R_M
+#define DEC_mod$8r_m DEC_MOD$R_M
+#define DEC_mod$16r_m DEC_MOD$R_M
+
+
+/* The same, but the register form is invalid with the address size
+   prefix.  */
+static int
+DEC_mod$r_m (struct output_data *d)
+{
+  if ((d->data[d->opoff1 / 8] & 0xc0) == 0xc0)
+    {
+      if (*d->prefixes & has_addr16)
+	return -1;
+      return DEC_reg (d);
+    }
+  return dec_general_mod$r_m (d);
+}
+
+#define DEC_mod$r_m$w DEC_mod$r_m
+#ifdef X86_64
+# define DEC_mod$64r_m DEC_MOD$R_M
+#else
+# define DEC_moda$r_m DEC_mod$r_m
+# define DEC_mod$64r_m DEC_mod$r_m
+#endif
+
+
+static int
+dec_abs (struct output_data *d, DisasmOpKind kind, int len)
+{
+  take_data_prefix (d);
+
+  if (*d->param_start + len > d->end)
+    return -1;
+  *d->param_start += len;
+
+  uint64_t absval;
+  if (len == 8)
+    absval = read_8ubyte_unaligned (&d->data[1]);
+  else
+    absval = read_4ubyte_unaligned (&d->data[1]);
+  return dec_operand (d, kind, absval);
+}
+
+
+static int
+DEC_absval (struct output_data *d)
+{
+  return dec_abs (d, DISASM_OP_IMM, 4);
+}
+
+
+static int
+DEC_abs (struct output_data *d)
+{
+#ifdef X86_64
+  return dec_abs (d, DISASM_OP_MEMADDR, 8);
+#else
+  return dec_abs (d, DISASM_OP_MEMADDR, 4);
+#endif
+}
+
+
+static int
+dec_target (struct output_data *d, int32_t offset)
+{
+  GElf_Addr target = d->addr + (*d->param_start - d->data) + offset;
+#ifndef X86_64
+  target = (uint32_t) target;
+#endif
+  return dec_operand (d, DISASM_OP_TARGET, target);
+}
+
+
+static int
+DEC_disp8 (struct output_data *d)
+{
+  if (*d->param_start >= d->end)
+    return -1;
+  int32_t offset = *(const int8_t *) (*d->param_start)++;
+  return dec_target (d, offset);
+}
+
+
+static int
+DEC_rel (struct output_data *d)
+{
+  if (*d->param_start + 4 > d->end)
+    return -1;
+  int32_t rel = read_4sbyte_unaligned_inc (*d->param_start);
+  return dec_target (d, rel);
+}
+
+
+static int
+dec_ds_xx (struct output_data *d)
+{
+  int prefix = *d->prefixes & SEGMENT_PREFIXES;
+
+  if (prefix == 0)
+    *d->prefixes |= prefix = has_ds;
+  /* Make sure only one bit is set.  */
+  else if ((prefix - 1) & prefix)
+    return -1;
+
+  take_data_prefix (d);
+  return dec_operand (d, DISASM_OP_MEM, 0);
+}
+
+#define DEC_ds_bx dec_ds_xx
+#define DEC_ds_si dec_ds_xx
+
+
+static int
+DEC_es_di (struct output_data *d)
+{
+  return dec_operand (d, DISASM_OP_MEM, 0);
+}
+
+
+static int
+DEC_imm (struct output_data *d)
+{
+  int64_t value;
+  if (*d->prefixes & has_data16)
+    {
+      if (*d->param_start + 2 > d->end)
+	return -1;
+      value = read_2ubyte_unaligned_inc (*d->param_start);
+    }
+  else
+    {
+      if (*d->param_start + 4 > d->end)
+	return -1;
+      value = read_4sbyte_unaligned_inc (*d->param_start);
+    }
+  return dec_operand (d, DISASM_OP_IMM, value);
+}
+
+
+static int
+DEC_imm8 (struct output_data *d)
+{
+  if (*d->param_start >= d->end)
+    return -1;
+  uint_fast8_t byte = *(*d->param_start)++;
+  return dec_operand (d, DISASM_OP_IMM, byte);
+}
+
+
+static int
+DEC_imm$w (struct output_data *d)
+{
+  if ((d->data[d->opoff2 / 8] & (1 << (7 - (d->opoff2 & 7)))) != 0)
+    return DEC_imm (d);
+  return DEC_imm8 (d);
+}
+
+
+#ifdef X86_64
+static int
+DEC_imm64$w (struct output_data *d)
+{
+  if ((d->data[d->opoff2 / 8] & (1 << (7 - (d->opoff2 & 7)))) == 0
+      || (*d->prefixes & has_data16) != 0)
+    return DEC_imm$w (d);
+
+  int64_t value;
+  if (*d->prefixes & has_rex_w)
+    {
+      if (*d->param_start + 8 > d->end)
+	return -1;
+      value = read_8ubyte_unaligned_inc (*d->param_start);
+    }
+  else
+    {
+      if (*d->param_start + 4 > d->end)
+	return -1;
+      value = read_4sbyte_unaligned_inc (*d->param_start);
+    }
+  return dec_operand (d, DISASM_OP_IMM, value);
+}
+#endif
+
+
+static int
+DEC_imms (struct output_data *d)
+{
+  if (*d->param_start >= d->end)
+    return -1;
+  int8_t byte = *(*d->param_start)++;
+  return dec_operand (d, DISASM_OP_IMM, byte);
+}
+
+#define DEC_imms8 DEC_imms
+
+
+static int
+DEC_imm$s (struct output_data *d)
+{
+  uint_fast8_t opcode = d->data[d->opoff2 / 8];
+  if ((opcode & 2) != 0)
+    return DEC_imms (d);
+  return DEC_imm (d);
+}
+
+
+static int
+DEC_imm16 (struct output_data *d)
+{
+  if (*d->param_start + 2 > d->end)
+    return -1;
+  uint16_t word = read_2ubyte_unaligned_inc (*d->param_start);
+  return dec_operand (d, DISASM_OP_IMM, word);
+}
+
+
+static int
+DEC_sel (struct output_data *d)
+{
+  if (*d->param_start + 2 >= d->end)
+    return -1;
+  *d->param_start += 2;
+  uint16_t absval = read_2ubyte_unaligned (&d->data[5]);
+  return dec_operand (d, DISASM_OP_IMM, absval);
+}
@@ -264,6 +264,8 @@ struct output_data
       addr_rel_always
     } symaddr_use;
   GElf_Addr symaddr;
+  /* Set when decoding without producing output.  */
+  DisasmInsn *insn;
 };
 
 
@@ -298,14 +300,207 @@ struct output_data
   } while (0)
 
 
-int
-i386_disasm (Ebl *ebl __attribute__((unused)),
-	     const uint8_t **startp, const uint8_t *end, GElf_Addr addr,
-	     const char *fmt, DisasmOutputCB_t outcb, DisasmGetSymCB_t symcb,
-	     void *outcbarg, void *symcbarg)
+/* One element of the output format string.  */
+struct fmt_op
+{
+  enum
+    {
+      fmt_text,			/* Literal text.  */
+      fmt_conv,			/* A %-conversion.  */
+      fmt_einval		/* Invalid escape sequence.  */
+    } kind;
+
+  /* Conversion character, field width and precision.  */
+  char conv;
+  int width;
+  int prec;
+
+  /* The literal text or, for a conversion, the color escape sequence
+     which precedes it.  */
+  const char *str;
+  size_t len;
+};
+
+
+/* Parse the format string FMT once instead of for every instruction.
+   The escape sequences in literal text are decoded.  The decoded text
+   lives in the same allocation as the returned array.  Walking the
+   array costs nothing measurable: a copy of disasm_core specialized
+   for the format of eu-objdump was no faster in tests/disasm-bench.
+   The formatting time is spent in the operand functions.  */
+static struct fmt_op *
+compile_fmt (const char *fmt, size_t *nopsp)
+{
+  size_t fmtlen = strlen (fmt);
+  struct fmt_op *ops = malloc ((fmtlen + 1) * sizeof (*ops) + fmtlen);
+  if (ops == NULL)
+    return NULL;
+
+  char *text = (char *) &ops[fmtlen + 1];
+  size_t nops = 0;
+  const char *deferred_start = NULL;
+  size_t deferred_len = 0;
+  while (*fmt != '\0')
+    {
+      if (*fmt != '%')
+	{
+	  char ch = *fmt++;
+	  if (ch == '\\')
+	    {
+	      switch ((ch = *fmt++))
+		{
+		case '0' ... '7':
+		  {
+		    int val = ch - '0';
+		    ch = *fmt;
+		    if (ch >= '0' && ch <= '7')
+		      {
+			val *= 8;
+			val += ch - '0';
+			ch = *++fmt;
+			if (ch >= '0' && ch <= '7' && val < 32)
+			  {
+			    val *= 8;
+			    val += ch - '0';
+			    ++fmt;
+			  }
+		      }
+		    ch = val;
+		  }
+		  break;
+
+		case 'n':
+		  ch = '\n';
+		  break;
+
+		case 't':
+		  ch = '\t';
+		  break;
+
+		default:
+		  ops[nops++] = (struct fmt_op) { .kind = fmt_einval };
+		  goto out;
+		}
+	    }
+	  else if (ch == '\e' && *fmt == '[')
+	    {
+	      deferred_start = fmt - 1;
+	      do
+		++fmt;
+	      while (*fmt != 'm' && *fmt != '\0');
+
+	      if (*fmt == 'm')
+		{
+		  deferred_len = ++fmt - deferred_start;
+		  continue;
+		}
+
+	      fmt = deferred_start + 1;
+	      deferred_start = NULL;
+	    }
+
+	  if (nops == 0 || ops[nops - 1].kind != fmt_text)
+	    ops[nops++] = (struct fmt_op) { .kind = fmt_text, .str = text };
+	  *text++ = ch;
+	  ++ops[nops - 1].len;
+	  continue;
+	}
+      ++fmt;
+
+      int width = 0;
+      while (isdigit (*fmt))
+	width = width * 10 + (*fmt++ - '0');
+
+      int prec = 0;
+      if (*fmt == '.')
+	while (isdigit (*++fmt))
+	  prec = prec * 10 + (*fmt - '0');
+
+      ops[nops++] = (struct fmt_op)
+	{
+	  .kind = fmt_conv,
+	  .conv = *fmt,
+	  .width = width,
+	  .prec = prec,
+	  .str = deferred_start,
+	  .len = deferred_start != NULL ? deferred_len : 0
+	};
+      deferred_start = NULL;
+
+      /* A missing conversion character is diagnosed when used.  */
+      if (*fmt == '\0')
+	break;
+      ++fmt;
+    }
+
+ out:
+  *nopsp = nops;
+  return ops;
+}
+
+
+/* Control flow class of the instruction with MNEMONIC whose opcode
+   starts at DATA.  */
+static DisasmInsnClass
+insn_class (unsigned int mnemonic, const uint8_t *data)
 {
-  const char *save_fmt = fmt;
+  switch (mnemonic)
+    {
+    case MNE_call:
+    case MNE_lcall:
+      return DISASM_INSN_CALL;
+    case MNE_jmp:
+    case MNE_ljmp:
+      return DISASM_INSN_JUMP;
+    case MNE_j:
+    case MNE_loop:
+    case MNE_loope:
+    case MNE_loopne:
+      return DISASM_INSN_COND_JUMP;
+    case MNE_ret:
+    case MNE_lret:
+    case MNE_iret:
+      return DISASM_INSN_RETURN;
+    case MNE_INVALID:
+      /* jcxz and friends.  */
+      if (*data == 0xe3)
+	return DISASM_INSN_COND_JUMP;
+      break;
+    }
+  return DISASM_INSN_OTHER;
+}
+
+
+static void
+decode_finish (DisasmInsn *insn, DisasmInsnClass class,
+	       const char *mne, size_t len)
+{
+  insn->insn_class = class;
+  if (len >= sizeof (insn->mnemonic))
+    len = sizeof (insn->mnemonic) - 1;
+  memcpy (insn->mnemonic, mne, len);
+  insn->mnemonic[len] = '\0';
+}
 
+
+static void
+decode_reset (DisasmInsn *insn)
+{
+  insn->nops = 0;
+  insn->has_target = false;
+  insn->has_memop = false;
+}
+
+
+/* Disassemble starting at *STARTP.  If INSN is NULL every instruction is
+   formatted according to FMTOPS and passed to OUTCB.  Otherwise only the
+   first instruction is decoded into INSN and no output is produced.  */
+static int
+disasm_core (const uint8_t **startp, const uint8_t *end, GElf_Addr addr,
+	     const struct fmt_op *fmtops, size_t nfmtops,
+	     DisasmOutputCB_t outcb, DisasmGetSymCB_t symcb,
+	     void *outcbarg, void *symcbarg, DisasmInsn *insn)
+{
 #define BUFSIZE 512
   char initbuf[BUFSIZE];
   int prefixes;
@@ -321,7 +516,8 @@ i386_disasm (Ebl *ebl __attribute__((unused)),
       .bufsize = bufsize,
       .bufcntp = &bufcnt,
       .param_start = &param_start,
-      .end = end
+      .end = end,
+      .insn = insn
     };
 
   int retval = 0;
@@ -356,8 +552,8 @@ i386_disasm (Ebl *ebl __attribute__((unused)),
       bufcnt = 0;
       size_t cnt = 0;
 
-      const uint8_t *curr = match_data;
-      const uint8_t *const match_end = match_data + sizeof (match_data);
+      const uint16_t *cand = NULL;
+      const uint16_t *cand_end = NULL;
 
       assert (data <= end);
       if (data == end)
@@ -369,16 +565,32 @@ i386_disasm (Ebl *ebl __attribute__((unused)),
 	  goto do_ret;
 	}
 
+      /* Only the entries which can match the first opcode byte, and for
+	 the 0x0f escape also the second one, need to be tried.  They are
+	 listed in the same order as in match_data.  */
+      if (*data == 0x0f && end - data > 1)
+	{
+	  cand = match_list + match_0f[data[1]];
+	  cand_end = match_list + match_0f[data[1] + 1];
+	}
+      else
+	{
+	  cand = match_list + match_first[*data];
+	  cand_end = match_list + match_first[*data + 1];
+	}
+
     next_match:
-      while (curr < match_end)
+      while (cand < cand_end)
 	{
+	  cnt = *cand;
+	  const uint8_t *curr = match_data + match_off[cnt];
 	  uint_fast8_t len = *curr++;
 	  uint_fast8_t clen = len >> 4;
 	  len &= 0xf;
-	  const uint8_t *next_curr = curr + clen + (len - clen) * 2;
 
 	  assert (len > 0);
-	  assert (curr + clen + 2 * (len - clen) <= match_end);
+	  assert (curr + clen + 2 * (len - clen)
+		  <= match_data + sizeof (match_data));
 
 	  const uint8_t *codep = data;
 	  int correct_prefix = 0;
@@ -416,8 +628,7 @@ i386_disasm (Ebl *ebl __attribute__((unused)),
 	      if (masked != *curr++)
 		{
 		not:
-		  curr = next_curr;
-		  ++cnt;
+		  ++cand;
 		  bufcnt = 0;
 		  goto next_match;
 		}
@@ -470,7 +681,7 @@ i386_disasm (Ebl *ebl __attribute__((unused)),
 		 are not used uninitialized.  */
 	      __asm (""
 		     : "=mr" (opoff), "=mr" (correct_prefix), "=mr" (codep),
-		     "=mr" (next_curr), "=mr" (len));
+		     "=mr" (len));
 	    }
 
 	  size_t prefix_size = 0;
@@ -571,6 +782,12 @@ i386_disasm (Ebl *ebl __attribute__((unused)),
 	      data = begin + 1;
 	      ++addr;
 
+	      if (insn != NULL)
+		{
+		  decode_reset (insn);
+		  decode_finish (insn, DISASM_INSN_OTHER, buf, bufcnt);
+		}
+
 	      goto out;
 	    }
 
@@ -614,87 +831,42 @@ i386_disasm (Ebl *ebl __attribute__((unused)),
 	  output_data.addr = addr + (data - begin);
 	  output_data.data = data;
 
+	  if (insn != NULL)
+	    {
+	      /* Forget what an entry which did not match left behind.  */
+	      decode_reset (insn);
+	      output_data.symaddr_use = addr_none;
+	    }
+
 	  unsigned long string_end_idx = 0;
-	  fmt = save_fmt;
+	  size_t mne_start = 0;
+	  size_t mne_end = 0;
 	  const char *deferred_start = NULL;
 	  size_t deferred_len = 0;
 	  // XXX Can we get this from color.c?
 	  static const char color_off[] = "\e[0m";
-	  while (*fmt != '\0')
+	  for (size_t opcnt = 0; opcnt < nfmtops; ++opcnt)
 	    {
-	      if (*fmt != '%')
+	      const struct fmt_op *op = &fmtops[opcnt];
+	      if (op->kind == fmt_text)
 		{
-		  char ch = *fmt++;
-		  if (ch == '\\')
-		    {
-		      switch ((ch = *fmt++))
-			{
-			case '0' ... '7':
-			  {
-			    int val = ch - '0';
-			    ch = *fmt;
-			    if (ch >= '0' && ch <= '7')
-			      {
-				val *= 8;
-				val += ch - '0';
-				ch = *++fmt;
-				if (ch >= '0' && ch <= '7' && val < 32)
-				  {
-				    val *= 8;
-				    val += ch - '0';
-				    ++fmt;
-				  }
-			      }
-			    ch = val;
-			  }
-			  break;
-
-			case 'n':
-			  ch = '\n';
-			  break;
-
-			case 't':
-			  ch = '\t';
-			  break;
-
-			default:
-			  retval = EINVAL;
-			  goto do_ret;
-			}
-		    }
-		  else if (ch == '\e' && *fmt == '[')
-		    {
-		      deferred_start = fmt - 1;
-		      do
-			++fmt;
-		      while (*fmt != 'm' && *fmt != '\0');
-
-		      if (*fmt == 'm')
-			{
-			  deferred_len = ++fmt - deferred_start;
-			  continue;
-			}
-
-		      fmt = deferred_start + 1;
-		      deferred_start = NULL;
-		    }
-		  ADD_CHAR (ch);
+		  ADD_NSTRING (op->str, op->len);
 		  continue;
 		}
-	      ++fmt;
-
-	      int width = 0;
-	      while (isdigit (*fmt))
-		width = width * 10 + (*fmt++ - '0');
+	      if (op->kind == fmt_einval)
+		{
+		  retval = EINVAL;
+		  goto do_ret;
+		}
 
-	      int prec = 0;
-	      if (*fmt == '.')
-		while (isdigit (*++fmt))
-		  prec = prec * 10 + (*fmt - '0');
+	      int width = op->width;
+	      int prec = op->prec;
+	      deferred_start = op->str;
+	      deferred_len = op->len;
 
 	      size_t start_idx = bufcnt;
 	      size_t non_printing = 0;
-	      switch (*fmt++)
+	      switch (op->conv)
 		{
 		  char mnebuf[16];
 		  const char *str;
@@ -825,6 +997,7 @@ i386_disasm (Ebl *ebl __attribute__((unused)),
 		      non_printing += deferred_len;
 		    }
 
+		  mne_start = bufcnt;
 		  ADD_STRING (str);
 
 		  switch (instrtab[cnt].suffix)
@@ -907,6 +1080,7 @@ i386_disasm (Ebl *ebl __attribute__((unused)),
 		      printf("unknown suffix %d\n", instrtab[cnt].suffix);
 		      abort ();
 		    }
+		  mne_end = bufcnt;
 
 		  if (deferred_start != NULL)
 		    {
@@ -937,7 +1111,8 @@ i386_disasm (Ebl *ebl __attribute__((unused)),
 					    + OFF1_2_BIAS - opoff);
 		      output_data.opoff3 = (instrtab[cnt].off1_3
 					    + OFF1_3_BIAS - opoff);
-		      int r = op1_fct[instrtab[cnt].fct1] (&output_data);
+		      int r = (insn != NULL ? op1_dec : op1_fct)
+			[instrtab[cnt].fct1] (&output_data);
 		      if (r < 0)
 			goto not;
 		      if (r > 0)
@@ -970,7 +1145,8 @@ i386_disasm (Ebl *ebl __attribute__((unused)),
 					    + OFF2_2_BIAS - opoff);
 		      output_data.opoff3 = (instrtab[cnt].off2_3
 					    + OFF2_3_BIAS - opoff);
-		      int r = op2_fct[instrtab[cnt].fct2] (&output_data);
+		      int r = (insn != NULL ? op2_dec : op2_fct)
+			[instrtab[cnt].fct2] (&output_data);
 		      if (r < 0)
 			goto not;
 		      if (r > 0)
@@ -1007,7 +1183,8 @@ i386_disasm (Ebl *ebl __attribute__((unused)),
 #else
 		      output_data.opoff3 = 0;
 #endif
-		      int r = op3_fct[instrtab[cnt].fct3] (&output_data);
+		      int r = (insn != NULL ? op3_dec : op3_fct)
+			[instrtab[cnt].fct3] (&output_data);
 		      if (r < 0)
 			goto not;
 		      if (r > 0)
@@ -1107,6 +1284,16 @@ i386_disasm (Ebl *ebl __attribute__((unused)),
 	  assert (string_end_idx != ~0ul);
 	  bufcnt = string_end_idx;
 
+	  if (insn != NULL)
+	    {
+	      if (output_data.symaddr_use == addr_rel_always)
+		for (unsigned int i = 0; i < insn->nops; ++i)
+		  if (insn->ops[i].kind == DISASM_OP_MEMADDR)
+		    insn->ops[i].value += addr + param_start - begin;
+	      decode_finish (insn, insn_class (instrtab[cnt].mnemonic, data),
+			     &buf[mne_start], mne_end - mne_start);
+	    }
+
 	  addr += param_start - begin;
 	  data = param_start;
 
@@ -1123,12 +1310,23 @@ i386_disasm (Ebl *ebl __attribute__((unused)),
       ADD_STRING ("(bad)");
       addr += data - begin;
 
+      if (insn != NULL)
+	{
+	  decode_reset (insn);
+	  decode_finish (insn, DISASM_INSN_INVALID, buf, bufcnt);
+	}
+
     out:
       if (bufcnt == bufsize)
 	goto enomem;
       buf[bufcnt] = '\0';
 
       *startp = data;
+      if (insn != NULL)
+	{
+	  insn->length = data - begin;
+	  goto do_ret;
+	}
       retval = outcb (buf, bufcnt, outcbarg);
       if (retval != 0)
 	goto do_ret;
@@ -1139,5 +1337,51 @@ i386_disasm (Ebl *ebl __attribute__((unused)),
   if (buf != initbuf)
     free (buf);
 
+  /* Not even one complete instruction.  */
+  if (insn != NULL && insn->length == 0 && retval == 0)
+    retval = -1;
+
+  return retval;
+}
+
+
+int
+i386_disasm (Ebl *ebl __attribute__((unused)),
+	     const uint8_t **startp, const uint8_t *end, GElf_Addr addr,
+	     const char *fmt, DisasmOutputCB_t outcb, DisasmGetSymCB_t symcb,
+	     void *outcbarg, void *symcbarg)
+{
+  size_t nfmtops;
+  struct fmt_op *fmtops = compile_fmt (fmt, &nfmtops);
+  if (fmtops == NULL)
+    return ENOMEM;
+
+  int retval = disasm_core (startp, end, addr, fmtops, nfmtops, outcb,
+			    symcb, outcbarg, symcbarg, NULL);
+
+  free (fmtops);
   return retval;
 }
+
+
+int
+i386_disasm_decode (Ebl *ebl __attribute__((unused)),
+		    const uint8_t **startp, const uint8_t *end,
+		    GElf_Addr addr, DisasmInsn *insn)
+{
+  /* The mnemonic followed by the operands in the order they are
+     printed.  */
+  static const struct fmt_op decode_fmt[] =
+    {
+      { .kind = fmt_conv, .conv = 'm' },
+      { .kind = fmt_conv, .conv = 'o', .prec = 1 },
+      { .kind = fmt_conv, .conv = 'o', .prec = 2 },
+      { .kind = fmt_conv, .conv = 'o', .prec = 3 }
+    };
+
+  insn->length = 0;
+  decode_reset (insn);
+  return disasm_core (startp, end, addr, decode_fmt,
+		      sizeof (decode_fmt) / sizeof (decode_fmt[0]),
+		      NULL, NULL, NULL, NULL, insn);
+}
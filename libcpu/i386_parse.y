@@ -153,6 +153,14 @@ struct argstring
 };
 
 
+/* Encoded match pattern of one instruction as written to match_data.  */
+struct match_enc
+{
+  uint8_t len;
+  uint8_t bytes[1 + 2 * 15];
+};
+
+
 static struct known_bitfield ax_reg =
   {
     .name = "ax", .bits = 0, .tmp = 0
@@ -194,6 +202,7 @@ static void find_numbers (void);
 static int compare_syn (const void *p1, const void *p2);
 static int compare_suf (const void *p1, const void *p2);
 static void instrtable_out (void);
+static void dispatch_out (const struct match_enc *encs, size_t nencs);
 #if 0
 static void create_mnemonic_table (void);
 #endif
@@ -1109,6 +1118,14 @@ print_op_fct (const void *nodep, VISIT value,
     }
 }
 
+static void
+print_op_dec (const void *nodep, VISIT value,
+	      int level __attribute__ ((unused)))
+{
+  if (value == leaf || value == postorder)
+    fprintf (outfile, "  DEC_%s,\n", (*(struct argstring **) nodep)->str);
+}
+
 static void
 instrtable_out (void)
 {
@@ -1169,6 +1186,12 @@ instrtable_out (void)
       twalk (fct_names[i], print_op_fct);
       fputs ("};\n", outfile);
 
+      /* The matching decode-only functions, in the same order.  */
+      fprintf (outfile, "static const opfct_t op%d_dec[] =\n{\n  NULL,\n",
+	       i + 1);
+      twalk (fct_names[i], print_op_dec);
+      fputs ("};\n", outfile);
+
       /* The operand strings.  */
       if (nbitstr[i] != 0)
 	{
@@ -1241,10 +1264,22 @@ instrtable_out (void)
     }
   fputs ("};\n", outfile);
 
+  /* The encoded match patterns are kept to compute the dispatch
+     tables below.  Each one is at most one length byte plus a mask and
+     value pair for up to 15 bytes.  */
+  struct match_enc *encs = xcalloc (ninstructions, sizeof (*encs));
+
   fputs ("static const uint8_t match_data[] =\n{\n", outfile);
   size_t cnt = 0;
   for (instr = instructions; instr != NULL; instr = instr->next, ++cnt)
     {
+      struct match_enc *enc = &encs[cnt];
+#define EMIT_BYTE(val) \
+      do {								      \
+	assert (enc->len < sizeof (enc->bytes));			      \
+	enc->bytes[enc->len++] = (val);					      \
+      } while (0)
+
       /* First count the number of bytes.  */
       size_t totalbits = 0;
       size_t zerobits = 0;
@@ -1276,7 +1311,8 @@ instrtable_out (void)
       assert (nbytes > 0);
       size_t leadingbytes = leadingbits / 8;
 
-      fprintf (outfile, "  %#zx,", nbytes | (leadingbytes << 4));
+      assert (nbytes < 16 && leadingbytes < 16);
+      EMIT_BYTE (nbytes | (leadingbytes << 4));
 
       /* Now create the mask and byte values.  */
       uint8_t byte = 0;
@@ -1294,12 +1330,14 @@ instrtable_out (void)
 		  if (leadingbytes > 0)
 		    {
 		      assert (mask == 0xff);
-		      fprintf (outfile, " %#" PRIx8 ",", byte);
+		      EMIT_BYTE (byte);
 		      --leadingbytes;
 		    }
 		  else
-		    fprintf (outfile, " %#" PRIx8 ", %#" PRIx8 ",",
-			     mask, byte);
+		    {
+		      EMIT_BYTE (mask);
+		      EMIT_BYTE (byte);
+		    }
 		  byte = mask = nbits = 0;
 		  if (--nbytes == 0)
 		    break;
@@ -1312,8 +1350,8 @@ instrtable_out (void)
 	      unsigned long int remaining = b->field->bits;
 	      while (nbits + remaining > 8)
 		{
-		  fprintf (outfile, " %#" PRIx8 ", %#" PRIx8 ",",
-			   mask << (8 - nbits), byte << (8 - nbits));
+		  EMIT_BYTE (mask << (8 - nbits));
+		  EMIT_BYTE (byte << (8 - nbits));
 		  remaining = nbits + remaining - 8;
 		  byte = mask = nbits = 0;
 		  if (--nbytes == 0)
@@ -1324,7 +1362,8 @@ instrtable_out (void)
 	      nbits += remaining;
 	      if (nbits == 8)
 		{
-		  fprintf (outfile, " %#" PRIx8 ", %#" PRIx8 ",", mask, byte);
+		  EMIT_BYTE (mask);
+		  EMIT_BYTE (byte);
 		  byte = mask = nbits = 0;
 		  if (--nbytes == 0)
 		    break;
@@ -1332,13 +1371,142 @@ instrtable_out (void)
 	    }
 	  b = b->next;
 	}
+#undef EMIT_BYTE
 
+      fprintf (outfile, "  %#" PRIx8 ",", enc->bytes[0]);
+      for (size_t i = 1; i < enc->len; ++i)
+	fprintf (outfile, " %#" PRIx8 ",", enc->bytes[i]);
       fputc_unlocked ('\n', outfile);
     }
   fputs ("};\n", outfile);
+
+  dispatch_out (encs, cnt);
+
+  free (encs);
 }
 
 
+/* Return true if BYTE is a value the disassembler consumes as a prefix
+   (or REX prefix) before looking up the opcode.  */
+static bool
+prefix_byte_p (uint8_t byte)
+{
+  switch (byte)
+    {
+    case 0x26: case 0x2e: case 0x36: case 0x3e: case 0x64: case 0x65:
+    case 0x66: case 0x67: case 0xf0: case 0xf2: case 0xf3:
+    case 0x40 ... 0x4f:
+      return true;
+    default:
+      return false;
+    }
+}
+
+
+/* Return true if BYTE can match byte IDX of the encoded pattern ENC.
+   Bytes past the end of the pattern match anything.  */
+static bool
+match_byte_p (const struct match_enc *enc, size_t idx, uint8_t byte)
+{
+  size_t len = enc->bytes[0] & 0xf;
+  size_t clen = enc->bytes[0] >> 4;
+
+  if (idx >= len)
+    return true;
+  if (idx < clen)
+    return enc->bytes[1 + idx] == byte;
+
+  const uint8_t *mv = &enc->bytes[1 + clen + 2 * (idx - clen)];
+  return (byte & mv[0]) == mv[1];
+}
+
+
+/* Return true if the instruction with pattern ENC might match input
+   starting with the NCODE bytes at CODE.  This must never reject an
+   entry which the matcher in i386_disasm could accept or which would
+   make it stop early.  */
+static bool
+match_candidate_p (const struct match_enc *enc, const uint8_t *code,
+		   size_t ncode)
+{
+  size_t i;
+  for (i = 0; i < ncode; ++i)
+    if (! match_byte_p (enc, i, code[i]))
+      break;
+  if (i == ncode)
+    return true;
+
+  /* A leading exact byte equal to the last prefix is matched against
+     that prefix, the remaining pattern against the opcode bytes.  */
+  if ((enc->bytes[0] >> 4) == 0 || ! prefix_byte_p (enc->bytes[1]))
+    return false;
+
+  /* A REX byte does not count as a legacy prefix, the matcher gives up
+     on the instruction without looking at the opcode.  */
+  if ((enc->bytes[1] & 0xf0) == 0x40)
+    return true;
+
+  for (i = 0; i < ncode; ++i)
+    if (! match_byte_p (enc, i + 1, code[i]))
+      return false;
+  return true;
+}
+
+
+/* Emit the offset of each entry in match_data and, for every possible
+   first opcode byte, the list of entries which need to be tried.  The
+   0x0f escape is additionally split by the second opcode byte.  */
+static void
+dispatch_out (const struct match_enc *encs, size_t nencs)
+{
+  fputs ("static const uint16_t match_off[] =\n{", outfile);
+  size_t off = 0;
+  for (size_t cnt = 0; cnt < nencs; ++cnt)
+    {
+      assert (off <= UINT16_MAX);
+      fprintf (outfile, "%s%zu,", cnt % 12 == 0 ? "\n  " : " ", off);
+      off += encs[cnt].len;
+    }
+  fputs ("\n};\n", outfile);
+
+  size_t first[257];
+  size_t second[257];
+  size_t nlist = 0;
+
+  fputs ("static const uint16_t match_list[] =\n{\n", outfile);
+  for (int pass = 0; pass < 2; ++pass)
+    for (unsigned int byte = 0; byte < 256; ++byte)
+      {
+	uint8_t code[2] = { pass == 0 ? byte : 0x0f, byte };
+	(pass == 0 ? first : second)[byte] = nlist;
+
+	bool any = false;
+	for (size_t cnt = 0; cnt < nencs; ++cnt)
+	  if (match_candidate_p (&encs[cnt], code, pass + 1))
+	    {
+	      fprintf (outfile, "%s%zu,", any ? " " : "  ", cnt);
+	      any = true;
+	      ++nlist;
+	    }
+	if (any)
+	  fprintf (outfile, "  /* %s%#x */\n", pass == 0 ? "" : "0x0f ",
+		   byte);
+      }
+  first[256] = second[256] = nlist;
+  assert (nlist <= UINT16_MAX);
+  fputs ("};\n", outfile);
+
+  for (int pass = 0; pass < 2; ++pass)
+    {
+      fprintf (outfile, "static const uint16_t %s[] =\n{",
+	       pass == 0 ? "match_first" : "match_0f");
+      for (unsigned int byte = 0; byte <= 256; ++byte)
+	fprintf (outfile, "%s%zu,", byte % 12 == 0 ? "\n  " : " ",
+		 (pass == 0 ? first : second)[byte]);
+      fputs ("\n};\n", outfile);
+    }
+}
+
 #if 0
 static size_t mnemonic_maxlen;
 static size_t mnemonic_minlen;
@@ -108,6 +108,1000 @@ static int compare_csr (const void *a, const void *b)
 }
 
 
+/* Names of the CSRs.  */
+static const struct known_csrs csr_names[] =
+  {
+    // This list must remain sorted by NR.
+    { 0x000, "ustatus" },
+    { 0x001, "fflags" },
+    { 0x002, "fram" },
+    { 0x003, "fcsr" },
+    { 0x004, "uie" },
+    { 0x005, "utvec" },
+    { 0x040, "uscratch" },
+    { 0x041, "uepc" },
+    { 0x042, "ucause" },
+    { 0x043, "utval" },
+    { 0x044, "uip" },
+    { 0x100, "sstatus" },
+    { 0x102, "sedeleg" },
+    { 0x103, "sideleg" },
+    { 0x104, "sie" },
+    { 0x105, "stvec" },
+    { 0x106, "scounteren" },
+    { 0x140, "sscratch" },
+    { 0x141, "sepc" },
+    { 0x142, "scause" },
+    { 0x143, "stval" },
+    { 0x144, "sip" },
+    { 0x180, "satp" },
+    { 0x200, "vsstatus" },
+    { 0x204, "vsie" },
+    { 0x205, "vstvec" },
+    { 0x240, "vsscratch" },
+    { 0x241, "vsepc" },
+    { 0x242, "vscause" },
+    { 0x243, "vstval" },
+    { 0x244, "vsip" },
+    { 0x280, "vsatp" },
+    { 0x600, "hstatus" },
+    { 0x602, "hedeleg" },
+    { 0x603, "hideleg" },
+    { 0x605, "htimedelta" },
+    { 0x606, "hcounteren" },
+    { 0x615, "htimedeltah" },
+    { 0x680, "hgatp" },
+    { 0xc00, "cycle" },
+    { 0xc01, "time" },
+    { 0xc02, "instret" },
+    { 0xc03, "hpmcounter3" },
+    { 0xc04, "hpmcounter4" },
+    { 0xc05, "hpmcounter5" },
+    { 0xc06, "hpmcounter6" },
+    { 0xc07, "hpmcounter7" },
+    { 0xc08, "hpmcounter8" },
+    { 0xc09, "hpmcounter9" },
+    { 0xc0a, "hpmcounter10" },
+    { 0xc0b, "hpmcounter11" },
+    { 0xc0c, "hpmcounter12" },
+    { 0xc0d, "hpmcounter13" },
+    { 0xc0e, "hpmcounter14" },
+    { 0xc0f, "hpmcounter15" },
+    { 0xc10, "hpmcounter16" },
+    { 0xc11, "hpmcounter17" },
+    { 0xc12, "hpmcounter18" },
+    { 0xc13, "hpmcounter19" },
+    { 0xc14, "hpmcounter20" },
+    { 0xc15, "hpmcounter21" },
+    { 0xc16, "hpmcounter22" },
+    { 0xc17, "hpmcounter23" },
+    { 0xc18, "hpmcounter24" },
+    { 0xc19, "hpmcounter25" },
+    { 0xc1a, "hpmcounter26" },
+    { 0xc1b, "hpmcounter27" },
+    { 0xc1c, "hpmcounter28" },
+    { 0xc1d, "hpmcounter29" },
+    { 0xc1e, "hpmcounter30" },
+    { 0xc1f, "hpmcounter31" },
+    { 0xc80, "cycleh" },
+    { 0xc81, "timeh" },
+    { 0xc82, "instreth" },
+    { 0xc83, "hpmcounter3h" },
+    { 0xc84, "hpmcounter4h" },
+    { 0xc85, "hpmcounter5h" },
+    { 0xc86, "hpmcounter6h" },
+    { 0xc87, "hpmcounter7h" },
+    { 0xc88, "hpmcounter8h" },
+    { 0xc89, "hpmcounter9h" },
+    { 0xc8a, "hpmcounter10h" },
+    { 0xc8b, "hpmcounter11h" },
+    { 0xc8c, "hpmcounter12h" },
+    { 0xc8d, "hpmcounter13h" },
+    { 0xc8e, "hpmcounter14h" },
+    { 0xc8f, "hpmcounter15h" },
+    { 0xc90, "hpmcounter16h" },
+    { 0xc91, "hpmcounter17h" },
+    { 0xc92, "hpmcounter18h" },
+    { 0xc93, "hpmcounter19h" },
+    { 0xc94, "hpmcounter20h" },
+    { 0xc95, "hpmcounter21h" },
+    { 0xc96, "hpmcounter22h" },
+    { 0xc97, "hpmcounter23h" },
+    { 0xc98, "hpmcounter24h" },
+    { 0xc99, "hpmcounter25h" },
+    { 0xc9a, "hpmcounter26h" },
+    { 0xc9b, "hpmcounter27h" },
+    { 0xc9c, "hpmcounter28h" },
+    { 0xc9d, "hpmcounter29h" },
+    { 0xc9e, "hpmcounter30h" },
+    { 0xc9f, "hpmcounter31h" },
+  };
+
+
+/* Length of the instruction which starts with the 16-bit parcel FIRST.  */
+static size_t
+insn_length (uint16_t first)
+{
+  if ((first & 0x3) != 0x3)
+    return 2;
+  if ((first & 0x1f) != 0x1f)
+    return 4;
+  if ((first & 0x3f) != 0x3f)
+    return 6;
+  if ((first & 0x7f) != 0x7f)
+    return 8;
+
+  uint16_t nnn = (first >> 12) & 0x7;
+  if (nnn != 0x7)
+    return 10 + 2 * nnn;
+
+  // This is invalid as of the RISC-V spec on 2019-06-21.
+  // The instruction is at least 192 bits in size so use
+  // this minimum size.
+  return 24;
+}
+
+
+/* Operand formats, named in defs/riscv without the fmt_ prefix.  */
+enum riscv_fmt
+  {
+    fmt_none,
+    fmt_fence,		/* pred, succ */
+    fmt_sfence,		/* rs1, rs2 */
+    fmt_r,		/* rd, rs1, rs2 */
+    fmt_i,		/* rd, rs1, imm */
+    fmt_shift,		/* rd, rs1, shamt */
+    fmt_load,		/* rd, imm(rs1) */
+    fmt_fload,		/* frd, imm(rs1) */
+    fmt_store,		/* rs2, imm(rs1) */
+    fmt_fstore,		/* frs2, imm(rs1) */
+    fmt_branch,		/* rs1, rs2, target */
+    fmt_u,		/* rd, imm */
+    fmt_jal,		/* rd, target */
+    fmt_jalr,		/* rd, imm(rs1) */
+    fmt_csr,		/* rd, csr, rs1 */
+    fmt_csri,		/* rd, csr, uimm */
+    fmt_amo,		/* rd, rs2, (rs1) */
+    fmt_lr,		/* rd, (rs1) */
+    fmt_fff,		/* frd, frs1, frs2 */
+    fmt_fff_rm,		/* frd, frs1, frs2, rm */
+    fmt_ffff_rm,	/* frd, frs1, frs2, frs3, rm */
+    fmt_fsgnj,		/* frd, frs1, frs2 */
+    fmt_ff,		/* frd, frs1 */
+    fmt_ff_rm,		/* frd, frs1, rm */
+    fmt_xf,		/* rd, frs1 */
+    fmt_xf_rm,		/* rd, frs1, rm */
+    fmt_xff,		/* rd, frs1, frs2 */
+    fmt_fx,		/* frd, rs1 */
+    fmt_fx_rm,		/* frd, rs1, rm */
+    fmt_c_addi4spn,	/* rd', sp, nzuimm */
+    fmt_c_lw,		/* rd', uimm(rs1') */
+    fmt_c_flw,
+    fmt_c_ld,
+    fmt_c_fld,
+    fmt_c_sw,		/* rs2', uimm(rs1') */
+    fmt_c_fsw,
+    fmt_c_sd,
+    fmt_c_fsd,
+    fmt_c_addi,		/* rd, rd, imm */
+    fmt_c_addiw,
+    fmt_c_li,		/* rd, imm */
+    fmt_c_addi16sp,	/* sp, sp, nzimm */
+    fmt_c_lui,		/* rd, nzimm */
+    fmt_c_shift,	/* rd', rd', shamt */
+    fmt_c_slli,		/* rd, rd, shamt */
+    fmt_c_andi,		/* rd', rd', imm */
+    fmt_c_arith,	/* rd', rd', rs2' */
+    fmt_c_j,		/* target */
+    fmt_c_branch,	/* rs1', target */
+    fmt_c_lwsp,		/* rd, uimm(sp) */
+    fmt_c_flwsp,
+    fmt_c_ldsp,
+    fmt_c_fldsp,
+    fmt_c_swsp,		/* rs2, uimm(sp) */
+    fmt_c_fswsp,
+    fmt_c_sdsp,
+    fmt_c_fsdsp,
+    fmt_c_jr,		/* rs1 */
+    fmt_c_mv,		/* rd, rs2 */
+    fmt_c_add		/* rd, rd, rs2 */
+  };
+
+struct riscv_opcode
+{
+  /* Name of the instruction.  */
+  const char *name;
+  /* Mnemonic used in the disassembler output.  Differs from NAME for
+     compressed instructions, which are shown as their expansion.  */
+  const char *mne;
+  uint32_t mask;
+  uint32_t match;
+  /* Zero if valid for both RV32 and RV64, otherwise ELFCLASS32 or
+     ELFCLASS64.  */
+  unsigned char class;
+  unsigned char fmt;
+};
+
+/* The buckets of one major opcode.  */
+struct riscv_dispatch
+{
+  uint16_t base;
+  unsigned char shift;
+  unsigned char mask;
+};
+
+/* The tables generated from defs/riscv.  */
+#include "riscv_dis.h"
+
+
+/* Return the entry of ENC, an instruction of LENGTH bytes, or NULL if
+   the encoding is not known for CLASS.  */
+static const struct riscv_opcode *
+riscv_lookup (uint32_t enc, size_t length, int class)
+{
+  const struct riscv_opcode *table;
+  size_t first;
+  size_t last;
+
+  if (length == 2)
+    {
+      size_t b = ((enc & 0x3) << 3) | (enc >> 13);
+      table = riscv_c_opcodes;
+      for (first = riscv_c_opcodes_idx[b], last = riscv_c_opcodes_idx[b + 1];
+	   first < last; ++first)
+	{
+	  const struct riscv_opcode *op
+	    = &table[riscv_c_opcodes_list[first]];
+	  if ((enc & op->mask) == op->match
+	      && (op->class == 0 || op->class == class))
+	    return op;
+	}
+    }
+  else if (length == 4)
+    {
+      const struct riscv_dispatch *d
+	= &riscv_opcodes_dispatch[(enc >> 2) & 0x1f];
+      size_t b = d->base + ((enc >> d->shift) & d->mask);
+      table = riscv_opcodes;
+      for (first = riscv_opcodes_idx[b], last = riscv_opcodes_idx[b + 1];
+	   first < last; ++first)
+	{
+	  const struct riscv_opcode *op = &table[riscv_opcodes_list[first]];
+	  if ((enc & op->mask) == op->match
+	      && (op->class == 0 || op->class == class))
+	    return op;
+	}
+    }
+
+  return NULL;
+}
+
+
+/* The operands of an instruction.  Register numbers are those of the
+   full register file, also for the compressed instructions.  */
+struct riscv_args
+{
+  unsigned int rd;
+  unsigned int rs1;
+  unsigned int rs2;
+  unsigned int rs3;
+  /* Immediate, offset, shift amount, or CSR number.  Branch and jump
+     offsets are relative to the instruction.  */
+  int64_t imm;
+};
+
+#define SEXT(val, bits) \
+  ((int64_t) ((uint64_t) (val) << (64 - (bits))) >> (64 - (bits)))
+
+/* Extract the operands of ENC, which matched OP, into ARGS.  Returns
+   false for reserved encodings.  */
+static bool
+extract_args (const struct riscv_opcode *op, uint32_t enc, int class,
+	      struct riscv_args *args)
+{
+  unsigned int rd = (enc >> 7) & 0x1f;
+  /* Register fields of the C extension.  */
+  unsigned int crs2 = (enc >> 2) & 0x1f;
+  unsigned int crdp = 8 + ((enc >> 2) & 0x7);
+  unsigned int crs1p = 8 + ((enc >> 7) & 0x7);
+  int64_t imm;
+
+  args->rd = rd;
+  args->rs1 = (enc >> 15) & 0x1f;
+  args->rs2 = (enc >> 20) & 0x1f;
+  args->rs3 = enc >> 27;
+  args->imm = 0;
+
+  switch (op->fmt)
+    {
+    case fmt_fence:
+      args->imm = (enc >> 20) & 0xff;
+      break;
+
+    case fmt_i:
+    case fmt_jalr:
+    case fmt_load:
+    case fmt_fload:
+      args->imm = (int32_t) enc >> 20;
+      break;
+
+    case fmt_shift:
+      args->imm = (enc >> 20) & (class == ELFCLASS32 ? 0x1f : 0x3f);
+      break;
+
+    case fmt_store:
+    case fmt_fstore:
+      args->imm = SEXT (((enc >> 20) & 0xfe0) | ((enc >> 7) & 0x1f), 12);
+      break;
+
+    case fmt_branch:
+      args->imm = SEXT (((enc >> 19) & 0x1000) | ((enc << 4) & 0x800)
+			| ((enc >> 20) & 0x7e0) | ((enc >> 7) & 0x1e), 13);
+      break;
+
+    case fmt_u:
+      args->imm = (int32_t) (enc & 0xfffff000);
+      break;
+
+    case fmt_jal:
+      args->imm = SEXT (((enc >> 11) & 0x100000) | (enc & 0xff000)
+			| ((enc >> 9) & 0x800) | ((enc >> 20) & 0x7fe), 21);
+      break;
+
+    case fmt_csr:
+    case fmt_csri:
+      args->imm = enc >> 20;
+      break;
+
+    case fmt_c_addi4spn:
+      imm = (((enc >> 7) & 0x30) | ((enc >> 1) & 0x3c0)
+	     | ((enc >> 4) & 0x4) | ((enc >> 2) & 0x8));
+      if (imm == 0)
+	return false;
+      args->rd = crdp;
+      args->rs1 = 2;
+      args->imm = imm;
+      break;
+
+    case fmt_c_lw:
+    case fmt_c_flw:
+    case fmt_c_sw:
+    case fmt_c_fsw:
+      args->imm = (((enc >> 7) & 0x38) | ((enc >> 4) & 0x4)
+		   | ((enc << 1) & 0x40));
+      args->rd = args->rs2 = crdp;
+      args->rs1 = crs1p;
+      break;
+
+    case fmt_c_ld:
+    case fmt_c_fld:
+    case fmt_c_sd:
+    case fmt_c_fsd:
+      args->imm = ((enc >> 7) & 0x38) | ((enc << 1) & 0xc0);
+      args->rd = args->rs2 = crdp;
+      args->rs1 = crs1p;
+      break;
+
+    case fmt_c_addi:
+    case fmt_c_addiw:
+    case fmt_c_li:
+    case fmt_c_lui:
+      imm = SEXT (((enc >> 7) & 0x20) | ((enc >> 2) & 0x1f), 6);
+      if (op->fmt == fmt_c_lui)
+	{
+	  if (imm == 0)
+	    return false;
+	  imm <<= 12;
+	}
+      else if (op->fmt == fmt_c_addiw && rd == 0)
+	return false;
+      args->rs1 = op->fmt == fmt_c_addi || op->fmt == fmt_c_addiw ? rd : 0;
+      args->imm = imm;
+      break;
+
+    case fmt_c_addi16sp:
+      imm = SEXT (((enc >> 3) & 0x200) | ((enc >> 2) & 0x10)
+		  | ((enc << 1) & 0x40) | ((enc << 4) & 0x180)
+		  | ((enc << 3) & 0x20), 10);
+      if (imm == 0)
+	return false;
+      args->rd = args->rs1 = 2;
+      args->imm = imm;
+      break;
+
+    case fmt_c_shift:
+    case fmt_c_slli:
+    case fmt_c_andi:
+      imm = ((enc >> 7) & 0x20) | ((enc >> 2) & 0x1f);
+      if (op->fmt == fmt_c_andi)
+	imm = SEXT (imm, 6);
+      else if (class == ELFCLASS32 && imm >= 32)
+	return false;
+      args->rd = args->rs1 = op->fmt == fmt_c_slli ? rd : crs1p;
+      args->imm = imm;
+      break;
+
+    case fmt_c_arith:
+      args->rd = args->rs1 = crs1p;
+      args->rs2 = crdp;
+      break;
+
+    case fmt_c_j:
+      args->imm = SEXT (((enc >> 1) & 0x800) | ((enc >> 7) & 0x10)
+			| ((enc >> 1) & 0x300) | ((enc << 2) & 0x400)
+			| ((enc >> 1) & 0x40) | ((enc << 1) & 0x80)
+			| ((enc >> 2) & 0xe) | ((enc << 3) & 0x20), 12);
+      break;
+
+    case fmt_c_branch:
+      args->rs1 = crs1p;
+      args->imm = SEXT (((enc >> 4) & 0x100) | ((enc >> 7) & 0x18)
+			| ((enc << 1) & 0xc0) | ((enc >> 2) & 0x6)
+			| ((enc << 3) & 0x20), 9);
+      break;
+
+    case fmt_c_lwsp:
+    case fmt_c_ldsp:
+    case fmt_c_flwsp:
+    case fmt_c_fldsp:
+      /* The integer loads may not use register zero.  */
+      if (rd == 0 && (op->fmt == fmt_c_lwsp || op->fmt == fmt_c_ldsp))
+	return false;
+      args->rs1 = 2;
+      if (op->fmt == fmt_c_lwsp || op->fmt == fmt_c_flwsp)
+	args->imm = (((enc >> 7) & 0x20) | ((enc >> 2) & 0x1c)
+		     | ((enc << 4) & 0xc0));
+      else
+	args->imm = (((enc >> 7) & 0x20) | ((enc >> 2) & 0x18)
+		     | ((enc << 4) & 0x1c0));
+      break;
+
+    case fmt_c_swsp:
+    case fmt_c_fswsp:
+      args->rs1 = 2;
+      args->rs2 = crs2;
+      args->imm = ((enc >> 7) & 0x3c) | ((enc >> 1) & 0xc0);
+      break;
+
+    case fmt_c_sdsp:
+    case fmt_c_fsdsp:
+      args->rs1 = 2;
+      args->rs2 = crs2;
+      args->imm = ((enc >> 7) & 0x38) | ((enc >> 1) & 0x1c0);
+      break;
+
+    case fmt_c_jr:
+      if (rd == 0)
+	return false;
+      args->rs1 = rd;
+      break;
+
+    case fmt_c_mv:
+    case fmt_c_add:
+      args->rs1 = rd;
+      args->rs2 = crs2;
+      break;
+
+    default:
+      break;
+    }
+
+  return true;
+}
+
+
+/* Store VAL in decimal at BUF and return BUF.  */
+static char *
+put_dec (char *buf, int64_t val)
+{
+  char tmp[20];
+  size_t n = 0;
+  uint64_t uval = val < 0 ? -(uint64_t) val : (uint64_t) val;
+  do
+    tmp[n++] = '0' + uval % 10;
+  while ((uval /= 10) != 0);
+
+  char *cp = buf;
+  if (val < 0)
+    *cp++ = '-';
+  while (n > 0)
+    *cp++ = tmp[--n];
+  *cp = '\0';
+  return buf;
+}
+
+/* Store VAL in hexadecimal with a 0x prefix at BUF and return BUF.  */
+static char *
+put_hex (char *buf, uint64_t val)
+{
+  int shift = 60;
+  while (shift > 0 && (val >> shift) == 0)
+    shift -= 4;
+
+  char *cp = buf;
+  *cp++ = '0';
+  *cp++ = 'x';
+  for (; shift >= 0; shift -= 4)
+    *cp++ = "0123456789abcdef"[(val >> shift) & 0xf];
+  *cp = '\0';
+  return buf;
+}
+
+/* Store the memory operand OFFSET(BASE) at BUF and return BUF.  */
+static char *
+put_mem (char *buf, int64_t offset, const char *base)
+{
+  char *cp = strchr (put_dec (buf, offset), '\0');
+  *cp++ = '(';
+  cp = stpcpy (cp, base);
+  *cp++ = ')';
+  *cp = '\0';
+  return buf;
+}
+
+
+static const char *const rndmode[8] =
+  {
+    "rne", "rtz", "rdn", "rup", "rmm", "???", "???", "dyn"
+  };
+
+static const char widthchar[4] = { 's', 'd', '\0', 'q' };
+
+
+/* Return the mnemonic for the instruction ENC at ADDR, which matched OPC
+   and has the operands ARGS, and store the operand strings in OP.
+   MNEBUF and OPBUF provide space for text which is not constant.  */
+static const char *
+format_insn (const struct riscv_opcode *opc, const struct riscv_args *args,
+	     uint32_t enc, GElf_Addr addr, char *op[5], char *mnebuf,
+	     char opbuf[2][32])
+{
+  const char *mne = opc->mne;
+  unsigned int rd = args->rd;
+  unsigned int rs1 = args->rs1;
+  unsigned int rs2 = args->rs2;
+  int64_t imm = args->imm;
+  uint32_t func = (enc >> 12) & 0x7;
+  uint32_t width = (enc >> 25) & 0x3;
+  uint32_t rm = func;
+  size_t next;
+
+  switch (opc->fmt)
+    {
+    case fmt_none:
+      break;
+
+    case fmt_fence:
+      if (imm != 0xff)
+	{
+	  static const char *const order[16] =
+	    {
+	      "unknown", "w", "r", "rw", "o", "ow", "or", "orw",
+	      "i", "iw", "ir", "irw", "io", "iow", "ior", "iorw"
+	    };
+	  op[0] = (char *) order[imm >> 4];
+	  op[1] = (char *) order[imm & 0xf];
+	}
+      break;
+
+    case fmt_sfence:
+      if (rs1 != 0 || rs2 != 0)
+	op[0] = REG (rs1);
+      if (rs2 != 0)
+	op[1] = REG (rs2);
+      break;
+
+    case fmt_r:
+      {
+	bool op32 = (enc & 0x7f) == 0x3b;
+	uint32_t func7 = enc >> 25;
+	op[0] = REG (rd);
+	if (func7 == 0x20 && func == 0 && rs1 == 0)
+	  {
+	    mne = op32 ? "negw" : "neg";
+	    op[1] = REG (rs2);
+	  }
+	else if (! op32 && func7 == 0 && func == 2 && rs2 == 0)
+	  {
+	    mne = "sltz";
+	    op[1] = REG (rs1);
+	  }
+	else if (! op32 && func7 == 0 && (func == 2 || func == 3) && rs1 == 0)
+	  {
+	    mne = func == 2 ? "sgtz" : "snez";
+	    op[1] = REG (rs2);
+	  }
+	else
+	  {
+	    op[1] = REG (rs1);
+	    op[2] = REG (rs2);
+	  }
+      }
+      break;
+
+    case fmt_i:
+      {
+	bool op32 = (enc & 0x7f) == 0x1b;
+	op[0] = REG (rd);
+	op[1] = REG (rs1);
+	if (func == 0 && rs1 == 0 && rd != 0)
+	  {
+	    mne = op32 ? "liw" : "li";
+	    op[1] = put_dec (opbuf[0], imm);
+	  }
+	else if (func == 0 && imm == 0)
+	  {
+	    if (op32)
+	      mne = "sext.w";
+	    else if (rd == 0)
+	      {
+		mne = "nop";
+		op[0] = op[1] = NULL;
+	      }
+	    else
+	      mne = "mv";
+	  }
+	else if (func == 3 && imm == 1)
+	  mne = "seqz";
+	else if (func == 4 && imm == -1)
+	  mne = "not";
+	else
+	  op[2] = put_dec (opbuf[0], imm);
+      }
+      break;
+
+    case fmt_shift:
+    case fmt_c_shift:
+    case fmt_c_slli:
+      op[0] = op[1] = REG (rd);
+      if (opc->fmt == fmt_shift)
+	op[1] = REG (rs1);
+      else if (opc->fmt == fmt_c_slli ? rd == 0 : imm == 0)
+	/* Hints are shown with the name of the compressed instruction.  */
+	mne = opc->name;
+      op[2] = put_hex (opbuf[0], imm);
+      break;
+
+    case fmt_load:
+    case fmt_c_lw:
+    case fmt_c_ld:
+    case fmt_c_lwsp:
+    case fmt_c_ldsp:
+      op[0] = REG (rd);
+      op[1] = put_mem (opbuf[0], imm, REG (rs1));
+      break;
+
+    case fmt_fload:
+    case fmt_c_flw:
+    case fmt_c_fld:
+    case fmt_c_flwsp:
+    case fmt_c_fldsp:
+      op[0] = FREG (rd);
+      op[1] = put_mem (opbuf[0], imm, REG (rs1));
+      break;
+
+    case fmt_store:
+    case fmt_c_sw:
+    case fmt_c_sd:
+    case fmt_c_swsp:
+    case fmt_c_sdsp:
+      op[0] = REG (rs2);
+      op[1] = put_mem (opbuf[0], imm, REG (rs1));
+      break;
+
+    case fmt_fstore:
+    case fmt_c_fsw:
+    case fmt_c_fsd:
+    case fmt_c_fswsp:
+    case fmt_c_fsdsp:
+      op[0] = FREG (rs2);
+      op[1] = put_mem (opbuf[0], imm, REG (rs1));
+      break;
+
+    case fmt_branch:
+      // TODO translate address
+      put_hex (opbuf[0], addr + imm);
+      if (rs1 == 0 && (func == 4 || func == 5))
+	{
+	  mne = func == 5 ? "blez" : "bgtz";
+	  op[0] = REG (rs2);
+	  op[1] = opbuf[0];
+	}
+      else if (rs2 == 0)
+	{
+	  op[0] = REG (rs1);
+	  if (func == 0 || func == 1 || func == 4 || func == 5)
+	    {
+	      strcpy (stpcpy (mnebuf, mne), "z");
+	      mne = mnebuf;
+	      op[1] = opbuf[0];
+	    }
+	  else
+	    {
+	      op[1] = REG (rs2);
+	      op[2] = opbuf[0];
+	    }
+	}
+      else if (func == 5 || func == 7)
+	{
+	  // binutils use these opcodes and the reverse parameter order
+	  mne = func == 5 ? "ble" : "bleu";
+	  op[0] = REG (rs2);
+	  op[1] = REG (rs1);
+	  op[2] = opbuf[0];
+	}
+      else
+	{
+	  op[0] = REG (rs1);
+	  op[1] = REG (rs2);
+	  op[2] = opbuf[0];
+	}
+      break;
+
+    case fmt_u:
+    case fmt_c_lui:
+      op[0] = REG (rd);
+      op[1] = put_hex (opbuf[0], (imm >> 12) & 0xfffff);
+      break;
+
+    case fmt_jal:
+      // TODO translate address
+      put_hex (opbuf[0], addr + imm);
+      if (rd == 0)
+	{
+	  mne = "j";
+	  op[0] = opbuf[0];
+	}
+      else
+	{
+	  op[0] = REG (rd);
+	  op[1] = opbuf[0];
+	}
+      break;
+
+    case fmt_jalr:
+      next = 0;
+      if (rd > 1)
+	op[next++] = REG (rd);
+      if (imm == 0)
+	{
+	  if (rs1 != 0 || next == 0)
+	    op[next] = REG (rs1);
+	}
+      else
+	op[next] = put_mem (opbuf[0], imm, REG (rs1));
+      mne = rd == 0 ? "jr" : "jalr";
+      break;
+
+    case fmt_csr:
+    case fmt_csri:
+      if ((func & 0x3) == 2 && rs1 == 0)
+	{
+	  /* Reading a CSR.  */
+	  static const char *const unprivrw[4] =
+	    {
+	      NULL, "frflags", "frrm", "frsr",
+	    };
+	  static const char *const unprivrolow[3] =
+	    {
+	      "rdcycle", "rdtime", "rdinstret"
+	    };
+	  if (imm >= 0x001 && imm <= 0x003)
+	    mne = unprivrw[imm];
+	  else if (imm >= 0xc00 && imm <= 0xc02)
+	    mne = unprivrolow[imm - 0xc00];
+	  else
+	    mne = NULL;
+	  if (mne != NULL)
+	    {
+	      op[0] = REG (rd);
+	      break;
+	    }
+	}
+      else if ((func & 0x3) == 1 && rd == 0 && imm >= 0x001 && imm <= 0x003)
+	{
+	  /* Writing a floating-point CSR.  */
+	  static const char *const unprivrs[4] =
+	    {
+	      NULL, "fsflags", "fsrm", "fssr",
+	    };
+	  static const char *const unprivrsi[4] =
+	    {
+	      NULL, "fsflagsi", "fsrmi", NULL
+	    };
+	  mne = (opc->fmt == fmt_csr ? unprivrs : unprivrsi)[imm];
+	  if (mne != NULL)
+	    {
+	      op[0] = (opc->fmt == fmt_csr ? REG (rs1)
+		       : put_dec (opbuf[1], rs1));
+	      break;
+	    }
+	}
+
+      next = 0;
+      if (rd != 0)
+	op[next++] = REG (rd);
+      struct known_csrs key = { imm, NULL };
+      struct known_csrs *found = bsearch (&key, csr_names,
+					  (sizeof (csr_names)
+					   / sizeof (csr_names[0])),
+					  sizeof (csr_names[0]),
+					  compare_csr);
+      if (found)
+	op[next] = (char *) found->name;
+      else
+	op[next] = put_hex (opbuf[0], imm);
+      ++next;
+      op[next] = (opc->fmt == fmt_csr ? REG (rs1) : put_dec (opbuf[1], rs1));
+
+      if (func == 1 && rd == 0)
+	mne = "csrw";
+      else if (func == 2 && rd == 0)
+	mne = "csrs";
+      else if (func == 6 && rd == 0)
+	mne = "csrsi";
+      else if (func == 2 && rs1 == 0)
+	mne = "csrr";
+      else if (func == 3 && rd == 0)
+	mne = "csrc";
+      else
+	mne = opc->mne;
+      break;
+
+    case fmt_amo:
+    case fmt_lr:
+      {
+	static const char *const aqrlstr[4] =
+	  {
+	    "", ".rl", ".aq", ".aqrl"
+	  };
+	strcpy (stpcpy (mnebuf, mne), aqrlstr[(enc >> 25) & 0x3]);
+	mne = mnebuf;
+	op[0] = REG (rd);
+	next = 1;
+	if (opc->fmt == fmt_amo)
+	  op[next++] = REG (rs2);
+	char *cp = opbuf[0];
+	*cp++ = '(';
+	strcpy (stpcpy (cp, REG (rs1)), ")");
+	op[next] = opbuf[0];
+      }
+      break;
+
+    case fmt_ffff_rm:
+      op[3] = FREG (args->rs3);
+      if (rm != 0x7)
+	op[4] = (char *) rndmode[rm];
+      FALLTHROUGH;
+    case fmt_fff:
+    case fmt_fff_rm:
+      op[0] = FREG (rd);
+      op[1] = FREG (rs1);
+      op[2] = FREG (rs2);
+      if (opc->fmt == fmt_fff_rm && rm != 0x7)
+	op[3] = (char *) rndmode[rm];
+      break;
+
+    case fmt_fsgnj:
+      op[0] = FREG (rd);
+      op[1] = FREG (rs1);
+      if (rs1 == rs2)
+	{
+	  static const char *const altsignmne[3] =
+	    {
+	      "fmv.", "fneg.", "fabs."
+	    };
+	  char *cp = stpcpy (mnebuf, altsignmne[func]);
+	  *cp++ = widthchar[width];
+	  *cp = '\0';
+	  mne = mnebuf;
+	}
+      else
+	op[2] = FREG (rs2);
+      break;
+
+    case fmt_ff:
+    case fmt_ff_rm:
+      op[0] = FREG (rd);
+      op[1] = FREG (rs1);
+      if (opc->fmt == fmt_ff_rm && rm != 0x7)
+	op[2] = (char *) rndmode[rm];
+      break;
+
+    case fmt_xf:
+    case fmt_xf_rm:
+    case fmt_xff:
+      op[0] = REG (rd);
+      op[1] = FREG (rs1);
+      if (opc->fmt == fmt_xff)
+	op[2] = FREG (rs2);
+      else if (opc->fmt == fmt_xf_rm && rm != 0x7)
+	op[2] = (char *) rndmode[rm];
+      break;
+
+    case fmt_fx:
+    case fmt_fx_rm:
+      op[0] = FREG (rd);
+      op[1] = REG (rs1);
+      /* Conversions from a 32-bit integer to double or quad precision
+	 are exact.  */
+      if (opc->fmt == fmt_fx_rm && rm != 0x7 && (width == 0 || rs2 >= 2))
+	op[2] = (char *) rndmode[rm];
+      break;
+
+    case fmt_c_addi4spn:
+    case fmt_c_addi16sp:
+    case fmt_c_andi:
+      op[0] = REG (rd);
+      op[1] = REG (rs1);
+      op[2] = put_dec (opbuf[0], imm);
+      break;
+
+    case fmt_c_addi:
+      if (rd == 0)
+	mne = "c.nop";
+      else
+	{
+	  if (imm == 0)
+	    mne = opc->name;
+	  op[0] = op[1] = REG (rd);
+	  op[2] = put_dec (opbuf[0], imm);
+	}
+      break;
+
+    case fmt_c_addiw:
+      op[0] = op[1] = REG (rd);
+      if (imm == 0)
+	mne = "sext.w";
+      else
+	op[2] = put_dec (opbuf[0], imm);
+      break;
+
+    case fmt_c_li:
+      if (rd == 0)
+	mne = opc->name;
+      op[0] = REG (rd);
+      op[1] = put_dec (opbuf[0], imm);
+      break;
+
+    case fmt_c_arith:
+      op[0] = op[1] = REG (rd);
+      op[2] = REG (rs2);
+      break;
+
+    case fmt_c_j:
+      // TODO translate address
+      op[0] = put_hex (opbuf[0], addr + imm);
+      break;
+
+    case fmt_c_branch:
+      op[0] = REG (rs1);
+      // TODO translate address
+      op[1] = put_hex (opbuf[0], addr + imm);
+      break;
+
+    case fmt_c_jr:
+      if ((enc & 0x1000) == 0 && rs1 == 1)
+	mne = "ret";
+      else
+	op[0] = REG (rs1);
+      break;
+
+    case fmt_c_mv:
+    case fmt_c_add:
+      if (rd == 0)
+	mne = opc->name;
+      op[0] = REG (rd);
+      if (opc->fmt == fmt_c_add)
+	op[1] = REG (rd);
+      op[opc->fmt == fmt_c_add ? 2 : 1] = REG (rs2);
+      break;
+    }
+
+  return mne;
+}
+
+
 int
 riscv_disasm (Ebl *ebl,
 	      const uint8_t **startp, const uint8_t *end, GElf_Addr addr,
@@ -136,1168 +1130,43 @@ riscv_disasm (Ebl *ebl,
 	}
       uint16_t first = read_2ubyte_unaligned (data);
 
-      // Determine length.
-      size_t length;
-      if ((first & 0x3) != 0x3)
-	length = 2;
-      else if ((first & 0x1f) != 0x1f)
-	length = 4;
-      else if ((first & 0x3f) != 0x3f)
-	length = 6;
-      else if ((first & 0x7f) != 0x7f)
-	length = 8;
-      else
-	{
-	  uint16_t nnn = (first >> 12) & 0x7;
-	  if (nnn != 0x7)
-	    length = 10 + 2 * nnn;
-	  else
-	    // This is invalid as of the RISC-V spec on 2019-06-21.
-	    // The instruction is at least 192 bits in size so use
-	    // this minimum size.
-	    length = 24;
-	}
+      size_t length = insn_length (first);
       if (data + length > end)
 	{
 	  retval = -1;
 	  break;
 	}
 
-      char *mne = NULL;
+      const char *mne = NULL;
       char mnebuf[32];
       char *op[5] = { NULL, NULL, NULL, NULL, NULL };
-      char immbuf[32];
+      char opbuf[2][32];
       size_t len;
       char *strp = NULL;
-      char addrbuf[32];
       bufcnt = 0;
-      int64_t opaddr;
-      if (length == 2)
-	{
-	  size_t idx = (first >> 13) * 3 + (first & 0x3);
-	  switch (idx)
-	    {
-	    uint16_t rd;
-	    uint16_t rs1;
-	    uint16_t rs2;
 
-	    case 0:
-	      if ((first & 0x1fe0) != 0)
-		{
-		  mne = "addi";
-		  op[0] = REGP ((first & 0x1c) >> 2);
-		  op[1] = REG (2);
-		  opaddr = (((first >> 1) & 0x3c0)
-			    | ((first >> 7) & 0x30)
-			    | ((first >> 2) & 0x8)
-			    | ((first >> 4) & 0x4));
-		  snprintf (addrbuf, sizeof (addrbuf), "%" PRIu64, opaddr);
-		  op[2] = addrbuf;
-		}
-	      else if (first == 0)
-		mne = "unimp";
-	      break;
-	    case 1:
-	      rs1 = (first >> 7) & 0x1f;
-	      int16_t nzimm = ((0 - ((first >> 7) & 0x20))
-			       | ((first >> 2) & 0x1f));
-	      if (rs1 == 0)
-	        mne = nzimm == 0 ? "nop" : "c.nop";
-	      else
-		{
-		  mne = nzimm == 0 ? "c.addi" : "addi";
-		  op[0] = op[1] = REG (rs1);
-		  snprintf (addrbuf, sizeof (addrbuf), "%" PRId16, nzimm);
-		  op[2] = addrbuf;
-		}
-	      break;
-	    case 2:
-	      rs1 = (first >> 7) & 0x1f;
-	      op[0] = op[1] = REG (rs1);
-	      opaddr = ((first >> 7) & 0x20) | ((first >> 2) & 0x1f);
-	      snprintf (addrbuf, sizeof (addrbuf), "0x%" PRIx64, opaddr);
-	      op[2] = addrbuf;
-	      mne = rs1 == 0 ? "c.slli" : "slli";
-	      break;
-	    case 3:
-	      op[0] = FREGP ((first >> 2) & 0x7);
-	      opaddr = ((first << 1) & 0xc0) | ((first >> 7) & 0x38);
-	      snprintf (addrbuf, sizeof (addrbuf), "%" PRIu64 "(%s)",
-			opaddr, REGP ((first >> 7) & 0x7));
-	      op[1] = addrbuf;
-	      mne = "fld";
-	      break;
-	    case 4:
-	      if (ebl->class == ELFCLASS32)
-		{
-		  mne = "jal";
-		  opaddr = (((first << 3) & 0x20) | ((first >> 2) & 0xe)
-			    | ((first << 1) & 0x80) | ((first >> 1) | 0x40)
-			    | ((first << 2) & 0x400) | (first & 0xb00)
-			    | ((first >> 6) & 0x10));
-		  snprintf (addrbuf, sizeof (addrbuf), "0x%" PRIx64, opaddr);
-		  op[0] = addrbuf;
-		}
-	      else
-		{
-		  int32_t imm = (((UINT32_C (0) - ((first >> 12) & 0x1)) << 5)
-				 | ((first >> 2) & 0x1f));
-		  uint16_t reg = (first >> 7) & 0x1f;
-		  if (reg == 0)
-		    {
-		      // Reserved
-		      len = snprintf (addrbuf, sizeof (addrbuf), "0x%" PRIx16, first);
-		      strp = addrbuf;
-		    }
-		  else
-		    {
-		      if (imm == 0)
-			mne = "sext.w";
-		      else
-			{
-			  mne = "addiw";
-			  snprintf (addrbuf, sizeof (addrbuf), "%" PRId32, imm);
-			  op[2] = addrbuf;
-			}
-		      op[0] = op[1] = REG (reg);
-		    }
-		}
-	      break;
-	    case 5:
-	      op[0] = FREG ((first >> 7) & 0x1f);
-	      opaddr = ((first << 4) & 0x1c0) | ((first >> 7) & 0x20) | ((first >> 2) & 0x18);
-	      snprintf (addrbuf, sizeof (addrbuf), "%" PRIu64 "(%s)", opaddr, REG (2));
-	      op[1] = addrbuf;
-	      mne = "fld";
-	      break;
-	    case 6:
-	    case 18:
-	      mne = idx == 6 ? "lw" : "sw";
-	      op[0] = REGP ((first >> 2) & 0x7);
-	      opaddr = (((first >> 7) & 0x38) | ((first << 1) & 0x40)
-			| ((first >> 4) & 0x4));
-	      snprintf (addrbuf, sizeof (addrbuf), "%" PRId64 "(%s)",
-			opaddr, REGP ((first >> 7) & 0x7));
-	      op[1] = addrbuf;
-	      break;
-	    case 7:
-	      mne = (first & 0xf80) == 0 ? "c.li" : "li";
-	      op[0] = REG((first >> 7) & 0x1f);
-	      snprintf (addrbuf, sizeof (addrbuf), "%" PRId16,
-			(UINT16_C (0) - ((first >> 7) & 0x20)) | ((first >> 2) & 0x1f));
-	      op[1] = addrbuf;
-	      break;
-	    case 8:
-	      rd = ((first >> 7) & 0x1f);
-	      if (rd == 0)
-		{
-		  len = snprintf (addrbuf, sizeof (addrbuf), "0x%" PRIx16, first);
-		  strp = addrbuf;
-		}
-	      else
-		{
-		  uint16_t uimm = (((first << 4) & 0xc0)
-				   | ((first >> 7) & 0x20)
-				   | ((first >> 2) & 0x1c));
-		  mne = "lw";
-		  op[0] = REG (rd);
-		  snprintf (addrbuf, sizeof (addrbuf), "%" PRIu16 "(%s)", uimm, REG (2));
-		  op[1] = addrbuf;
-		}
-	      break;
-	    case 9:
-	      if (ebl->class == ELFCLASS32)
-		{
-		  mne = "flw";
-		  op[0] = FREGP ((first >> 2) & 0x7);
-		  opaddr = (((first << 1) & 0x40)
-		            | ((first >> 7) & 0x38)
-			    | ((first >> 4) & 0x4));
-		}
-	      else
-		{
-		  mne = "ld";
-		  op[0] = REGP ((first >> 2) & 0x7);
-		  opaddr = ((first >> 7) & 0x38) | ((first << 1) & 0xc0);
-		}
-	      snprintf (addrbuf, sizeof (addrbuf), "%" PRId64 "(%s)",
-			opaddr, REGP ((first >> 7) & 0x7));
-	      op[1] = addrbuf;
-	      break;
-	    case 10:
-	      if ((first & 0xf80) == (2 << 7))
-		{
-		  mne = "addi";
-		  op[0] = op[1] = REG (2);
-		  opaddr = (((first >> 2) & 0x10) | ((first << 3) & 0x20)
-			    | ((first << 1) & 0x40) | ((first << 4) & 0x180)
-			    | ((UINT64_C (0) - ((first >> 12) & 0x1)) << 9));
-		  snprintf (addrbuf, sizeof (addrbuf), "%" PRId64, opaddr);
-		  op[2] = addrbuf;
-		}
-	      else
-		{
-		  mne = "lui";
-		  op[0] = REG((first & 0xf80) >> 7);
-		  opaddr = (((UINT64_C (0) - ((first >> 12) & 0x1)) & ~0x1f)
-			    | ((first >> 2) & 0x1f));
-		  snprintf (addrbuf, sizeof (addrbuf), "0x%" PRIx64, opaddr & 0xfffff);
-		  op[1] = addrbuf;
-		}
-	      break;
-	    case 11:
-	      if (ebl->class == ELFCLASS32)
-		{
-		  mne = "flw";
-		  op[0] = FREG ((first >> 7) & 0x1f);
-		  opaddr = (((first << 4) & 0xc0)
-			    | ((first >> 7) & 0x20)
-			    | ((first >> 2) & 0x1c));
-		}
-	      else
-		{
-		  mne = "ld";
-		  op[0] = REG ((first >> 7) & 0x1f);
-		  opaddr = (((first << 4) & 0x1c0)
-			    | ((first >> 7) & 0x20)
-			    | ((first >> 2) & 0x18));
-		}
-	      snprintf (addrbuf, sizeof (addrbuf), "%" PRId64 "(%s)", opaddr, REG (2));
-	      op[1] = addrbuf;
-	      break;
-	    case 13:
-	      if ((first & 0xc00) != 0xc00)
-		{
-		  int16_t imm = ((first >> 7) & 0x20) | ((first >> 2) & 0x1f);
-		  if ((first & 0xc00) == 0x800)
-		    {
-		      imm |= 0 - (imm & 0x20);
-		      mne = "andi";
-		      snprintf (addrbuf, sizeof (addrbuf), "%" PRId16, imm);
-		    }
-		  else
-		    {
-		      if (ebl->class != ELFCLASS32 || imm < 32)
-			{
-			  mne = (first & 0x400) ? "srai" : "srli";
-			  if (imm == 0)
-			    {
-			      strcpy (stpcpy (mnebuf, "c."), mne);
-			      mne = mnebuf;
-			    }
-			}
-		      snprintf (addrbuf, sizeof (addrbuf), "0x%" PRIx16, imm);
-		    }
-		  op[2] = addrbuf;
-		}
-	      else
-		{
-		  op[2] = REGP ((first >> 2) & 0x7);
-		  static const char *const arithmne[8] =
-		    {
-		      "sub", "xor", "or", "and", "subw", "addw", NULL, NULL
-		    };
-		  mne = (char *) arithmne[((first >> 10) & 0x4) | ((first >> 5) & 0x3)];
-		}
-		op[0] = op[1] = REGP ((first >> 7) & 0x7);
-	      break;
-	    case 14:
-	      rs1 = (first >> 7) & 0x1f;
-	      rs2 = (first >> 2) & 0x1f;
-	      op[0] = REG (rs1);
-	      if ((first & 0x1000) == 0)
-		{
-		  if (rs2 == 0)
-		    {
-		      op[1] = NULL;
-		      if (rs1 == 1)
-			{
-			  mne = "ret";
-			  op[0] = NULL;
-			}
-		      else
-			mne = "jr";
-		    }
-		  else
-		    {
-		      mne = rs1 != 0 ? "mv" : "c.mv";
-		      op[1] = REG (rs2);
-		    }
-		}
-	      else
-		{
-		  if (rs2 == 0)
-		    {
-		      if (rs1 == 0)
-			{
-			  mne = "ebreak";
-			  op[0] = op[1] = NULL;
-			}
-		      else
-			mne = "jalr";
-		    }
-		  else
-		    {
-		      mne = rs1 != 0 ? "add" : "c.add";
-		      op[2] = REG (rs2);
-		      op[1] = op[0];
-		    }
-		}
-	      break;
-	    case 15:
-	      op[0] = FREGP ((first >> 2) & 0x7);
-	      opaddr = ((first << 1) & 0xc0) | ((first >> 7) & 0x38);
-	      snprintf (addrbuf, sizeof (addrbuf), "%" PRIu64 "(%s)",
-			opaddr, REGP ((first >> 7) & 0x7));
-	      op[1] = addrbuf;
-	      mne = "fsd";
-	      break;
-	    case 16:
-	      opaddr = (((UINT64_C (0) - ((first >> 12) & 0x1)) << 11)
-			| ((first << 2) & 0x400)
-			| ((first >> 1) & 0x300)
-			| ((first << 1) & 0x80)
-			| ((first >> 1) & 0x40)
-			| ((first << 3) & 0x20)
-			| ((first >> 7) & 0x10)
-			| ((first >> 2) & 0xe));
-	      mne = "j";
-	      // TODO translate address
-	      snprintf (addrbuf, sizeof (addrbuf), "0x%" PRIx64, addr + opaddr);
-	      op[0] = addrbuf;
-	      break;
-	    case 17:
-	      op[0] = FREG ((first >> 2) & 0x1f);
-	      opaddr = ((first >> 1) & 0x1c0) | ((first >> 7) & 0x38);
-	      snprintf (addrbuf, sizeof (addrbuf), "%" PRIu64 "(%s)", opaddr, REG (2));
-	      op[1] = addrbuf;
-	      mne = "fsd";
-	      break;
-	    case 19:
-	    case 22:
-	      mne = idx == 19 ? "beqz" : "bnez";
-	      op[0] = REG (8 + ((first >> 7) & 0x7));
-	      opaddr = addr + (((UINT64_C (0) - ((first >> 12) & 0x1)) & ~0xff)
-			       | ((first << 1) & 0xc0) | ((first << 3) & 0x20)
-			       | ((first >> 7) & 0x18) |  ((first >> 2) & 0x6));
-	      // TODO translate address
-	      snprintf (addrbuf, sizeof (addrbuf), "0x%" PRIx64, opaddr);
-	      op[1] = addrbuf;
-	      break;
-	    case 20:
-	      op[0] = REG ((first >> 2) & 0x1f);
-	      opaddr = ((first >> 1) & 0xc0) | ((first >> 7) & 0x3c);
-	      snprintf (addrbuf, sizeof (addrbuf), "%" PRId64 "(%s)", opaddr, REG (2));
-	      op[1] = addrbuf;
-	      mne = "sw";
-	      break;
-	    case 21:
-	      if (idx == 18 || ebl->class == ELFCLASS32)
-		{
-		  mne = "fsw";
-		  op[0] = FREGP ((first >> 2) & 0x7);
-		  opaddr = (((first >> 7) & 0x38) | ((first << 1) & 0x40)
-			    | ((first >> 4) & 0x4));
-		}
-	      else
-		{
-		  mne = "sd";
-		  op[0] = REGP ((first >> 2) & 0x7);
-		  opaddr = ((first >> 7) & 0x38) | ((first << 1) & 0xc0);
-		}
-	      snprintf (addrbuf, sizeof (addrbuf), "%" PRId64 "(%s)",
-			opaddr, REGP ((first >> 7) & 0x7));
-	      op[1] = addrbuf;
-	      break;
-	    case 23:
-	      if (idx == 18 || ebl->class == ELFCLASS32)
-		{
-		  mne = "fsw";
-		  op[0] = FREG ((first & 0x7c) >> 2);
-		  opaddr = ((first & 0x1e00) >> 7) | ((first & 0x180) >> 1);
-		}
-	      else
-		{
-		  mne = "sd";
-		  op[0] = REG ((first & 0x7c) >> 2);
-		  opaddr = ((first & 0x1c00) >> 7) | ((first & 0x380) >> 1);
-		}
-	      snprintf (addrbuf, sizeof (addrbuf), "%" PRId64 "(%s)", opaddr, REG (2));
-	      op[1] = addrbuf;
-	      break;
-	    default:
-	      break;
-	    }
+      const struct riscv_opcode *opc = NULL;
+      struct riscv_args args;
+      uint32_t enc = 0;
+      if (length <= 4)
+	{
+	  enc = length == 2 ? first : read_4ubyte_unaligned (data);
+	  opc = riscv_lookup (enc, length, ebl->class);
+	  if (opc != NULL && ! extract_args (opc, enc, ebl->class, &args))
+	    opc = NULL;
+	}
 
-	  if (strp == NULL && mne == NULL)
-	    {
-	      len = snprintf (immbuf, sizeof (immbuf), "0x%04" PRIx16, first);
-	      strp = immbuf;
-	    }
+      if (opc != NULL)
+	mne = format_insn (opc, &args, enc, addr, op, mnebuf, opbuf);
+      else if (length == 2)
+	{
+	  len = snprintf (mnebuf, sizeof (mnebuf), "0x%04" PRIx16, first);
+	  strp = mnebuf;
 	}
       else if (length == 4)
 	{
-	  uint32_t word = read_4ubyte_unaligned (data);
-	  size_t idx = (word >> 2) & 0x1f;
-
-	  switch (idx)
-	    {
-	    static const char widthchar[4] = { 's', 'd', '\0', 'q' };
-	    static const char intwidthchar[4] = { 'w', 'd', '\0', 'q' };
-	    static const char *const rndmode[8] = { "rne", "rtz", "rdn", "rup", "rmm", "???", "???", "dyn" };
-	    uint32_t rd;
-	    uint32_t rs1;
-	    uint32_t rs2;
-	    uint32_t rs3;
-	    uint32_t func;
-
-	    case 0x00:
-	    case 0x01:
-	      // LOAD and LOAD-FP
-	      rd = (word >> 7) & 0x1f;
-	      op[0] = idx == 0x00 ? REG (rd) : FREG (rd);
-	      opaddr = ((int32_t) word) >> 20;
-	      snprintf (addrbuf, sizeof (addrbuf), "%" PRId64 "(%s)",
-			opaddr, REG ((word >> 15) & 0x1f));
-	      op[1] = addrbuf;
-	      func = (word >> 12) & 0x7;
-	      static const char *const loadmne[8] =
-	        {
-	          "lb", "lh", "lw", "ld", "lbu", "lhu", "lwu", NULL
-	        };
-	      static const char *const floadmne[8] =
-		{
-		  NULL, NULL, "flw", "fld", "flq", NULL, NULL, NULL
-		};
-	      mne = (char *) (idx == 0x00 ? loadmne[func] : floadmne[func]);
-	      break;
-	    case 0x03:
-	      // MISC-MEM
-	      rd = (word >> 7) & 0x1f;
-	      rs1 = (word >> 15) & 0x1f;
-	      func = (word >> 12) & 0x7;
-
-	      if (word == 0x8330000f)
-		mne = "fence.tso";
-	      else if (word == 0x0000100f)
-		mne = "fence.i";
-	      else if (func == 0 && rd == 0 && rs1 == 0 && (word & 0xf0000000) == 0)
-		{
-		  static const char *const order[16] =
-		    {
-		      "unknown", "w", "r", "rw", "o", "ow", "or", "orw",
-		      "i", "iw", "ir", "irw", "io", "iow", "ior", "iorw"
-		    };
-		  uint32_t pred = (word >> 20) & 0xf;
-		  uint32_t succ = (word >> 24) & 0xf;
-		  if (pred != 0xf || succ != 0xf)
-		    {
-		      op[0] = (char *) order[succ];
-		      op[1] = (char *) order[pred];
-		     }
-		   mne = "fence";
-		}
-	      break;
-	    case 0x04:
-	    case 0x06:
-	      // OP-IMM and OP-IMM32
-	      rd = (word >> 7) & 0x1f;
-	      op[0] = REG (rd);
-	      rs1 = (word >> 15) & 0x1f;
-	      op[1] = REG (rs1);
-	      opaddr = ((int32_t) word) >> 20;
-	      static const char *const opimmmne[8] =
-		{
-		  "addi", NULL, "slti", "sltiu", "xori", NULL, "ori", "andi"
-		};
-	      func = (word >> 12) & 0x7;
-	      mne = (char *) opimmmne[func];
-	      if (mne == NULL)
-		{
-		  const uint64_t shiftmask = ebl->class == ELFCLASS32 ? 0x1f : 0x3f;
-		  if (func == 0x1 && (opaddr & ~shiftmask) == 0)
-		    mne = "slli";
-		  else if (func == 0x5 && (opaddr & ~shiftmask) == 0)
-		    mne = "srli";
-		  else if (func == 0x5 && (opaddr & ~shiftmask) == 0x400)
-		    mne = "srai";
-		  snprintf (addrbuf, sizeof (addrbuf), "0x%" PRIx64, opaddr & shiftmask);
-		  op[2] = addrbuf;
-		}
-	      else if (func == 0x0 && (rd != 0 || idx == 0x06) && rs1 == 0 && rd != 0)
-		{
-		  mne = "li";
-		  snprintf (addrbuf, sizeof (addrbuf), "%" PRId64, opaddr);
-		  op[1] = addrbuf;
-		}
-	      else if (func == 0x00 && opaddr == 0)
-		{
-		  if (idx == 0x06)
-		    mne ="sext.";
-		  else if (rd == 0)
-		    {
-		      mne = "nop";
-		      op[0] = op[1] = NULL;
-		    }
-		  else
-		    mne = "mv";
-		}
-	      else if (func == 0x3 && opaddr == 1)
-		mne = "seqz";
-	      else if (func == 0x4 && opaddr == -1)
-		{
-		  mne = "not";
-		  op[2] = NULL;
-		}
-	      else
-		{
-		  snprintf (addrbuf, sizeof (addrbuf), "%" PRId64, opaddr);
-		  op[2] = addrbuf;
-
-		  if (func == 0x0 && rs1 == 0 && rd != 0)
-		    {
-		      op[1] = op[2];
-		      op[2] = NULL;
-		      mne = "li";
-		    }
-		}
-	      if (mne != NULL && idx == 0x06)
-		{
-		  mne = strcpy (mnebuf, mne);
-		  strcat (mnebuf, "w");
-		}
-	      break;
-	    case 0x05:
-	    case 0x0d:
-	      // LUI and AUIPC
-	      mne = idx == 0x05 ? "auipc" : "lui";
-	      op[0] = REG ((word >> 7) & 0x1f);
-	      opaddr = word >> 12;
-	      snprintf (addrbuf, sizeof (addrbuf), "0x%" PRIx64, opaddr);
-	      op[1] = addrbuf;
-	      break;
-	    case 0x08:
-	    case 0x09:
-	      // STORE and STORE-FP
-	      rs2 = (word >> 20) & 0x1f;
-	      op[0] = idx == 0x08 ? REG (rs2) : FREG (rs2);
-	      opaddr = ((((int64_t) ((int32_t) word) >> 20)) & ~0x1f) | ((word >> 7) & 0x1f);
-	      snprintf (addrbuf, sizeof (addrbuf), "%" PRId64 "(%s)",
-			opaddr, REG ((word >> 15) & 0x1f));
-	      op[1] = addrbuf;
-	      func = (word >> 12) & 0x7;
-	      static const char *const storemne[8] =
-		{
-		  "sb", "sh", "sw", "sd", NULL, NULL, NULL, NULL
-		};
-	      static const char *const fstoremne[8] =
-		{
-		  NULL, NULL, "fsw", "fsd", "fsq", NULL, NULL, NULL
-		};
-	      mne = (char *) (idx == 0x08 ? storemne[func] : fstoremne[func]);
-	      break;
-	    case 0x0b:
-	      // AMO
-	      op[0] = REG ((word >> 7) & 0x1f);
-	      rs1 = (word >> 15) & 0x1f;
-	      rs2 = (word >> 20) & 0x1f;
-	      snprintf (addrbuf, sizeof (addrbuf), "(%s)", REG (rs1));
-	      op[2] = addrbuf;
-	      size_t width = (word >> 12) & 0x7;
-	      func = word >> 27;
-	      static const char *const amomne[32] =
-		{
-		  "amoadd", "amoswap", "lr", "sc", "amoxor", NULL, NULL, NULL,
-		  "amoor", NULL, NULL, NULL, "amoand", NULL, NULL, NULL,
-		  "amomin", NULL, NULL, NULL, "amomax", NULL, NULL, NULL,
-		  "amominu", NULL, NULL, NULL, "amomaxu", NULL, NULL, NULL
-		};
-	      if (amomne[func] != NULL && width >= 2 && width <= 3
-		  && (func != 0x02 || rs2 == 0))
-		{
-		  if (func == 0x02)
-		    {
-		      op[1] = op[2];
-		      op[2] = NULL;
-		    }
-		  else
-		    op[1] = REG (rs2);
-
-		  char *cp = stpcpy (mnebuf, amomne[func]);
-		  *cp++ = '.';
-		  *cp++ = "  wd    "[width];
-		  assert (cp[-1] != ' ');
-		  static const char *const aqrlstr[4] =
-		    {
-		      "", ".rl", ".aq", ".aqrl"
-		    };
-		  strcpy (cp, aqrlstr[(word >> 25) & 0x3]);
-		  mne = mnebuf;
-		}
-	      break;
-	    case 0x0c:
-	    case 0x0e:
-	      // OP and OP-32
-	      if ((word & 0xbc000000) == 0)
-		{
-		  rs1 = (word >> 15) & 0x1f;
-		  rs2 = (word >> 20) & 0x1f;
-		  op[0] = REG ((word >> 7) & 0x1f);
-		  func = ((word >> 21) & 0x10) | ((word >> 27) & 0x8) | ((word >> 12) & 0x7);
-		  static const char *const arithmne2[32] =
-		    {
-		      "add", "sll", "slt", "sltu", "xor", "srl", "or", "and",
-		      "sub", NULL, NULL, NULL, NULL, "sra", NULL, NULL,
-		      "mul", "mulh", "mulhsu", "mulhu", "div", "divu", "rem", "remu",
-		      NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL
-		    };
-		  static const char *const arithmne3[32] =
-		    {
-		      "addw", "sllw", NULL, NULL, NULL, "srlw", NULL, NULL,
-		      "subw", NULL, NULL, NULL, NULL, "sraw", NULL, NULL,
-		      "mulw", NULL, NULL, NULL, "divw", "divuw", "remw", "remuw",
-		      NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL
-		    };
-		  if (func == 8 && rs1 == 0)
-		    {
-		      mne = idx == 0x0c ? "neg" : "negw";
-		      op[1] = REG (rs2);
-		    }
-		  else if (idx == 0x0c && rs2 == 0 && func == 2)
-		    {
-		      op[1] = REG (rs1);
-		      mne = "sltz";
-		    }
-		  else if (idx == 0x0c && rs1 == 0 && (func == 2 || func == 3))
-		    {
-		      op[1] = REG (rs2);
-		      mne = func == 2 ? "sgtz" : "snez";
-		    }
-		  else
-		    {
-		      mne = (char *) (idx == 0x0c ? arithmne2[func] : arithmne3[func]);
-		      op[1] = REG (rs1);
-		      op[2] = REG (rs2);
-		    }
-		}
-	      break;
-	    case 0x10:
-	    case 0x11:
-	    case 0x12:
-	    case 0x13:
-	      // MADD, MSUB, NMSUB, NMADD
-	      if ((word & 0x06000000) != 0x04000000)
-		{
-		  rd = (word >> 7) & 0x1f;
-		  rs1 = (word >> 15) & 0x1f;
-		  rs2 = (word >> 20) & 0x1f;
-		  rs3 = (word >> 27) & 0x1f;
-		  uint32_t rm = (word >> 12) & 0x7;
-		  width = (word >> 25) & 0x3;
-
-		  static const char *const fmamne[4] =
-		    {
-		      "fmadd.", "fmsub.", "fnmsub.", "fnmadd."
-		    };
-		  char *cp = stpcpy (mnebuf, fmamne[idx & 0x3]);
-		  *cp++ = widthchar[width];
-		  *cp = '\0';
-		  mne = mnebuf;
-		  op[0] = FREG (rd);
-		  op[1] = FREG (rs1);
-		  op[2] = FREG (rs2);
-		  op[3] = FREG (rs3);
-		  if (rm != 0x7)
-		    op[4] = (char *) rndmode[rm];
-		}
-	      break;
-	    case 0x14:
-	      // OP-FP
-	      if ((word & 0x06000000) != 0x04000000)
-		{
-		  width = (word >> 25) & 0x3;
-		  rd = (word >> 7) & 0x1f;
-		  rs1 = (word >> 15) & 0x1f;
-		  rs2 = (word >> 20) & 0x1f;
-		  func = word >> 27;
-		  uint32_t rm = (word >> 12) & 0x7;
-		  if (func < 4)
-		    {
-		      static const char *const fpop[4] =
-			{
-			  "fadd", "fsub", "fmul", "fdiv"
-			};
-		      char *cp = stpcpy (mnebuf, fpop[func]);
-		      *cp++ = '.';
-		      *cp++ = widthchar[width];
-		      *cp = '\0';
-		      mne = mnebuf;
-		      op[0] = FREG (rd);
-		      op[1] = FREG (rs1);
-		      op[2] = FREG (rs2);
-		      if (rm != 0x7)
-			op[3] = (char *) rndmode[rm];
-		    }
-		  else if (func == 0x1c && width != 2 && rs2 == 0 && rm <= 1)
-		    {
-		      char *cp;
-		      if (rm == 0)
-			{
-			  cp = stpcpy (mnebuf, "fmv.x.");
-			  *cp++ = intwidthchar[width];
-			}
-		      else
-			{
-			  cp = stpcpy (mnebuf, "fclass.");
-			  *cp++ = widthchar[width];
-			}
-		      *cp = '\0';
-		      mne = mnebuf;
-		      op[0] = REG (rd);
-		      op[1] = FREG (rs1);
-		    }
-		  else if (func == 0x1e && width != 2 && rs2 == 0 && rm == 0)
-		    {
-		      char *cp = stpcpy (mnebuf, "fmv.");
-		      *cp++ = intwidthchar[width];
-		      strcpy (cp, ".x");
-		      mne = mnebuf;
-		      op[0] = FREG (rd);
-		      op[1] = REG (rs1);
-		    }
-		  else if (func == 0x14)
-		    {
-		      uint32_t cmpop = (word >> 12) & 0x7;
-		      if (cmpop < 3)
-			{
-			  static const char *const mnefpcmp[3] =
-			    {
-			      "fle", "flt", "feq"
-			    };
-			  char *cp = stpcpy (mnebuf, mnefpcmp[cmpop]);
-			  *cp++ = '.';
-			  *cp++ = widthchar[width];
-			  *cp = '\0';
-			  mne = mnebuf;
-			  op[0] = REG (rd);
-			  op[1] = FREG (rs1);
-			  op[2] = FREG (rs2);
-			}
-		    }
-		  else if (func == 0x04)
-		    {
-		      uint32_t cmpop = (word >> 12) & 0x7;
-		      if (cmpop < 3)
-			{
-			  op[0] = FREG (rd);
-			  op[1] = FREG (rs1);
-
-			  static const char *const mnefpcmp[3] =
-			    {
-			      "fsgnj.", "fsgnjn.", "fsgnjx."
-			    };
-			  static const char *const altsignmne[3] =
-			    {
-			      "fmv.", "fneg.", "fabs."
-			    };
-			  char *cp = stpcpy (mnebuf, rs1 == rs2 ? altsignmne[cmpop] : mnefpcmp[cmpop]);
-			  *cp++ = widthchar[width];
-			  *cp = '\0';
-			  mne = mnebuf;
-
-			  if (rs1 != rs2)
-			    op[2] = FREG (rs2);
-			}
-		    }
-		  else if (func == 0x08 && width != 2 && rs2 <= 3 && rs2 != 2 && rs2 != width)
-		    {
-		      op[0] = FREG (rd);
-		      op[1] = FREG (rs1);
-		      char *cp = stpcpy (mnebuf, "fcvt.");
-		      *cp++ = widthchar[width];
-		      *cp++ = '.';
-		      *cp++ = widthchar[rs2];
-		      *cp = '\0';
-		      mne = mnebuf;
-		    }
-		  else if ((func & 0x1d) == 0x18 && width != 2 && rs2 < 4)
-		    {
-		      char *cp = stpcpy (mnebuf, "fcvt.");
-		      if (func == 0x18)
-			{
-			  *cp++ = rs2 >= 2 ? 'l' : 'w';
-			  if ((rs2 & 1) == 1)
-			    *cp++ = 'u';
-			  *cp++ = '.';
-			  *cp++ = widthchar[width];
-			  *cp = '\0';
-			  op[0] = REG (rd);
-			  op[1] = FREG (rs1);
-			}
-		      else
-			{
-			  *cp++ = widthchar[width];
-			  *cp++ = '.';
-			  *cp++ = rs2 >= 2 ? 'l' : 'w';
-			  if ((rs2 & 1) == 1)
-			    *cp++ = 'u';
-			  *cp = '\0';
-			  op[0] = FREG (rd);
-			  op[1] = REG (rs1);
-			}
-		      mne = mnebuf;
-		      if (rm != 0x7 && (func == 0x18 || width == 0 || rs2 >= 2))
-			op[2] = (char *) rndmode[rm];
-		    }
-		  else if (func == 0x0b && rs2 == 0)
-		    {
-		      op[0] = FREG (rd);
-		      op[1] = FREG (rs1);
-		      char *cp = stpcpy (mnebuf, "fsqrt.");
-		      *cp++ = widthchar[width];
-		      *cp = '\0';
-		      mne = mnebuf;
-		      if (rm != 0x7)
-			op[2] = (char *) rndmode[rm];
-		    }
-		  else if (func == 0x05 && rm < 2)
-		    {
-		      op[0] = FREG (rd);
-		      op[1] = FREG (rs1);
-		      op[2] = FREG (rs2);
-		      char *cp = stpcpy (mnebuf, rm == 0 ? "fmin." : "fmax.");
-		      *cp++ = widthchar[width];
-		      *cp = '\0';
-		      mne = mnebuf;
-		    }
-		  else if (func == 0x14 && rm <= 0x2)
-		    {
-		      op[0] = REG (rd);
-		      op[1] = FREG (rs1);
-		      op[2] = FREG (rs2);
-		      static const char *const fltcmpmne[3] =
-			{
-			  "fle.", "flt.", "feq."
-			};
-		      char *cp = stpcpy (mnebuf, fltcmpmne[rm]);
-		      *cp++ = widthchar[width];
-		      *cp = '\0';
-		      mne = mnebuf;
-		    }
-		}
-	      break;
-	    case 0x18:
-	      // BRANCH
-	      rs1 = (word >> 15) & 0x1f;
-	      op[0] = REG (rs1);
-	      rs2 = (word >> 20) & 0x1f;
-	      op[1] = REG (rs2);
-	      opaddr = addr + (((UINT64_C (0) - (word >> 31)) << 12)
-			       + ((word << 4) & 0x800)
-			       + ((word >> 20) & 0x7e0)
-			       + ((word >> 7) & 0x1e));
-	      // TODO translate address
-	      snprintf (addrbuf, sizeof (addrbuf), "0x%" PRIx64, opaddr);
-	      op[2] = addrbuf;
-	      static const char *const branchmne[8] =
-		{
-		  "beq", "bne", NULL, NULL, "blt", "bge", "bltu", "bgeu"
-		};
-	      func = (word >> 12) & 0x7;
-	      mne = (char *) branchmne[func];
-	      if (rs1 == 0 && func == 5)
-		{
-		  op[0] = op[1];
-		  op[1] = op[2];
-		  op[2] = NULL;
-		  mne = "blez";
-		}
-	      else if (rs1 == 0 && func == 4)
-		{
-		  op[0] = op[1];
-		  op[1] = op[2];
-		  op[2] = NULL;
-		  mne = "bgtz";
-		}
-	      else if (rs2 == 0)
-		{
-		  if (func == 0 || func == 1 || func == 4 || func == 5)
-		    {
-		      op[1] = op[2];
-		      op[2] = NULL;
-		      strcpy (stpcpy (mnebuf, mne), "z");
-		      mne = mnebuf;
-		    }
-		}
-	      else if (func == 5 || func == 7)
-		{
-		  // binutils use these opcodes and the reverse parameter order
-		  char *tmp = op[0];
-		  op[0] = op[1];
-		  op[1] = tmp;
-		  mne = func == 5 ? "ble" : "bleu";
-		}
-	      break;
-	    case 0x19:
-	      // JALR
-	      if ((word & 0x7000) == 0)
-		{
-		  rd = (word >> 7) & 0x1f;
-		  rs1 = (word >> 15) & 0x1f;
-		  opaddr = (int32_t) word >> 20;
-		  size_t next = 0;
-		  if (rd > 1)
-		    op[next++] = REG (rd);
-		  if (opaddr == 0)
-		    {
-		      if (rs1 != 0 || next == 0)
-			op[next] = REG (rs1);
-		    }
-		  else
-		    {
-		      snprintf (addrbuf, sizeof (addrbuf), "%" PRId64 "(%s)", opaddr, REG (rs1));
-		      op[next] = addrbuf;
-		    }
-		  mne = rd == 0 ? "jr" : "jalr";
-		}
-	      break;
-	    case 0x1b:
-	      // JAL
-	      rd = (word >> 7) & 0x1f;
-	      if (rd != 0)
-		op[0] = REG (rd);
-	      opaddr = addr + ((UINT64_C (0) - ((word >> 11) & 0x100000))
-			       | (word & 0xff000)
-			       | ((word >> 9) & 0x800)
-			       | ((word >> 20) & 0x7fe));
-	      // TODO translate address
-	      snprintf (addrbuf, sizeof (addrbuf), "0x%" PRIx64, opaddr);
-	      op[rd != 0] = addrbuf;
-	      mne = rd == 0 ? "j" : "jal";
-	      break;
-	    case 0x1c:
-	      // SYSTEM
-	      rd = (word >> 7) & 0x1f;
-	      rs1 = (word >> 15) & 0x1f;
-	      if (word == 0x00000073)
-		mne = "ecall";
-	      else if (word == 0x00100073)
-		mne = "ebreak";
-	      else if (word == 0x00200073)
-		mne = "uret";
-	      else if (word == 0x10200073)
-		mne = "sret";
-	      else if (word == 0x30200073)
-		mne = "mret";
-	      else if (word == 0x10500073)
-		mne = "wfi";
-	      else if ((word & 0x3000) == 0x2000 && rs1 == 0)
-		{
-		  uint32_t csr = word >> 20;
-		  if (/* csr >= 0x000 && */ csr <= 0x007)
-		    {
-		      static const char *const unprivrw[4] =
-			{
-			  NULL, "frflags", "frrm", "frsr",
-			};
-		      mne = (char *) unprivrw[csr - 0x000];
-		    }
-		  else if (csr >= 0xc00 && csr <= 0xc03)
-		    {
-		      static const char *const unprivrolow[3] =
-			{
-			  "rdcycle", "rdtime", "rdinstret"
-			};
-		      mne = (char *) unprivrolow[csr - 0xc00];
-		    }
-		  op[0] = REG ((word >> 7) & 0x1f);
-		}
-	      else if ((word & 0x3000) == 0x1000 && rd == 0)
-		{
-		  uint32_t csr = word >> 20;
-		  if (/* csr >= 0x000 && */ csr <= 0x003)
-		    {
-		      static const char *const unprivrs[4] =
-			{
-			  NULL, "fsflags", "fsrm", "fssr",
-			};
-		      static const char *const unprivrsi[4] =
-			{
-			  NULL, "fsflagsi", "fsrmi", NULL
-			};
-		      mne = (char *) ((word & 0x4000) == 0 ? unprivrs : unprivrsi)[csr - 0x000];
-
-		      if ((word & 0x4000) == 0)
-			op[0] = REG ((word >> 15) & 0x1f);
-		      else
-			{
-			  snprintf (immbuf, sizeof (immbuf), "%" PRIu32, (word >> 15) & 0x1f);
-			  op[0] = immbuf;
-			}
-		    }
-		}
-	      if (mne == NULL && (word & 0x3000) != 0)
-		{
-		  static const char *const mnecsr[8] =
-		    {
-		      NULL, "csrrw", "csrrs", "csrrc",
-		      NULL, "csrrwi", "csrrsi", "csrrci"
-		    };
-		  static const struct known_csrs known[] =
-		    {
-		      // This list must remain sorted by NR.
-		      { 0x000, "ustatus" },
-		      { 0x001, "fflags" },
-		      { 0x002, "fram" },
-		      { 0x003, "fcsr" },
-		      { 0x004, "uie" },
-		      { 0x005, "utvec" },
-		      { 0x040, "uscratch" },
-		      { 0x041, "uepc" },
-		      { 0x042, "ucause" },
-		      { 0x043, "utval" },
-		      { 0x044, "uip" },
-		      { 0x100, "sstatus" },
-		      { 0x102, "sedeleg" },
-		      { 0x103, "sideleg" },
-		      { 0x104, "sie" },
-		      { 0x105, "stvec" },
-		      { 0x106, "scounteren" },
-		      { 0x140, "sscratch" },
-		      { 0x141, "sepc" },
-		      { 0x142, "scause" },
-		      { 0x143, "stval" },
-		      { 0x144, "sip" },
-		      { 0x180, "satp" },
-		      { 0x200, "vsstatus" },
-		      { 0x204, "vsie" },
-		      { 0x205, "vstvec" },
-		      { 0x240, "vsscratch" },
-		      { 0x241, "vsepc" },
-		      { 0x242, "vscause" },
-		      { 0x243, "vstval" },
-		      { 0x244, "vsip" },
-		      { 0x280, "vsatp" },
-		      { 0x600, "hstatus" },
-		      { 0x602, "hedeleg" },
-		      { 0x603, "hideleg" },
-		      { 0x605, "htimedelta" },
-		      { 0x606, "hcounteren" },
-		      { 0x615, "htimedeltah" },
-		      { 0x680, "hgatp" },
-		      { 0xc00, "cycle" },
-		      { 0xc01, "time" },
-		      { 0xc02, "instret" },
-		      { 0xc03, "hpmcounter3" },
-		      { 0xc04, "hpmcounter4" },
-		      { 0xc05, "hpmcounter5" },
-		      { 0xc06, "hpmcounter6" },
-		      { 0xc07, "hpmcounter7" },
-		      { 0xc08, "hpmcounter8" },
-		      { 0xc09, "hpmcounter9" },
-		      { 0xc0a, "hpmcounter10" },
-		      { 0xc0b, "hpmcounter11" },
-		      { 0xc0c, "hpmcounter12" },
-		      { 0xc0d, "hpmcounter13" },
-		      { 0xc0e, "hpmcounter14" },
-		      { 0xc0f, "hpmcounter15" },
-		      { 0xc10, "hpmcounter16" },
-		      { 0xc11, "hpmcounter17" },
-		      { 0xc12, "hpmcounter18" },
-		      { 0xc13, "hpmcounter19" },
-		      { 0xc14, "hpmcounter20" },
-		      { 0xc15, "hpmcounter21" },
-		      { 0xc16, "hpmcounter22" },
-		      { 0xc17, "hpmcounter23" },
-		      { 0xc18, "hpmcounter24" },
-		      { 0xc19, "hpmcounter25" },
-		      { 0xc1a, "hpmcounter26" },
-		      { 0xc1b, "hpmcounter27" },
-		      { 0xc1c, "hpmcounter28" },
-		      { 0xc1d, "hpmcounter29" },
-		      { 0xc1e, "hpmcounter30" },
-		      { 0xc1f, "hpmcounter31" },
-		      { 0xc80, "cycleh" },
-		      { 0xc81, "timeh" },
-		      { 0xc82, "instreth" },
-		      { 0xc83, "hpmcounter3h" },
-		      { 0xc84, "hpmcounter4h" },
-		      { 0xc85, "hpmcounter5h" },
-		      { 0xc86, "hpmcounter6h" },
-		      { 0xc87, "hpmcounter7h" },
-		      { 0xc88, "hpmcounter8h" },
-		      { 0xc89, "hpmcounter9h" },
-		      { 0xc8a, "hpmcounter10h" },
-		      { 0xc8b, "hpmcounter11h" },
-		      { 0xc8c, "hpmcounter12h" },
-		      { 0xc8d, "hpmcounter13h" },
-		      { 0xc8e, "hpmcounter14h" },
-		      { 0xc8f, "hpmcounter15h" },
-		      { 0xc90, "hpmcounter16h" },
-		      { 0xc91, "hpmcounter17h" },
-		      { 0xc92, "hpmcounter18h" },
-		      { 0xc93, "hpmcounter19h" },
-		      { 0xc94, "hpmcounter20h" },
-		      { 0xc95, "hpmcounter21h" },
-		      { 0xc96, "hpmcounter22h" },
-		      { 0xc97, "hpmcounter23h" },
-		      { 0xc98, "hpmcounter24h" },
-		      { 0xc99, "hpmcounter25h" },
-		      { 0xc9a, "hpmcounter26h" },
-		      { 0xc9b, "hpmcounter27h" },
-		      { 0xc9c, "hpmcounter28h" },
-		      { 0xc9d, "hpmcounter29h" },
-		      { 0xc9e, "hpmcounter30h" },
-		      { 0xc9f, "hpmcounter31h" },
-		    };
-		  uint32_t csr = word >> 20;
-		  uint32_t instr = (word >> 12) & 0x7;
-		  size_t last = 0;
-		  if (rd != 0)
-		    op[last++] = REG (rd);
-		  struct known_csrs key = { csr, NULL };
-		  struct known_csrs *found = bsearch (&key, known,
-						      sizeof (known) / sizeof (known[0]),
-						      sizeof (known[0]),
-						      compare_csr);
-		  if (found)
-		    op[last] = (char *) found->name;
-		  else
-		    {
-		      snprintf (addrbuf, sizeof (addrbuf), "0x%" PRIx32, csr);
-		      op[last] = addrbuf;
-		    }
-		  ++last;
-		  if ((word & 0x4000) == 0)
-		    op[last] = REG ((word >> 15) & 0x1f);
-		  else
-		    {
-		      snprintf (immbuf, sizeof (immbuf), "%" PRIu32, (word >> 15) & UINT32_C(0x1f));
-		      op[last] = immbuf;
-		    }
-		  if (instr == 1 && rd == 0)
-		    mne = "csrw";
-		  else if (instr == 2 && rd == 0)
-		    mne = "csrs";
-		  else if (instr == 6 && rd == 0)
-		    mne = "csrsi";
-		  else if (instr == 2 && rs1 == 0)
-		    mne = "csrr";
-		  else if (instr == 3 && rd == 0)
-		    mne = "csrc";
-		  else
-		    mne = (char *) mnecsr[instr];
-		}
-	      break;
-	    default:
-	      break;
-	    }
-
-	  if (strp == NULL && mne == NULL)
-	    {
-	      len = snprintf (addrbuf, sizeof (addrbuf), "0x%08" PRIx32, word);
-	      strp = addrbuf;
-	    }
+	  len = snprintf (mnebuf, sizeof (mnebuf), "0x%08" PRIx32, enc);
+	  strp = mnebuf;
 	}
       else
 	{
@@ -1499,3 +1368,226 @@ riscv_disasm (Ebl *ebl,
 
   return retval;
 }
+
+
+static void
+add_operand (DisasmInsn *insn, DisasmOpKind kind, int64_t value)
+{
+  insn->ops[insn->nops].kind = kind;
+  insn->ops[insn->nops].value = value;
+  ++insn->nops;
+  if (kind == DISASM_OP_MEM)
+    insn->has_memop = true;
+  else if (kind == DISASM_OP_TARGET)
+    {
+      insn->has_target = true;
+      insn->target = value;
+    }
+}
+
+/* Fill in the operands of INSN at ADDR, which matched OP and has the
+   operands ARGS, and its control flow class.  */
+static void
+decode_operands (DisasmInsn *insn, const struct riscv_opcode *op,
+		 const struct riscv_args *args, GElf_Addr addr)
+{
+  switch (op->fmt)
+    {
+    case fmt_none:
+    case fmt_fence:
+      break;
+
+    case fmt_sfence:
+      add_operand (insn, DISASM_OP_REG, args->rs1);
+      add_operand (insn, DISASM_OP_REG, args->rs2);
+      break;
+
+    case fmt_r:
+    case fmt_fff:
+    case fmt_fff_rm:
+    case fmt_fsgnj:
+    case fmt_xff:
+    case fmt_ffff_rm:
+      add_operand (insn, DISASM_OP_REG, args->rd);
+      add_operand (insn, DISASM_OP_REG, args->rs1);
+      add_operand (insn, DISASM_OP_REG, args->rs2);
+      if (op->fmt == fmt_ffff_rm)
+	add_operand (insn, DISASM_OP_REG, args->rs3);
+      break;
+
+    case fmt_ff:
+    case fmt_ff_rm:
+    case fmt_xf:
+    case fmt_xf_rm:
+    case fmt_fx:
+    case fmt_fx_rm:
+      add_operand (insn, DISASM_OP_REG, args->rd);
+      add_operand (insn, DISASM_OP_REG, args->rs1);
+      break;
+
+    case fmt_i:
+    case fmt_shift:
+    case fmt_jalr:
+    case fmt_c_addi:
+    case fmt_c_addiw:
+    case fmt_c_addi4spn:
+    case fmt_c_addi16sp:
+    case fmt_c_shift:
+    case fmt_c_slli:
+    case fmt_c_andi:
+      add_operand (insn, DISASM_OP_REG, args->rd);
+      add_operand (insn, DISASM_OP_REG, args->rs1);
+      add_operand (insn, DISASM_OP_IMM, args->imm);
+      if (op->fmt == fmt_jalr)
+	{
+	  if (args->rd != 0)
+	    insn->insn_class = DISASM_INSN_CALL;
+	  else if (args->rs1 == 1 && args->imm == 0)
+	    insn->insn_class = DISASM_INSN_RETURN;
+	  else
+	    insn->insn_class = DISASM_INSN_JUMP;
+	}
+      break;
+
+    case fmt_load:
+    case fmt_fload:
+    case fmt_c_lw:
+    case fmt_c_flw:
+    case fmt_c_ld:
+    case fmt_c_fld:
+    case fmt_c_lwsp:
+    case fmt_c_flwsp:
+    case fmt_c_ldsp:
+    case fmt_c_fldsp:
+      add_operand (insn, DISASM_OP_REG, args->rd);
+      add_operand (insn, DISASM_OP_MEM, args->imm);
+      break;
+
+    case fmt_store:
+    case fmt_fstore:
+    case fmt_c_sw:
+    case fmt_c_fsw:
+    case fmt_c_sd:
+    case fmt_c_fsd:
+    case fmt_c_swsp:
+    case fmt_c_fswsp:
+    case fmt_c_sdsp:
+    case fmt_c_fsdsp:
+      add_operand (insn, DISASM_OP_REG, args->rs2);
+      add_operand (insn, DISASM_OP_MEM, args->imm);
+      break;
+
+    case fmt_branch:
+    case fmt_c_branch:
+      add_operand (insn, DISASM_OP_REG, args->rs1);
+      if (op->fmt == fmt_branch)
+	add_operand (insn, DISASM_OP_REG, args->rs2);
+      add_operand (insn, DISASM_OP_TARGET, addr + args->imm);
+      insn->insn_class = DISASM_INSN_COND_JUMP;
+      break;
+
+    case fmt_u:
+    case fmt_c_li:
+    case fmt_c_lui:
+      add_operand (insn, DISASM_OP_REG, args->rd);
+      add_operand (insn, DISASM_OP_IMM, args->imm);
+      break;
+
+    case fmt_jal:
+    case fmt_c_j:
+      if (op->fmt == fmt_jal)
+	add_operand (insn, DISASM_OP_REG, args->rd);
+      add_operand (insn, DISASM_OP_TARGET, addr + args->imm);
+      /* c.jal links to ra, c.j does not link.  */
+      if (op->fmt == fmt_jal ? args->rd != 0 : (op->match & 0xe000) == 0x2000)
+	insn->insn_class = DISASM_INSN_CALL;
+      else
+	insn->insn_class = DISASM_INSN_JUMP;
+      break;
+
+    case fmt_csr:
+    case fmt_csri:
+      add_operand (insn, DISASM_OP_REG, args->rd);
+      add_operand (insn, DISASM_OP_IMM, args->imm);
+      add_operand (insn, (op->fmt == fmt_csr
+			  ? DISASM_OP_REG : DISASM_OP_IMM), args->rs1);
+      break;
+
+    case fmt_amo:
+    case fmt_lr:
+      add_operand (insn, DISASM_OP_REG, args->rd);
+      if (op->fmt == fmt_amo)
+	add_operand (insn, DISASM_OP_REG, args->rs2);
+      add_operand (insn, DISASM_OP_MEM, 0);
+      break;
+
+    case fmt_c_arith:
+    case fmt_c_add:
+      add_operand (insn, DISASM_OP_REG, args->rd);
+      add_operand (insn, DISASM_OP_REG, args->rs1);
+      add_operand (insn, DISASM_OP_REG, args->rs2);
+      break;
+
+    case fmt_c_mv:
+      add_operand (insn, DISASM_OP_REG, args->rd);
+      add_operand (insn, DISASM_OP_REG, args->rs2);
+      break;
+
+    case fmt_c_jr:
+      add_operand (insn, DISASM_OP_REG, args->rs1);
+      if ((op->match & 0x1000) != 0)
+	insn->insn_class = DISASM_INSN_CALL;
+      else if (args->rs1 == 1)
+	insn->insn_class = DISASM_INSN_RETURN;
+      else
+	insn->insn_class = DISASM_INSN_JUMP;
+      break;
+    }
+}
+
+
+int
+riscv_disasm_decode (Ebl *ebl, const uint8_t **startp, const uint8_t *end,
+		     GElf_Addr addr, DisasmInsn *insn)
+{
+  const uint8_t *data = *startp;
+  assert (data <= end);
+  if (data + 2 > end)
+    return -1;
+
+  uint16_t first = read_2ubyte_unaligned (data);
+  size_t length = insn_length (first);
+  if (data + length > end)
+    return -1;
+
+  insn->nops = 0;
+  insn->has_target = false;
+  insn->has_memop = false;
+  insn->insn_class = DISASM_INSN_OTHER;
+
+  /* Longer encodings are not known.  */
+  const struct riscv_opcode *op = NULL;
+  struct riscv_args args;
+  if (length <= 4)
+    {
+      uint32_t enc = length == 2 ? first : read_4ubyte_unaligned (data);
+      op = riscv_lookup (enc, length, ebl->class);
+      if (op != NULL && ! extract_args (op, enc, ebl->class, &args))
+	op = NULL;
+    }
+
+  if (op == NULL)
+    {
+      insn->insn_class = DISASM_INSN_INVALID;
+      strcpy (insn->mnemonic, "unknown");
+    }
+  else
+    {
+      decode_operands (insn, op, &args, addr);
+      strcpy (insn->mnemonic, op->name);
+    }
+
+  insn->length = length;
+  *startp = data + length;
+  return 0;
+}
@@ -0,0 +1,233 @@
+# Generate the RISC-V decode tables from defs/riscv.
+# This file is part of elfutils.
+#
+# This file is free software; you can redistribute it and/or modify
+# it under the terms of either
+#
+#   * the GNU Lesser General Public License as published by the Free
+#     Software Foundation; either version 3 of the License, or (at
+#     your option) any later version
+#
+# or
+#
+#   * the GNU General Public License as published by the Free
+#     Software Foundation; either version 2 of the License, or (at
+#     your option) any later version
+#
+# or both in parallel, as here.
+#
+# elfutils is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+# General Public License for more details.
+#
+# You should have received copies of the GNU General Public License and
+# the GNU Lesser General Public License along with this program.  If
+# not, see <http://www.gnu.org/licenses/>.
+
+# The output contains riscv_opcodes and riscv_c_opcodes with one entry
+# per input line, in input order, and for each of them a list of
+# buckets.  An instruction is listed in every bucket its pattern can
+# match, so the decoder only has to look at the entries of a single
+# bucket.
+#
+# 32-bit instructions are first split by the major opcode (bits 6:2).
+# The instructions of one major opcode are then split by funct3 (bits
+# 14:12), or by funct7 (bits 31:25) if that would leave more than
+# MAXBUCKET entries in one bucket, as for OP-FP where funct3 holds the
+# rounding mode.  Compressed instructions are split by the quadrant
+# (bits 1:0) and funct3 (bits 15:13).
+#
+# Only POSIX awk features are used; the masks are computed from the
+# pattern strings since there are no portable bit operations.
+
+function fail(msg)
+{
+  printf ("%s:%d: %s\n", FILENAME, FNR, msg) > "/dev/stderr"
+  failed = 1
+  exit 1
+}
+
+# Hexadecimal value of PAT where '1' (ONES true) or anything but '-'
+# (ONES false) is a one bit.
+function hexval(pat, ones,    res, i, j, v, c)
+{
+  res = "0x"
+  for (i = 1; i <= length (pat); i += 4)
+    {
+      v = 0
+      for (j = i; j < i + 4; ++j)
+	{
+	  c = substr (pat, j, 1)
+	  v = v * 2 + (ones ? c == "1" : c != "-")
+	}
+      res = res substr ("0123456789abcdef", v + 1, 1)
+    }
+  return res
+}
+
+# True if the WIDTH bits of PAT starting at bit SHIFT can be VAL.
+function canbe(pat, shift, width, val,    j, c)
+{
+  for (j = 0; j < width; ++j)
+    {
+      c = substr (pat, length (pat) - shift - j, 1)
+      if (c != "-" && c != int (val / 2 ^ j) % 2)
+	return 0
+    }
+  return 1
+}
+
+# Add the buckets for the instructions in PATS with field (SHIFT1,
+# WIDTH1) equal to VAL1, split by field (SHIFT2, WIDTH2).
+function addbuckets(shift1, width1, val1, shift2, width2,    v)
+{
+  for (v = 0; v < 2 ^ width2; ++v)
+    {
+      bshift1[nbuckets] = shift1
+      bwidth1[nbuckets] = width1
+      bval1[nbuckets] = val1
+      bshift2[nbuckets] = shift2
+      bwidth2[nbuckets] = width2
+      bval2[nbuckets] = v
+      ++nbuckets
+    }
+}
+
+# Largest number of instructions of major opcode MAJOR with the same
+# value in field (SHIFT, WIDTH).
+function maxbucket(major, shift, width,    v, i, cnt, max)
+{
+  max = 0
+  for (v = 0; v < 2 ^ width; ++v)
+    {
+      cnt = 0
+      for (i = 0; i < n32; ++i)
+	if (canbe(pats32[i], 2, 5, major) && canbe(pats32[i], shift, width, v))
+	  ++cnt
+      if (cnt > max)
+	max = cnt
+    }
+  return max
+}
+
+# Print the table VAR with the N entries in ENTS, and the bucket lists
+# for PATS, using TYPE for the indices.
+function emit(var, pats, ents, n, type,    i, k, cnt, list, idx)
+{
+  printf ("static const struct riscv_opcode %s[%d] =\n  {\n", var, n)
+  for (i = 0; i < n; ++i)
+    printf ("    %s,\n", ents[i])
+  printf ("  };\n\n")
+
+  cnt = 0
+  list = ""
+  idx = ""
+  for (k = 0; k < nbuckets; ++k)
+    {
+      idx = idx sprintf ("%s%d,", k % 12 == 0 ? "\n    " : " ", cnt)
+      for (i = 0; i < n; ++i)
+	if (canbe(pats[i], bshift1[k], bwidth1[k], bval1[k]) &&
+	    canbe(pats[i], bshift2[k], bwidth2[k], bval2[k]))
+	  {
+	    list = list sprintf ("%s%d,", cnt % 12 == 0 ? "\n    " : " ", i)
+	    ++cnt
+	  }
+    }
+  idx = idx sprintf ("%s%d,", k % 12 == 0 ? "\n    " : " ", cnt)
+
+  printf ("static const %s %s_list[%d] =\n  {%s\n  };\n\n",
+	  type, var, cnt, list)
+  printf ("static const %s %s_idx[%d] =\n  {%s\n  };\n",
+	  type, var, nbuckets + 1, idx)
+}
+
+BEGIN {
+  MAXBUCKET = 8
+  n32 = 0
+  n16 = 0
+}
+
+/^#/ || NF == 0 {
+  next
+}
+
+{
+  pat = $1
+  gsub (/_/, "", pat)
+  if ((length (pat) != 32 && length (pat) != 16) || pat ~ /[^01-]/)
+    fail("invalid pattern")
+  if (NF < 3 || NF > 4)
+    fail("wrong number of fields")
+
+  name = $2
+  mne = $2
+  if (length (pat) == 16)
+    {
+      if (split ($2, names, "/") != 2)
+	fail("compressed instruction needs two names")
+      name = names[1]
+      mne = names[2]
+    }
+
+  class = "0"
+  if (NF == 4)
+    {
+      if ($4 == "rv32")
+	class = "ELFCLASS32"
+      else if ($4 == "rv64")
+	class = "ELFCLASS64"
+      else
+	fail("invalid class")
+    }
+
+  ent = sprintf ("{ \"%s\", \"%s\", %s, %s, %s, fmt_%s }", name, mne,
+		 hexval(pat, 0), hexval(pat, 1), class, $3)
+  if (length (pat) == 32)
+    {
+      if (substr (pat, 31, 2) != "11")
+	fail("32-bit pattern must end in 11")
+      pats32[n32] = pat
+      ents32[n32++] = ent
+    }
+  else
+    {
+      pats16[n16] = pat
+      ents16[n16++] = ent
+    }
+}
+
+END {
+  if (failed)
+    exit 1
+
+  printf ("/* Generated by riscv_gendis.awk from defs/riscv.  Do not edit.  */\n\n")
+
+  nbuckets = 0
+  dispatch = ""
+  for (major = 0; major < 32; ++major)
+    {
+      if (maxbucket(major, 12, 3) <= MAXBUCKET)
+	{
+	  shift = 12
+	  width = 3
+	}
+      else
+	{
+	  shift = 25
+	  width = 7
+	}
+      dispatch = dispatch sprintf ("\n    { %d, %d, %#x },", nbuckets, shift,
+				   2 ^ width - 1)
+      addbuckets(2, 5, major, shift, width)
+    }
+  printf ("static const struct riscv_dispatch riscv_opcodes_dispatch[32] =\n")
+  printf ("  {%s\n  };\n\n", dispatch)
+  emit("riscv_opcodes", pats32, ents32, n32, "uint16_t")
+  printf ("\n")
+
+  nbuckets = 0
+  for (quadrant = 0; quadrant < 3; ++quadrant)
+    addbuckets(0, 2, quadrant, 13, 3)
+  emit("riscv_c_opcodes", pats16, ents16, n16, "uint8_t")
+}
@@ -509,12 +509,25 @@ cie_cache_initial_state (Dwarf_CFI *cache, struct dwarf_cie *cie)
 int
 internal_function
 __libdw_frame_at_address (Dwarf_CFI *cache, struct dwarf_fde *fde,
-			  Dwarf_Addr address, Dwarf_Frame **frame)
+			  Dwarf_Addr address, Dwarf_Frame **frame,
+			  Dwarf_Frame **spare)
 {
   int result = cie_cache_initial_state (cache, fde->cie);
   if (likely (result == DWARF_E_NOERROR))
     {
-      Dwarf_Frame *fs = duplicate_frame_state (fde->cie->initial_state, NULL);
+      const Dwarf_Frame *initial = fde->cie->initial_state;
+      Dwarf_Frame *fs;
+      /* The spare frame has room for at least its nregs.  */
+      if (spare != NULL && *spare != NULL
+	  && (*spare)->nregs >= initial->nregs)
+	{
+	  fs = *spare;
+	  *spare = NULL;
+	  memcpy (fs, initial, offsetof (Dwarf_Frame, regs[initial->nregs]));
+	  fs->prev = NULL;
+	}
+      else
+	fs = duplicate_frame_state (initial, NULL);
       if (unlikely (fs == NULL))
 	return DWARF_E_NOMEM;
 
@@ -98,6 +98,10 @@ struct Dwarf_CFI_s
   /* Search tree for parsed DWARF expressions, indexed by raw pointer.  */
   void *expr_tree;
 
+  /* Search tree for the expressions of expr_tree compiled by the libdwfl
+     unwinder, indexed by their Dwarf_Op array.  */
+  void *expr_code_tree;
+
   /* Backend hook.  */
   struct ebl *ebl;
 
@@ -215,12 +219,21 @@ extern struct dwarf_fde *__libdw_fde_by_offset (Dwarf_CFI *cache,
   __nonnull_attribute__ (1) internal_function;
 
 /* Process the FDE that contains the given PC address,
-   to yield the frame state when stopped there.
+   to yield the frame state when stopped there.  If SPARE is not NULL
+   and *SPARE is a frame no longer used, it might be reused for the
+   result and is set to NULL then.
    The return value is a DWARF_E_* error code.  */
 extern int __libdw_frame_at_address (Dwarf_CFI *cache, struct dwarf_fde *fde,
-				     Dwarf_Addr address, Dwarf_Frame **frame)
+				     Dwarf_Addr address, Dwarf_Frame **frame,
+				     Dwarf_Frame **spare)
   __nonnull_attribute__ (1, 2, 4) internal_function;
 
+/* Like dwarf_cfi_addrframe, but reusing *SPARE like
+   __libdw_frame_at_address.  */
+extern int __libdw_cfi_addrframe (Dwarf_CFI *cache, Dwarf_Addr address,
+				  Dwarf_Frame **frame, Dwarf_Frame **spare)
+  __nonnull_attribute__ (3) internal_function;
+
 
 /* Dummy struct for memory-access.h macros.  */
 #define BYTE_ORDER_DUMMY(var, e_ident)					      \
@@ -32,6 +32,7 @@
 
 #define NAME Dwarf_Abbrev_Hash
 #define TYPE Dwarf_Abbrev *
+#define SWISS
 
 #include <dynamicsizehash_concurrent.h>
 
@@ -224,7 +224,8 @@ check_section (Dwarf *result, size_t shstrndx, Elf_Scn *scn, bool inscngrp)
     /* Not a debug section; ignore it. */
     return result;
 
-  if (unlikely (result->sectiondata[cnt] != NULL))
+  if (unlikely (result->sectiondata[cnt] != NULL
+		|| result->lazyscn[cnt] != NULL))
     /* A section appears twice.  That's bad.  We ignore the section.  */
     return result;
 
@@ -235,6 +236,18 @@ check_section (Dwarf *result, size_t shstrndx, Elf_Scn *scn, bool inscngrp)
 
   if ((shdr->sh_flags & SHF_COMPRESSED) != 0)
     {
+      /* Only decompress the section when it is first used, see
+	 __libdw_sectiondata.  Many users only ever look at a few of
+	 the sections.  The header tells us whether there is any data
+	 at all, which is all we need to know for now.  */
+      GElf_Chdr chdr;
+      if (gelf_getchdr (scn, &chdr) != NULL)
+	{
+	  if (chdr.ch_size != 0)
+	    result->lazyscn[cnt] = scn;
+	  return result;
+	}
+
       if (elf_compress (scn, 0, 0) < 0)
 	{
 	  /* It would be nice if we could fail with a specific error.
@@ -305,9 +318,9 @@ valid_p (Dwarf *result)
 
      Require at least one section that can be read "standalone".  */
   if (likely (result != NULL)
-      && unlikely (result->sectiondata[IDX_debug_info] == NULL
-		   && result->sectiondata[IDX_debug_line] == NULL
-		   && result->sectiondata[IDX_debug_frame] == NULL))
+      && unlikely (!__libdw_have_section (result, IDX_debug_info)
+		   && !__libdw_have_section (result, IDX_debug_line)
+		   && !__libdw_have_section (result, IDX_debug_frame)))
     {
       Dwarf_Sig8_Hash_free (&result->sig8_hash);
       __libdw_seterrno (DWARF_E_NO_DWARF);
@@ -335,7 +348,7 @@ valid_p (Dwarf *result)
   /* For dwarf_location_attr () we need a "fake" CU to indicate
      where the "fake" attribute data comes from.  This is a block
      inside the .debug_loc or .debug_loclists section.  */
-  if (result != NULL && result->sectiondata[IDX_debug_loc] != NULL)
+  if (result != NULL && __libdw_have_section (result, IDX_debug_loc))
     {
       result->fake_loc_cu = malloc (sizeof (Dwarf_CU));
       if (unlikely (result->fake_loc_cu == NULL))
@@ -349,12 +362,13 @@ valid_p (Dwarf *result)
 	{
 	  result->fake_loc_cu->sec_idx = IDX_debug_loc;
 	  result->fake_loc_cu->dbg = result;
-	  result->fake_loc_cu->startp
-	    = result->sectiondata[IDX_debug_loc]->d_buf;
+	  /* A compressed section gets these when it is loaded.  */
+	  Elf_Data *data = result->sectiondata[IDX_debug_loc];
+	  result->fake_loc_cu->startp = data != NULL ? data->d_buf : NULL;
 	  result->fake_loc_cu->endp
-	    = (result->sectiondata[IDX_debug_loc]->d_buf
-	       + result->sectiondata[IDX_debug_loc]->d_size);
+	    = data != NULL ? data->d_buf + data->d_size : NULL;
 	  result->fake_loc_cu->locs = NULL;
+	  result->fake_loc_cu->ranges = NULL;
 	  result->fake_loc_cu->address_size = elf_addr_size;
 	  result->fake_loc_cu->offset_size = 4;
 	  result->fake_loc_cu->version = 4;
@@ -362,7 +376,7 @@ valid_p (Dwarf *result)
 	}
     }
 
-  if (result != NULL && result->sectiondata[IDX_debug_loclists] != NULL)
+  if (result != NULL && __libdw_have_section (result, IDX_debug_loclists))
     {
       result->fake_loclists_cu = malloc (sizeof (Dwarf_CU));
       if (unlikely (result->fake_loclists_cu == NULL))
@@ -377,12 +391,13 @@ valid_p (Dwarf *result)
 	{
 	  result->fake_loclists_cu->sec_idx = IDX_debug_loclists;
 	  result->fake_loclists_cu->dbg = result;
-	  result->fake_loclists_cu->startp
-	    = result->sectiondata[IDX_debug_loclists]->d_buf;
+	  /* A compressed section gets these when it is loaded.  */
+	  Elf_Data *data = result->sectiondata[IDX_debug_loclists];
+	  result->fake_loclists_cu->startp = data != NULL ? data->d_buf : NULL;
 	  result->fake_loclists_cu->endp
-	    = (result->sectiondata[IDX_debug_loclists]->d_buf
-	       + result->sectiondata[IDX_debug_loclists]->d_size);
+	    = data != NULL ? data->d_buf + data->d_size : NULL;
 	  result->fake_loclists_cu->locs = NULL;
+	  result->fake_loclists_cu->ranges = NULL;
 	  result->fake_loclists_cu->address_size = elf_addr_size;
 	  result->fake_loclists_cu->offset_size = 4;
 	  result->fake_loclists_cu->version = 5;
@@ -394,7 +409,7 @@ valid_p (Dwarf *result)
      the dwarf_location_attr () will need a "fake" address CU to
      indicate where the attribute data comes from.  This is a just
      inside the .debug_addr section, if it exists.  */
-  if (result != NULL && result->sectiondata[IDX_debug_addr] != NULL)
+  if (result != NULL && __libdw_have_section (result, IDX_debug_addr))
     {
       result->fake_addr_cu = malloc (sizeof (Dwarf_CU));
       if (unlikely (result->fake_addr_cu == NULL))
@@ -410,12 +425,13 @@ valid_p (Dwarf *result)
 	{
 	  result->fake_addr_cu->sec_idx = IDX_debug_addr;
 	  result->fake_addr_cu->dbg = result;
-	  result->fake_addr_cu->startp
-	    = result->sectiondata[IDX_debug_addr]->d_buf;
+	  /* A compressed section gets these when it is loaded.  */
+	  Elf_Data *data = result->sectiondata[IDX_debug_addr];
+	  result->fake_addr_cu->startp = data != NULL ? data->d_buf : NULL;
 	  result->fake_addr_cu->endp
-	    = (result->sectiondata[IDX_debug_addr]->d_buf
-	       + result->sectiondata[IDX_debug_addr]->d_size);
+	    = data != NULL ? data->d_buf + data->d_size : NULL;
 	  result->fake_addr_cu->locs = NULL;
+	  result->fake_addr_cu->ranges = NULL;
 	  result->fake_addr_cu->address_size = elf_addr_size;
 	  result->fake_addr_cu->offset_size = 4;
 	  result->fake_addr_cu->version = 5;
@@ -573,7 +589,9 @@ dwarf_begin_elf (Elf *elf, Dwarf_Cmd cmd, Elf_Scn *scngrp)
      actual allocation.  */
   result->mem_default_size = mem_default_size;
   result->oom_handler = __libdw_oom;
-  if (pthread_rwlock_init(&result->mem_rwl, NULL) != 0)
+  if (pthread_rwlock_init(&result->mem_rwl, NULL) != 0
+      || pthread_mutex_init (&result->sectiondata_lock, NULL) != 0
+      || pthread_mutex_init (&result->ranges_lock, NULL) != 0)
     {
       free (result);
       __libdw_seterrno (DWARF_E_NOMEM); /* no memory.  */
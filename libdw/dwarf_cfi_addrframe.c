@@ -33,7 +33,9 @@
 #include "cfi.h"
 
 int
-dwarf_cfi_addrframe (Dwarf_CFI *cache, Dwarf_Addr address, Dwarf_Frame **frame)
+internal_function
+__libdw_cfi_addrframe (Dwarf_CFI *cache, Dwarf_Addr address,
+		       Dwarf_Frame **frame, Dwarf_Frame **spare)
 {
   /* Maybe there was a previous error.  */
   if (cache == NULL)
@@ -43,7 +45,7 @@ dwarf_cfi_addrframe (Dwarf_CFI *cache, Dwarf_Addr address, Dwarf_Frame **frame)
   if (fde == NULL)
     return -1;
 
-  int error = __libdw_frame_at_address (cache, fde, address, frame);
+  int error = __libdw_frame_at_address (cache, fde, address, frame, spare);
   if (error != DWARF_E_NOERROR)
     {
       __libdw_seterrno (error);
@@ -51,4 +53,10 @@ dwarf_cfi_addrframe (Dwarf_CFI *cache, Dwarf_Addr address, Dwarf_Frame **frame)
     }
   return 0;
 }
+
+int
+dwarf_cfi_addrframe (Dwarf_CFI *cache, Dwarf_Addr address, Dwarf_Frame **frame)
+{
+  return __libdw_cfi_addrframe (cache, address, frame, NULL);
+}
 INTDEF (dwarf_cfi_addrframe)
@@ -39,9 +39,9 @@ __libdw_read_package_index (Dwarf *dbg, bool tu)
 {
   Elf_Data *data;
   if (tu)
-    data = dbg->sectiondata[IDX_debug_tu_index];
+    data = __libdw_sectiondata (dbg, IDX_debug_tu_index);
   else
-    data = dbg->sectiondata[IDX_debug_cu_index];
+    data = __libdw_sectiondata (dbg, IDX_debug_cu_index);
 
   /* We need at least 16 bytes for the header.  */
   if (data == NULL || data->d_size < 16)
@@ -146,9 +146,9 @@ __libdw_read_package_index (Dwarf *dbg, bool tu)
 
   /* DW_SECT_INFO (or DW_SECT_TYPES for DWARF 4 type units) and DW_SECT_ABBREV
      are required.  */
-  if (((!tu || dbg->sectiondata[IDX_debug_types] == NULL)
+  if (((!tu || !__libdw_have_section (dbg, IDX_debug_types))
        && index->sections[DW_SECT_INFO - 1] == UINT32_MAX)
-      || (tu && dbg->sectiondata[IDX_debug_types] != NULL
+      || (tu && __libdw_have_section (dbg, IDX_debug_types)
 	  && index->sections[DW_SECT_TYPES - 1] == UINT32_MAX)
       || index->sections[DW_SECT_ABBREV - 1] == UINT32_MAX)
     {
@@ -205,8 +205,9 @@ __libdw_package_index (Dwarf *dbg, bool tu)
 
      Note that this will be fixed properly in DWARF 6:
      https://dwarfstd.org/issues/220708.2.html.  */
+  Elf_Data *info = __libdw_sectiondata (dbg, IDX_debug_info);
   if (index->sections[DW_SECT_INFO - 1] != UINT32_MAX
-      && dbg->sectiondata[IDX_debug_info]->d_size > UINT32_MAX)
+      && info != NULL && info->d_size > UINT32_MAX)
     {
       Dwarf_Package_Index *cu_index, *tu_index = NULL;
       if (tu)
@@ -223,8 +224,8 @@ __libdw_package_index (Dwarf *dbg, bool tu)
       else
 	{
 	  cu_index = index;
-	  if (dbg->sectiondata[IDX_debug_tu_index] != NULL
-	      && dbg->sectiondata[IDX_debug_types] == NULL)
+	  if (__libdw_have_section (dbg, IDX_debug_tu_index)
+	      && !__libdw_have_section (dbg, IDX_debug_types))
 	    {
 	      assert (dbg->tu_index == NULL);
 	      tu_index = __libdw_read_package_index (dbg, true);
@@ -409,7 +410,8 @@ __libdw_dwp_find_unit (Dwarf *dbg, bool debug_types, Dwarf_Off off,
       return 0;
     }
   bool tu = unit_type == DW_UT_split_type || debug_types;
-  if (dbg->sectiondata[tu ? IDX_debug_tu_index : IDX_debug_cu_index] == NULL)
+  if (!__libdw_have_section (dbg,
+			     tu ? IDX_debug_tu_index : IDX_debug_cu_index))
     goto not_dwp;
   Dwarf_Package_Index *index = __libdw_package_index (dbg, tu);
   if (index == NULL)
@@ -63,6 +63,7 @@ cu_free (void *arg)
   struct Dwarf_CU *p = (struct Dwarf_CU *) arg;
 
   tdestroy (p->locs, noop_free);
+  tdestroy (p->ranges, free);
 
   /* Only free the CU internals if its not a fake CU.  */
   if(p != p->dbg->fake_loc_cu && p != p->dbg->fake_loclists_cu
@@ -70,6 +71,9 @@ cu_free (void *arg)
     {
       Dwarf_Abbrev_Hash_free (&p->abbrev_hash);
 
+      if (p->scope_tree != (void *) -1l)
+	__libdw_scope_tree_free (p->scope_tree);
+
       /* Free split dwarf one way (from skeleton to split).  */
       if (p->unit_type == DW_UT_skeleton
 	  && p->split != NULL && p->split != (void *)-1)
@@ -108,8 +112,12 @@ dwarf_end (Dwarf *dwarf)
       /* Search tree for macro opcode tables.  */
       tdestroy (dwarf->macro_ops, noop_free);
 
-      /* Search tree for decoded .debug_lines units.  */
+      /* Search tree for decoded .debug_lines units.  The nodes are
+	 allocated separately, but their line tables need to be freed.  */
       tdestroy (dwarf->files_lines, noop_free);
+      for (struct files_lines_s *node = dwarf->files_lines_list;
+	   node != NULL; node = node->next)
+	free (node->lines);
 
       /* And the split Dwarf.  */
       tdestroy (dwarf->split_tree, noop_free);
@@ -128,6 +136,9 @@ dwarf_end (Dwarf *dwarf)
       if (dwarf->mem_tails != NULL)
         free (dwarf->mem_tails);
       pthread_rwlock_destroy (&dwarf->mem_rwl);
+      __libdw_account_memory (dwarf, -(ptrdiff_t) dwarf->mem_usage);
+      pthread_mutex_destroy (&dwarf->sectiondata_lock);
+      pthread_mutex_destroy (&dwarf->ranges_lock);
 
       /* Free the pubnames helper structure.  */
       free (dwarf->pubnames_sets);
@@ -49,3 +49,4 @@ dwarf_filesrc (Dwarf_Files *file, size_t idx, Dwarf_Word *mtime,
 
   return file->info[idx].name;
 }
+INTDEF (dwarf_filesrc)
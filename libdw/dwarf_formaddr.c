@@ -42,7 +42,8 @@ __libdw_addrx (Dwarf_CU *cu, Dwarf_Word idx, Dwarf_Addr *addr)
     return -1;
 
   Dwarf *dbg = cu->dbg;
-  if (dbg->sectiondata[IDX_debug_addr] == NULL)
+  Elf_Data *data = __libdw_sectiondata (dbg, IDX_debug_addr);
+  if (data == NULL)
     {
       __libdw_seterrno (DWARF_E_NO_DEBUG_ADDR);
       return -1;
@@ -50,24 +51,22 @@ __libdw_addrx (Dwarf_CU *cu, Dwarf_Word idx, Dwarf_Addr *addr)
 
   /* The section should at least contain room for one address.  */
   int address_size = cu->address_size;
-  if (cu->address_size > dbg->sectiondata[IDX_debug_addr]->d_size)
+  if (cu->address_size > data->d_size)
     {
     invalid_offset:
       __libdw_seterrno (DWARF_E_INVALID_OFFSET);
       return -1;
     }
 
-  if (addr_off > (dbg->sectiondata[IDX_debug_addr]->d_size
-		  - address_size))
+  if (addr_off > data->d_size - address_size)
     goto invalid_offset;
 
   idx *= address_size;
-  if (idx > (dbg->sectiondata[IDX_debug_addr]->d_size
-	     - address_size - addr_off))
+  if (idx > data->d_size - address_size - addr_off)
     goto invalid_offset;
 
   const unsigned char *datap;
-  datap = dbg->sectiondata[IDX_debug_addr]->d_buf + addr_off + idx;
+  datap = data->d_buf + addr_off + idx;
   if (address_size == 4)
     *addr = read_4ubyte_unaligned (dbg, datap);
   else
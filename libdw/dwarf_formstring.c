@@ -59,8 +59,8 @@ dwarf_formstring (Dwarf_Attribute *attrp)
     }
 
   Elf_Data *data = ((attrp->form == DW_FORM_line_strp)
-		    ? dbg_ret->sectiondata[IDX_debug_line_str]
-		    : dbg_ret->sectiondata[IDX_debug_str]);
+		    ? __libdw_sectiondata (dbg_ret, IDX_debug_line_str)
+		    : __libdw_sectiondata (dbg_ret, IDX_debug_str));
   size_t data_size = ((attrp->form == DW_FORM_line_strp)
 		      ? dbg_ret->string_section_size[STR_SCN_IDX_debug_line_str]
 		      : dbg_ret->string_section_size[STR_SCN_IDX_debug_str]);
@@ -142,7 +142,9 @@ dwarf_formstring (Dwarf_Attribute *attrp)
       if (str_off == (Dwarf_Off) -1)
 	return NULL;
 
-      if (dbg->sectiondata[IDX_debug_str_offsets] == NULL)
+      Elf_Data *str_offsets = __libdw_sectiondata (dbg,
+						   IDX_debug_str_offsets);
+      if (str_offsets == NULL)
 	{
 	  __libdw_seterrno (DWARF_E_NO_STR_OFFSETS);
 	  return NULL;
@@ -150,7 +152,7 @@ dwarf_formstring (Dwarf_Attribute *attrp)
 
       /* The section should at least contain room for one offset.  */
       int offset_size = cu->offset_size;
-      if (cu->offset_size > dbg->sectiondata[IDX_debug_str_offsets]->d_size)
+      if (cu->offset_size > str_offsets->d_size)
 	{
 	invalid_offset:
 	  __libdw_seterrno (DWARF_E_INVALID_OFFSET);
@@ -158,17 +160,15 @@ dwarf_formstring (Dwarf_Attribute *attrp)
 	}
 
       /* And the base offset should be at least inside the section.  */
-      if (str_off > (dbg->sectiondata[IDX_debug_str_offsets]->d_size
-		     - offset_size))
+      if (str_off > str_offsets->d_size - offset_size)
 	goto invalid_offset;
 
-      size_t max_idx = (dbg->sectiondata[IDX_debug_str_offsets]->d_size
-			- offset_size - str_off) / offset_size;
+      size_t max_idx = ((str_offsets->d_size - offset_size - str_off)
+			/ offset_size);
       if (idx > max_idx)
 	goto invalid_offset;
 
-      datap = (dbg->sectiondata[IDX_debug_str_offsets]->d_buf
-	       + str_off + (idx * offset_size));
+      datap = str_offsets->d_buf + str_off + (idx * offset_size);
       if (offset_size == 4)
 	off = read_4ubyte_unaligned (dbg, datap);
       else
@@ -42,7 +42,7 @@ __libdw_formptr (Dwarf_Attribute *attr, int sec_index,
   if (attr == NULL)
     return NULL;
 
-  const Elf_Data *d = attr->cu->dbg->sectiondata[sec_index];
+  const Elf_Data *d = __libdw_sectiondata (attr->cu->dbg, sec_index);
   Dwarf_CU *skel = NULL; /* See below, needed for GNU DebugFission.  */
   if (unlikely (d == NULL
 		&& sec_index == IDX_debug_ranges
@@ -51,7 +51,7 @@ __libdw_formptr (Dwarf_Attribute *attr, int sec_index,
     {
       skel = __libdw_find_split_unit (attr->cu);
       if (skel != NULL)
-	d = skel->dbg->sectiondata[IDX_debug_ranges];
+	d = __libdw_sectiondata (skel->dbg, IDX_debug_ranges);
     }
 
   if (unlikely (d == NULL))
@@ -68,7 +68,7 @@ dwarf_get_units (Dwarf *dwarf, Dwarf_CU *cu, Dwarf_CU **next_cu,
 	{
 	  if (off >= cu->dbg->sectiondata[IDX_debug_info]->d_size)
 	    {
-	      if (cu->dbg->sectiondata[IDX_debug_types] == NULL)
+	      if (__libdw_sectiondata (cu->dbg, IDX_debug_types) == NULL)
 		return 1;
 
 	      off = 0;
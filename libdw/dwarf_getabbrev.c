@@ -41,17 +41,18 @@ __libdw_getabbrev (Dwarf *dbg, struct Dwarf_CU *cu, Dwarf_Off offset,
 		   size_t *lengthp, Dwarf_Abbrev *result)
 {
   /* Don't fail if there is not .debug_abbrev section.  */
-  if (dbg->sectiondata[IDX_debug_abbrev] == NULL)
+  Elf_Data *data = __libdw_sectiondata (dbg, IDX_debug_abbrev);
+  if (data == NULL)
     return NULL;
 
-  if (offset >= dbg->sectiondata[IDX_debug_abbrev]->d_size)
+  if (offset >= data->d_size)
     {
       __libdw_seterrno (DWARF_E_INVALID_OFFSET);
       return NULL;
     }
 
   const unsigned char *abbrevp
-    = (unsigned char *) dbg->sectiondata[IDX_debug_abbrev]->d_buf + offset;
+    = (unsigned char *) data->d_buf + offset;
 
   if (*abbrevp == '\0')
     /* We are past the last entry.  */
@@ -73,8 +74,7 @@ __libdw_getabbrev (Dwarf *dbg, struct Dwarf_CU *cu, Dwarf_Off offset,
      consists of two parts. The first part is an unsigned LEB128
      number representing the attribute's name. The second part is
      an unsigned LEB128 number representing the attribute's form.  */
-  const unsigned char *end = (dbg->sectiondata[IDX_debug_abbrev]->d_buf
-			      + dbg->sectiondata[IDX_debug_abbrev]->d_size);
+  const unsigned char *end = data->d_buf + data->d_size;
   const unsigned char *start_abbrevp = abbrevp;
   unsigned int code;
   // We start off with abbrevp at offset, which is checked above.
@@ -173,7 +173,7 @@ dwarf_getabbrev (Dwarf_Die *die, Dwarf_Off offset, size_t *lengthp)
   Dwarf_CU *cu = die->cu;
   Dwarf *dbg = cu->dbg;
   Dwarf_Off abbrev_offset = cu->orig_abbrev_offset;
-  Elf_Data *data = dbg->sectiondata[IDX_debug_abbrev];
+  Elf_Data *data = __libdw_sectiondata (dbg, IDX_debug_abbrev);
   if (data == NULL)
     return NULL;
 
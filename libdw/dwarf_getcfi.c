@@ -40,12 +40,14 @@ dwarf_getcfi (Dwarf *dbg)
   if (dbg == NULL)
     return NULL;
 
-  if (dbg->cfi == NULL && dbg->sectiondata[IDX_debug_frame] != NULL)
+  Elf_Data *data;
+  if (dbg->cfi == NULL
+      && (data = __libdw_sectiondata (dbg, IDX_debug_frame)) != NULL)
     {
       Dwarf_CFI *cfi = libdw_typed_alloc (dbg, Dwarf_CFI);
 
       cfi->dbg = dbg;
-      cfi->data = (Elf_Data_Scn *) dbg->sectiondata[IDX_debug_frame];
+      cfi->data = (Elf_Data_Scn *) data;
 
       cfi->search_table = NULL;
       cfi->search_table_vaddr = 0;
@@ -67,6 +69,7 @@ dwarf_getcfi (Dwarf *dbg)
 
       cfi->next_offset = 0;
       cfi->cie_tree = cfi->fde_tree = cfi->expr_tree = NULL;
+      cfi->expr_code_tree = NULL;
 
       cfi->ebl = NULL;
 
@@ -759,12 +759,12 @@ initial_offset (Dwarf_Attribute *attr, ptrdiff_t *offset)
 	}
       get_uleb128 (idx, datap, endp);
 
-      Elf_Data *data = cu->dbg->sectiondata[secidx];
+      Elf_Data *data = __libdw_sectiondata (cu->dbg, secidx);
       if (data == NULL && cu->unit_type == DW_UT_split_compile)
 	{
 	  cu = __libdw_find_split_unit (cu);
 	  if (cu != NULL)
-	    data = cu->dbg->sectiondata[secidx];
+	    data = __libdw_sectiondata (cu->dbg, secidx);
 	}
 
       if (data == NULL)
@@ -778,7 +778,7 @@ initial_offset (Dwarf_Attribute *attr, ptrdiff_t *offset)
       Dwarf_Off loc_base_off = __libdw_cu_locs_base (cu);
 
       /* The section should at least contain room for one offset.  */
-      size_t sec_size = cu->dbg->sectiondata[secidx]->d_size;
+      size_t sec_size = data->d_size;
       size_t offset_size = cu->offset_size;
       if (offset_size > sec_size)
 	{
@@ -795,8 +795,7 @@ initial_offset (Dwarf_Attribute *attr, ptrdiff_t *offset)
       if (idx > max_idx)
 	goto invalid_offset;
 
-      datap = (cu->dbg->sectiondata[secidx]->d_buf
-	       + loc_base_off + (idx * offset_size));
+      datap = data->d_buf + loc_base_off + (idx * offset_size);
       if (offset_size == 4)
 	start_offset = read_4ubyte_unaligned (cu->dbg, datap);
       else
@@ -947,7 +946,7 @@ dwarf_getlocation_addr (Dwarf_Attribute *attr, Dwarf_Addr address,
     return -1;
 
   size_t secidx = attr->cu->version < 5 ? IDX_debug_loc : IDX_debug_loclists;
-  const Elf_Data *d = attr->cu->dbg->sectiondata[secidx];
+  const Elf_Data *d = __libdw_sectiondata (attr->cu->dbg, secidx);
 
   while (got < maxlocs
          && (off = getlocations_addr (attr, off, &base, &start, &end,
@@ -1033,7 +1032,7 @@ dwarf_getlocations (Dwarf_Attribute *attr, ptrdiff_t offset, Dwarf_Addr *basep,
     }
 
   size_t secidx = attr->cu->version < 5 ? IDX_debug_loc : IDX_debug_loclists;
-  const Elf_Data *d = attr->cu->dbg->sectiondata[secidx];
+  const Elf_Data *d = __libdw_sectiondata (attr->cu->dbg, secidx);
 
   return getlocations_addr (attr, offset, basep, startp, endp,
 			    (Dwarf_Word) -1, d, expr, exprlen);
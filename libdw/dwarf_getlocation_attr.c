@@ -57,7 +57,7 @@ attr_form_cu (Dwarf_Attribute *attr)
 static unsigned char *
 addr_valp (Dwarf_CU *cu, Dwarf_Word index)
 {
-  Elf_Data *debug_addr = cu->dbg->sectiondata[IDX_debug_addr];
+  Elf_Data *debug_addr = __libdw_sectiondata (cu->dbg, IDX_debug_addr);
   if (debug_addr == NULL)
     {
       __libdw_seterrno (DWARF_E_NO_DEBUG_ADDR);
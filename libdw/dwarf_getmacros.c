@@ -137,7 +137,7 @@ get_macinfo_table (Dwarf *dbg, Dwarf_Word macoff, Dwarf_Die *cudie)
 	return NULL;
     }
   else if (cudie->cu->unit_type == DW_UT_split_compile
-	   && dbg->sectiondata[IDX_debug_line] != NULL)
+	   && __libdw_have_section (dbg, IDX_debug_line))
     line_offset = 0;
   if (line_offset != (Dwarf_Off) -1)
     {
@@ -346,7 +346,7 @@ read_macros (Dwarf *dbg, int sec_index,
 	     void *arg, ptrdiff_t offset, bool accept_0xff,
 	     Dwarf_Die *cudie)
 {
-  Elf_Data *d = dbg->sectiondata[sec_index];
+  Elf_Data *d = __libdw_sectiondata (dbg, sec_index);
   if (unlikely (d == NULL || d->d_buf == NULL))
     {
       __libdw_seterrno (DWARF_E_NO_ENTRY);
@@ -533,7 +533,8 @@ gnu_macros_getmacros_off (Dwarf *dbg, Dwarf_Off macoff,
 {
   assert (offset >= 0);
 
-  if (macoff >= dbg->sectiondata[IDX_debug_macro]->d_size)
+  Elf_Data *d = __libdw_sectiondata (dbg, IDX_debug_macro);
+  if (d == NULL || macoff >= d->d_size)
     {
       __libdw_seterrno (DWARF_E_INVALID_OFFSET);
       return -1;
@@ -41,15 +41,18 @@
 
 
 static int
-get_offsets (Dwarf *dbg)
+get_offsets (Dwarf *dbg, Elf_Data *data)
 {
   size_t allocated = 0;
   size_t cnt = 0;
   struct pubnames_s *mem = NULL;
   const size_t entsize = sizeof (struct pubnames_s);
-  unsigned char *const startp = dbg->sectiondata[IDX_debug_pubnames]->d_buf;
+  Elf_Data *info = __libdw_checked_get_data (dbg, IDX_debug_info);
+  if (info == NULL)
+    return -1;
+  unsigned char *const startp = data->d_buf;
   unsigned char *readp = startp;
-  unsigned char *endp = readp + dbg->sectiondata[IDX_debug_pubnames]->d_size;
+  unsigned char *endp = readp + data->d_size;
 
   while (readp + 14 < endp)
     {
@@ -87,7 +90,7 @@ get_offsets (Dwarf *dbg)
       /* Now we know the offset of the first offset/name pair.  */
       mem[cnt].set_start = readp + 2 + 2 * len_bytes - startp;
       mem[cnt].address_len = len_bytes;
-      size_t max_size = dbg->sectiondata[IDX_debug_pubnames]->d_size;
+      size_t max_size = data->d_size;
       if (mem[cnt].set_start >= max_size
 	  || len - (2 + 2 * len_bytes) > max_size - mem[cnt].set_start)
 	/* Something wrong, the first entry is beyond the end of
@@ -110,9 +113,10 @@ get_offsets (Dwarf *dbg)
 	goto err_return;
 
       /* Determine the size of the CU header.  */
-      unsigned char *infop
-	= ((unsigned char *) dbg->sectiondata[IDX_debug_info]->d_buf
-	   + mem[cnt].cu_offset);
+      if (__libdw_section_range (dbg, IDX_debug_info, mem[cnt].cu_offset, 4))
+	goto err_return;
+      unsigned char *infop = ((unsigned char *) info->d_buf
+			      + mem[cnt].cu_offset);
       if (read_4ubyte_unaligned_noncvt (infop) == DWARF3_LENGTH_64_BIT)
 	mem[cnt].cu_header_size = 23;
       else
@@ -153,14 +157,13 @@ dwarf_getpubnames (Dwarf *dbg,
     }
 
   /* Make sure it is a valid offset.  */
-  if (unlikely (dbg->sectiondata[IDX_debug_pubnames] == NULL
-		|| ((size_t) offset
-		    >= dbg->sectiondata[IDX_debug_pubnames]->d_size)))
+  Elf_Data *data = __libdw_sectiondata (dbg, IDX_debug_pubnames);
+  if (unlikely (data == NULL || (size_t) offset >= data->d_size))
     /* No (more) entry.  */
     return 0;
 
   /* If necessary read the set information.  */
-  if (dbg->pubnames_nsets == 0 && unlikely (get_offsets (dbg) != 0))
+  if (dbg->pubnames_nsets == 0 && unlikely (get_offsets (dbg, data) != 0))
     return -1l;
 
   /* Find the place where to start.  */
@@ -182,10 +185,8 @@ dwarf_getpubnames (Dwarf *dbg,
       assert (cnt + 1 < dbg->pubnames_nsets);
     }
 
-  unsigned char *startp
-    = (unsigned char *) dbg->sectiondata[IDX_debug_pubnames]->d_buf;
-  unsigned char *endp
-    = startp + dbg->sectiondata[IDX_debug_pubnames]->d_size;
+  unsigned char *startp = (unsigned char *) data->d_buf;
+  unsigned char *endp = startp + data->d_size;
   unsigned char *readp = startp + offset;
   while (1)
     {
@@ -234,7 +235,7 @@ dwarf_getpubnames (Dwarf *dbg,
 	/* This was the last set.  */
 	break;
 
-      startp = (unsigned char *) dbg->sectiondata[IDX_debug_pubnames]->d_buf;
+      startp = (unsigned char *) data->d_buf;
       readp = startp + dbg->pubnames_sets[cnt].set_start;
     }
 
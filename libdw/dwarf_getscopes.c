@@ -179,6 +179,114 @@ pc_record (unsigned int depth, struct Dwarf_Die_Chain *die, void *arg)
 }
 
 
+static bool
+tree_haspc (struct Dwarf_Scope_Tree *tree, unsigned int idx, Dwarf_Addr pc)
+{
+  Dwarf_Addr (*r)[2] = &tree->ranges[tree->nodes[idx].range];
+  for (unsigned int i = 0; i < tree->nodes[idx].nranges; ++i)
+    if (pc >= r[i][0] && pc < r[i][1])
+      return true;
+  return false;
+}
+
+/* Like pc_match and pc_record, but using the scope tree of the CU.  */
+static int
+tree_pc_record (struct Dwarf_Scope_Tree *tree, Dwarf_Die *cudie,
+		struct args *a)
+{
+  /* Descend into the first DIE containing PC on each level.  */
+  unsigned int inner = SCOPE_NO_PARENT;
+  unsigned int i = 0;
+  unsigned int end = tree->nnodes;
+  while (i < end)
+    if (tree_haspc (tree, i, a->pc))
+      {
+	inner = i;
+	end = tree->nodes[i].next;
+	++i;
+      }
+    else
+      i = tree->nodes[i].next;
+
+  if (inner == SCOPE_NO_PARENT)
+    return 0;
+
+  /* The scopes stop at the innermost inlined instance, or else
+     include the CU DIE.  */
+  a->nscopes = 1;
+  for (i = inner; i != SCOPE_NO_PARENT; i = tree->nodes[i].parent)
+    if (tree->nodes[i].inlined)
+      {
+	a->inlined = 1;
+	break;
+      }
+    else
+      ++a->nscopes;
+
+  a->scopes = malloc (a->nscopes * sizeof a->scopes[0]);
+  if (a->scopes == NULL)
+    {
+      __libdw_seterrno (DWARF_E_NOMEM);
+      return -1;
+    }
+
+  i = inner;
+  for (unsigned int n = 0; n < a->nscopes; ++n)
+    if (i == SCOPE_NO_PARENT)
+      a->scopes[n] = *cudie;
+    else
+      {
+	a->scopes[n] = __libdw_scope_die (tree, i);
+	i = tree->nodes[i].parent;
+      }
+
+  if (a->inlined == 0)
+    return a->nscopes;
+
+  Dwarf_Die *const inlinedie = &a->scopes[a->nscopes - 1];
+  Dwarf_Attribute attr_mem;
+  Dwarf_Attribute *attr = INTUSE (dwarf_attr) (inlinedie,
+					       DW_AT_abstract_origin,
+					       &attr_mem);
+  if (INTUSE (dwarf_formref_die) (attr, &a->inlined_origin) == NULL)
+    return -1;
+  return 0;
+}
+
+/* Like origin_match, but using the scope tree of the origin's CU.
+   Returns -2 if the origin isn't in there.  */
+static int
+tree_origin_match (struct args *a)
+{
+  Dwarf_CU *cu = a->inlined_origin.cu;
+  struct Dwarf_Scope_Tree *tree = __libdw_scope_tree (cu);
+  if (tree == NULL)
+    return -2;
+  unsigned int origin = __libdw_scope_find (tree, a->inlined_origin.addr);
+  if (origin == SCOPE_NO_PARENT)
+    return -2;
+
+  unsigned int nscopes = a->nscopes + 1;
+  for (unsigned int i = tree->nodes[origin].parent; i != SCOPE_NO_PARENT;
+       i = tree->nodes[i].parent)
+    ++nscopes;
+
+  Dwarf_Die *scopes = realloc (a->scopes, nscopes * sizeof scopes[0]);
+  if (scopes == NULL)
+    {
+      __libdw_seterrno (DWARF_E_NOMEM);
+      return -1;
+    }
+
+  a->scopes = scopes;
+  for (unsigned int i = tree->nodes[origin].parent; i != SCOPE_NO_PARENT;
+       i = tree->nodes[i].parent)
+    scopes[a->nscopes++] = __libdw_scope_die (tree, i);
+  scopes[a->nscopes++] = CUDIE (cu);
+  return a->nscopes;
+}
+
+
 int
 dwarf_getscopes (Dwarf_Die *cudie, Dwarf_Addr pc, Dwarf_Die **scopes)
 {
@@ -188,14 +296,28 @@ dwarf_getscopes (Dwarf_Die *cudie, Dwarf_Addr pc, Dwarf_Die **scopes)
   struct Dwarf_Die_Chain cu = { .parent = NULL, .die = *cudie };
   struct args a = { .pc = pc };
 
-  int result = __libdw_visit_scopes (0, &cu, NULL, &pc_match, &pc_record, &a);
+  /* The scope tree only covers whole CUs.  */
+  struct Dwarf_Scope_Tree *tree = NULL;
+  if (cudie->cu != NULL && cudie->addr == CUDIE (cudie->cu).addr)
+    tree = __libdw_scope_tree (cudie->cu);
+
+  int result;
+  if (tree != NULL)
+    result = tree_pc_record (tree, cudie, &a);
+  else
+    result = __libdw_visit_scopes (0, &cu, NULL, &pc_match, &pc_record, &a);
 
   if (result >= 0 && a.scopes != NULL && a.inlined > 0)
     {
       /* We like the find the inline function's abstract definition
          scope, but that might be in a different CU.  */
-      cu.die = CUDIE (a.inlined_origin.cu);
-      result = __libdw_visit_scopes (0, &cu, NULL, &origin_match, NULL, &a);
+      result = tree_origin_match (&a);
+      if (result == -2)
+	{
+	  cu.die = CUDIE (a.inlined_origin.cu);
+	  result = __libdw_visit_scopes (0, &cu, NULL, &origin_match, NULL,
+					 &a);
+	}
     }
 
   if (result > 0)
@@ -205,3 +327,4 @@ dwarf_getscopes (Dwarf_Die *cudie, Dwarf_Addr pc, Dwarf_Die **scopes)
 
   return result;
 }
+INTDEF (dwarf_getscopes)
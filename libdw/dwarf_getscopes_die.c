@@ -65,6 +65,32 @@ dwarf_getscopes_die (Dwarf_Die *die, Dwarf_Die **scopes)
   if (die == NULL)
     return -1;
 
+  struct Dwarf_Scope_Tree *tree = __libdw_scope_tree (die->cu);
+  unsigned int idx = (tree != NULL
+		      ? __libdw_scope_find (tree, die->addr) : SCOPE_NO_PARENT);
+  if (idx != SCOPE_NO_PARENT)
+    {
+      int depth = 1;
+      for (unsigned int i = idx; i != SCOPE_NO_PARENT;
+	   i = tree->nodes[i].parent)
+	++depth;
+
+      Dwarf_Die *result = malloc (depth * sizeof result[0]);
+      if (result == NULL)
+	{
+	  __libdw_seterrno (DWARF_E_NOMEM);
+	  return -1;
+	}
+
+      int n = 0;
+      for (unsigned int i = idx; i != SCOPE_NO_PARENT;
+	   i = tree->nodes[i].parent)
+	result[n++] = __libdw_scope_die (tree, i);
+      result[n] = CUDIE (die->cu);
+      *scopes = result;
+      return depth;
+    }
+
   struct Dwarf_Die_Chain cu = { .die = CUDIE (die->cu), .parent = NULL };
   void *info = die->addr;
   int result = __libdw_visit_scopes (1, &cu, NULL, &scope_visitor, NULL, &info);
@@ -72,3 +98,4 @@ dwarf_getscopes_die (Dwarf_Die *die, Dwarf_Die **scopes)
     *scopes = info;
   return result;
 }
+INTDEF (dwarf_getscopes_die)
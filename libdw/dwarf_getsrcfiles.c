@@ -62,7 +62,7 @@ dwarf_getsrcfiles (Dwarf_Die *cudie, Dwarf_Files **files, size_t *nfiles)
 
 	  /* See if there is a .debug_line section, for split CUs
 	     the table is at offset zero.  */
-	  if (cu->dbg->sectiondata[IDX_debug_line] != NULL)
+	  if (__libdw_have_section (cu->dbg, IDX_debug_line))
 	    {
 	      Dwarf_Off dwp_off;
 	      if (INTUSE(dwarf_cu_dwp_section_info) (cu, DW_SECT_LINE,
@@ -1227,9 +1227,16 @@ read_srclines (Dwarf *dbg,
       *filesp = newfiles;
     }
 
+  /* Not from libdw_alloc, so dwarf_trim_memory can free it.  */
   size_t buf_size = (sizeof (Dwarf_Lines)
 		     + (sizeof (Dwarf_Line) * state.nlinelist));
-  void *buf = libdw_alloc (dbg, Dwarf_Lines, buf_size, 1);
+  void *buf = malloc (buf_size);
+  if (unlikely (buf == NULL))
+    {
+      __libdw_seterrno (DWARF_E_NOMEM);
+      goto out;
+    }
+  __libdw_account_memory (dbg, buf_size);
 
   /* First use the buffer for the pointers, and sort the entries.
      We'll write the pointers in the end of the buffer, and then
@@ -1340,6 +1347,7 @@ get_lines_or_files (Dwarf *dbg, Dwarf_Off debug_line_offset,
       /* Srcfiles will be read but srclines might not.  Set lines here
 	 to avoid possible uninitialized value errors.  */
       node->lines = NULL;
+      __libdw_touch_lines (dbg, node);
 
       /* If linesp is NULL then read srcfiles without reading srclines.  */
       if (linesp == NULL)
@@ -1357,9 +1365,18 @@ get_lines_or_files (Dwarf *dbg, Dwarf_Off debug_line_offset,
       found = tsearch (node, &dbg->files_lines, files_lines_compare);
       if (found == NULL)
 	{
+	  if (node->lines != NULL)
+	    {
+	      __libdw_account_memory (dbg, -(ptrdiff_t) (sizeof (Dwarf_Lines)
+							 + (node->lines->nlines
+							    * sizeof (Dwarf_Line))));
+	      free (node->lines);
+	    }
 	  __libdw_seterrno (DWARF_E_NOMEM);
 	  return -1;
 	}
+      node->next = dbg->files_lines_list;
+      dbg->files_lines_list = node;
     }
   else if (*found != NULL
 	   && (*found)->files != NULL
@@ -1377,6 +1394,7 @@ get_lines_or_files (Dwarf *dbg, Dwarf_Off debug_line_offset,
       const unsigned char *lineendp = data->d_buf + data->d_size;
 
       struct files_lines_s *node = *found;
+      __libdw_touch_lines (dbg, node);
 
       if (read_srclines (dbg, linep, lineendp, comp_dir, address_size,
 			 &node->lines, &node->files, true) != 0)
@@ -1390,6 +1408,8 @@ get_lines_or_files (Dwarf *dbg, Dwarf_Off debug_line_offset,
       __libdw_seterrno (DWARF_E_INVALID_DEBUG_LINE);
       return -1;
     }
+  else if (linesp != NULL)
+    __libdw_touch_lines (dbg, *found);
 
   if (linesp != NULL)
     *linesp = (*found)->lines;
@@ -1420,6 +1440,20 @@ __libdw_getsrcfiles (Dwarf *dbg, Dwarf_Off debug_line_offset,
 			     address_size, NULL, filesp);
 }
 
+/* The Dwarf whose line tables the lines of CU are from.  */
+static Dwarf *
+lines_dbg (Dwarf_CU *cu)
+{
+  if (cu->unit_type == DW_UT_split_compile
+      || cu->unit_type == DW_UT_split_type)
+    {
+      Dwarf_CU *skel = __libdw_find_split_unit (cu);
+      if (skel != NULL)
+	return skel->dbg;
+    }
+  return cu->dbg;
+}
+
 /* Get the compilation directory, if any is set.  */
 const char *
 __libdw_getcompdir (Dwarf_Die *cudie)
@@ -1442,8 +1476,12 @@ dwarf_getsrclines (Dwarf_Die *cudie, Dwarf_Lines **lines, size_t *nlines)
       return -1;
     }
 
-  /* Get the information if it is not already known.  */
+  /* Get the information if it is not already known, or was evicted
+     by dwarf_trim_memory.  */
   struct Dwarf_CU *const cu = cudie->cu;
+  if (cu->lines != NULL && cu->lines != (void *) -1l
+      && cu->lines_epoch != lines_dbg (cu)->lines_epoch)
+    cu->lines = NULL;
   if (cu->lines == NULL)
     {
       /* For split units always pick the lines from the skeleton.  */
@@ -1461,6 +1499,7 @@ dwarf_getsrclines (Dwarf_Die *cudie, Dwarf_Lines **lines, size_t *nlines)
 	      if (res == 0)
 		{
 		  cu->lines = skel->lines;
+		  cu->lines_epoch = skel->dbg->lines_epoch;
 		  *lines = cu->lines;
 		  *nlines = cu->lines->nlines;
 		}
@@ -1491,6 +1530,7 @@ dwarf_getsrclines (Dwarf_Die *cudie, Dwarf_Lines **lines, size_t *nlines)
 			       __libdw_getcompdir (cudie),
 			       cu->address_size, &cu->lines, &cu->files) < 0)
 	return -1;
+      cu->lines_epoch = cu->dbg->lines_epoch;
     }
   else if (cu->lines == (void *) -1l)
     return -1;
@@ -41,18 +41,16 @@ dwarf_getstring (Dwarf *dbg, Dwarf_Off offset, size_t *lenp)
   if (dbg == NULL)
     return NULL;
 
-  if (dbg->sectiondata[IDX_debug_str] == NULL
-      || offset >= dbg->sectiondata[IDX_debug_str]->d_size)
+  Elf_Data *data = __libdw_sectiondata (dbg, IDX_debug_str);
+  if (data == NULL || offset >= data->d_size)
     {
     no_string:
       __libdw_seterrno (DWARF_E_NO_STRING);
       return NULL;
     }
 
-  const char *result = ((const char *) dbg->sectiondata[IDX_debug_str]->d_buf
-			+ offset);
-  const char *endp = memchr (result, '\0',
-			     dbg->sectiondata[IDX_debug_str]->d_size - offset);
+  const char *result = (const char *) data->d_buf + offset;
+  const char *endp = memchr (result, '\0', data->d_size - offset);
   if (endp == NULL)
     goto no_string;
 
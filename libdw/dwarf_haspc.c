@@ -43,6 +43,34 @@ dwarf_haspc (Dwarf_Die *die, Dwarf_Addr pc)
   Dwarf_Addr base;
   Dwarf_Addr begin;
   Dwarf_Addr end;
+  if (INTUSE(dwarf_highpc) (die, &end) == 0
+      && INTUSE(dwarf_lowpc) (die, &begin) == 0)
+    return pc >= begin && pc < end;
+
+  /* Binary search the decoded range list.  */
+  const struct Dwarf_Range_List *list;
+  if (__libdw_range_list (die, &list) == 0)
+    {
+      if (list == NULL)
+	return 0;
+
+      size_t lo = 0;
+      size_t hi = list->nmerged;
+      while (lo < hi)
+	{
+	  size_t mid = (lo + hi) / 2;
+	  if (pc < list->merged[mid][0])
+	    hi = mid;
+	  else if (pc >= list->merged[mid][1])
+	    lo = mid + 1;
+	  else
+	    return 1;
+	}
+      return 0;
+    }
+
+  /* The list is broken, but PC might be in a range before the
+     error.  */
   ptrdiff_t offset = 0;
   while ((offset = INTUSE(dwarf_ranges) (die, offset, &base,
 					 &begin, &end)) > 0)
@@ -42,7 +42,7 @@ dwarf_linefunctionname (Dwarf *dbg, Dwarf_Line *line)
   if (line->context == 0)
     return NULL;
 
-  Elf_Data *str_data = dbg->sectiondata[IDX_debug_str];
+  Elf_Data *str_data = __libdw_sectiondata (dbg, IDX_debug_str);
   if (str_data == NULL || line->function_name >= str_data->d_size
       || memchr (str_data->d_buf + line->function_name, '\0',
 		 str_data->d_size - line->function_name) == NULL)
@@ -54,3 +54,4 @@ dwarf_linesrc (Dwarf_Line *line, Dwarf_Word *mtime, Dwarf_Word *length)
 
   return line->files->info[line->file].name;
 }
+INTDEF (dwarf_linesrc)
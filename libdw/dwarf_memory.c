@@ -0,0 +1,148 @@
+/* Account for and limit the memory used for derived DWARF data.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of either
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at
+       your option) any later version
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at
+       your option) any later version
+
+   or both in parallel, as here.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <stdlib.h>
+#include "libdwP.h"
+#include "system.h"
+
+
+/* The total over all Dwarf handles and its budget.  */
+static size_t global_usage;
+static size_t global_budget;
+
+
+void
+internal_function
+__libdw_account_memory (Dwarf *dbg, ptrdiff_t delta)
+{
+  __atomic_fetch_add (&dbg->mem_usage, (size_t) delta, __ATOMIC_RELAXED);
+  __atomic_fetch_add (&global_usage, (size_t) delta, __ATOMIC_RELAXED);
+}
+
+
+static size_t
+lines_size (Dwarf_Lines *lines)
+{
+  return sizeof (Dwarf_Lines) + lines->nlines * sizeof (Dwarf_Line);
+}
+
+
+static int
+compare_last_use (const void *a, const void *b)
+{
+  const struct files_lines_s *n1 = *(const struct files_lines_s **) a;
+  const struct files_lines_s *n2 = *(const struct files_lines_s **) b;
+  return n1->last_use < n2->last_use ? -1 : n1->last_use > n2->last_use;
+}
+
+
+/* Evict line tables of DBG, the least recently used first, until its
+   memory usage is at most TARGET.  */
+static size_t
+trim_lines (Dwarf *dbg, size_t target)
+{
+  size_t usage = __atomic_load_n (&dbg->mem_usage, __ATOMIC_RELAXED);
+  if (usage <= target)
+    return 0;
+
+  size_t n = 0;
+  for (struct files_lines_s *node = dbg->files_lines_list; node != NULL;
+       node = node->next)
+    n += node->lines != NULL;
+  if (n == 0)
+    return 0;
+
+  struct files_lines_s **nodes = malloc (n * sizeof nodes[0]);
+  if (nodes == NULL)
+    return 0;
+  n = 0;
+  for (struct files_lines_s *node = dbg->files_lines_list; node != NULL;
+       node = node->next)
+    if (node->lines != NULL)
+      nodes[n++] = node;
+  qsort (nodes, n, sizeof nodes[0], compare_last_use);
+
+  size_t freed = 0;
+  for (size_t i = 0; i < n && usage - freed > target; ++i)
+    {
+      size_t size = lines_size (nodes[i]->lines);
+      free (nodes[i]->lines);
+      nodes[i]->lines = NULL;
+      freed += size;
+    }
+  free (nodes);
+
+  if (freed > 0)
+    {
+      __libdw_account_memory (dbg, -(ptrdiff_t) freed);
+      /* The CUs notice the lines are gone when asked for them again.  */
+      dbg->lines_epoch++;
+    }
+  return freed;
+}
+
+
+size_t
+dwarf_memory_usage (Dwarf *dbg)
+{
+  return __atomic_load_n (dbg == NULL ? &global_usage : &dbg->mem_usage,
+			  __ATOMIC_RELAXED);
+}
+
+
+size_t
+dwarf_set_memory_budget (Dwarf *dbg, size_t budget)
+{
+  return __atomic_exchange_n (dbg == NULL ? &global_budget : &dbg->mem_budget,
+			      budget, __ATOMIC_RELAXED);
+}
+
+
+size_t
+dwarf_trim_memory (Dwarf *dbg, size_t target)
+{
+  if (dbg == NULL)
+    return 0;
+
+  size_t usage = __atomic_load_n (&dbg->mem_usage, __ATOMIC_RELAXED);
+  size_t budget = __atomic_load_n (&dbg->mem_budget, __ATOMIC_RELAXED);
+  if (budget != 0)
+    target = MIN (target, budget);
+
+  /* Over the global budget DBG gives up what the others use too
+     much, as far as it can.  */
+  budget = __atomic_load_n (&global_budget, __ATOMIC_RELAXED);
+  size_t total = __atomic_load_n (&global_usage, __ATOMIC_RELAXED);
+  if (budget != 0 && total > budget)
+    target = MIN (target, usage - MIN (usage, total - budget));
+
+  return trim_lines (dbg, target);
+}
@@ -43,7 +43,7 @@ dwarf_next_lines (Dwarf *dbg, Dwarf_Off off,
   if (dbg == NULL)
     return -1;
 
-  Elf_Data *lines = dbg->sectiondata[IDX_debug_line];
+  Elf_Data *lines = __libdw_sectiondata (dbg, IDX_debug_line);
   if (lines == NULL)
     {
       __libdw_seterrno (DWARF_E_NO_DEBUG_LINE);
@@ -70,22 +70,28 @@ __libdw_next_unit (Dwarf *dwarf, bool v4_debug_types, Dwarf_Off off,
     return -1;
 
   /* If we reached the end before don't do anything.  */
+  Elf_Data *secdata;
   if (off == (Dwarf_Off) -1l
-      || unlikely (dwarf->sectiondata[sec_idx] == NULL)
+      || unlikely ((secdata = __libdw_sectiondata (dwarf, sec_idx)) == NULL)
       /* Make sure there is enough space in the .debug_info section
 	 for at least the initial word.  We cannot test the rest since
 	 we don't know yet whether this is a 64-bit object or not.  */
-      || unlikely (off + 4 >= dwarf->sectiondata[sec_idx]->d_size))
+      || unlikely (off + 4 >= secdata->d_size))
     {
       *next_off = (Dwarf_Off) -1l;
       return 1;
     }
 
+  /* Only the unit header is read here, which is at most 40 bytes
+     (see below).  */
+  if (__libdw_section_range (dwarf, sec_idx, off, 40) != 0)
+    return -1;
+
   /* This points into the .debug_info or .debug_types section to the
      beginning of the CU entry.  */
-  const unsigned char *data = dwarf->sectiondata[sec_idx]->d_buf;
+  const unsigned char *data = secdata->d_buf;
   const unsigned char *bytes = data + off;
-  const unsigned char *bytes_end = data + dwarf->sectiondata[sec_idx]->d_size;
+  const unsigned char *bytes_end = data + secdata->d_size;
 
   /* The format of the CU header is described in dwarf2p1 7.5.1 and
      changed in DWARFv5 (to include unit type, switch location of some
@@ -213,7 +219,7 @@ __libdw_next_unit (Dwarf *dwarf, bool v4_debug_types, Dwarf_Off off,
   /* Now we know how large the header is (should be).  */
   if (unlikely (__libdw_first_die_from_cu_start (off, offset_size, version,
 						 unit_type)
-		>= dwarf->sectiondata[sec_idx]->d_size))
+		>= secdata->d_size))
     {
       *next_off = -1;
       return 1;
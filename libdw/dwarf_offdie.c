@@ -43,8 +43,9 @@ __libdw_offdie (Dwarf *dbg, Dwarf_Off offset, Dwarf_Die *result,
   if (dbg == NULL)
     return NULL;
 
-  Elf_Data *const data = dbg->sectiondata[debug_types ? IDX_debug_types
-					  : IDX_debug_info];
+  Elf_Data *const data = __libdw_sectiondata (dbg, (debug_types
+						    ? IDX_debug_types
+						    : IDX_debug_info));
   if (data == NULL || offset >= data->d_size)
     {
       __libdw_seterrno (DWARF_E_INVALID_DWARF);
@@ -33,6 +33,9 @@
 #include "libdwP.h"
 #include <dwarf.h>
 #include <assert.h>
+#include <search.h>
+#include <stdlib.h>
+#include <string.h>
 
 /* Read up begin/end pair and increment read pointer.
     - If it's normal range record, set up `*beginp' and `*endp' and return 0.
@@ -401,12 +404,12 @@ initial_offset (Dwarf_Attribute *attr, ptrdiff_t *offset)
 	}
       get_uleb128 (idx, datap, endp);
 
-      Elf_Data *data = cu->dbg->sectiondata[secidx];
+      Elf_Data *data = __libdw_sectiondata (cu->dbg, secidx);
       if (data == NULL && cu->unit_type == DW_UT_split_compile)
 	{
 	  cu = __libdw_find_split_unit (cu);
 	  if (cu != NULL)
-	    data = cu->dbg->sectiondata[secidx];
+	    data = __libdw_sectiondata (cu->dbg, secidx);
 	}
 
       if (data == NULL)
@@ -420,7 +423,7 @@ initial_offset (Dwarf_Attribute *attr, ptrdiff_t *offset)
       Dwarf_Off range_base_off = __libdw_cu_ranges_base (cu);
 
       /* The section should at least contain room for one offset.  */
-      size_t sec_size = cu->dbg->sectiondata[secidx]->d_size;
+      size_t sec_size = data->d_size;
       size_t offset_size = cu->offset_size;
       if (offset_size > sec_size)
 	{
@@ -437,8 +440,7 @@ initial_offset (Dwarf_Attribute *attr, ptrdiff_t *offset)
       if (idx > max_idx)
 	goto invalid_offset;
 
-      datap = (cu->dbg->sectiondata[secidx]->d_buf
-	       + range_base_off + (idx * offset_size));
+      datap = data->d_buf + range_base_off + (idx * offset_size);
       if (offset_size == 4)
 	start_offset = read_4ubyte_unaligned (cu->dbg, datap);
       else
@@ -460,6 +462,260 @@ initial_offset (Dwarf_Attribute *attr, ptrdiff_t *offset)
   return 0;
 }
 
+/* Find the CU and section the range lists of DIE are read from.  */
+static int
+range_section (Dwarf_Die *die, Dwarf_CU **cup, size_t *secidxp,
+	       const Elf_Data **dp)
+{
+  Dwarf_CU *cu = die->cu;
+  if (cu == NULL)
+    {
+      __libdw_seterrno (DWARF_E_INVALID_DWARF);
+      return -1;
+    }
+
+  size_t secidx = (cu->version < 5 ? IDX_debug_ranges : IDX_debug_rnglists);
+  const Elf_Data *d = __libdw_sectiondata (cu->dbg, secidx);
+  if (cu->unit_type == DW_UT_split_compile && (d == NULL || is_cudie (die)))
+    {
+      Dwarf_CU *skel = __libdw_find_split_unit (cu);
+      const Elf_Data *skel_d;
+      if (skel != NULL
+	  && (skel_d = __libdw_sectiondata (skel->dbg, secidx)) != NULL)
+	{
+	  cu = skel;
+	  d = skel_d;
+	}
+    }
+
+  *cup = cu;
+  *secidxp = secidx;
+  *dp = d;
+  return 0;
+}
+
+/* Find the start of the DW_AT_ranges list of DIE and its base address.
+   Returns 1 if DIE has no DW_AT_ranges.  */
+static int
+range_list_start (Dwarf_Die *die, ptrdiff_t *offsetp, Dwarf_Addr *basep)
+{
+  Dwarf_Attribute attr_mem;
+  Dwarf_Attribute *attr = INTUSE(dwarf_attr) (die, DW_AT_ranges, &attr_mem);
+  /* Note that above we use dwarf_attr, not dwarf_attr_integrate.
+     The only case where the ranges can come from another DIE
+     attribute are the split CU case. In that case we also have a
+     different CU to check against. But that is already set up
+     in range_section using __libdw_find_split_unit.  */
+  if (attr == NULL
+      && is_cudie (die)
+      && die->cu->unit_type == DW_UT_split_compile)
+    attr = INTUSE(dwarf_attr_integrate) (die, DW_AT_ranges, &attr_mem);
+  if (attr == NULL)
+    return 1;
+
+  *basep = __libdw_cu_base_address (attr->cu);
+  if (*basep == (Dwarf_Addr) -1)
+    return -1;
+
+  return initial_offset (attr, offsetp);
+}
+
+static int
+range_list_compare (const void *p1, const void *p2)
+{
+  const struct Dwarf_Range_List *l1 = p1;
+  const struct Dwarf_Range_List *l2 = p2;
+
+  if (l1->offset != l2->offset)
+    return l1->offset < l2->offset ? -1 : 1;
+  if (l1->base != l2->base)
+    return l1->base < l2->base ? -1 : 1;
+  return 0;
+}
+
+static int
+range_compare (const void *p1, const void *p2)
+{
+  const Dwarf_Addr *r1 = p1;
+  const Dwarf_Addr *r2 = p2;
+
+  if (r1[0] != r2[0])
+    return r1[0] < r2[0] ? -1 : 1;
+  return 0;
+}
+
+static size_t
+range_list_size (size_t nranges)
+{
+  return (sizeof (struct Dwarf_Range_List)
+	  + nranges * (sizeof (struct Dwarf_Range_Entry)
+		       + 2 * sizeof (Dwarf_Addr)));
+}
+
+/* Decode the whole list at OFFSET.  */
+static struct Dwarf_Range_List *
+read_range_list (Dwarf_CU *cu, size_t secidx, const Elf_Data *d,
+		 ptrdiff_t offset, Dwarf_Addr base)
+{
+  const unsigned char *readp = d->d_buf + offset;
+  const unsigned char *readendp = d->d_buf + d->d_size;
+
+  size_t nranges = 0;
+  size_t nalloc = 0;
+  struct Dwarf_Range_Entry *entries = NULL;
+  Dwarf_Addr curbase = base;
+  while (true)
+    {
+      Dwarf_Addr begin;
+      Dwarf_Addr end;
+      int res = __libdw_read_begin_end_pair_inc (cu, secidx,
+						 &readp, readendp,
+						 cu->address_size,
+						 &begin, &end, &curbase);
+      if (res == 1)
+	continue;
+      if (res == 2)
+	break;
+      if (res != 0)
+	{
+	  free (entries);
+	  return NULL;
+	}
+
+      if (nranges == nalloc)
+	{
+	  nalloc = nalloc == 0 ? 4 : 2 * nalloc;
+	  struct Dwarf_Range_Entry *newp;
+	  newp = realloc (entries, nalloc * sizeof entries[0]);
+	  if (newp == NULL)
+	    {
+	      free (entries);
+	      __libdw_seterrno (DWARF_E_NOMEM);
+	      return NULL;
+	    }
+	  entries = newp;
+	}
+      entries[nranges].begin = begin;
+      entries[nranges].end = end;
+      entries[nranges].base = curbase;
+      entries[nranges].next = readp - (unsigned char *) d->d_buf;
+      ++nranges;
+    }
+
+  struct Dwarf_Range_List *list = malloc (range_list_size (nranges));
+  if (list == NULL)
+    {
+      free (entries);
+      __libdw_seterrno (DWARF_E_NOMEM);
+      return NULL;
+    }
+
+  list->offset = offset;
+  list->base = base;
+  list->nranges = nranges;
+  list->entries = (struct Dwarf_Range_Entry *) (list + 1);
+  list->merged = (Dwarf_Addr (*)[2]) (list->entries + nranges);
+  if (nranges > 0)
+    memcpy (list->entries, entries, nranges * sizeof entries[0]);
+  free (entries);
+
+  /* Empty ranges never contain anything.  */
+  size_t n = 0;
+  for (size_t i = 0; i < nranges; ++i)
+    if (list->entries[i].begin < list->entries[i].end)
+      {
+	list->merged[n][0] = list->entries[i].begin;
+	list->merged[n][1] = list->entries[i].end;
+	++n;
+      }
+  qsort (list->merged, n, sizeof list->merged[0], range_compare);
+  list->nmerged = 0;
+  for (size_t i = 0; i < n; ++i)
+    if (list->nmerged > 0
+	&& list->merged[i][0] <= list->merged[list->nmerged - 1][1])
+      {
+	if (list->merged[i][1] > list->merged[list->nmerged - 1][1])
+	  list->merged[list->nmerged - 1][1] = list->merged[i][1];
+      }
+    else
+      {
+	list->merged[list->nmerged][0] = list->merged[i][0];
+	list->merged[list->nmerged][1] = list->merged[i][1];
+	++list->nmerged;
+      }
+
+  return list;
+}
+
+/* Look up the list at OFFSET in the ranges tree of CU, decoding it if
+   it isn't there yet.  */
+static const struct Dwarf_Range_List *
+find_range_list (Dwarf_CU *cu, size_t secidx, const Elf_Data *d,
+		 ptrdiff_t offset, Dwarf_Addr base)
+{
+  if (d == NULL)
+    {
+      __libdw_seterrno (secidx == IDX_debug_ranges
+			? DWARF_E_NO_DEBUG_RANGES
+			: DWARF_E_NO_DEBUG_RNGLISTS);
+      return NULL;
+    }
+
+  Dwarf *dbg = cu->dbg;
+  struct Dwarf_Range_List key = { .offset = offset, .base = base };
+  pthread_mutex_lock (&dbg->ranges_lock);
+  struct Dwarf_Range_List **found = tfind (&key, &cu->ranges,
+					   range_list_compare);
+  pthread_mutex_unlock (&dbg->ranges_lock);
+  if (found != NULL)
+    return *found;
+
+  /* Decoding might need other sections, so don't hold the lock.  */
+  struct Dwarf_Range_List *list = read_range_list (cu, secidx, d,
+						   offset, base);
+  if (list == NULL)
+    return NULL;
+
+  pthread_mutex_lock (&dbg->ranges_lock);
+  found = tsearch (list, &cu->ranges, range_list_compare);
+  pthread_mutex_unlock (&dbg->ranges_lock);
+  if (found == NULL)
+    {
+      free (list);
+      __libdw_seterrno (DWARF_E_NOMEM);
+      return NULL;
+    }
+  if (*found != list)
+    /* Another thread was faster.  */
+    free (list);
+  else
+    __libdw_account_memory (dbg, range_list_size (list->nranges));
+  return *found;
+}
+
+int
+internal_function
+__libdw_range_list (Dwarf_Die *die, const struct Dwarf_Range_List **listp)
+{
+  Dwarf_CU *cu;
+  size_t secidx;
+  const Elf_Data *d;
+  if (range_section (die, &cu, &secidx, &d) != 0)
+    return -1;
+
+  ptrdiff_t offset;
+  Dwarf_Addr base;
+  int res = range_list_start (die, &offset, &base);
+  if (res != 0)
+    {
+      *listp = NULL;
+      return res < 0 ? -1 : 0;
+    }
+
+  *listp = find_range_list (cu, secidx, d, offset, base);
+  return *listp == NULL ? -1 : 0;
+}
+
 ptrdiff_t
 dwarf_ranges (Dwarf_Die *die, ptrdiff_t offset, Dwarf_Addr *basep,
 	      Dwarf_Addr *startp, Dwarf_Addr *endp)
@@ -480,50 +736,35 @@ dwarf_ranges (Dwarf_Die *die, ptrdiff_t offset, Dwarf_Addr *basep,
     return 0;
 
   /* We have to look for a noncontiguous range.  */
-  Dwarf_CU *cu = die->cu;
-  if (cu == NULL)
-    {
-      __libdw_seterrno (DWARF_E_INVALID_DWARF);
-      return -1;
-    }
-
-  size_t secidx = (cu->version < 5 ? IDX_debug_ranges : IDX_debug_rnglists);
-  const Elf_Data *d = cu->dbg->sectiondata[secidx];
-  if (cu->unit_type == DW_UT_split_compile && (d == NULL || is_cudie (die)))
-    {
-      Dwarf_CU *skel = __libdw_find_split_unit (cu);
-      if (skel != NULL && skel->dbg->sectiondata[secidx] != NULL)
-	{
-	  cu = skel;
-	  d = cu->dbg->sectiondata[secidx];
-	}
-    }
+  Dwarf_CU *cu;
+  size_t secidx;
+  const Elf_Data *d;
+  if (range_section (die, &cu, &secidx, &d) != 0)
+    return -1;
 
-  const unsigned char *readp;
-  const unsigned char *readendp;
   if (offset == 0)
     {
-      Dwarf_Attribute attr_mem;
-      Dwarf_Attribute *attr = INTUSE(dwarf_attr) (die, DW_AT_ranges,
-						  &attr_mem);
-      /* Note that above we use dwarf_attr, not dwarf_attr_integrate.
-	 The only case where the ranges can come from another DIE
-	 attribute are the split CU case. In that case we also have a
-	 different CU to check against. But that is already set up
-	 above using __libdw_find_split_unit.  */
-      if (attr == NULL
-	  && is_cudie (die)
-	  && die->cu->unit_type == DW_UT_split_compile)
-	attr = INTUSE(dwarf_attr_integrate) (die, DW_AT_ranges, &attr_mem);
-      if (attr == NULL)
+      int res = range_list_start (die, &offset, basep);
+      if (res != 0)
 	/* No PC attributes in this DIE at all, so an empty range list.  */
-	return 0;
-
-      *basep = __libdw_cu_base_address (attr->cu);
-      if (*basep == (Dwarf_Addr) -1)
-	return -1;
-
-      if (initial_offset (attr, &offset) != 0)
+	return res < 0 ? -1 : 0;
+
+      /* The first range comes from the decoded list.  The following
+	 ones are read directly, that is cheap enough when going
+	 through them in order.  If the list cannot be decoded,
+	 read it directly to still get the ranges before the error.  */
+      const struct Dwarf_Range_List *list;
+      list = find_range_list (cu, secidx, d, offset, *basep);
+      if (list != NULL)
+	{
+	  if (list->nranges == 0)
+	    return 0;
+	  *startp = list->entries[0].begin;
+	  *endp = list->entries[0].end;
+	  *basep = list->entries[0].base;
+	  return list->entries[0].next;
+	}
+      if (d == NULL)
 	return -1;
     }
   else
@@ -533,8 +774,8 @@ dwarf_ranges (Dwarf_Die *die, ptrdiff_t offset, Dwarf_Addr *basep,
 	return -1;
     }
 
-  readp = d->d_buf + offset;
-  readendp = d->d_buf + d->d_size;
+  const unsigned char *readp = d->d_buf + offset;
+  const unsigned char *readendp = d->d_buf + d->d_size;
 
   Dwarf_Addr begin;
   Dwarf_Addr end;
@@ -37,6 +37,7 @@
 
 #define NAME Dwarf_Sig8_Hash
 #define TYPE struct Dwarf_CU *
+#define SWISS
 
 #include <dynamicsizehash_concurrent.h>
 
@@ -1123,6 +1123,30 @@ extern const char *dwarf_errmsg (int err);
 extern Dwarf_OOM dwarf_new_oom_handler (Dwarf *dbg, Dwarf_OOM handler);
 
 
+/* Return the number of bytes libdw allocated for data derived from
+   the DWARF of DBG, like CUs, abbreviations, location expressions and
+   line tables.  The section data itself is not included.  If DBG is
+   NULL return the total for all Dwarf handles.  */
+extern size_t dwarf_memory_usage (Dwarf *dbg);
+
+/* Set the memory budget of DBG, or if DBG is NULL the budget for all
+   Dwarf handles together, to BUDGET bytes.  Zero means unlimited,
+   which is the default.  libdw never evicts anything on its own, the
+   budgets are enforced by dwarf_trim_memory.  Returns the previous
+   budget.  */
+extern size_t dwarf_set_memory_budget (Dwarf *dbg, size_t budget);
+
+/* Evict the line tables of DBG, the least recently used first, until
+   dwarf_memory_usage (DBG) is at most TARGET and the budgets set with
+   dwarf_set_memory_budget are kept, or nothing evictable is left.
+   Pass SIZE_MAX as TARGET to only enforce the budgets.  Returns the
+   number of bytes freed.  An evicted line table is read again when it
+   is needed next.  All Dwarf_Lines and Dwarf_Line pointers gotten from
+   DBG before are invalid afterwards.  Must not be called while another
+   thread uses DBG.  */
+extern size_t dwarf_trim_memory (Dwarf *dbg, size_t target);
+
+
 /* Inline optimizations.  */
 #ifdef __OPTIMIZE__
 /* Return attribute code of given attribute.  */
@@ -59,7 +59,14 @@ struct files_lines_s
 {
   Dwarf_Off debug_line_offset;
   Dwarf_Files *files;
+  /* The lines are malloced, so that dwarf_trim_memory can free them.
+     The files stay, they are shared with the macro tables.  */
   Dwarf_Lines *lines;
+  /* Value of lines_clock when the lines were last looked up, stored
+     atomically.  */
+  size_t last_use;
+  /* All nodes of the files_lines tree, newest first.  */
+  struct files_lines_s *next;
 };
 
 /* Valid indices for the section data.  */
@@ -183,9 +190,24 @@ struct Dwarf
   /* DWARF package file.  */
   Dwarf *dwp_dwarf;
 
-  /* The section data.  */
+  /* The section data.  Use __libdw_sectiondata to get at it, since
+     SHF_COMPRESSED sections are only decompressed when first used.  */
   Elf_Data *sectiondata[IDX_last];
 
+  /* The SHF_COMPRESSED sections, whose data is only filled in by
+     __libdw_sectiondata.  Not changed after dwarf_begin_elf.  */
+  Elf_Scn *lazyscn[IDX_last];
+
+  /* Whether the data of lazyscn is only decompressed in parts, see
+     __libdw_section_range.  */
+  bool partial[IDX_last];
+
+  /* Serializes decompressing the sections in lazyscn.  */
+  pthread_mutex_t sectiondata_lock;
+
+  /* Protects the ranges trees of the CUs.  */
+  pthread_mutex_t ranges_lock;
+
   /* Size of a prefix of string sections, where any string will be
      null-terminated. */
   size_t string_section_size[STR_SCN_IDX_last];
@@ -232,6 +254,17 @@ struct Dwarf
   /* Search tree for decoded .debug_line units.  */
   void *files_lines;
 
+  /* The same nodes as a list, for dwarf_trim_memory.  */
+  struct files_lines_s *files_lines_list;
+
+  /* Incremented whenever line tables are evicted, so that the lines
+     cached in the CUs are looked up again.  */
+  unsigned int lines_epoch;
+
+  /* Incremented atomically for every line table lookup, see last_use.
+     A size_t, so that no libatomic is needed on 32-bit hosts.  */
+  size_t lines_clock;
+
   /* Address ranges read from .debug_aranges.  */
   Dwarf_Aranges *aranges;
 
@@ -278,6 +311,11 @@ struct Dwarf
   /* Default size of allocated memory blocks.  */
   size_t mem_default_size;
 
+  /* Bytes allocated for the mem_tails blocks and line tables, updated
+     atomically, and zero or the limit set by dwarf_set_memory_budget.  */
+  size_t mem_usage;
+  size_t mem_budget;
+
   /* Registered OOM handler.  */
   Dwarf_OOM oom_handler;
 };
@@ -419,12 +457,24 @@ struct Dwarf_CU
   /* The srcline information.  */
   Dwarf_Lines *lines;
 
+  /* The lines_epoch of the Dwarf the lines came from when they were
+     cached.  */
+  unsigned int lines_epoch;
+
+  /* NULL, the scope tree or (void *) -1 if it couldn't be built, and
+     how often the scopes of this CU were looked up.  */
+  struct Dwarf_Scope_Tree *scope_tree;
+  unsigned int scope_queries;
+
   /* The source file information.  */
   Dwarf_Files *files;
 
   /* Known location lists.  */
   void *locs;
 
+  /* Known range lists, see __libdw_range_list.  */
+  void *ranges;
+
   /* Base address for use with ranges and locs.
      Don't access directly, call __libdw_cu_base_address.  */
   Dwarf_Addr base_address;
@@ -465,6 +515,7 @@ INTDECL (dwarf_diename)
 INTDECL (dwarf_end)
 INTDECL (dwarf_entrypc)
 INTDECL (dwarf_errmsg)
+INTDECL (dwarf_filesrc)
 INTDECL (dwarf_formaddr)
 INTDECL (dwarf_formblock)
 INTDECL (dwarf_formref_die)
@@ -477,6 +528,8 @@ INTDECL (dwarf_getarange_addr)
 INTDECL (dwarf_getarangeinfo)
 INTDECL (dwarf_getaranges)
 INTDECL (dwarf_getlocation_die)
+INTDECL (dwarf_getscopes)
+INTDECL (dwarf_getscopes_die)
 INTDECL (dwarf_getsrcfiles)
 INTDECL (dwarf_getsrclines)
 INTDECL (dwarf_get_units)
@@ -484,6 +537,7 @@ INTDECL (dwarf_hasattr)
 INTDECL (dwarf_haschildren)
 INTDECL (dwarf_haspc)
 INTDECL (dwarf_highpc)
+INTDECL (dwarf_linesrc)
 INTDECL (dwarf_lowpc)
 INTDECL (dwarf_nextcu)
 INTDECL (dwarf_next_unit)
@@ -497,6 +551,94 @@ INTDECL (dwarf_tag)
 
 #define ISV4TU(cu) ((cu)->version == 4 && (cu)->sec_idx == IDX_debug_types)
 
+/* Decompress section IDX of DBG, which dwarf_begin_elf only recorded
+   in lazyscn.  This is in the header rather than libdw proper because
+   readelf uses the section data through __libdw_sectiondata too.  */
+static inline Elf_Data *
+__libdw_load_section (Dwarf *dbg, size_t idx)
+{
+  pthread_mutex_lock (&dbg->sectiondata_lock);
+
+  Elf_Data *data = dbg->sectiondata[idx];
+  Elf_Scn *scn = dbg->lazyscn[idx];
+  GElf_Shdr shdr_mem;
+  GElf_Shdr *shdr;
+  if (data == NULL
+      && (shdr = gelf_getshdr (scn, &shdr_mem)) != NULL)
+    {
+      /* The section might have been decompressed by someone else
+	 using the same Elf, that is no error.  */
+      if ((shdr->sh_flags & SHF_COMPRESSED) == 0)
+	data = elf_rawdata (scn, NULL);
+      else if (idx == IDX_debug_info || idx == IDX_debug_types)
+	{
+	  /* The units are only decompressed when they are read, which
+	     saves work when the section was compressed in seekable
+	     frames.  */
+	  data = elf_compressed_data (scn);
+	  dbg->partial[idx] = data != NULL;
+	}
+      else if (elf_compress (scn, 0, 0) >= 0)
+	data = elf_rawdata (scn, NULL);
+    }
+
+  if (data != NULL && dbg->sectiondata[idx] == NULL)
+    {
+      if (data->d_buf == NULL || data->d_size == 0)
+	data = NULL;
+      else
+	{
+	  /* For string sections, find the size of a prefix where any
+	     string will be null-terminated.  */
+	  if (idx == IDX_debug_str || idx == IDX_debug_line_str)
+	    {
+	      size_t size = data->d_size;
+	      while (size > 0 && *((const char *) data->d_buf + size - 1) != '\0')
+		--size;
+	      dbg->string_section_size[idx == IDX_debug_str
+				       ? STR_SCN_IDX_debug_str
+				       : STR_SCN_IDX_debug_line_str] = size;
+	    }
+
+	  /* The fake CUs for the section were created without data.  */
+	  struct Dwarf_CU *fake = (idx == IDX_debug_loc ? dbg->fake_loc_cu
+				   : idx == IDX_debug_loclists
+				   ? dbg->fake_loclists_cu
+				   : idx == IDX_debug_addr ? dbg->fake_addr_cu
+				   : NULL);
+	  if (fake != NULL)
+	    {
+	      fake->startp = data->d_buf;
+	      fake->endp = data->d_buf + data->d_size;
+	    }
+
+	  __atomic_store_n (&dbg->sectiondata[idx], data, __ATOMIC_RELEASE);
+	}
+    }
+  /* On failure we return NULL, like dwarf_begin_elf did for a section
+     it could not decompress.  */
+
+  pthread_mutex_unlock (&dbg->sectiondata_lock);
+  return data;
+}
+
+/* Return the data of section IDX of DBG, or NULL if there is none.  */
+static inline Elf_Data *
+__libdw_sectiondata (Dwarf *dbg, size_t idx)
+{
+  Elf_Data *data = __atomic_load_n (&dbg->sectiondata[idx], __ATOMIC_ACQUIRE);
+  if (likely (data != NULL) || likely (dbg->lazyscn[idx] == NULL))
+    return data;
+  return __libdw_load_section (dbg, idx);
+}
+
+/* Whether DBG has section IDX, without decompressing it.  */
+static inline bool
+__libdw_have_section (Dwarf *dbg, size_t idx)
+{
+  return dbg->sectiondata[idx] != NULL || dbg->lazyscn[idx] != NULL;
+}
+
 /* Compute the offset of a CU's first DIE from the CU offset.
    CU must be a valid/known version/unit_type.  */
 static inline Dwarf_Off
@@ -568,6 +710,8 @@ __libdw_first_die_off_from_cu (struct Dwarf_CU *cu)
 					  cu->unit_type);
 }
 
+/* The section of a CU has been loaded before the CU could be created,
+   so CUDIE and SUBDIE can use sectiondata directly.  */
 #define CUDIE(fromcu)							      \
   ((Dwarf_Die)								      \
    {									      \
@@ -687,6 +831,22 @@ libdw_valid_user_form (int form)
 /* Set error value.  */
 extern void __libdw_seterrno (int value) internal_function;
 
+/* Make sure the SIZE bytes at OFFSET in section IDX of DBG, which must
+   have been gotten with __libdw_sectiondata, can be read.  */
+static inline int
+__libdw_section_range (Dwarf *dbg, size_t idx, Dwarf_Off offset, size_t size)
+{
+  if (likely (! dbg->partial[idx]))
+    return 0;
+
+  pthread_mutex_lock (&dbg->sectiondata_lock);
+  int res = elf_compressed_range (dbg->lazyscn[idx], offset, size);
+  pthread_mutex_unlock (&dbg->sectiondata_lock);
+  if (unlikely (res != 0))
+    __libdw_seterrno (DWARF_E_INVALID_DWARF);
+  return res;
+}
+
 
 /* Memory handling, the easy parts.  */
 #define libdw_alloc(dbg, type, tsize, cnt) \
@@ -906,6 +1066,62 @@ extern int __libdw_visit_scopes (unsigned int depth,
 				 void *arg)
   __nonnull_attribute__ (2, 4) internal_function;
 
+/* Compact copy of what __libdw_visit_scopes sees of a CU, so
+   dwarf_getscopes and dwarf_getscopes_die don't have to walk the
+   DIEs again.  The nodes are the DIEs which have address ranges,
+   subprograms and the parents of those, in the order visited.  */
+struct Dwarf_Scope_Tree
+{
+  struct Dwarf_Scope_Node
+  {
+    void *addr;
+    Dwarf_CU *cu;		/* Differs for imported units.  */
+    unsigned int parent;	/* SCOPE_NO_PARENT below the CU DIE.  */
+    unsigned int next;		/* Index past the subtree.  */
+    unsigned int range;		/* First entry in ranges.  */
+    unsigned int nranges : 30;
+    unsigned int inlined : 1;	/* A DW_TAG_inlined_subroutine.  */
+    unsigned int keep : 1;	/* Used while building.  */
+  } *nodes;
+  size_t nnodes;
+
+  /* Begin and end of the address ranges of the nodes.  */
+  Dwarf_Addr (*ranges)[2];
+
+  /* The nodes sorted by addr, the first visited first.  */
+  struct Dwarf_Scope_Addr
+  {
+    void *addr;
+    unsigned int node;
+  } *byaddr;
+};
+
+#define SCOPE_NO_PARENT ((unsigned int) -1)
+
+/* The DIE of node IDX in TREE.  */
+static inline Dwarf_Die
+__libdw_scope_die (struct Dwarf_Scope_Tree *tree, unsigned int idx)
+{
+  return (Dwarf_Die) { .addr = tree->nodes[idx].addr,
+		       .cu = tree->nodes[idx].cu };
+}
+
+/* Returns the scope tree of CU, building it when CU was asked for
+   scopes before.  Returns NULL if there is none, then the caller has
+   to use __libdw_visit_scopes.  */
+extern struct Dwarf_Scope_Tree *__libdw_scope_tree (Dwarf_CU *cu)
+  __nonnull_attribute__ (1) internal_function;
+
+/* Returns the index of the first node for the DIE at ADDR in TREE,
+   or SCOPE_NO_PARENT if it isn't there.  */
+extern unsigned int __libdw_scope_find (struct Dwarf_Scope_Tree *tree,
+					void *addr)
+  __nonnull_attribute__ (1) internal_function;
+
+/* Frees TREE.  */
+extern void __libdw_scope_tree_free (struct Dwarf_Scope_Tree *tree)
+  internal_function;
+
 /* Parse a DWARF Dwarf_Block into an array of Dwarf_Op's,
    and cache the result (via tsearch).  */
 extern int __libdw_intern_expression (Dwarf *dbg,
@@ -957,7 +1173,7 @@ __libdw_relocate_offset (Dwarf *dbg __attribute__ ((unused)),
 static inline Elf_Data *
 __libdw_checked_get_data (Dwarf *dbg, int sec_index)
 {
-  Elf_Data *data = dbg->sectiondata[sec_index];
+  Elf_Data *data = __libdw_sectiondata (dbg, sec_index);
   if (unlikely (data == NULL)
       || unlikely (data->d_buf == NULL))
     {
@@ -1087,6 +1303,37 @@ int __libdw_read_begin_end_pair_inc (Dwarf_CU *cu, int sec_index,
 				     Dwarf_Addr *basep)
   internal_function;
 
+/* A DW_AT_ranges list decoded by __libdw_range_list.  */
+struct Dwarf_Range_List
+{
+  /* Where the list starts in its section and the base address it was
+     read with.  */
+  Dwarf_Off offset;
+  Dwarf_Addr base;
+
+  /* The ranges as dwarf_ranges returns them, with the base address
+     and the offset to return after each.  */
+  size_t nranges;
+  struct Dwarf_Range_Entry
+  {
+    Dwarf_Addr begin;
+    Dwarf_Addr end;
+    Dwarf_Addr base;
+    Dwarf_Off next;
+  } *entries;
+
+  /* The union of the ranges as sorted, disjoint [begin, end) pairs.  */
+  size_t nmerged;
+  Dwarf_Addr (*merged)[2];
+};
+
+/* Finds the DW_AT_ranges list of DIE, decoding it the first time.
+   Returns 0 and sets *LISTP, to NULL if DIE has no DW_AT_ranges.
+   Returns -1 if the list cannot be read completely.  Then the caller
+   has to read it entry by entry to get the ranges before the error.  */
+int __libdw_range_list (Dwarf_Die *die, const struct Dwarf_Range_List **listp)
+  internal_function __nonnull_attribute__ (1, 2);
+
 const unsigned char * __libdw_formptr (Dwarf_Attribute *attr, int sec_index,
 				       int err_nodata,
 				       const unsigned char **endpp,
@@ -1121,6 +1368,20 @@ int __libdw_getsrcfiles (Dwarf *dbg, Dwarf_Off debug_line_offset,
 /* Load and return value of DW_AT_comp_dir from CUDIE.  */
 const char *__libdw_getcompdir (Dwarf_Die *cudie);
 
+/* Add DELTA, which may be negative, to the memory usage of DBG.  */
+void __libdw_account_memory (Dwarf *dbg, ptrdiff_t delta)
+  internal_function;
+
+/* Record that the line table of NODE was just looked up in DBG.  */
+static inline void
+__libdw_touch_lines (Dwarf *dbg, struct files_lines_s *node)
+{
+  __atomic_store_n (&node->last_use,
+		    __atomic_add_fetch (&dbg->lines_clock, 1,
+					__ATOMIC_RELAXED),
+		    __ATOMIC_RELAXED);
+}
+
 /* Get the base address for the CU, fetches it when not yet set.
    This is used as initial base address for ranges and loclists.  */
 Dwarf_Addr __libdw_cu_base_address (Dwarf_CU *cu);
@@ -1206,7 +1467,7 @@ str_offsets_base_off (Dwarf *dbg, Dwarf_CU *cu)
   if (dbg == NULL)
     goto no_header;
 
-  Elf_Data *data =  dbg->sectiondata[IDX_debug_str_offsets];
+  Elf_Data *data =  __libdw_sectiondata (dbg, IDX_debug_str_offsets);
   if (data == NULL)
     goto no_header;
 
@@ -1297,7 +1558,7 @@ __libdw_cu_ranges_base (Dwarf_CU *cu)
 	  /* There wasn't an rnglists_base, if the Dwarf does have a
 	     .debug_rnglists section, then it might be we need the
 	     base after the first header. */
-	  Elf_Data *data = cu->dbg->sectiondata[IDX_debug_rnglists];
+	  Elf_Data *data = __libdw_sectiondata (cu->dbg, IDX_debug_rnglists);
 	  if (offset == dwp_offset && data != NULL)
 	    {
 	      Dwarf *dbg = cu->dbg;
@@ -1380,7 +1641,7 @@ __libdw_cu_locs_base (Dwarf_CU *cu)
       /* There wasn't an loclists_base, if the Dwarf does have a
 	 .debug_loclists section, then it might be we need the
 	 base after the first header. */
-      Elf_Data *data = cu->dbg->sectiondata[IDX_debug_loclists];
+      Elf_Data *data = __libdw_sectiondata (cu->dbg, IDX_debug_loclists);
       if (offset == dwp_offset && data != NULL)
 	{
 	  Dwarf *dbg = cu->dbg;
@@ -1454,17 +1715,16 @@ __libdw_link_skel_split (Dwarf_CU *skel, Dwarf_CU *split)
      per .dwp file).  */
   Dwarf *dbg = skel->dbg;
   Dwarf *sdbg = split->dbg;
-  if (dbg->sectiondata[IDX_debug_addr] != NULL
+  Elf_Data *debug_addr = __libdw_sectiondata (dbg, IDX_debug_addr);
+  if (debug_addr != NULL
       /* If this split file hasn't been linked yet...  */
       && (sdbg->sectiondata[IDX_debug_addr] == NULL
 	  /* ... or it was linked to the same skeleton file for another
 	     unit...  */
-	  || (sdbg->sectiondata[IDX_debug_addr]
-	      == dbg->sectiondata[IDX_debug_addr])))
+	  || sdbg->sectiondata[IDX_debug_addr] == debug_addr))
     {
       /* ... then link the address information for this file and unit.  */
-      sdbg->sectiondata[IDX_debug_addr]
-	= dbg->sectiondata[IDX_debug_addr];
+      sdbg->sectiondata[IDX_debug_addr] = debug_addr;
       split->addr_base = __libdw_cu_addr_base (skel);
       sdbg->fake_addr_cu = dbg->fake_addr_cu;
     }
@@ -97,6 +97,7 @@ __libdw_alloc_tail (Dwarf *dbg)
       result->remaining = result->size;
       result->prev = NULL;
       dbg->mem_tails[thread_id] = result;
+      __libdw_account_memory (dbg, dbg->mem_default_size);
     }
   pthread_rwlock_unlock (&dbg->mem_rwl);
   return result;
@@ -134,6 +135,8 @@ __libdw_allocate (Dwarf *dbg, size_t minsize, size_t align)
   dbg->mem_tails[thread_id] = newp;
   pthread_rwlock_unlock (&dbg->mem_rwl);
 
+  __libdw_account_memory (dbg, size);
+
   return (void *) result;
 }
 
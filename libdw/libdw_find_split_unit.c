@@ -112,8 +112,8 @@ try_dwp_file (Dwarf_CU *cu)
 	      /* There's no way to know whether we got the correct file until
 		 we look up the unit, but it should at least be a dwp file.  */
 	      if (dwp_dwarf != NULL
-		  && (dwp_dwarf->sectiondata[IDX_debug_cu_index] != NULL
-		      || dwp_dwarf->sectiondata[IDX_debug_tu_index] != NULL))
+		  && (__libdw_have_section (dwp_dwarf, IDX_debug_cu_index)
+		      || __libdw_have_section (dwp_dwarf, IDX_debug_tu_index)))
 		{
 		  cu->dbg->dwp_dwarf = dwp_dwarf;
 		  cu->dbg->dwp_fd = dwp_fd;
@@ -143,6 +143,13 @@ __libdw_intern_next_unit (Dwarf *dbg, bool debug_types)
   if (unlikely (*offsetp > data->d_size))
     *offsetp = data->d_size;
 
+  /* The whole unit is read from now on.  */
+  if (__libdw_section_range (dbg, sec_idx, oldoff, *offsetp - oldoff) != 0)
+    {
+      *offsetp = oldoff;
+      return NULL;
+    }
+
   uint32_t dwp_row;
   Dwarf_Off dwp_abbrev_offset;
   if (__libdw_dwp_find_unit (dbg, debug_types, oldoff, version, unit_type,
@@ -167,7 +174,10 @@ __libdw_intern_next_unit (Dwarf *dbg, bool debug_types)
   newp->orig_abbrev_offset = newp->last_abbrev_offset = abbrev_offset;
   newp->files = NULL;
   newp->lines = NULL;
+  newp->scope_tree = NULL;
+  newp->scope_queries = 0;
   newp->locs = NULL;
+  newp->ranges = NULL;
   newp->split = (Dwarf_CU *) -1;
   newp->base_address = (Dwarf_Addr) -1;
   newp->addr_base = (Dwarf_Off) -1;
@@ -272,20 +282,20 @@ __libdw_findcu_addr (Dwarf *dbg, void *addr)
 {
   void **tree;
   Dwarf_Off start;
-  if (addr >= dbg->sectiondata[IDX_debug_info]->d_buf
-      && addr < (dbg->sectiondata[IDX_debug_info]->d_buf
-		 + dbg->sectiondata[IDX_debug_info]->d_size))
+  Elf_Data *info = __libdw_sectiondata (dbg, IDX_debug_info);
+  Elf_Data *types;
+  if (info != NULL
+      && addr >= info->d_buf && addr < info->d_buf + info->d_size)
     {
       tree = &dbg->cu_tree;
-      start = addr - dbg->sectiondata[IDX_debug_info]->d_buf;
+      start = addr - info->d_buf;
     }
-  else if (dbg->sectiondata[IDX_debug_types] != NULL
-	   && addr >= dbg->sectiondata[IDX_debug_types]->d_buf
-	   && addr < (dbg->sectiondata[IDX_debug_types]->d_buf
-		      + dbg->sectiondata[IDX_debug_types]->d_size))
+  else if ((types = __libdw_sectiondata (dbg, IDX_debug_types)) != NULL
+	   && addr >= types->d_buf
+	   && addr < types->d_buf + types->d_size)
     {
       tree = &dbg->tu_tree;
-      start = addr - dbg->sectiondata[IDX_debug_types]->d_buf;
+      start = addr - types->d_buf;
     }
   else
     return NULL;
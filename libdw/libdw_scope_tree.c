@@ -0,0 +1,264 @@
+/* Build a compact tree of the scopes in a CU.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of either
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at
+       your option) any later version
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at
+       your option) any later version
+
+   or both in parallel, as here.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <stdlib.h>
+#include "libdwP.h"
+#include <dwarf.h>
+
+
+struct build_state
+{
+  struct Dwarf_Scope_Tree *tree;
+  size_t nodes_alloc;
+  size_t nranges;
+  size_t ranges_alloc;
+  /* The node of the DIE visited at each depth.  */
+  unsigned int *stack;
+  size_t stack_alloc;
+};
+
+static bool
+grow (void *pp, size_t *alloc, size_t need, size_t elsize)
+{
+  if (need <= *alloc)
+    return true;
+
+  size_t n = *alloc == 0 ? 64 : *alloc * 2;
+  while (n < need)
+    n *= 2;
+  void *newp = realloc (*(void **) pp, n * elsize);
+  if (newp == NULL)
+    {
+      __libdw_seterrno (DWARF_E_NOMEM);
+      return false;
+    }
+  *(void **) pp = newp;
+  *alloc = n;
+  return true;
+}
+
+/* Preorder visitor: record the DIE with its address ranges.  */
+static int
+build_previsit (unsigned int depth, struct Dwarf_Die_Chain *die, void *arg)
+{
+  struct build_state *s = arg;
+  struct Dwarf_Scope_Tree *tree = s->tree;
+
+  /* Node indices must fit, and SCOPE_NO_PARENT is reserved.  */
+  if (tree->nnodes >= SCOPE_NO_PARENT - 1)
+    {
+      __libdw_seterrno (DWARF_E_NOMEM);
+      return -1;
+    }
+  if (! grow (&tree->nodes, &s->nodes_alloc, tree->nnodes + 1,
+	      sizeof tree->nodes[0])
+      || ! grow (&s->stack, &s->stack_alloc, depth + 1, sizeof s->stack[0]))
+    return -1;
+
+  unsigned int idx = tree->nnodes++;
+  s->stack[depth] = idx;
+
+  struct Dwarf_Scope_Node *node = &tree->nodes[idx];
+  node->addr = die->die.addr;
+  node->cu = die->die.cu;
+  node->parent = depth > 1 ? s->stack[depth - 1] : SCOPE_NO_PARENT;
+  node->range = s->nranges;
+  node->nranges = 0;
+  int tag = INTUSE(dwarf_tag) (&die->die);
+  node->inlined = tag == DW_TAG_inlined_subroutine;
+  /* It might be the abstract origin of an inlined subroutine.  */
+  node->keep = tag == DW_TAG_subprogram;
+
+  /* Like pc_match in dwarf_getscopes, missing range attributes are no
+     error.  Ranges before an error still count there, so keep
+     them.  */
+  Dwarf_Addr base, begin, end;
+  ptrdiff_t offset = 0;
+  while ((offset = INTUSE(dwarf_ranges) (&die->die, offset, &base,
+					 &begin, &end)) > 0)
+    {
+      if (! grow (&tree->ranges, &s->ranges_alloc, s->nranges + 1,
+		  sizeof tree->ranges[0]))
+	return -1;
+      tree->ranges[s->nranges][0] = begin;
+      tree->ranges[s->nranges][1] = end;
+      s->nranges++;
+      if (++node->nranges == 0)
+	{
+	  /* The bit-field overflowed.  */
+	  __libdw_seterrno (DWARF_E_NOMEM);
+	  return -1;
+	}
+    }
+  if (offset < 0)
+    {
+      int error = INTUSE(dwarf_errno) ();
+      if (error != DWARF_E_NOERROR
+	  && error != DWARF_E_NO_DEBUG_RANGES
+	  && error != DWARF_E_NO_DEBUG_RNGLISTS)
+	{
+	  __libdw_seterrno (error);
+	  return -1;
+	}
+    }
+
+  return 0;
+}
+
+/* Postorder visitor: drop the DIE again if nobody will ask for it.  */
+static int
+build_postvisit (unsigned int depth, struct Dwarf_Die_Chain *die
+		 __attribute__ ((unused)), void *arg)
+{
+  struct build_state *s = arg;
+  struct Dwarf_Scope_Tree *tree = s->tree;
+  unsigned int idx = s->stack[depth];
+  struct Dwarf_Scope_Node *node = &tree->nodes[idx];
+
+  if (tree->nnodes == idx + 1 && node->nranges == 0 && ! node->keep)
+    tree->nnodes--;
+  else
+    node->next = tree->nnodes;
+
+  return 0;
+}
+
+static int
+compare_addr (const void *a, const void *b)
+{
+  const struct Dwarf_Scope_Addr *p1 = a;
+  const struct Dwarf_Scope_Addr *p2 = b;
+
+  if (p1->addr != p2->addr)
+    return p1->addr < p2->addr ? -1 : 1;
+  return p1->node < p2->node ? -1 : p1->node > p2->node;
+}
+
+static struct Dwarf_Scope_Tree *
+build_tree (Dwarf_CU *cu)
+{
+  struct Dwarf_Scope_Tree *tree = calloc (1, sizeof *tree);
+  if (tree == NULL)
+    {
+      __libdw_seterrno (DWARF_E_NOMEM);
+      return NULL;
+    }
+
+  struct build_state s = { .tree = tree };
+  struct Dwarf_Die_Chain root = { .parent = NULL, .die = CUDIE (cu) };
+  int result = __libdw_visit_scopes (0, &root, NULL, &build_previsit,
+				     &build_postvisit, &s);
+  free (s.stack);
+  if (result != 0)
+    {
+      __libdw_scope_tree_free (tree);
+      return NULL;
+    }
+
+  tree->byaddr = malloc ((tree->nnodes ?: 1) * sizeof tree->byaddr[0]);
+  if (tree->byaddr == NULL)
+    {
+      __libdw_seterrno (DWARF_E_NOMEM);
+      __libdw_scope_tree_free (tree);
+      return NULL;
+    }
+  for (size_t i = 0; i < tree->nnodes; ++i)
+    {
+      tree->byaddr[i].addr = tree->nodes[i].addr;
+      tree->byaddr[i].node = i;
+    }
+  qsort (tree->byaddr, tree->nnodes, sizeof tree->byaddr[0], compare_addr);
+
+  __libdw_account_memory (cu->dbg,
+			  s.nodes_alloc * sizeof tree->nodes[0]
+			  + s.ranges_alloc * sizeof tree->ranges[0]
+			  + tree->nnodes * sizeof tree->byaddr[0]);
+  return tree;
+}
+
+struct Dwarf_Scope_Tree *
+internal_function
+__libdw_scope_tree (Dwarf_CU *cu)
+{
+  struct Dwarf_Scope_Tree *tree = __atomic_load_n (&cu->scope_tree,
+						   __ATOMIC_ACQUIRE);
+  if (tree != NULL)
+    return tree == (void *) -1l ? NULL : tree;
+
+  /* Walking the DIEs once is cheaper than building the tree, so only
+     do that when the CU is asked a second time.  */
+  if (__atomic_fetch_add (&cu->scope_queries, 1, __ATOMIC_RELAXED) == 0)
+    return NULL;
+
+  tree = build_tree (cu);
+  struct Dwarf_Scope_Tree *expected = NULL;
+  if (! __atomic_compare_exchange_n (&cu->scope_tree, &expected,
+				     tree ?: (void *) -1l, false,
+				     __ATOMIC_RELEASE, __ATOMIC_ACQUIRE))
+    {
+      /* Another thread was faster.  */
+      __libdw_scope_tree_free (tree);
+      tree = expected == (void *) -1l ? NULL : expected;
+    }
+  return tree;
+}
+
+unsigned int
+internal_function
+__libdw_scope_find (struct Dwarf_Scope_Tree *tree, void *addr)
+{
+  size_t lo = 0;
+  size_t hi = tree->nnodes;
+  while (lo < hi)
+    {
+      size_t mid = (lo + hi) / 2;
+      if (tree->byaddr[mid].addr < addr)
+	lo = mid + 1;
+      else
+	hi = mid;
+    }
+  if (lo < tree->nnodes && tree->byaddr[lo].addr == addr)
+    return tree->byaddr[lo].node;
+  return SCOPE_NO_PARENT;
+}
+
+void
+internal_function
+__libdw_scope_tree_free (struct Dwarf_Scope_Tree *tree)
+{
+  if (tree == NULL)
+    return;
+
+  free (tree->nodes);
+  free (tree->ranges);
+  free (tree->byaddr);
+  free (tree);
+}
@@ -37,7 +37,7 @@ dwelf_dwarf_gnu_debugaltlink (Dwarf *dwarf,
 			      const char **name_p,
 			      const void **build_idp)
 {
-  Elf_Data *data = dwarf->sectiondata[IDX_gnu_debugaltlink];
+  Elf_Data *data = __libdw_sectiondata (dwarf, IDX_gnu_debugaltlink);
   if (data == NULL)
     {
       return 0;
@@ -32,13 +32,16 @@
 #endif
 
 #include <assert.h>
+#include <endian.h>
 #include <inttypes.h>
 #include <libelf.h>
+#include <pthread.h>
 #include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include "libdwelfP.h"
+#include "atomics.h"
 #include <system.h>
 
 
@@ -46,14 +49,32 @@ struct Dwelf_Strent
 {
   const char *string;
   size_t len;
-  struct Dwelf_Strent *next;
-  struct Dwelf_Strent *left;
-  struct Dwelf_Strent *right;
   size_t offset;
-  char reverse[0];
+  /* Set by dwelf_strtab_finalize if the string is stored as the tail
+     of the string which follows it in sorted order.  */
+  bool merged;
 };
 
 
+/* Definitions for the hash table used to find identical strings.  */
+#define NAME Dwelf_Strent_Hash
+#define TYPE Dwelf_Strent *
+#define COMPARE(a, b) \
+  ((a)->len != (b)->len || memcmp ((a)->string, (b)->string, (a)->len) != 0)
+#define NO_UNDEF
+#include <dynamicsizehash.h>
+
+/* This is defined in dwarf_abbrev_hash.c, we can just use it here.  */
+#define next_prime __libdwarf_next_prime
+extern size_t next_prime (size_t) attribute_hidden;
+
+#include <dynamicsizehash.c>
+#undef NO_UNDEF
+#undef NAME
+#undef TYPE
+#undef COMPARE
+
+
 struct memoryblock
 {
   struct memoryblock *next;
@@ -63,11 +84,14 @@ struct memoryblock
 
 struct Dwelf_Strtab
 {
-  struct Dwelf_Strent *root;
+  Dwelf_Strent_Hash hash;
+  /* All distinct strings in the order they were added.  */
+  Dwelf_Strent **entries;
+  size_t nentries;
+  size_t maxentries;
   struct memoryblock *memory;
   char *backp;
   size_t left;
-  size_t total;
   bool nullstr;
 
   struct Dwelf_Strent null;
@@ -93,6 +117,12 @@ dwelf_strtab_init (bool nullstr)
   Dwelf_Strtab *ret = calloc (1, sizeof (struct Dwelf_Strtab));
   if (ret != NULL)
     {
+      if (Dwelf_Strent_Hash_init (&ret->hash, 61) != 0)
+	{
+	  free (ret);
+	  return NULL;
+	}
+
       ret->nullstr = nullstr;
 
       if (nullstr)
@@ -140,6 +170,8 @@ dwelf_strtab_free (Dwelf_Strtab *st)
       free (old);
     }
 
+  Dwelf_Strent_Hash_free (&st->hash);
+  free (st->entries);
   free (st);
 }
 
@@ -154,9 +186,9 @@ newstring (Dwelf_Strtab *st, const char *str, size_t len)
 		  & (__alignof__ (struct Dwelf_Strent) - 1));
 
   /* Make sure there is enough room in the memory block.  */
-  if (st->left < align + sizeof (struct Dwelf_Strent) + len)
+  if (st->left < align + sizeof (struct Dwelf_Strent))
     {
-      if (morememory (st, sizeof (struct Dwelf_Strent) + len))
+      if (morememory (st, sizeof (struct Dwelf_Strent)))
 	return NULL;
 
       align = 0;
@@ -166,43 +198,23 @@ newstring (Dwelf_Strtab *st, const char *str, size_t len)
   Dwelf_Strent *newstr = (Dwelf_Strent *) (st->backp + align);
   newstr->string = str;
   newstr->len = len;
-  newstr->next = NULL;
-  newstr->left = NULL;
-  newstr->right = NULL;
   newstr->offset = 0;
-  for (int i = len - 2; i >= 0; --i)
-    newstr->reverse[i] = str[len - 2 - i];
-  newstr->reverse[len - 1] = '\0';
-  st->backp += align + sizeof (struct Dwelf_Strent) + len;
-  st->left -= align + sizeof (struct Dwelf_Strent) + len;
+  newstr->merged = false;
+  st->backp += align + sizeof (struct Dwelf_Strent);
+  st->left -= align + sizeof (struct Dwelf_Strent);
 
   return newstr;
 }
 
 
-/* XXX This function should definitely be rewritten to use a balancing
-   tree algorithm (AVL, red-black trees).  For now a simple, correct
-   implementation is enough.  */
-static Dwelf_Strent **
-searchstring (Dwelf_Strent **sep, Dwelf_Strent *newstr)
+/* FNV-1a hash of the LEN bytes at STR.  */
+static unsigned long int
+strhash (const char *str, size_t len)
 {
-  /* More strings?  */
-  if (*sep == NULL)
-    {
-      *sep = newstr;
-      return sep;
-    }
-
-  /* Compare the strings.  */
-  int cmpres = memcmp ((*sep)->reverse, newstr->reverse,
-		       MIN ((*sep)->len, newstr->len) - 1);
-  if (cmpres == 0)
-    /* We found a matching string.  */
-    return sep;
-  else if (cmpres > 0)
-    return searchstring (&(*sep)->left, newstr);
-  else
-    return searchstring (&(*sep)->right, newstr);
+  uint64_t h = 0xcbf29ce484222325ull;
+  for (size_t i = 0; i < len; ++i)
+    h = (h ^ (unsigned char) str[i]) * 0x100000001b3ull;
+  return h ^ (h >> 32);
 }
 
 
@@ -215,111 +227,581 @@ strtab_add (Dwelf_Strtab *st, const char *str, size_t len)
   if (len == 1 && st->null.string != NULL)
     return &st->null;
 
+  /* Identical strings share one entry.  Strings which are the tail of
+     another string are only merged in dwelf_strtab_finalize.  */
+  unsigned long int hval = strhash (str, len);
+  Dwelf_Strent key = { .string = str, .len = len };
+  Dwelf_Strent *found = Dwelf_Strent_Hash_find (&st->hash, hval, &key);
+  if (found != NULL)
+    return found;
+
+  if (st->nentries == st->maxentries)
+    {
+      size_t newmax = st->maxentries == 0 ? 64 : 2 * st->maxentries;
+      Dwelf_Strent **newentries = realloc (st->entries,
+					   newmax * sizeof (Dwelf_Strent *));
+      if (newentries == NULL)
+	return NULL;
+      st->entries = newentries;
+      st->maxentries = newmax;
+    }
+
   /* Allocate memory for the new string and its associated information.  */
   Dwelf_Strent *newstr = newstring (st, str, len);
   if (newstr == NULL)
     return NULL;
 
-  /* Search in the array for the place to insert the string.  If there
-     is no string with matching prefix and no string with matching
-     leading substring, create a new entry.  */
-  Dwelf_Strent **sep = searchstring (&st->root, newstr);
-  if (*sep != newstr)
+  Dwelf_Strent_Hash_insert (&st->hash, hval, newstr);
+  st->entries[st->nentries++] = newstr;
+
+  return newstr;
+}
+
+Dwelf_Strent *
+dwelf_strtab_add (Dwelf_Strtab *st, const char *str)
+{
+  return strtab_add (st, str, strlen (str) + 1);
+}
+
+Dwelf_Strent *
+dwelf_strtab_add_len (Dwelf_Strtab *st, const char *str, size_t len)
+{
+  return strtab_add (st, str, len);
+}
+
+
+/* The strings are sorted by their reversed contents, without the
+   terminating NUL, so that a string which is the tail of another one
+   directly precedes it or another string with the same tail.  The
+   sort looks at seven characters at a time.  Return them for the
+   characters starting at 7 * DEPTH counted from the end of SE as a
+   number which orders like the characters, with the number of
+   characters present in the low byte.  Missing characters count as
+   zero, so a string which ends compares less than any longer one.  */
+static inline uint64_t
+revkey (const Dwelf_Strent *se, size_t depth)
+{
+  size_t pos = 7 * depth;
+  size_t slen = se->len - 1;
+  if (pos >= slen)
+    return 0;
+
+  const unsigned char *cp = (const unsigned char *) se->string + slen - pos;
+  if (slen - pos >= 8)
+    {
+      /* Read as little endian, the last of the eight bytes ends up in
+	 the most significant position.  */
+      uint64_t key;
+      memcpy (&key, cp - 8, sizeof key);
+      return (le64toh (key) & ~(uint64_t) 0xff) | 7;
+    }
+
+  size_t n = MIN (slen - pos, 7);
+  uint64_t key = n;
+  for (size_t i = 0; i < n; ++i)
+    key |= (uint64_t) *--cp << (56 - 8 * i);
+  return key;
+}
+
+/* True if the strings with the key KEY continue past it.  */
+#define KEY_FULL(key) (((key) & 0xff) == 7)
+
+/* Compare the reversed strings of A and B starting at DEPTH.  */
+static int
+revcmp (const Dwelf_Strent *a, const Dwelf_Strent *b, size_t depth)
+{
+  while (1)
+    {
+      uint64_t ka = revkey (a, depth);
+      uint64_t kb = revkey (b, depth);
+      if (ka != kb)
+	return ka < kb ? -1 : 1;
+      if (! KEY_FULL (ka))
+	return 0;
+      ++depth;
+    }
+}
+
+#define SWAP(a, i, j) \
+  do { Dwelf_Strent *_tmp = (a)[i]; (a)[i] = (a)[j]; (a)[j] = _tmp; } while (0)
+
+/* Index of the entry among I, J and K in A with the median key.  */
+static inline size_t
+median3 (Dwelf_Strent **a, size_t i, size_t j, size_t k, size_t depth)
+{
+  uint64_t ki = revkey (a[i], depth);
+  uint64_t kj = revkey (a[j], depth);
+  uint64_t kk = revkey (a[k], depth);
+  if (ki < kj)
+    return kj < kk ? j : (ki < kk ? k : i);
+  else
+    return ki < kk ? i : (kj < kk ? k : j);
+}
+
+struct sortrange
+{
+  size_t lo;
+  size_t n;
+  size_t depth;
+};
+
+/* Partition the range R of ARR, which has at least two entries, by
+   the key at its depth.  Store the resulting ranges with more than one
+   entry which still need sorting in SUB and return their number.  */
+static size_t
+partition (Dwelf_Strent **arr, struct sortrange r, struct sortrange sub[3])
+{
+  Dwelf_Strent **a = arr + r.lo;
+
+  /* Use the median of three, or for larger ranges the median of
+     three medians of three, as the pivot and move it to the front.  */
+  size_t pm = r.n / 2;
+  if (r.n > 40)
     {
-      /* This is not the same entry.  This means we have a prefix match.  */
-      if ((*sep)->len > newstr->len)
+      size_t step = r.n / 8;
+      size_t p1 = median3 (a, 0, step, 2 * step, r.depth);
+      size_t p2 = median3 (a, pm - step, pm, pm + step, r.depth);
+      size_t p3 = median3 (a, r.n - 1 - 2 * step, r.n - 1 - step,
+			   r.n - 1, r.depth);
+      pm = median3 (a, p1, p2, p3, r.depth);
+    }
+  else
+    pm = median3 (a, 0, pm, r.n - 1, r.depth);
+  SWAP (a, 0, pm);
+  uint64_t pivot = revkey (a[0], r.depth);
+
+  /* Split-end partition (Bentley and McIlroy, "Engineering a sort
+     function").  Keys equal to the pivot are collected at both ends
+     and moved to the middle afterwards: [0, lt) < pivot, [lt, gt)
+     == pivot, [gt, n) > pivot.  */
+  size_t pa = 1;
+  size_t pb = 1;
+  size_t pc = r.n - 1;
+  size_t pd = r.n - 1;
+  while (1)
+    {
+      uint64_t c;
+      while (pb <= pc && (c = revkey (a[pb], r.depth)) <= pivot)
 	{
-	  /* Check whether we already know this string.  */
-	  for (Dwelf_Strent *subs = (*sep)->next; subs != NULL;
-	       subs = subs->next)
-	    if (subs->len == newstr->len)
-	      {
-		/* We have an exact match with a substring.  Free the memory
-		   we allocated.  */
-		st->left += st->backp - (char *) newstr;
-		st->backp = (char *) newstr;
-
-		return subs;
-	      }
-
-	  /* We have a new substring.  This means we don't need the reverse
-	     string of this entry anymore.  */
-	  st->backp -= newstr->len;
-	  st->left += newstr->len;
-
-	  newstr->next = (*sep)->next;
-	  (*sep)->next = newstr;
+	  if (c == pivot)
+	    {
+	      SWAP (a, pa, pb);
+	      ++pa;
+	    }
+	  ++pb;
 	}
-      else if ((*sep)->len != newstr->len)
+      while (pb <= pc && (c = revkey (a[pc], r.depth)) >= pivot)
 	{
-	  /* When we get here it means that the string we are about to
-	     add has a common prefix with a string we already have but
-	     it is longer.  In this case we have to put it first.  */
-	  st->total += newstr->len - (*sep)->len;
-	  newstr->next = *sep;
-	  newstr->left = (*sep)->left;
-	  newstr->right = (*sep)->right;
-	  *sep = newstr;
+	  if (c == pivot)
+	    {
+	      SWAP (a, pc, pd);
+	      --pd;
+	    }
+	  --pc;
 	}
-      else
+      if (pb > pc)
+	break;
+      SWAP (a, pb, pc);
+      ++pb;
+      --pc;
+    }
+
+  size_t cnt = MIN (pa, pb - pa);
+  for (size_t i = 0; i < cnt; ++i)
+    SWAP (a, i, pb - cnt + i);
+  cnt = MIN (pd - pc, r.n - 1 - pd);
+  for (size_t i = 0; i < cnt; ++i)
+    SWAP (a, pb + i, r.n - cnt + i);
+  size_t lt = pb - pa;
+  size_t gt = r.n - (pd - pc);
+
+  size_t nsub = 0;
+  if (lt > 1)
+    sub[nsub++] = (struct sortrange) { r.lo, lt, r.depth };
+  if (r.n - gt > 1)
+    sub[nsub++] = (struct sortrange) { r.lo + gt, r.n - gt, r.depth };
+  /* Strings which ended at this depth are identical, nothing more
+     to sort among them.  */
+  if (gt - lt > 1 && KEY_FULL (pivot))
+    sub[nsub++] = (struct sortrange) { r.lo + lt, gt - lt, r.depth + 1 };
+  return nsub;
+}
+
+/* Sort the range R of ARR with a multikey quicksort (Bentley and
+   Sedgewick, "Fast algorithms for sorting and searching strings").
+   Every comparison looks at a single key, and keys which are known
+   to be identical are not compared again.  Pending ranges are kept
+   on an explicit stack.  Return nonzero if no memory could be
+   allocated.  */
+static int
+sortstrings (Dwelf_Strent **arr, struct sortrange r)
+{
+  size_t maxstack = 64;
+  struct sortrange *stack = malloc (maxstack * sizeof (*stack));
+  if (stack == NULL)
+    return 1;
+
+  size_t nstack = 0;
+  stack[nstack++] = r;
+
+  while (nstack > 0)
+    {
+      r = stack[--nstack];
+
+      if (r.n < 16)
 	{
-	  /* We have an exact match.  Free the memory we allocated.  */
-	  st->left += st->backp - (char *) newstr;
-	  st->backp = (char *) newstr;
+	  Dwelf_Strent **a = arr + r.lo;
+	  for (size_t i = 1; i < r.n; ++i)
+	    {
+	      Dwelf_Strent *se = a[i];
+	      size_t j = i;
+	      while (j > 0 && revcmp (a[j - 1], se, r.depth) > 0)
+		{
+		  a[j] = a[j - 1];
+		  --j;
+		}
+	      a[j] = se;
+	    }
+	  continue;
+	}
 
-	  newstr = *sep;
+      if (nstack + 3 > maxstack)
+	{
+	  struct sortrange *newstack = realloc (stack, (2 * maxstack
+							* sizeof (*stack)));
+	  if (newstack == NULL)
+	    {
+	      free (stack);
+	      return 1;
+	    }
+	  stack = newstack;
+	  maxstack *= 2;
 	}
+
+      nstack += partition (arr, r, &stack[nstack]);
     }
-  else
-    st->total += newstr->len;
 
-  return newstr;
+  free (stack);
+  return 0;
 }
 
-Dwelf_Strent *
-dwelf_strtab_add (Dwelf_Strtab *st, const char *str)
+
+static int
+rangecmp (const void *p1, const void *p2)
 {
-  return strtab_add (st, str, strlen (str) + 1);
+  const struct sortrange *r1 = p1;
+  const struct sortrange *r2 = p2;
+  return r1->n < r2->n ? 1 : r1->n > r2->n ? -1 : 0;
 }
 
-Dwelf_Strent *
-dwelf_strtab_add_len (Dwelf_Strtab *st, const char *str, size_t len)
+/* Split the N entries of ARR into independent ranges of at most LIMIT
+   entries each, which can then be sorted separately.  The ranges are
+   returned in *RANGESP, sorted by size, largest first.  Return the
+   number of ranges or -1 if no memory could be allocated.  */
+static ssize_t
+splitstrings (Dwelf_Strent **arr, size_t n, size_t limit,
+	      struct sortrange **rangesp)
 {
-  return strtab_add (st, str, len);
+  size_t maxranges = 64;
+  struct sortrange *ranges = malloc (maxranges * sizeof (*ranges));
+  if (ranges == NULL)
+    return -1;
+
+  /* Ranges at the start of the array are done, the others are still
+     too large.  */
+  size_t ndone = 0;
+  size_t nranges = 0;
+  ranges[nranges++] = (struct sortrange) { 0, n, 0 };
+
+  while (ndone < nranges)
+    {
+      struct sortrange r = ranges[--nranges];
+      if (r.n <= limit)
+	{
+	  ranges[nranges++] = ranges[ndone];
+	  ranges[ndone++] = r;
+	  continue;
+	}
+
+      if (nranges + 3 > maxranges)
+	{
+	  struct sortrange *newranges = realloc (ranges, (2 * maxranges
+							  * sizeof (*ranges)));
+	  if (newranges == NULL)
+	    {
+	      free (ranges);
+	      return -1;
+	    }
+	  ranges = newranges;
+	  maxranges *= 2;
+	}
+
+      nranges += partition (arr, r, &ranges[nranges]);
+    }
+
+  /* Hand out the largest ranges first to keep the threads busy.  */
+  qsort (ranges, nranges, sizeof (*ranges), rangecmp);
+
+  *rangesp = ranges;
+  return nranges;
+}
+
+
+/* Return true if string A is the tail of string B.  */
+static inline bool
+istail (const Dwelf_Strent *a, const Dwelf_Strent *b)
+{
+  return (a->len <= b->len
+	  && memcmp (a->string, b->string + b->len - a->len, a->len - 1) == 0);
 }
 
+
+/* Part of the sorted entries, [LO, HI), which is stored by one call of
+   copychunk.  */
+struct strchunk
+{
+  size_t lo;
+  size_t hi;
+  /* Number of bytes taken by the strings of the chunk.  */
+  size_t size;
+  /* Index of the first string of the chunk which is stored itself, or
+     HI if all are merged into later strings.  */
+  size_t firstkept;
+  /* Offset of the strings of the chunk in the table.  */
+  size_t start;
+  /* End offset of the string with index HI.  */
+  size_t nextend;
+};
+
+/* A string which is the tail of the next one in sorted order is stored
+   as part of it.  The next string is either stored itself or is the
+   tail of a later one, in either case it ends at the same place.  Mark
+   the merged strings of CHUNK and add up the size of the others.  */
 static void
-copystrings (Dwelf_Strent *nodep, char **freep, size_t *offsetp)
+markchunk (Dwelf_Strent **arr, size_t n, struct strchunk *chunk)
 {
-  if (nodep->left != NULL)
-    copystrings (nodep->left, freep, offsetp);
+  chunk->size = 0;
+  chunk->firstkept = chunk->hi;
+  for (size_t i = chunk->hi; i-- > chunk->lo; )
+    {
+      arr[i]->merged = i + 1 < n && istail (arr[i], arr[i + 1]);
+      if (! arr[i]->merged)
+	{
+	  chunk->size += arr[i]->len;
+	  chunk->firstkept = i;
+	}
+    }
+}
 
-  /* Process the current node.  */
-  nodep->offset = *offsetp;
-  *freep = (char *) mempcpy (*freep, nodep->string, nodep->len);
-  *offsetp += nodep->len;
+/* Compute the start of each of the NCHUNKS chunks from the sizes of
+   the chunks before it, and the end of the string following each.
+   The table starts at offset START.  Return the total size.  */
+static size_t
+layoutchunks (Dwelf_Strent **arr, struct strchunk *chunks, size_t nchunks,
+	      size_t start)
+{
+  for (size_t c = 0; c < nchunks; ++c)
+    {
+      chunks[c].start = start;
+      start += chunks[c].size;
+    }
 
-  for (Dwelf_Strent *subs = nodep->next; subs != NULL; subs = subs->next)
+  /* The string following a chunk ends where the first string stored
+     at or after it ends.  The last string is never merged.  */
+  size_t nextend = start;
+  for (size_t c = nchunks; c-- > 0; )
     {
-      assert (subs->len < nodep->len);
-      subs->offset = nodep->offset + nodep->len - subs->len;
-      assert (subs->offset != 0 || subs->string[0] == '\0');
+      chunks[c].nextend = nextend;
+      if (chunks[c].firstkept < chunks[c].hi)
+	nextend = chunks[c].start + arr[chunks[c].firstkept]->len;
     }
 
-  if (nodep->right != NULL)
-    copystrings (nodep->right, freep, offsetp);
+  return start;
+}
+
+/* Store the strings of CHUNK in BUF, back to front since the offset of
+   a tail depends on the string it is part of.  */
+static void
+copychunk (Dwelf_Strent **arr, char *buf, const struct strchunk *chunk)
+{
+  size_t endoff = chunk->start + chunk->size;
+  size_t nextend = chunk->nextend;
+  for (size_t i = chunk->hi; i-- > chunk->lo; )
+    {
+      Dwelf_Strent *se = arr[i];
+      if (se->merged)
+	{
+	  se->offset = nextend - se->len;
+	  assert (se->offset != 0 || se->string[0] == '\0');
+	}
+      else
+	{
+	  endoff -= se->len;
+	  se->offset = endoff;
+	  memcpy (buf + endoff, se->string, se->len);
+	  nextend = endoff + se->len;
+	}
+    }
+  assert (endoff == chunk->start);
 }
 
 
-Elf_Data *
-dwelf_strtab_finalize (Dwelf_Strtab *st, Elf_Data *data)
+enum strtab_phase
+{
+  phase_sort,
+  phase_mark,
+  phase_copy
+};
+
+/* Work shared by the threads of dwelf_strtab_finalize_parallel.  Each
+   phase consists of COUNT items, which the threads take one at a time
+   using NEXT.  */
+struct strtab_work
+{
+  Dwelf_Strent **arr;
+  size_t n;
+  enum strtab_phase phase;
+  size_t count;
+  atomic_size_t next;
+  atomic_bool failed;
+  struct sortrange *ranges;
+  struct strchunk *chunks;
+  char *buf;
+};
+
+static void *
+strtab_worker (void *arg)
+{
+  struct strtab_work *work = arg;
+  size_t i;
+
+  while ((i = atomic_fetch_add (&work->next, 1)) < work->count)
+    switch (work->phase)
+      {
+      case phase_sort:
+	if (sortstrings (work->arr, work->ranges[i]) != 0)
+	  atomic_store (&work->failed, true);
+	break;
+      case phase_mark:
+	markchunk (work->arr, work->n, &work->chunks[i]);
+	break;
+      case phase_copy:
+	copychunk (work->arr, work->buf, &work->chunks[i]);
+	break;
+      }
+
+  return NULL;
+}
+
+/* Process the COUNT items of PHASE with NTHREADS threads, including
+   the calling one.  If threads cannot be created the remaining ones
+   do all the work.  */
+static void
+strtab_run (struct strtab_work *work, enum strtab_phase phase, size_t count,
+	    unsigned int nthreads)
+{
+  work->phase = phase;
+  work->count = count;
+  atomic_store (&work->next, 0);
+
+  pthread_t *threads = NULL;
+  unsigned int nstarted = 0;
+  if (nthreads > 1 && count > 1)
+    {
+      nthreads = MIN (nthreads, count);
+      threads = malloc ((nthreads - 1) * sizeof (pthread_t));
+      if (threads != NULL)
+	while (nstarted + 1 < nthreads
+	       && pthread_create (&threads[nstarted], NULL, strtab_worker,
+				  work) == 0)
+	  ++nstarted;
+    }
+
+  strtab_worker (work);
+
+  for (unsigned int t = 0; t < nstarted; ++t)
+    pthread_join (threads[t], NULL);
+  free (threads);
+}
+
+
+/* Tables with fewer strings are always finalized by one thread.  */
+#define PARALLEL_MIN 65536
+
+static Elf_Data *
+strtab_finalize (Dwelf_Strtab *st, Elf_Data *data, unsigned int nthreads)
 {
   size_t nulllen = st->nullstr ? 1 : 0;
+  struct strtab_work work =
+    {
+      .arr = st->entries,
+      .n = st->nentries,
+    };
+  atomic_init (&work.next, 0);
+  atomic_init (&work.failed, false);
+
+  if (work.n < PARALLEL_MIN)
+    nthreads = 1;
+
+  /* First sort the strings.  With more than one thread the top of the
+     sort is done here, until the remaining ranges can be sorted
+     separately.  */
+  if (nthreads == 1)
+    {
+      if (work.n > 1
+	  && sortstrings (work.arr, (struct sortrange) { 0, work.n, 0 }) != 0)
+	atomic_store (&work.failed, true);
+    }
+  else
+    {
+      size_t limit = MAX (work.n / (8 * (size_t) nthreads), 16);
+      ssize_t nranges = splitstrings (work.arr, work.n, limit, &work.ranges);
+      if (nranges < 0)
+	atomic_store (&work.failed, true);
+      else
+	{
+	  strtab_run (&work, phase_sort, nranges, nthreads);
+	  free (work.ranges);
+	}
+    }
+  if (atomic_load (&work.failed))
+    {
+      data->d_buf = NULL;
+      return NULL;
+    }
+
+  /* Then split the sorted strings into chunks and find out how much
+     room each chunk takes.  */
+  size_t nchunks = MIN (work.n, 4 * (size_t) nthreads);
+  struct strchunk chunk;
+  if (nchunks > 1)
+    {
+      work.chunks = malloc (nchunks * sizeof (struct strchunk));
+      if (work.chunks == NULL)
+	{
+	  data->d_buf = NULL;
+	  return NULL;
+	}
+    }
+  else
+    work.chunks = &chunk;
+  for (size_t c = 0; c < nchunks; ++c)
+    {
+      work.chunks[c].lo = c * work.n / nchunks;
+      work.chunks[c].hi = (c + 1) * work.n / nchunks;
+    }
+  strtab_run (&work, phase_mark, nchunks, nthreads);
+
+  size_t total = layoutchunks (work.arr, work.chunks, nchunks, nulllen);
 
   /* Fill in the information.  */
-  data->d_buf = malloc (st->total + nulllen);
+  data->d_buf = malloc (total);
   if (data->d_buf == NULL)
-    return NULL;
+    {
+      if (work.chunks != &chunk)
+	free (work.chunks);
+      return NULL;
+    }
 
   /* The first byte must always be zero if we created the table with a
      null string.  */
@@ -327,23 +809,43 @@ dwelf_strtab_finalize (Dwelf_Strtab *st, Elf_Data *data)
     *((char *) data->d_buf) = '\0';
 
   data->d_type = ELF_T_BYTE;
-  data->d_size = st->total + nulllen;
+  data->d_size = total;
   data->d_off = 0;
   data->d_align = 1;
   data->d_version = EV_CURRENT;
 
-  /* Now run through the tree and add all the string while also updating
-     the offset members of the elfstrent records.  */
-  char *endp = (char *) data->d_buf + nulllen;
-  size_t copylen = nulllen;
-  if (st->root)
-    copystrings (st->root, &endp, &copylen);
-  assert (copylen == st->total + nulllen);
+  /* Now store the strings and set the offsets.  */
+  work.buf = data->d_buf;
+  strtab_run (&work, phase_copy, nchunks, nthreads);
+
+  if (work.chunks != &chunk)
+    free (work.chunks);
 
   return data;
 }
 
 
+Elf_Data *
+dwelf_strtab_finalize (Dwelf_Strtab *st, Elf_Data *data)
+{
+  return strtab_finalize (st, data, 1);
+}
+
+
+Elf_Data *
+dwelf_strtab_finalize_parallel (Dwelf_Strtab *st, Elf_Data *data,
+				unsigned int nthreads)
+{
+  if (nthreads == 0)
+    {
+      long int ncpus = sysconf (_SC_NPROCESSORS_ONLN);
+      nthreads = ncpus > 0 ? ncpus : 1;
+    }
+
+  return strtab_finalize (st, data, nthreads);
+}
+
+
 size_t
 dwelf_strent_off (Dwelf_Strent *se)
 {
@@ -111,6 +111,15 @@ extern Elf_Data *dwelf_strtab_finalize (Dwelf_Strtab *st,
 					Elf_Data *data)
   __nonnull_attribute__ (1, 2);
 
+/* Like dwelf_strtab_finalize, but sort and copy the strings using
+   NTHREADS threads, or one per online CPU if NTHREADS is zero.  The
+   result is identical to that of dwelf_strtab_finalize.  Small tables
+   are always finalized by the calling thread alone.  */
+extern Elf_Data *dwelf_strtab_finalize_parallel (Dwelf_Strtab *st,
+						 Elf_Data *data,
+						 unsigned int nthreads)
+  __nonnull_attribute__ (1, 2);
+
 /* Get offset in string table for string associated with entry.  Only
    valid after dwelf_strtab_finalize has been called.  */
 extern size_t dwelf_strent_off (Dwelf_Strent *se)
@@ -31,6 +31,7 @@
 #include "libelfP.h"	/* For NOTE_ALIGN.  */
 #include "libdwflP.h"
 #include <gelf.h>
+#include <fcntl.h>
 
 /* On failure return, we update *NEXT to point back at OFFSET.  */
 static inline Elf *
@@ -443,9 +444,105 @@ __libdwfl_dynamic_vaddr_get (Elf *elf, GElf_Addr *vaddrp)
   return false;
 }
 
-NEW_VERSION (dwfl_core_file_report, ELFUTILS_0.158)
-int
-dwfl_core_file_report (Dwfl *dwfl, Elf *elf, const char *executable)
+/* Return the DT_SONAME of ELF from its section headers, or NULL.  */
+
+static const char *
+elf_soname (Elf *elf)
+{
+  Elf_Scn *scn = NULL;
+  while ((scn = elf_nextscn (elf, scn)) != NULL)
+    {
+      GElf_Shdr shdr_mem;
+      GElf_Shdr *shdr = gelf_getshdr (scn, &shdr_mem);
+      if (shdr == NULL || shdr->sh_type != SHT_DYNAMIC)
+	continue;
+      Elf_Data *data = elf_getdata (scn, NULL);
+      if (data == NULL || shdr->sh_entsize == 0)
+	return NULL;
+      for (size_t i = 0; i < shdr->sh_size / shdr->sh_entsize; i++)
+	{
+	  GElf_Dyn dyn_mem;
+	  GElf_Dyn *dyn = gelf_getdyn (data, i, &dyn_mem);
+	  if (dyn == NULL || dyn->d_tag == DT_NULL)
+	    break;
+	  if (dyn->d_tag == DT_SONAME)
+	    return elf_strptr (elf, shdr->sh_link, dyn->d_un.d_val);
+	}
+      return NULL;
+    }
+  return NULL;
+}
+
+/* Report a module for each ELF file mapped at file offset zero in the
+   NT_FILE note, using the files on disk as they are.  AT_PHDR from
+   NT_AUXV tells which of them is the main program.  */
+
+static int
+report_file_mappings (Dwfl *dwfl, const char *executable,
+		      const struct dwfl_file_mapping *mappings, size_t count,
+		      GElf_Addr at_phdr)
+{
+  int listed = 0;
+  GElf_Addr reported_end = 0;
+  for (size_t i = 0; i < count; i++)
+    {
+      const struct dwfl_file_mapping *m = &mappings[i];
+      /* MAPPINGS is sorted, skip those in the last module reported.  */
+      if (m->offset != 0 || m->start < reported_end)
+	continue;
+
+      bool is_main = m->start <= at_phdr && at_phdr < m->end;
+
+      char *path = NULL;
+      if (is_main && executable != NULL)
+	path = strdup (executable);
+      else if (dwfl->sysroot != NULL)
+	{
+	  if (asprintf (&path, "%s%s", dwfl->sysroot, m->name) < 0)
+	    path = NULL;
+	}
+      else
+	path = strdup (m->name);
+      if (path == NULL)
+	{
+	  __libdwfl_seterrno (DWFL_E_NOMEM);
+	  return -1;
+	}
+
+      int fd = open (path, O_RDONLY);
+      Elf *elf = NULL;
+      if (fd < 0
+	  || __libdw_open_file (&fd, &elf, true, false) != DWFL_E_NOERROR)
+	{
+	  /* Not there, or not ELF like a locale archive.  */
+	  free (path);
+	  continue;
+	}
+
+      const char *name = elf_soname (elf) ?: m->name;
+      GElf_Ehdr ehdr_mem, *ehdr = gelf_getehdr (elf, &ehdr_mem);
+      Dwfl_Module *mod = NULL;
+      if (ehdr != NULL && (ehdr->e_type == ET_EXEC || ehdr->e_type == ET_DYN))
+	mod = __libdwfl_report_elf (dwfl, name, path, fd, elf, m->start,
+				    false, true);
+      free (path);
+      if (mod == NULL)
+	{
+	  elf_end (elf);
+	  close (fd);
+	  continue;
+	}
+      if (is_main)
+	mod->is_executable = true;
+      reported_end = mod->high_addr;
+      ++listed;
+    }
+  return listed;
+}
+
+static int
+core_file_report (Dwfl *dwfl, Elf *elf, const char *executable,
+		  bool trust_nt_file)
 {
   size_t phnum;
   if (unlikely (elf_getphdrnum (elf, &phnum) != 0))
@@ -508,6 +605,7 @@ dwfl_core_file_report (Dwfl *dwfl, Elf *elf, const char *executable)
   const void *note_file = NULL;
   size_t auxv_size = 0;
   size_t note_file_size = 0;
+  GElf_Addr at_phdr = 0;
   if (likely (notes_phdr.p_type == PT_NOTE))
     {
       /* PT_NOTE -> NT_AUXV -> AT_PHDR -> PT_DYNAMIC -> DT_DEBUG */
@@ -533,6 +631,21 @@ dwfl_core_file_report (Dwfl *dwfl, Elf *elf, const char *executable)
 		  {
 		    auxv = notes->d_buf + desc_pos;
 		    auxv_size = nhdr.n_descsz;
+		    if (trust_nt_file)
+		      {
+			Elf_Data *auxv_data
+			  = elf_getdata_rawchunk (elf, (notes_phdr.p_offset
+							+ desc_pos),
+						  auxv_size, ELF_T_AUXV);
+			GElf_auxv_t av_mem, *av;
+			for (int i = 0;
+			     auxv_data != NULL
+			     && (av = gelf_getauxv (auxv_data, i,
+						    &av_mem)) != NULL;
+			     i++)
+			  if (av->a_type == AT_PHDR)
+			    at_phdr = av->a_un.a_val;
+		      }
 		  }
 		if (nhdr.n_type == NT_FILE)
 		  {
@@ -543,6 +656,25 @@ dwfl_core_file_report (Dwfl *dwfl, Elf *elf, const char *executable)
 	}
     }
 
+  /* Decode the NT_FILE note just once for all the modules.  */
+  const unsigned char *e_ident = (const unsigned char *) elf_getident (elf,
+								       NULL);
+  size_t nfile_mappings = 0;
+  struct dwfl_file_mapping *file_mappings
+    = __libdwfl_file_note_mappings (note_file, note_file_size,
+				    e_ident[EI_CLASS], e_ident[EI_DATA],
+				    &nfile_mappings);
+
+  if (trust_nt_file && file_mappings != NULL)
+    {
+      /* Take the NT_FILE note at its word, no need to look at the
+	 dynamic linker data or at the segment contents.  */
+      int listed = report_file_mappings (dwfl, executable, file_mappings,
+					 nfile_mappings, at_phdr);
+      free (file_mappings);
+      return listed;
+    }
+
   /* Now we have NT_AUXV contents.  From here on this processing could be
      used for a live process with auxv read from /proc.  */
 
@@ -563,10 +695,11 @@ dwfl_core_file_report (Dwfl *dwfl, Elf *elf, const char *executable)
 					    &dwfl_elf_phdr_memory_callback, elf,
 					    core_file_read_eagerly, elf,
 					    elf->maximum_size,
-					    note_file, note_file_size,
+					    file_mappings, nfile_mappings,
 					    &r_debug_info);
       if (unlikely (seg < 0))
 	{
+	  free (file_mappings);
 	  clear_r_debug_info (&r_debug_info);
 	  return seg;
 	}
@@ -579,6 +712,7 @@ dwfl_core_file_report (Dwfl *dwfl, Elf *elf, const char *executable)
 	++ndx;
     }
   while (ndx < (int) phnum);
+  free (file_mappings);
 
   /* Now report the modules from dwfl_link_map_report which were not filtered
      out by dwfl_segment_report_module.  */
@@ -630,8 +764,21 @@ dwfl_core_file_report (Dwfl *dwfl, Elf *elf, const char *executable)
      error rather than just nothing found.  */
   return listed > 0 ? listed : retval;
 }
+
+NEW_VERSION (dwfl_core_file_report, ELFUTILS_0.158)
+int
+dwfl_core_file_report (Dwfl *dwfl, Elf *elf, const char *executable)
+{
+  return core_file_report (dwfl, elf, executable, false);
+}
 NEW_INTDEF (dwfl_core_file_report)
 
+int
+dwfl_core_file_report_nt_file (Dwfl *dwfl, Elf *elf, const char *executable)
+{
+  return core_file_report (dwfl, elf, executable, true);
+}
+
 #ifdef SYMBOL_VERSIONING
 int _compat_without_executable_dwfl_core_file_report (Dwfl *dwfl, Elf *elf);
 COMPAT_VERSION_NEWPROTO (dwfl_core_file_report, ELFUTILS_0.146,
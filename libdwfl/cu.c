@@ -173,7 +173,8 @@ compare_cukey (const void *a, const void *b)
 static Dwfl_Error
 intern_cu (Dwfl_Module *mod, Dwarf_Off cuoff, struct dwfl_cu **result)
 {
-  if (unlikely (cuoff + 4 >= mod->dw->sectiondata[IDX_debug_info]->d_size))
+  Elf_Data *info = __libdw_sectiondata (mod->dw, IDX_debug_info);
+  if (unlikely (info == NULL || cuoff + 4 >= info->d_size))
     {
       if (likely (mod->lazycu == 1))
 	{
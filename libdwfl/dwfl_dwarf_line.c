@@ -40,6 +40,12 @@ dwfl_dwarf_line (Dwfl_Line *line, Dwarf_Addr *bias)
     return NULL;
 
   struct dwfl_cu *cu = dwfl_linecu (line);
+  Dwfl_Error error = __libdwfl_cu_getsrclines (cu);
+  if (unlikely (error != DWFL_E_NOERROR))
+    {
+      __libdwfl_seterrno (error);
+      return NULL;
+    }
   const Dwarf_Line *info = &cu->die.cu->lines->info[line->idx];
 
   *bias = dwfl_adjusted_dwarf_addr (cu->mod, 0);
@@ -69,6 +69,36 @@ state_fetch_pc (Dwfl_Frame *state)
   abort ();
 }
 
+Dwfl_Frame *
+internal_function
+__libdwfl_frame_alloc (Dwfl_Process *process)
+{
+  pthread_mutex_lock (&process->lock);
+  Dwfl_Frame *state = process->free_frames;
+  if (state != NULL)
+    process->free_frames = state->unwound;
+  pthread_mutex_unlock (&process->lock);
+  if (state == NULL)
+    {
+      size_t nregs = ebl_frame_nregs (process->ebl);
+      state = malloc (sizeof (*state) + sizeof (*state->regs) * nregs);
+      if (state == NULL)
+	return NULL;
+    }
+  state->unwound = NULL;
+  return state;
+}
+
+void
+internal_function
+__libdwfl_frame_free (Dwfl_Process *process, Dwfl_Frame *state)
+{
+  pthread_mutex_lock (&process->lock);
+  state->unwound = process->free_frames;
+  process->free_frames = state;
+  pthread_mutex_unlock (&process->lock);
+}
+
 /* Do not call it on your own, to be used by thread_* functions only.  */
 
 static void
@@ -77,7 +107,7 @@ free_states (Dwfl_Frame *state)
   while (state)
     {
       Dwfl_Frame *next = state->unwound;
-      free(state);
+      __libdwfl_frame_free (state->thread->process, state);
       state = next;
     }
 }
@@ -91,7 +121,7 @@ state_alloc (Dwfl_Thread *thread)
   if (nregs == 0)
     return NULL;
   assert (nregs < sizeof (((Dwfl_Frame *) NULL)->regs_set) * 8);
-  Dwfl_Frame *state = malloc (sizeof (*state) + sizeof (*state->regs) * nregs);
+  Dwfl_Frame *state = __libdwfl_frame_alloc (thread->process);
   if (state == NULL)
     return NULL;
   state->thread = thread;
@@ -115,6 +145,14 @@ __libdwfl_process_free (Dwfl_Process *process)
   dwfl->process = NULL;
   if (process->ebl_close)
     ebl_closebackend (process->ebl);
+  while (process->free_frames != NULL)
+    {
+      Dwfl_Frame *state = process->free_frames;
+      process->free_frames = state->unwound;
+      free (state);
+    }
+  free (process->spare_cfi_frame);
+  pthread_mutex_destroy (&process->lock);
   free (process);
   dwfl->attacherr = DWFL_E_NOERROR;
 }
@@ -126,6 +164,11 @@ process_alloc (Dwfl *dwfl)
   Dwfl_Process *process = malloc (sizeof (*process));
   if (process == NULL)
     return;
+  if (pthread_mutex_init (&process->lock, NULL) != 0)
+    {
+      free (process);
+      return;
+    }
   process->dwfl = dwfl;
   dwfl->process = process;
 }
@@ -205,6 +248,8 @@ dwfl_attach_state (Dwfl *dwfl, Elf *elf, pid_t pid,
   process->pid = pid;
   process->callbacks = thread_callbacks;
   process->callbacks_arg = arg;
+  process->free_frames = NULL;
+  process->spare_cfi_frame = NULL;
   return true;
 }
 INTDEF(dwfl_attach_state)
@@ -436,7 +481,7 @@ dwfl_thread_getframes (Dwfl_Thread *thread,
       __libdwfl_frame_unwind (state);
       Dwfl_Frame *next = state->unwound;
       /* The old frame is no longer needed.  */
-      free (state);
+      __libdwfl_frame_free (process, state);
       state = next;
     }
   while (state && state->pc_state == DWFL_FRAME_STATE_PC_SET);
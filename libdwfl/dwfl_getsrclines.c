@@ -37,14 +37,11 @@ dwfl_getsrclines (Dwarf_Die *cudie, size_t *nlines)
 {
   struct dwfl_cu *cu = (struct dwfl_cu *) cudie;
 
-  if (cu->lines == NULL)
+  Dwfl_Error error = __libdwfl_cu_getsrclines (cu);
+  if (error != DWFL_E_NOERROR)
     {
-      Dwfl_Error error = __libdwfl_cu_getsrclines (cu);
-      if (error != DWFL_E_NOERROR)
-	{
-	  __libdwfl_seterrno (error);
-	  return -1;
-	}
+      __libdwfl_seterrno (error);
+      return -1;
     }
 
   *nlines = cu->die.cu->lines->nlines;
@@ -41,6 +41,12 @@ dwfl_lineinfo (Dwfl_Line *line, Dwarf_Addr *addr, int *linep, int *colp,
     return NULL;
 
   struct dwfl_cu *cu = dwfl_linecu (line);
+  Dwfl_Error error = __libdwfl_cu_getsrclines (cu);
+  if (unlikely (error != DWFL_E_NOERROR))
+    {
+      __libdwfl_seterrno (error);
+      return NULL;
+    }
   const Dwarf_Line *info = &cu->die.cu->lines->info[line->idx];
 
   if (addr != NULL)
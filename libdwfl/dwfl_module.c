@@ -67,6 +67,9 @@ __libdwfl_module_free (Dwfl_Module *mod)
   if (mod->aranges != NULL)
     free (mod->aranges);
 
+  if (mod->inline_chains != NULL)
+    tdestroy (mod->inline_chains, free);
+
   if (mod->cu != NULL)
     {
       for (size_t i = 0; i < mod->ncu; ++i)
@@ -111,6 +114,9 @@ __libdwfl_module_free (Dwfl_Module *mod)
     free_file (&mod->debug);
   free_file (&mod->main);
   free_file (&mod->aux_sym);
+  if (mod->aux_sym_data != NULL)
+    __libdwfl_debugdata_release (mod->aux_sym_data);
+  free (mod->symhash);
 
   if (mod->build_id_bits != NULL)
     free (mod->build_id_bits);
@@ -694,6 +694,50 @@ enum
   i_max
 };
 
+/* Fetch the .gnu.hash or .hash table found at OFFS for the dynamic
+   symbol table MOD->symdata, for dwfl_module_symbol_by_name.  The whole
+   table is read as words, the bloom filter is not used.  */
+static void
+find_dynsym_hash (Dwfl_Module *mod, GElf_Off offs[i_max], GElf_Ehdr *ehdr)
+{
+  mod->symhashdata = NULL;
+
+  GElf_Off size = 0;
+  if (offs[i_gnu_hash] != 0)
+    {
+      Elf_Data *data = elf_getdata_rawchunk (mod->main.elf, offs[i_gnu_hash],
+					     4 * sizeof (Elf32_Word),
+					     ELF_T_WORD);
+      if (data != NULL)
+	{
+	  const Elf32_Word *header = data->d_buf;
+	  if (header[1] <= mod->syments)
+	    size = ((4 + (GElf_Off) header[2] * gelf_getclass (mod->main.elf)
+		     + header[0] + mod->syments - header[1])
+		    * sizeof (Elf32_Word));
+	  mod->symhash_gnu = true;
+	}
+    }
+  if (size == 0 && offs[i_hash] != 0 && SH_ENTSIZE_HASH (ehdr) == 4)
+    {
+      Elf_Data *data = elf_getdata_rawchunk (mod->main.elf, offs[i_hash],
+					     2 * sizeof (Elf32_Word),
+					     ELF_T_WORD);
+      if (data != NULL)
+	{
+	  const Elf32_Word *header = data->d_buf;
+	  size = (2 + (GElf_Off) header[0] + header[1]) * sizeof (Elf32_Word);
+	  mod->symhash_gnu = false;
+	}
+    }
+
+  if (size != 0 && size == (size_t) size)
+    mod->symhashdata = elf_getdata_rawchunk (mod->main.elf,
+					     (mod->symhash_gnu
+					      ? offs[i_gnu_hash] : offs[i_hash]),
+					     size, ELF_T_WORD);
+}
+
 /* Translate pointers into file offsets.  ADJUST is either zero
    in case the dynamic segment wasn't adjusted or mod->main_bias.
    Will set mod->symfile if the translated offsets can be used as
@@ -815,6 +859,7 @@ translate_offs (GElf_Addr adjust,
 	{
 	  mod->symfile = &mod->main;
 	  mod->symerr = DWFL_E_NOERROR;
+	  find_dynsym_hash (mod, offs, ehdr);
 	}
     }
 }
@@ -900,6 +945,19 @@ find_dynsym (Dwfl_Module *mod)
 }
 
 
+/* Drop MOD->aux_sym and the image it was read from.  */
+static void
+end_aux_sym (Dwfl_Module *mod)
+{
+  elf_end (mod->aux_sym.elf);
+  mod->aux_sym.elf = NULL;
+  if (mod->aux_sym_data != NULL)
+    {
+      __libdwfl_debugdata_release (mod->aux_sym_data);
+      mod->aux_sym_data = NULL;
+    }
+}
+
 #if USE_LZMA
 /* Try to find the offset between the main file and .gnu_debugdata.  */
 static bool
@@ -963,90 +1021,105 @@ find_aux_sym (Dwfl_Module *mod __attribute__ ((unused)),
   if (scn == NULL)
     return;
 
-  /* Found the .gnu_debugdata section.  Uncompress the lzma image and
-     turn it into an ELF image.  */
+  /* Found the .gnu_debugdata section.  Uncompress the lzma image, or
+     take it from the cache, and turn it into an ELF image.  */
   Elf_Data *rawdata = elf_rawdata (scn, NULL);
   if (rawdata == NULL)
     return;
 
-  Dwfl_Error error;
-  void *buffer = NULL;
-  size_t size = 0;
-  error = __libdw_unlzma (-1, 0, rawdata->d_buf, rawdata->d_size,
-			  &buffer, &size);
-  if (error == DWFL_E_NOERROR)
-    {
-      if (unlikely (size == 0))
-	free (buffer);
-      else
-	{
-	  mod->aux_sym.elf = elf_memory (buffer, size);
-	  if (mod->aux_sym.elf == NULL)
-	    free (buffer);
-	  else
-	    {
-	      mod->aux_sym.fd = -1;
-	      mod->aux_sym.elf->flags |= ELF_F_MALLOCED;
-	      if (open_elf (mod, &mod->aux_sym) != DWFL_E_NOERROR)
-		return;
-	      if (! find_aux_address_sync (mod))
-		{
-		  elf_end (mod->aux_sym.elf);
-		  mod->aux_sym.elf = NULL;
-		  return;
-		}
+  void *buffer;
+  size_t size;
+  if (__libdwfl_debugdata_get (mod, rawdata, &mod->aux_sym_data,
+			       &buffer, &size) != DWFL_E_NOERROR)
+    return;
 
-	      /* So far, so good. Get minisymtab table data and cache it. */
-	      bool minisymtab = false;
-	      scn = NULL;
-	      while ((scn = elf_nextscn (mod->aux_sym.elf, scn)) != NULL)
-		{
-		  GElf_Shdr shdr_mem, *shdr = gelf_getshdr (scn, &shdr_mem);
-		  if (shdr != NULL)
-		    switch (shdr->sh_type)
-		      {
-		      case SHT_SYMTAB:
-			if (shdr->sh_entsize == 0)
-			  return;
-			minisymtab = true;
-			*aux_symscn = scn;
-			*aux_strshndx = shdr->sh_link;
-			mod->aux_syments = shdr->sh_size / shdr->sh_entsize;
-			mod->aux_first_global = shdr->sh_info;
-			if (*aux_xndxscn != NULL)
-			  return;
-			break;
-
-		      case SHT_SYMTAB_SHNDX:
-			*aux_xndxscn = scn;
-			if (minisymtab)
-			  return;
-			break;
-
-		      default:
-			break;
-		      }
-		}
+  mod->aux_sym.elf = elf_memory (buffer, size);
+  mod->aux_sym.fd = -1;
+  if (mod->aux_sym.elf == NULL
+      || open_elf (mod, &mod->aux_sym) != DWFL_E_NOERROR
+      || ! find_aux_address_sync (mod))
+    {
+      end_aux_sym (mod);
+      return;
+    }
 
-	      if (minisymtab)
-		/* We found one, though no SHT_SYMTAB_SHNDX to go with it.  */
-		return;
+  /* So far, so good. Get minisymtab table data and cache it. */
+  bool minisymtab = false;
+  scn = NULL;
+  while ((scn = elf_nextscn (mod->aux_sym.elf, scn)) != NULL)
+    {
+      GElf_Shdr shdr_mem, *shdr = gelf_getshdr (scn, &shdr_mem);
+      if (shdr != NULL)
+	switch (shdr->sh_type)
+	  {
+	  case SHT_SYMTAB:
+	    if (shdr->sh_entsize == 0)
+	      return;
+	    minisymtab = true;
+	    *aux_symscn = scn;
+	    *aux_strshndx = shdr->sh_link;
+	    mod->aux_syments = shdr->sh_size / shdr->sh_entsize;
+	    mod->aux_first_global = shdr->sh_info;
+	    if (*aux_xndxscn != NULL)
+	      return;
+	    break;
 
-	      /* We found no SHT_SYMTAB, so everything else is bogus.  */
-	      *aux_xndxscn = NULL;
-	      *aux_strshndx = 0;
-	      mod->aux_syments = 0;
-	      elf_end (mod->aux_sym.elf);
-	      mod->aux_sym.elf = NULL;
+	  case SHT_SYMTAB_SHNDX:
+	    *aux_xndxscn = scn;
+	    if (minisymtab)
 	      return;
-	    }
-	}
+	    break;
+
+	  default:
+	    break;
+	  }
     }
-  else
-    free (buffer);
+
+  if (minisymtab)
+    /* We found one, though no SHT_SYMTAB_SHNDX to go with it.  */
+    return;
+
+  /* We found no SHT_SYMTAB, so everything else is bogus.  */
+  *aux_xndxscn = NULL;
+  *aux_strshndx = 0;
+  mod->aux_syments = 0;
+  end_aux_sym (mod);
 #endif
 }
 
+/* Find the .gnu.hash or .hash section for the dynamic symbol table
+   SYMSCN, for dwfl_module_symbol_by_name.  */
+static void
+find_symscn_hash (Dwfl_Module *mod, Elf_Scn *symscn)
+{
+  mod->symhashdata = NULL;
+
+  Elf_Scn *hashscn = NULL;
+  Elf_Scn *scn = NULL;
+  while ((scn = elf_nextscn (mod->symfile->elf, scn)) != NULL)
+    {
+      GElf_Shdr shdr_mem;
+      GElf_Shdr *shdr = gelf_getshdr (scn, &shdr_mem);
+      if (shdr == NULL || shdr->sh_link != elf_ndxscn (symscn))
+	continue;
+
+      if (shdr->sh_type == SHT_GNU_HASH)
+	{
+	  hashscn = scn;
+	  mod->symhash_gnu = true;
+	  break;
+	}
+      if (shdr->sh_type == SHT_HASH && shdr->sh_entsize == 4)
+	{
+	  hashscn = scn;
+	  mod->symhash_gnu = false;
+	}
+    }
+
+  if (hashscn != NULL)
+    mod->symhashdata = elf_getdata (hashscn, NULL);
+}
+
 /* Try to find a symbol table in either MOD->main.elf or MOD->debug.elf.  */
 static void
 find_symtab (Dwfl_Module *mod)
@@ -1134,6 +1207,7 @@ find_symtab (Dwfl_Module *mod)
       mod->symdata = NULL;
       mod->syments = 0;
       mod->first_global = 0;
+      mod->symhashdata = NULL;
       mod->symerr = DWFL_E (LIBELF, elf_errno ());
       goto aux_cleanup; /* This cleans up some more and tries find_dynsym.  */
     }
@@ -1210,6 +1284,9 @@ find_symtab (Dwfl_Module *mod)
       || (size_t) mod->first_global > mod->syments)
     goto elferr;
 
+  if (shdr->sh_type == SHT_DYNSYM)
+    find_symscn_hash (mod, symscn);
+
   /* Cache any auxiliary symbol info, when it fails, just ignore aux_sym.  */
   if (aux_symscn != NULL)
     {
@@ -1219,8 +1296,7 @@ find_symtab (Dwfl_Module *mod)
 	{
 	aux_cleanup:
 	  mod->aux_syments = 0;
-	  elf_end (mod->aux_sym.elf);
-	  mod->aux_sym.elf = NULL;
+	  end_aux_sym (mod);
 	  /* We thought we had something through shdrs, but it failed...
 	     Last ditch, look for dynamic symbols without section headers.  */
 	  find_dynsym (mod);
@@ -0,0 +1,326 @@
+/* Find the inlined functions at a PC address.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of either
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at
+       your option) any later version
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at
+       your option) any later version
+
+   or both in parallel, as here.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include "libdwflP.h"
+#include "libdwP.h"
+#include <dwarf.h>
+#include <search.h>
+
+/* The chain is the same for all module addresses in [start, end): they
+   are in the same innermost scope and in the same line table row.  */
+struct inline_chain
+{
+  Dwarf_Addr start;
+  Dwarf_Addr end;
+  int nframes;
+  Dwfl_Inline_Frame frames[];
+};
+
+static int
+compare_chain (const void *a, const void *b)
+{
+  const struct inline_chain *c1 = a;
+  const struct inline_chain *c2 = b;
+
+  if (c1->end <= c2->start)
+    return -1;
+  if (c1->start >= c2->end)
+    return 1;
+  return 0;
+}
+
+static bool
+is_function (Dwarf_Die *die)
+{
+  switch (INTUSE(dwarf_tag) (die))
+    {
+    case DW_TAG_subprogram:
+    case DW_TAG_inlined_subroutine:
+    case DW_TAG_entry_point:
+      return true;
+    default:
+      return false;
+    }
+}
+
+/* Like eu-stack, prefer the linkage name.  */
+static const char *
+function_name (Dwarf_Die *die)
+{
+  Dwarf_Attribute attr;
+  const char *name;
+  name = INTUSE(dwarf_formstring)
+    (INTUSE(dwarf_attr_integrate) (die, DW_AT_MIPS_linkage_name, &attr)
+     ?: INTUSE(dwarf_attr_integrate) (die, DW_AT_linkage_name, &attr));
+  if (name == NULL)
+    name = INTUSE(dwarf_diename) (die);
+  return name;
+}
+
+static bool
+call_attr (Dwarf_Die *die, unsigned int name, Dwarf_Word *val)
+{
+  Dwarf_Attribute attr;
+  return INTUSE(dwarf_formudata) (INTUSE(dwarf_attr) (die, name, &attr),
+				  val) == 0;
+}
+
+/* Shrink [*LO, *HI) around ADDR so no range of a DIE below DIE is in
+   it.  Those would be a more inner scope for some of the addresses.  */
+static void
+exclude_children (Dwarf_Die *die, Dwarf_Addr addr,
+		  Dwarf_Addr *lo, Dwarf_Addr *hi)
+{
+  Dwarf_Die child;
+  if (INTUSE(dwarf_child) (die, &child) != 0)
+    return;
+
+  do
+    {
+      Dwarf_Addr base, begin, end;
+      ptrdiff_t offset = 0;
+      while ((offset = INTUSE(dwarf_ranges) (&child, offset, &base,
+					     &begin, &end)) > 0)
+	if (end <= addr)
+	  *lo = MAX (*lo, end);
+	else if (begin > addr)
+	  *hi = MIN (*hi, begin);
+	else
+	  {
+	    /* Overlapping scopes, only trust ADDR itself.  */
+	    *lo = addr;
+	    *hi = addr + 1;
+	  }
+      exclude_children (&child, addr, lo, hi);
+    }
+  while (INTUSE(dwarf_siblingof) (&child, &child) == 0);
+}
+
+/* Compute the chain at module address PC.  Returns its number of
+   frames, zero if there is no function DIE or -1 for errors.  */
+static int
+build_chain (Dwfl_Module *mod, Dwarf_Addr pc, struct inline_chain **chainp)
+{
+  Dwarf_Addr bias;
+  if (INTUSE(dwfl_module_getdwarf) (mod, &bias) == NULL)
+    return 0;
+
+  struct dwfl_cu *cu;
+  if (__libdwfl_addrcu (mod, pc, &cu) != DWFL_E_NOERROR)
+    return 0;
+
+  Dwarf_Addr addr = pc - bias;
+  Dwarf_Die *scopes = NULL;
+  int nscopes = INTUSE(dwarf_getscopes) (&cu->die, addr, &scopes);
+  if (nscopes < 0)
+    {
+      __libdwfl_seterrno (DWFL_E_LIBDW);
+      return -1;
+    }
+
+  int first = 0;
+  while (first < nscopes && ! is_function (&scopes[first]))
+    first++;
+  if (first == nscopes)
+    {
+      free (scopes);
+      return 0;
+    }
+
+  /* The part of the range of the innermost scope that has ADDR, less
+     the scopes nested in it.  */
+  Dwarf_Addr lo = addr;
+  Dwarf_Addr hi = addr + 1;
+  Dwarf_Addr base, begin, end;
+  ptrdiff_t offset = 0;
+  while ((offset = INTUSE(dwarf_ranges) (&scopes[0], offset, &base,
+					 &begin, &end)) > 0)
+    if (begin <= addr && addr < end)
+      {
+	lo = begin;
+	hi = end;
+	break;
+      }
+  exclude_children (&scopes[0], addr, &lo, &hi);
+
+  /* The first frame is at the source line of PC.  */
+  const char *file = NULL;
+  int line = 0;
+  int column = 0;
+  Dwfl_Line *dwfl_line = INTUSE(dwfl_module_getsrc) (mod, pc);
+  if (dwfl_line != NULL)
+    {
+      struct dwfl_cu *linecu = dwfl_linecu (dwfl_line);
+      Dwarf_Line *row = &linecu->die.cu->lines->info[dwfl_line->idx];
+      /* The last row is an end_sequence, so there is a next one.  */
+      lo = MAX (lo, row->addr);
+      hi = MIN (hi, row[1].addr);
+      file = INTUSE(dwarf_linesrc) (row, NULL, NULL);
+      line = row->line;
+      column = row->column;
+    }
+  else
+    {
+      lo = addr;
+      hi = addr + 1;
+    }
+
+  Dwarf_Die *chain_scopes;
+  int nchain = INTUSE(dwarf_getscopes_die) (&scopes[first], &chain_scopes);
+  free (scopes);
+  if (nchain <= 0)
+    {
+      __libdwfl_seterrno (DWFL_E_LIBDW);
+      return -1;
+    }
+
+  struct inline_chain *chain = malloc (sizeof *chain
+				       + nchain * sizeof chain->frames[0]);
+  if (chain == NULL)
+    {
+      free (chain_scopes);
+      __libdwfl_seterrno (DWFL_E_NOMEM);
+      return -1;
+    }
+  chain->start = lo + bias;
+  chain->end = hi + bias;
+
+  Dwarf_Files *files = NULL;
+  INTUSE(dwarf_getsrcfiles) (&cu->die, &files, NULL);
+
+  /* Each further frame is at the call site of the one before.  */
+  int n = 0;
+  Dwarf_Die *callee = NULL;
+  for (int i = 0; i < nchain; i++)
+    {
+      Dwarf_Die *scope = &chain_scopes[i];
+      if (! is_function (scope))
+	continue;
+
+      Dwfl_Inline_Frame *frame = &chain->frames[n++];
+      frame->die = *scope;
+      frame->name = function_name (scope);
+      if (callee == NULL)
+	{
+	  frame->file = file;
+	  frame->line = line;
+	  frame->column = column;
+	}
+      else
+	{
+	  Dwarf_Word val;
+	  frame->file = NULL;
+	  frame->line = frame->column = 0;
+	  if (files != NULL && call_attr (callee, DW_AT_call_file, &val))
+	    frame->file = INTUSE(dwarf_filesrc) (files, val, NULL, NULL);
+	  if (call_attr (callee, DW_AT_call_line, &val))
+	    frame->line = val;
+	  if (call_attr (callee, DW_AT_call_column, &val))
+	    frame->column = val;
+	}
+
+      /* Found the function in which everything was inlined?  */
+      if (INTUSE(dwarf_tag) (scope) == DW_TAG_subprogram)
+	break;
+      callee = &frame->die;
+    }
+  chain->nframes = n;
+  free (chain_scopes);
+
+  *chainp = chain;
+  return n;
+}
+
+int
+dwfl_module_inline_chain (Dwfl_Module *mod, Dwarf_Addr pc,
+			  Dwfl_Inline_Frame **frames)
+{
+  if (mod == NULL)
+    return -1;
+
+  struct inline_chain key = { .start = pc, .end = pc + 1 };
+  void **found = tfind (&key, &mod->inline_chains, compare_chain);
+  if (found != NULL)
+    {
+      struct inline_chain *chain = *found;
+      *frames = chain->frames;
+      return chain->nframes;
+    }
+
+  struct inline_chain *chain;
+  int n = build_chain (mod, pc, &chain);
+  if (n <= 0)
+    {
+      *frames = NULL;
+      return n;
+    }
+
+  found = tsearch (chain, &mod->inline_chains, compare_chain);
+  if (found != NULL && *found != chain)
+    {
+      /* Bogus DWARF made it overlap another chain, which cannot have
+	 PC or we had found it.  */
+      chain->start = pc;
+      chain->end = pc + 1;
+      found = tsearch (chain, &mod->inline_chains, compare_chain);
+    }
+  if (found == NULL || *found != chain)
+    {
+      free (chain);
+      __libdwfl_seterrno (DWFL_E_NOMEM);
+      *frames = NULL;
+      return -1;
+    }
+
+  *frames = chain->frames;
+  return n;
+}
+INTDEF (dwfl_module_inline_chain)
+
+int
+dwfl_frame_inline_chain (Dwfl_Frame *state, Dwfl_Inline_Frame **frames)
+{
+  Dwarf_Addr pc;
+  bool isactivation;
+  if (! INTUSE(dwfl_frame_pc) (state, &pc, &isactivation))
+    return -1;
+  if (! isactivation)
+    pc--;
+
+  Dwfl_Module *mod = INTUSE(dwfl_addrmodule) (state->thread->process->dwfl,
+					      pc);
+  if (mod == NULL)
+    {
+      *frames = NULL;
+      return 0;
+    }
+  return INTUSE(dwfl_module_inline_chain) (mod, pc, frames);
+}
@@ -0,0 +1,344 @@
+/* Find symbols in a module by name.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of either
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at
+       your option) any later version
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at
+       your option) any later version
+
+   or both in parallel, as here.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include "libdwflP.h"
+
+/* A dynamic symbol table is looked up through its own .gnu.hash or
+   .hash table, MOD->symhashdata.  For all other symbols, those of a
+   .symtab and of the auxiliary table, this hash table is built on the
+   first lookup.  */
+struct dwfl_symhash
+{
+  size_t nbuckets;
+  Elf32_Word *buckets;		/* Entry index + 1, or zero.  */
+  struct symhash_entry
+  {
+    const char *name;
+    Elf32_Word hash;		/* elf_gnu_hash of NAME.  */
+    Elf32_Word next;		/* Entry index + 1, or zero.  */
+    int ndx;			/* As for dwfl_module_getsym_info.  */
+    int rank;			/* See sym_rank.  */
+  } entries[];
+};
+
+/* The best symbol found so far for one name.  */
+struct lookup
+{
+  const char *name;
+  size_t namelen;
+  Elf32_Word hash;
+  int ndx;
+  int rank;
+};
+
+/* Like dwfl_module_addrsym, prefer global over weak over local symbols.
+   Undefined symbols, and those of sections and files, don't count.  */
+static int
+sym_rank (const GElf_Sym *sym)
+{
+  if (sym->st_shndx == SHN_UNDEF)
+    return 0;
+
+  switch (GELF_ST_TYPE (sym->st_info))
+    {
+    case STT_SECTION:
+    case STT_FILE:
+      return 0;
+    default:
+      break;
+    }
+
+  switch (GELF_ST_BIND (sym->st_info))
+    {
+    case STB_GLOBAL:
+    case STB_GNU_UNIQUE:
+      return 3;
+    case STB_WEAK:
+      return 2;
+    default:
+      return 1;
+    }
+}
+
+/* The index dwfl_module_getsym_info uses for entry TNDX of the main or
+   the auxiliary table.  This is the inverse of the mapping done by
+   __libdwfl_getsym.  */
+static int
+table_ndx (Dwfl_Module *mod, bool aux, size_t tndx)
+{
+  int skip_aux_zero = (mod->syments > 0 && mod->aux_syments > 0) ? 1 : 0;
+  if (! aux)
+    {
+      if (mod->aux_symdata == NULL || tndx < (size_t) mod->first_global)
+	return tndx;
+      return tndx + mod->aux_first_global - skip_aux_zero;
+    }
+  if (tndx < (size_t) mod->aux_first_global)
+    return tndx + mod->first_global - skip_aux_zero;
+  return tndx + mod->syments - skip_aux_zero;
+}
+
+static void
+consider (struct lookup *l, int ndx, int rank)
+{
+  if (rank > l->rank || (rank > 0 && rank == l->rank && ndx < l->ndx))
+    {
+      l->ndx = ndx;
+      l->rank = rank;
+    }
+}
+
+/* Check entry TNDX of the dynamic symbol table.  */
+static void
+consider_dynsym (Dwfl_Module *mod, struct lookup *l, size_t tndx)
+{
+  GElf_Sym sym_mem;
+  GElf_Sym *sym = gelf_getsym (mod->symdata, tndx, &sym_mem);
+  if (sym == NULL
+      || sym->st_name >= mod->symstrdata->d_size
+      || mod->symstrdata->d_size - sym->st_name <= l->namelen
+      || memcmp ((const char *) mod->symstrdata->d_buf + sym->st_name,
+		 l->name, l->namelen + 1) != 0)
+    return;
+
+  consider (l, table_ndx (mod, false, tndx), sym_rank (sym));
+}
+
+static void
+lookup_symhashdata (Dwfl_Module *mod, struct lookup *l)
+{
+  const Elf32_Word *w = mod->symhashdata->d_buf;
+  size_t nw = mod->symhashdata->d_size / sizeof (Elf32_Word);
+
+  if (mod->symhash_gnu)
+    {
+      /* nbuckets, symoffset, bloom size, bloom shift, the bloom words,
+	 the buckets, then one hash value per hashed symbol.  */
+      if (nw < 4 || w[0] == 0 || w[0] >= nw || w[2] >= nw)
+	return;
+      size_t buckets = 4 + (size_t) w[2] * gelf_getclass (mod->symfile->elf);
+      size_t chain = buckets + w[0];
+      if (chain > nw)
+	return;
+
+      Elf32_Word symoffset = w[1];
+      for (size_t i = w[buckets + l->hash % w[0]];
+	   i >= symoffset && i < mod->syments && chain + i - symoffset < nw;
+	   ++i)
+	{
+	  Elf32_Word hash = w[chain + i - symoffset];
+	  if ((hash | 1) == (l->hash | 1))
+	    consider_dynsym (mod, l, i);
+	  if ((hash & 1) != 0)
+	    break;
+	}
+    }
+  else
+    {
+      /* nbucket, nchain, the buckets, then the chains.  */
+      if (nw < 2 || w[0] == 0 || w[0] > nw - 2 || w[1] > nw - 2 - w[0])
+	return;
+      Elf32_Word nchain = w[1];
+      const Elf32_Word *chain = &w[2 + w[0]];
+
+      Elf32_Word i = w[2 + elf_hash (l->name) % w[0]];
+      for (Elf32_Word n = 0; i != STN_UNDEF && i < nchain && n < nchain;
+	   i = chain[i], ++n)
+	if (i < mod->syments)
+	  consider_dynsym (mod, l, i);
+    }
+}
+
+static void
+add_table (Dwfl_Module *mod, struct dwfl_symhash *symhash, size_t *used,
+	   bool aux)
+{
+  Elf_Data *symdata = aux ? mod->aux_symdata : mod->symdata;
+  Elf_Data *symstrdata = aux ? mod->aux_symstrdata : mod->symstrdata;
+  size_t syments = aux ? mod->aux_syments : mod->syments;
+
+  /* All names below are then terminated.  */
+  if (symstrdata->d_size == 0
+      || ((const char *) symstrdata->d_buf)[symstrdata->d_size - 1] != '\0')
+    return;
+
+  for (size_t tndx = 1; tndx < syments; ++tndx)
+    {
+      GElf_Sym sym_mem;
+      GElf_Sym *sym = gelf_getsym (symdata, tndx, &sym_mem);
+      if (sym == NULL || sym->st_name == 0
+	  || sym->st_name >= symstrdata->d_size)
+	continue;
+      int rank = sym_rank (sym);
+      if (rank == 0)
+	continue;
+
+      struct symhash_entry *entry = &symhash->entries[*used];
+      entry->name = (const char *) symstrdata->d_buf + sym->st_name;
+      entry->hash = elf_gnu_hash (entry->name);
+      entry->ndx = table_ndx (mod, aux, tndx);
+      entry->rank = rank;
+
+      Elf32_Word *bucket = &symhash->buckets[entry->hash % symhash->nbuckets];
+      entry->next = *bucket;
+      *bucket = ++*used;
+    }
+}
+
+static Dwfl_Error
+build_symhash (Dwfl_Module *mod)
+{
+  size_t n = ((mod->symhashdata == NULL ? mod->syments : 0)
+	      + (mod->aux_symdata != NULL ? mod->aux_syments : 0));
+  size_t nbuckets = n | 1;
+  if (n > UINT32_MAX - 1
+      || n > ((SIZE_MAX - sizeof (struct dwfl_symhash))
+	      / (sizeof (struct symhash_entry) + 2 * sizeof (Elf32_Word))))
+    return DWFL_E_NOMEM;
+
+  struct dwfl_symhash *symhash
+    = malloc (sizeof *symhash + n * sizeof (struct symhash_entry)
+	      + nbuckets * sizeof (Elf32_Word));
+  if (symhash == NULL)
+    return DWFL_E_NOMEM;
+  symhash->nbuckets = nbuckets;
+  symhash->buckets = (Elf32_Word *) &symhash->entries[n];
+  memset (symhash->buckets, 0, nbuckets * sizeof (Elf32_Word));
+
+  size_t used = 0;
+  if (mod->symhashdata == NULL && mod->symdata != NULL)
+    add_table (mod, symhash, &used, false);
+  if (mod->aux_symdata != NULL)
+    add_table (mod, symhash, &used, true);
+
+  mod->symhash = symhash;
+  return DWFL_E_NOERROR;
+}
+
+static void
+lookup_symhash (struct dwfl_symhash *symhash, struct lookup *l)
+{
+  for (Elf32_Word i = symhash->buckets[l->hash % symhash->nbuckets];
+       i != 0; i = symhash->entries[i - 1].next)
+    {
+      struct symhash_entry *entry = &symhash->entries[i - 1];
+      if (entry->hash == l->hash && strcmp (entry->name, l->name) == 0)
+	consider (l, entry->ndx, entry->rank);
+    }
+}
+
+/* Load the symbol tables and build MOD->symhash if it is needed.  */
+static bool
+prepare_lookup (Dwfl_Module *mod)
+{
+  if (INTUSE(dwfl_module_getsymtab) (mod) < 0)
+    return false;
+
+  if (mod->symhash == NULL
+      && (mod->symhashdata == NULL || mod->aux_symdata != NULL))
+    {
+      Dwfl_Error error = build_symhash (mod);
+      if (error != DWFL_E_NOERROR)
+	{
+	  __libdwfl_seterrno (error);
+	  return false;
+	}
+    }
+  return true;
+}
+
+static int
+find_symbol (Dwfl_Module *mod, const char *name)
+{
+  struct lookup l =
+    {
+      .name = name,
+      .namelen = strlen (name),
+      .hash = elf_gnu_hash (name),
+      .ndx = -1,
+      .rank = 0
+    };
+
+  if (mod->symhashdata != NULL)
+    lookup_symhashdata (mod, &l);
+  if (mod->symhash != NULL)
+    lookup_symhash (mod->symhash, &l);
+  return l.ndx;
+}
+
+int
+dwfl_module_symbol_by_name (Dwfl_Module *mod, const char *name,
+			    GElf_Sym *sym, GElf_Addr *addr,
+			    GElf_Word *shndxp, Elf **elfp, Dwarf_Addr *bias)
+{
+  if (mod == NULL || ! prepare_lookup (mod))
+    return -1;
+
+  int ndx = find_symbol (mod, name);
+  if (ndx < 0)
+    return -1;
+
+  bool resolved;
+  if (__libdwfl_getsym (mod, ndx, sym, addr, shndxp, elfp, bias,
+			&resolved, false) == NULL)
+    return -1;
+  return ndx;
+}
+
+int
+dwfl_module_symbols_by_name (Dwfl_Module *mod, size_t n,
+			     const char *const names[], int ndx[],
+			     GElf_Addr addrs[])
+{
+  if (mod == NULL || ! prepare_lookup (mod))
+    return -1;
+
+  int found = 0;
+  for (size_t i = 0; i < n; ++i)
+    {
+      ndx[i] = find_symbol (mod, names[i]);
+      if (addrs != NULL)
+	addrs[i] = 0;
+      if (ndx[i] < 0)
+	continue;
+
+      ++found;
+      if (addrs != NULL)
+	{
+	  GElf_Sym sym;
+	  bool resolved;
+	  if (__libdwfl_getsym (mod, ndx[i], &sym, &addrs[i], NULL, NULL,
+				NULL, &resolved, false) == NULL)
+	    return -1;
+	}
+    }
+  return found;
+}
@@ -40,14 +40,11 @@ dwfl_onesrcline (Dwarf_Die *cudie, size_t idx)
   if (cudie == NULL)
     return NULL;
 
-  if (cu->lines == NULL)
+  Dwfl_Error error = __libdwfl_cu_getsrclines (cu);
+  if (error != DWFL_E_NOERROR)
     {
-      Dwfl_Error error = __libdwfl_cu_getsrclines (cu);
-      if (error != DWFL_E_NOERROR)
-	{
-	  __libdwfl_seterrno (error);
-	  return NULL;
-	}
+      __libdwfl_seterrno (error);
+      return NULL;
     }
 
   if (idx >= cu->die.cu->lines->nlines)
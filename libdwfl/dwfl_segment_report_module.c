@@ -138,14 +138,22 @@ buf_read_ulong (unsigned char ei_data, size_t sz,
   return true;
 }
 
-/* Try to find matching entry for module from address MODULE_START to
-   MODULE_END in NT_FILE note located at NOTE_FILE of NOTE_FILE_SIZE
-   bytes in format EI_CLASS and EI_DATA.  */
+static int
+compare_file_mapping (const void *a, const void *b)
+{
+  const struct dwfl_file_mapping *m1 = a;
+  const struct dwfl_file_mapping *m2 = b;
 
-static const char *
-handle_file_note (GElf_Addr module_start, GElf_Addr module_end,
-		  unsigned char ei_class, unsigned char ei_data,
-		  const void *note_file, size_t note_file_size)
+  if (m1->start != m2->start)
+    return m1->start < m2->start ? -1 : 1;
+  return m1 < m2 ? -1 : m1 > m2;
+}
+
+struct dwfl_file_mapping *
+internal_function
+__libdwfl_file_note_mappings (const void *note_file, size_t note_file_size,
+			      unsigned char ei_class, unsigned char ei_data,
+			      size_t *countp)
 {
   if (note_file == NULL)
     return NULL;
@@ -166,49 +174,80 @@ handle_file_note (GElf_Addr module_start, GElf_Addr module_end,
   const void *ptr = note_file;
   const void *end = note_file + note_file_size;
   uint64_t count;
-  if (! buf_read_ulong (ei_data, sz, &ptr, end, &count))
-    return NULL;
-  if (! buf_read_ulong (ei_data, sz, &ptr, end, NULL)) // page_size
+  uint64_t page_size;
+  if (! buf_read_ulong (ei_data, sz, &ptr, end, &count)
+      || ! buf_read_ulong (ei_data, sz, &ptr, end, &page_size))
     return NULL;
 
   uint64_t maxcount = (size_t) (end - ptr) / (3 * sz);
-  if (count > maxcount)
+  if (count == 0 || count > maxcount)
+    return NULL;
+
+  struct dwfl_file_mapping *mappings = malloc (count * sizeof mappings[0]);
+  if (mappings == NULL)
     return NULL;
 
   /* Where file names are stored.  */
   const char *fptr = ptr + 3 * count * sz;
-
-  ssize_t firstix = -1;
-  ssize_t lastix = -1;
   for (size_t mix = 0; mix < count; mix++)
     {
       uint64_t mstart, mend, moffset;
       if (! buf_read_ulong (ei_data, sz, &ptr, fptr, &mstart)
 	  || ! buf_read_ulong (ei_data, sz, &ptr, fptr, &mend)
 	  || ! buf_read_ulong (ei_data, sz, &ptr, fptr, &moffset))
-	return NULL;
-      if (mstart == module_start && moffset == 0)
-	firstix = lastix = mix;
-      if (firstix != -1 && mstart < module_end)
-	lastix = mix;
-      if (mend >= module_end)
-	break;
+	goto invalid;
+      mappings[mix].start = mstart;
+      mappings[mix].end = mend;
+      mappings[mix].offset = moffset * page_size;
     }
-  if (firstix == -1)
-    return NULL;
-
-  const char *retval = NULL;
-  for (ssize_t mix = 0; mix <= lastix; mix++)
+  for (size_t mix = 0; mix < count; mix++)
     {
       const char *fnext = memchr (fptr, 0, (const char *) end - fptr);
       if (fnext == NULL)
-	return NULL;
-      if (mix == firstix)
-	retval = fptr;
-      if (firstix < mix && mix <= lastix && strcmp (fptr, retval) != 0)
-	return NULL;
+	goto invalid;
+      mappings[mix].name = fptr;
       fptr = fnext + 1;
     }
+
+  /* The kernel writes them in address order, but be sure.  */
+  qsort (mappings, count, sizeof mappings[0], compare_file_mapping);
+  *countp = count;
+  return mappings;
+
+ invalid:
+  free (mappings);
+  return NULL;
+}
+
+/* Try to find matching entry for module from address MODULE_START to
+   MODULE_END in the COUNT MAPPINGS of the NT_FILE note.  */
+
+static const char *
+handle_file_note (GElf_Addr module_start, GElf_Addr module_end,
+		  const struct dwfl_file_mapping *mappings, size_t count)
+{
+  size_t lo = 0;
+  size_t hi = count;
+  while (lo < hi)
+    {
+      size_t mid = (lo + hi) / 2;
+      if (mappings[mid].start < module_start)
+	lo = mid + 1;
+      else
+	hi = mid;
+    }
+  while (lo < count && mappings[lo].start == module_start
+	 && mappings[lo].offset != 0)
+    lo++;
+  if (lo == count || mappings[lo].start != module_start)
+    return NULL;
+
+  /* All of the module must be mapped from the same file.  */
+  const char *retval = mappings[lo].name;
+  for (size_t mix = lo + 1;
+       mix < count && mappings[mix].start < module_end; mix++)
+    if (strcmp (mappings[mix].name, retval) != 0)
+      return NULL;
   return retval;
 }
 
@@ -294,7 +333,8 @@ dwfl_segment_report_module (Dwfl *dwfl, int ndx, const char *name,
 			    Dwfl_Module_Callback *read_eagerly,
 			    void *read_eagerly_arg,
 			    size_t maxread,
-			    const void *note_file, size_t note_file_size,
+			    const struct dwfl_file_mapping *file_mappings,
+			    size_t nfile_mappings,
 			    const struct r_debug_info *r_debug_info)
 {
   size_t segment = ndx;
@@ -772,8 +812,8 @@ dwfl_segment_report_module (Dwfl *dwfl, int ndx, const char *name,
     }
 
   const char *file_note_name = handle_file_note (module_start, module_end,
-						 ei_class, ei_data,
-						 note_file, note_file_size);
+						 file_mappings,
+						 nfile_mappings);
   if (file_note_name)
     {
       name = file_note_name;
@@ -0,0 +1,337 @@
+/* Cache of decompressed .gnu_debugdata images.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of either
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at
+       your option) any later version
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at
+       your option) any later version
+
+   or both in parallel, as here.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include "libdwflP.h"
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "system.h"
+
+/* The images are keyed by the build ID of the main file and the size
+   of its .gnu_debugdata section.  All the modules of the process with
+   that file share one image, also across Dwfl sessions.  Images no
+   module uses any more are kept, the least recently used ones are
+   dropped when they take more than DEBUGDATA_IDLE_MAX bytes.  */
+#define DEBUGDATA_IDLE_MAX (64 * 1024 * 1024)
+
+struct dwfl_debugdata
+{
+  struct dwfl_debugdata *next;	/* Most recently used first.  */
+  unsigned int refs;
+  bool mapped;			/* IMAGE is mmap'd from the disk cache.  */
+  bool cached;			/* On the debugdata list.  */
+  void *image;
+  size_t size;
+  size_t rawsize;
+  size_t build_id_len;
+  unsigned char build_id[];
+};
+
+static pthread_mutex_t debugdata_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct dwfl_debugdata *debugdata;
+static size_t debugdata_idle;
+static char *debugdata_dir;
+
+static void
+free_debugdata (struct dwfl_debugdata *data)
+{
+  if (data->mapped)
+    munmap (data->image, data->size);
+  else
+    free (data->image);
+  free (data);
+}
+
+/* Drop idle images beyond DEBUGDATA_IDLE_MAX.  Called with the lock
+   held.  */
+static void
+trim_debugdata (void)
+{
+  size_t idle = 0;
+  for (struct dwfl_debugdata **p = &debugdata; *p != NULL; )
+    {
+      struct dwfl_debugdata *data = *p;
+      if (data->refs == 0 && idle + data->size > DEBUGDATA_IDLE_MAX)
+	{
+	  *p = data->next;
+	  free_debugdata (data);
+	  continue;
+	}
+      if (data->refs == 0)
+	idle += data->size;
+      p = &data->next;
+    }
+  debugdata_idle = idle;
+}
+
+static void __attribute__ ((destructor))
+free_debugdata_cache (void)
+{
+  struct dwfl_debugdata **p = &debugdata;
+  while (*p != NULL)
+    {
+      struct dwfl_debugdata *data = *p;
+      if (data->refs == 0)
+	{
+	  *p = data->next;
+	  free_debugdata (data);
+	}
+      else
+	p = &data->next;
+    }
+  free (debugdata_dir);
+  debugdata_dir = NULL;
+}
+
+/* The name of the image in the disk cache DIR, or NULL.  */
+static char *
+cache_file_name (const char *dir, const unsigned char *build_id,
+		 size_t build_id_len, size_t rawsize)
+{
+  size_t dirlen = strlen (dir);
+  char *name = malloc (dirlen + 1 + 2 * build_id_len
+		       + 1 + 2 * sizeof rawsize + sizeof ".debugdata");
+  if (name == NULL)
+    return NULL;
+
+  char *p = mempcpy (name, dir, dirlen);
+  *p++ = '/';
+  for (size_t i = 0; i < build_id_len; ++i)
+    p += sprintf (p, "%02x", build_id[i]);
+  sprintf (p, "-%zx.debugdata", rawsize);
+  return name;
+}
+
+/* Map the image from the disk cache.  Returns false if it is not there
+   or does not look right.  */
+static bool
+read_cache_file (const char *name, struct dwfl_debugdata *data)
+{
+  int fd = open (name, O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    return false;
+
+  struct stat st;
+  void *image = MAP_FAILED;
+  if (fstat (fd, &st) == 0 && S_ISREG (st.st_mode)
+      && (size_t) st.st_size > EI_NIDENT)
+    image = mmap (NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close (fd);
+  if (image == MAP_FAILED)
+    return false;
+
+  if (memcmp (image, ELFMAG, SELFMAG) != 0)
+    {
+      munmap (image, st.st_size);
+      return false;
+    }
+
+  data->image = image;
+  data->size = st.st_size;
+  data->mapped = true;
+  return true;
+}
+
+/* Put the image into the disk cache, as a whole or not at all.  Errors
+   are ignored, the image is just decompressed again next time.  */
+static void
+write_cache_file (const char *dir, const char *name,
+		  const struct dwfl_debugdata *data)
+{
+  char *tmpname;
+  if (asprintf (&tmpname, "%s/.debugdata.XXXXXX", dir) < 0)
+    return;
+
+  int fd = mkstemp (tmpname);
+  if (fd < 0)
+    {
+      free (tmpname);
+      return;
+    }
+
+  bool ok = (pwrite_retry (fd, data->image, data->size, 0)
+	     == (ssize_t) data->size);
+  ok = close (fd) == 0 && ok;
+  if (! ok || rename (tmpname, name) != 0)
+    unlink (tmpname);
+  free (tmpname);
+}
+
+Dwfl_Error
+internal_function
+__libdwfl_debugdata_get (Dwfl_Module *mod, Elf_Data *rawdata,
+			 struct dwfl_debugdata **datap,
+			 void **image, size_t *size)
+{
+  const unsigned char *build_id = NULL;
+  GElf_Addr vaddr;
+  int build_id_len = INTUSE(dwfl_module_build_id) (mod, &build_id, &vaddr);
+  if (build_id_len < 0)
+    build_id_len = 0;
+
+  struct dwfl_debugdata *data = NULL;
+  char *dir = NULL;
+  if (build_id_len > 0)
+    {
+      pthread_mutex_lock (&debugdata_lock);
+      for (struct dwfl_debugdata **p = &debugdata; *p != NULL;
+	   p = &(*p)->next)
+	if ((*p)->build_id_len == (size_t) build_id_len
+	    && (*p)->rawsize == rawdata->d_size
+	    && memcmp ((*p)->build_id, build_id, build_id_len) == 0)
+	  {
+	    data = *p;
+	    if (data->refs++ == 0)
+	      debugdata_idle -= data->size;
+	    /* Move it to the front.  */
+	    *p = data->next;
+	    data->next = debugdata;
+	    debugdata = data;
+	    break;
+	  }
+      if (data == NULL && debugdata_dir != NULL)
+	dir = strdup (debugdata_dir);
+      pthread_mutex_unlock (&debugdata_lock);
+
+      if (data != NULL)
+	{
+	  *datap = data;
+	  *image = data->image;
+	  *size = data->size;
+	  return DWFL_E_NOERROR;
+	}
+    }
+
+  data = malloc (sizeof *data + build_id_len);
+  if (data == NULL)
+    {
+      free (dir);
+      return DWFL_E_NOMEM;
+    }
+  data->refs = 1;
+  data->mapped = false;
+  data->cached = build_id_len > 0;
+  data->rawsize = rawdata->d_size;
+  data->build_id_len = build_id_len;
+  if (build_id_len > 0)
+    memcpy (data->build_id, build_id, build_id_len);
+
+  char *name = NULL;
+  if (dir != NULL)
+    name = cache_file_name (dir, build_id, build_id_len, rawdata->d_size);
+
+  if (name == NULL || ! read_cache_file (name, data))
+    {
+      Dwfl_Error error = DWFL_E_LZMA;
+      data->image = NULL;
+      data->size = 0;
+#if USE_LZMA
+      error = __libdw_unlzma (-1, 0, rawdata->d_buf, rawdata->d_size,
+			      &data->image, &data->size);
+#endif
+      if (error == DWFL_E_NOERROR && unlikely (data->size == 0))
+	error = DWFL_E_BADELF;
+      if (error != DWFL_E_NOERROR)
+	{
+	  free (data->image);
+	  free (data);
+	  free (name);
+	  free (dir);
+	  return error;
+	}
+      if (name != NULL)
+	write_cache_file (dir, name, data);
+    }
+  free (name);
+  free (dir);
+
+  if (data->cached)
+    {
+      pthread_mutex_lock (&debugdata_lock);
+      data->next = debugdata;
+      debugdata = data;
+      pthread_mutex_unlock (&debugdata_lock);
+    }
+
+  *datap = data;
+  *image = data->image;
+  *size = data->size;
+  return DWFL_E_NOERROR;
+}
+
+void
+internal_function
+__libdwfl_debugdata_release (struct dwfl_debugdata *data)
+{
+  if (! data->cached)
+    {
+      free_debugdata (data);
+      return;
+    }
+
+  pthread_mutex_lock (&debugdata_lock);
+  if (--data->refs == 0)
+    {
+      debugdata_idle += data->size;
+      if (debugdata_idle > DEBUGDATA_IDLE_MAX)
+	trim_debugdata ();
+    }
+  pthread_mutex_unlock (&debugdata_lock);
+}
+
+int
+dwfl_set_debugdata_cache (const char *path)
+{
+  char *dir = NULL;
+  if (path != NULL)
+    {
+      dir = realpath (path, NULL);
+      if (dir == NULL)
+	return -1;
+
+      struct stat st;
+      if (stat (dir, &st) != 0 || ! S_ISDIR (st.st_mode))
+	{
+	  free (dir);
+	  errno = ENOTDIR;
+	  return -1;
+	}
+    }
+
+  pthread_mutex_lock (&debugdata_lock);
+  char *old = debugdata_dir;
+  debugdata_dir = dir;
+  pthread_mutex_unlock (&debugdata_lock);
+  free (old);
+  return 0;
+}
@@ -31,6 +31,7 @@
 #endif
 
 #include "cfi.h"
+#include <search.h>
 #include <stdlib.h>
 #include "libdwflP.h"
 #include "dwarf.h"
@@ -86,103 +87,96 @@ bra_compar (const void *key_voidp, const void *elem_voidp)
   return (offset > op->offset) - (offset < op->offset);
 }
 
-struct eval_stack {
-  Dwarf_Addr *addrs;
-  size_t used;
-  size_t allocated;
+/* DWARF expressions are compiled to one of these per Dwarf_Op, so
+   evaluating them again neither decodes the atoms nor looks up the
+   branch targets.  */
+enum expr_code_op
+{
+  ec_push,			/* Push A.  */
+  ec_addr,			/* Push A plus the bias.  */
+  ec_reg,			/* Push register A.  */
+  ec_breg,			/* Push register A plus B.  */
+  ec_dup,
+  ec_drop,
+  ec_pick,			/* Push stack entry A.  */
+  ec_over,
+  ec_swap,
+  ec_rot,
+  ec_deref,
+  ec_deref_size,		/* A bytes, B is the address size.  */
+  ec_abs,
+  ec_neg,
+  ec_not,
+  ec_plus_uconst,		/* Add A.  */
+  ec_and,
+  ec_div,
+  ec_minus,
+  ec_mod,
+  ec_mul,
+  ec_or,
+  ec_plus,
+  ec_shl,
+  ec_shr,
+  ec_shra,
+  ec_xor,
+  ec_le,
+  ec_ge,
+  ec_eq,
+  ec_lt,
+  ec_gt,
+  ec_ne,
+  ec_bra,			/* A is the index of the target.  */
+  ec_skip,			/* Likewise.  */
+  ec_nop,
+  ec_call_frame_cfa,
+  ec_stack_value,
+  ec_unsupported,
+  ec_invalid
 };
 
-static bool
-do_push (struct eval_stack *stack, Dwarf_Addr val)
-{
-  if (stack->used >= DWARF_EXPR_STACK_MAX)
-    {
-      __libdwfl_seterrno (DWFL_E_INVALID_DWARF);
-      return false;
-    }
-  if (stack->used == stack->allocated)
-    {
-      stack->allocated = MAX (stack->allocated * 2, 32);
-      Dwarf_Addr *new_addrs;
-      new_addrs = realloc (stack->addrs,
-			   stack->allocated * sizeof (*stack->addrs));
-      if (new_addrs == NULL)
-        {
-          __libdwfl_seterrno (DWFL_E_NOMEM);
-          return false;
-        }
-      stack->addrs = new_addrs;
-    }
-  stack->addrs[stack->used++] = val;
-  return true;
-}
+/* Branch target of ec_bra and ec_skip which isn't an operation.  */
+#define EXPR_BAD_TARGET ((Dwarf_Word) -1)
 
-static bool
-do_pop (struct eval_stack *stack, Dwarf_Addr *val)
+struct expr_insn
 {
-  if (stack->used == 0)
-    {
-      __libdwfl_seterrno (DWFL_E_INVALID_DWARF);
-      return false;
-    }
-  *val = stack->addrs[--stack->used];
-  return true;
-}
-
-/* If FRAME is NULL is are computing CFI frame base.  In such case another
-   DW_OP_call_frame_cfa is no longer permitted.  */
+  enum expr_code_op code;
+  Dwarf_Word a;
+  Dwarf_Word b;
+};
 
-static bool
-expr_eval (Dwfl_Frame *state, Dwarf_Frame *frame, const Dwarf_Op *ops,
-	   size_t nops, Dwarf_Addr *result, Dwarf_Addr bias)
+/* Compiled expression in the expr_code_tree of the Dwarf_CFI.  */
+struct expr_code
 {
-  Dwfl_Process *process = state->thread->process;
-  if (nops == 0)
-    {
-      __libdwfl_seterrno (DWFL_E_INVALID_DWARF);
-      return false;
-    }
-  struct eval_stack stack =
-    {
-      .addrs = NULL,
-      .used = 0,
-      .allocated = 0
-    };
+  /* The parsed expression from the expr_tree of the Dwarf_CFI.  */
+  const Dwarf_Op *ops;
+  struct expr_insn insns[];
+};
 
-#define pop(x) do_pop(&stack, x)
-#define push(x) do_push(&stack, x)
+static void
+compile_expr (Dwarf_CFI *cfi, const Dwarf_Op *ops, size_t nops,
+	      struct expr_insn *insns)
+{
+  const unsigned addr_bytes = cfi->e_ident[EI_CLASS] == ELFCLASS32 ? 4 : 8;
 
-  Dwarf_Addr val1, val2;
-  bool is_location = false;
-  size_t steps_count = 0;
-  for (const Dwarf_Op *op = ops; op < ops + nops; op++)
+  for (size_t i = 0; i < nops; i++)
     {
-      if (++steps_count > DWARF_EXPR_STEPS_MAX)
-	{
-	  __libdwfl_seterrno (DWFL_E_INVALID_DWARF);
-	  return false;
-	}
+      const Dwarf_Op *op = &ops[i];
+      struct expr_insn *insn = &insns[i];
+      insn->a = op->number;
+      insn->b = 0;
       switch (op->atom)
-      {
-	/* DW_OP_* order matches libgcc/unwind-dw2.c execute_stack_op:  */
+	{
 	case DW_OP_lit0 ... DW_OP_lit31:
-	  if (! push (op->atom - DW_OP_lit0))
-	    {
-	      free (stack.addrs);
-	      return false;
-	    }
+	  insn->code = ec_push;
+	  insn->a = op->atom - DW_OP_lit0;
 	  break;
 	case DW_OP_addr:
-	  if (! push (op->number + bias))
-	    {
-	      free (stack.addrs);
-	      return false;
-	    }
+	  insn->code = ec_addr;
 	  break;
 	case DW_OP_GNU_encoded_addr:
 	  /* Missing support in the rest of elfutils.  */
-	  __libdwfl_seterrno (DWFL_E_UNSUPPORTED_DWARF);
-	  return false;
+	  insn->code = ec_unsupported;
+	  break;
 	case DW_OP_const1u:
 	case DW_OP_const1s:
 	case DW_OP_const2u:
@@ -193,293 +187,345 @@ expr_eval (Dwfl_Frame *state, Dwarf_Frame *frame, const Dwarf_Op *ops,
 	case DW_OP_const8s:
 	case DW_OP_constu:
 	case DW_OP_consts:
-	  if (! push (op->number))
-	    {
-	      free (stack.addrs);
-	      return false;
-	    }
+	  insn->code = ec_push;
 	  break;
 	case DW_OP_reg0 ... DW_OP_reg31:
-	  if (INTUSE (dwfl_frame_reg) (state, op->atom - DW_OP_reg0, &val1) != 0
-	      || ! push (val1))
-	    {
-	      free (stack.addrs);
-	      return false;
-	    }
+	  insn->code = ec_reg;
+	  insn->a = op->atom - DW_OP_reg0;
 	  break;
 	case DW_OP_regx:
-	  if (INTUSE (dwfl_frame_reg) (state, op->number, &val1) != 0 || ! push (val1))
-	    {
-	      free (stack.addrs);
-	      return false;
-	    }
+	  insn->code = ec_reg;
 	  break;
 	case DW_OP_breg0 ... DW_OP_breg31:
-	  if (INTUSE (dwfl_frame_reg) (state, op->atom - DW_OP_breg0, &val1) != 0)
-	    {
-	      free (stack.addrs);
-	      return false;
-	    }
-	  val1 += op->number;
-	  if (! push (val1))
-	    {
-	      free (stack.addrs);
-	      return false;
-	    }
+	  insn->code = ec_breg;
+	  insn->a = op->atom - DW_OP_breg0;
+	  insn->b = op->number;
 	  break;
 	case DW_OP_bregx:
-	  if (INTUSE (dwfl_frame_reg) (state, op->number, &val1) != 0)
-	    {
-	      free (stack.addrs);
-	      return false;
-	    }
-	  val1 += op->number2;
-	  if (! push (val1))
-	    {
-	      free (stack.addrs);
-	      return false;
-	    }
+	  insn->code = ec_breg;
+	  insn->b = op->number2;
 	  break;
-	case DW_OP_dup:
-	  if (! pop (&val1) || ! push (val1) || ! push (val1))
-	    {
-	      free (stack.addrs);
-	      return false;
-	    }
+	case DW_OP_deref_size:
+	  insn->code = ec_deref_size;
+	  insn->b = addr_bytes;
 	  break;
-	case DW_OP_drop:
-	  if (! pop (&val1))
-	    {
-	      free (stack.addrs);
-	      return false;
-	    }
+	case DW_OP_bra:
+	case DW_OP_skip:;
+	  insn->code = op->atom == DW_OP_bra ? ec_bra : ec_skip;
+	  Dwarf_Word offset = op->offset + 1 + 2 + (int16_t) op->number;
+	  const Dwarf_Op *found = bsearch ((void *) (uintptr_t) offset, ops, nops,
+					   sizeof (*ops), bra_compar);
+	  /* PPC32 vDSO has such invalid operations.  Only fail when
+	     the branch is taken.  */
+	  insn->a = found != NULL ? (Dwarf_Word) (found - ops) : EXPR_BAD_TARGET;
 	  break;
-	case DW_OP_pick:
-	  if (stack.used <= op->number)
-	    {
-	      free (stack.addrs);
-	      __libdwfl_seterrno (DWFL_E_INVALID_DWARF);
-	      return false;
-	    }
-	  if (! push (stack.addrs[stack.used - 1 - op->number]))
-	    {
-	      free (stack.addrs);
-	      return false;
-	    }
+#define SIMPLE(atom, ec)						\
+	case atom:							\
+	  insn->code = ec;						\
 	  break;
-	case DW_OP_over:
-	  if (! pop (&val1) || ! pop (&val2)
-	      || ! push (val2) || ! push (val1) || ! push (val2))
-	    {
-	      free (stack.addrs);
-	      return false;
-	    }
+	SIMPLE (DW_OP_dup, ec_dup)
+	SIMPLE (DW_OP_drop, ec_drop)
+	SIMPLE (DW_OP_pick, ec_pick)
+	SIMPLE (DW_OP_over, ec_over)
+	SIMPLE (DW_OP_swap, ec_swap)
+	SIMPLE (DW_OP_rot, ec_rot)
+	SIMPLE (DW_OP_deref, ec_deref)
+	SIMPLE (DW_OP_abs, ec_abs)
+	SIMPLE (DW_OP_neg, ec_neg)
+	SIMPLE (DW_OP_not, ec_not)
+	SIMPLE (DW_OP_plus_uconst, ec_plus_uconst)
+	SIMPLE (DW_OP_and, ec_and)
+	SIMPLE (DW_OP_div, ec_div)
+	SIMPLE (DW_OP_minus, ec_minus)
+	SIMPLE (DW_OP_mod, ec_mod)
+	SIMPLE (DW_OP_mul, ec_mul)
+	SIMPLE (DW_OP_or, ec_or)
+	SIMPLE (DW_OP_plus, ec_plus)
+	SIMPLE (DW_OP_shl, ec_shl)
+	SIMPLE (DW_OP_shr, ec_shr)
+	SIMPLE (DW_OP_shra, ec_shra)
+	SIMPLE (DW_OP_xor, ec_xor)
+	SIMPLE (DW_OP_le, ec_le)
+	SIMPLE (DW_OP_ge, ec_ge)
+	SIMPLE (DW_OP_eq, ec_eq)
+	SIMPLE (DW_OP_lt, ec_lt)
+	SIMPLE (DW_OP_gt, ec_gt)
+	SIMPLE (DW_OP_ne, ec_ne)
+	SIMPLE (DW_OP_nop, ec_nop)
+	SIMPLE (DW_OP_call_frame_cfa, ec_call_frame_cfa)
+	SIMPLE (DW_OP_stack_value, ec_stack_value)
+#undef SIMPLE
+	default:
+	  insn->code = ec_invalid;
 	  break;
-	case DW_OP_swap:
-	  if (! pop (&val1) || ! pop (&val2) || ! push (val1) || ! push (val2))
-	    {
-	      free (stack.addrs);
-	      return false;
-	    }
+	}
+    }
+}
+
+static int
+expr_code_compare (const void *p1, const void *p2)
+{
+  const struct expr_code *c1 = p1;
+  const struct expr_code *c2 = p2;
+  uintptr_t o1 = (uintptr_t) c1->ops;
+  uintptr_t o2 = (uintptr_t) c2->ops;
+  return (o1 > o2) - (o1 < o2);
+}
+
+/* Return the compiled code of OPS, which must be from the expr_tree of
+   CFI, compiling it the first time.  */
+static const struct expr_insn *
+intern_expr_code (Dwarf_CFI *cfi, const Dwarf_Op *ops, size_t nops)
+{
+  struct expr_code key = { .ops = ops };
+  struct expr_code **found = tfind (&key, &cfi->expr_code_tree,
+				    expr_code_compare);
+  if (found != NULL)
+    return (*found)->insns;
+
+  struct expr_code *code = malloc (sizeof (*code)
+				   + nops * sizeof (code->insns[0]));
+  if (code == NULL)
+    {
+      __libdwfl_seterrno (DWFL_E_NOMEM);
+      return NULL;
+    }
+  code->ops = ops;
+  compile_expr (cfi, ops, nops, code->insns);
+
+  found = tsearch (code, &cfi->expr_code_tree, expr_code_compare);
+  if (found == NULL)
+    {
+      free (code);
+      __libdwfl_seterrno (DWFL_E_NOMEM);
+      return NULL;
+    }
+  return code->insns;
+}
+
+static bool expr_eval (Dwfl_Frame *state, Dwarf_CFI *cfi, Dwarf_Frame *frame,
+		       const Dwarf_Op *ops, size_t nops, bool interned,
+		       Dwarf_Addr *result, Dwarf_Addr bias);
+
+/* If FRAME is NULL is are computing CFI frame base.  In such case another
+   DW_OP_call_frame_cfa is no longer permitted.  */
+
+static bool
+expr_run (Dwfl_Frame *state, Dwarf_CFI *cfi, Dwarf_Frame *frame,
+	  const struct expr_insn *insns, size_t ninsns,
+	  Dwarf_Addr *result, Dwarf_Addr bias)
+{
+  Dwfl_Process *process = state->thread->process;
+  Dwarf_Addr stack[DWARF_EXPR_STACK_MAX];
+  size_t used = 0;
+
+#define pop(x)								\
+  do									\
+    {									\
+      if (used == 0)							\
+	goto invalid;							\
+      x = stack[--used];						\
+    }									\
+  while (0)
+#define push(x)								\
+  do									\
+    {									\
+      Dwarf_Addr push_val = (x);					\
+      if (used == DWARF_EXPR_STACK_MAX)					\
+	goto invalid;							\
+      stack[used++] = push_val;						\
+    }									\
+  while (0)
+
+  Dwarf_Addr val1, val2, val3;
+  bool is_location = false;
+  size_t steps_count = 0;
+  size_t i = 0;
+  while (i < ninsns)
+    {
+      const struct expr_insn *insn = &insns[i++];
+      if (++steps_count > DWARF_EXPR_STEPS_MAX)
+	goto invalid;
+      switch (insn->code)
+	{
+	case ec_push:
+	  push (insn->a);
 	  break;
-	case DW_OP_rot:
-	  {
-	    Dwarf_Addr val3;
-	    if (! pop (&val1) || ! pop (&val2) || ! pop (&val3)
-		|| ! push (val1) || ! push (val3) || ! push (val2))
-	      {
-		free (stack.addrs);
-		return false;
-	      }
-	  }
-	  break;
-	case DW_OP_deref:
-	case DW_OP_deref_size:
+	case ec_addr:
+	  push (insn->a + bias);
+	  break;
+	case ec_reg:
+	  if (INTUSE (dwfl_frame_reg) (state, insn->a, &val1) != 0)
+	    return false;
+	  push (val1);
+	  break;
+	case ec_breg:
+	  if (INTUSE (dwfl_frame_reg) (state, insn->a, &val1) != 0)
+	    return false;
+	  push (val1 + insn->b);
+	  break;
+	case ec_dup:
+	  pop (val1);
+	  push (val1);
+	  push (val1);
+	  break;
+	case ec_drop:
+	  pop (val1);
+	  break;
+	case ec_pick:
+	  if (used <= insn->a)
+	    goto invalid;
+	  push (stack[used - 1 - insn->a]);
+	  break;
+	case ec_over:
+	  pop (val1);
+	  pop (val2);
+	  push (val2);
+	  push (val1);
+	  push (val2);
+	  break;
+	case ec_swap:
+	  pop (val1);
+	  pop (val2);
+	  push (val1);
+	  push (val2);
+	  break;
+	case ec_rot:
+	  pop (val1);
+	  pop (val2);
+	  pop (val3);
+	  push (val1);
+	  push (val3);
+	  push (val2);
+	  break;
+	case ec_deref:
+	case ec_deref_size:
 	  if (process->callbacks->memory_read == NULL)
 	    {
-	      free (stack.addrs);
 	      __libdwfl_seterrno (DWFL_E_INVALID_ARGUMENT);
 	      return false;
 	    }
-	  if (! pop (&val1)
-	      || ! process->callbacks->memory_read (process->dwfl, val1, &val1,
-						    process->callbacks_arg))
-	    {
-	      free (stack.addrs);
-	      return false;
-	    }
-	  if (op->atom == DW_OP_deref_size)
+	  pop (val1);
+	  if (! process->callbacks->memory_read (process->dwfl, val1, &val1,
+						 process->callbacks_arg))
+	    return false;
+	  if (insn->code == ec_deref_size)
 	    {
-	      const int elfclass = frame->cache->e_ident[EI_CLASS];
-	      const unsigned addr_bytes = elfclass == ELFCLASS32 ? 4 : 8;
-	      if (op->number > addr_bytes)
-		{
-		  free (stack.addrs);
-		  __libdwfl_seterrno (DWFL_E_INVALID_DWARF);
-		  return false;
-		}
+	      if (insn->a > insn->b)
+		goto invalid;
 #if BYTE_ORDER == BIG_ENDIAN
-	      if (op->number == 0)
+	      if (insn->a == 0)
 		val1 = 0;
 	      else
-		val1 >>= (addr_bytes - op->number) * 8;
+		val1 >>= (insn->b - insn->a) * 8;
 #else
-	      if (op->number < 8)
-		val1 &= (1ULL << (op->number * 8)) - 1;
+	      if (insn->a < 8)
+		val1 &= (1ULL << (insn->a * 8)) - 1;
 #endif
 	    }
-	  if (! push (val1))
-	    {
-	      free (stack.addrs);
-	      return false;
-	    }
+	  push (val1);
 	  break;
-#define UNOP(atom, expr)						\
-	case atom:							\
-	  if (! pop (&val1) || ! push (expr))				\
-	    {								\
-	      free (stack.addrs);					\
-	      return false;						\
-	    }								\
-	  break;
-	UNOP (DW_OP_abs, llabs ((int64_t) val1))
-	UNOP (DW_OP_neg, -(int64_t) val1)
-	UNOP (DW_OP_not, ~val1)
+#define UNOP(code, expr)						\
+	case code:							\
+	  pop (val1);							\
+	  push (expr);							\
+	  break;
+	UNOP (ec_abs, llabs ((int64_t) val1))
+	UNOP (ec_neg, -(int64_t) val1)
+	UNOP (ec_not, ~val1)
+	UNOP (ec_plus_uconst, val1 + insn->a)
 #undef UNOP
-	case DW_OP_plus_uconst:
-	  if (! pop (&val1) || ! push (val1 + op->number))
-	    {
-	      free (stack.addrs);
-	      return false;
-	    }
+#define BINOP(code, op)							\
+	case code:							\
+	  pop (val2);							\
+	  pop (val1);							\
+	  push (val1 op val2);						\
 	  break;
-#define BINOP(atom, op)							\
-	case atom:							\
-	  if (! pop (&val2) || ! pop (&val1) || ! push (val1 op val2))	\
-	    {								\
-	      free (stack.addrs);					\
-	      return false;						\
-	    }								\
+#define BINOP_SIGNED(code, op)						\
+	case code:							\
+	  pop (val2);							\
+	  pop (val1);							\
+	  push ((int64_t) val1 op (int64_t) val2);			\
 	  break;
-#define BINOP_SIGNED(atom, op)						\
-	case atom:							\
-	  if (! pop (&val2) || ! pop (&val1)				\
-	      || ! push ((int64_t) val1 op (int64_t) val2))		\
-	    {								\
-	      free (stack.addrs);					\
-	      return false;						\
-	    }								\
-	  break;
-	BINOP (DW_OP_and, &)
-	case DW_OP_div:
-	  if (! pop (&val2) || ! pop (&val1))
-	    {
-	      free (stack.addrs);
-	      return false;
-	    }
+	BINOP (ec_and, &)
+	case ec_div:
+	  pop (val2);
+	  pop (val1);
 	  if (val2 == 0)
-	    {
-	      free (stack.addrs);
-	      __libdwfl_seterrno (DWFL_E_INVALID_DWARF);
-	      return false;
-	    }
-	  if (! push ((int64_t) val1 / (int64_t) val2))
-	    {
-	      free (stack.addrs);
-	      return false;
-	    }
+	    goto invalid;
+	  push ((int64_t) val1 / (int64_t) val2);
 	  break;
-	BINOP (DW_OP_minus, -)
-	case DW_OP_mod:
-	  if (! pop (&val2) || ! pop (&val1))
-	    {
-	      free (stack.addrs);
-	      return false;
-	    }
+	BINOP (ec_minus, -)
+	case ec_mod:
+	  pop (val2);
+	  pop (val1);
 	  if (val2 == 0)
-	    {
-	      free (stack.addrs);
-	      __libdwfl_seterrno (DWFL_E_INVALID_DWARF);
-	      return false;
-	    }
-	  if (! push (val1 % val2))
-	    {
-	      free (stack.addrs);
-	      return false;
-	    }
+	    goto invalid;
+	  push (val1 % val2);
 	  break;
-	BINOP (DW_OP_mul, *)
-	BINOP (DW_OP_or, |)
-	BINOP (DW_OP_plus, +)
-	BINOP (DW_OP_shl, <<)
-	BINOP (DW_OP_shr, >>)
-	BINOP_SIGNED (DW_OP_shra, >>)
-	BINOP (DW_OP_xor, ^)
-	BINOP_SIGNED (DW_OP_le, <=)
-	BINOP_SIGNED (DW_OP_ge, >=)
-	BINOP_SIGNED (DW_OP_eq, ==)
-	BINOP_SIGNED (DW_OP_lt, <)
-	BINOP_SIGNED (DW_OP_gt, >)
-	BINOP_SIGNED (DW_OP_ne, !=)
+	BINOP (ec_mul, *)
+	BINOP (ec_or, |)
+	BINOP (ec_plus, +)
+	BINOP (ec_shl, <<)
+	BINOP (ec_shr, >>)
+	BINOP_SIGNED (ec_shra, >>)
+	BINOP (ec_xor, ^)
+	BINOP_SIGNED (ec_le, <=)
+	BINOP_SIGNED (ec_ge, >=)
+	BINOP_SIGNED (ec_eq, ==)
+	BINOP_SIGNED (ec_lt, <)
+	BINOP_SIGNED (ec_gt, >)
+	BINOP_SIGNED (ec_ne, !=)
 #undef BINOP
 #undef BINOP_SIGNED
-	case DW_OP_bra:
-	  if (! pop (&val1))
-	    {
-	      free (stack.addrs);
-	      return false;
-	    }
+	case ec_bra:
+	  pop (val1);
 	  if (val1 == 0)
 	    break;
 	  FALLTHROUGH;
-	case DW_OP_skip:;
-	  Dwarf_Word offset = op->offset + 1 + 2 + (int16_t) op->number;
-	  const Dwarf_Op *found = bsearch ((void *) (uintptr_t) offset, ops, nops,
-					   sizeof (*ops), bra_compar);
-	  if (found == NULL)
-	    {
-	      free (stack.addrs);
-	      /* PPC32 vDSO has such invalid operations.  */
-	      __libdwfl_seterrno (DWFL_E_INVALID_DWARF);
-	      return false;
-	    }
-	  /* Undo the 'for' statement increment.  */
-	  op = found - 1;
+	case ec_skip:
+	  if (insn->a == EXPR_BAD_TARGET)
+	    goto invalid;
+	  i = insn->a;
 	  break;
-	case DW_OP_nop:
+	case ec_nop:
 	  break;
-	/* DW_OP_* not listed in libgcc/unwind-dw2.c execute_stack_op:  */
-	case DW_OP_call_frame_cfa:;
+	case ec_call_frame_cfa:;
 	  // Not used by CFI itself but it is synthetized by elfutils internation.
 	  Dwarf_Op *cfa_ops;
 	  size_t cfa_nops;
 	  Dwarf_Addr cfa;
-	  if (frame == NULL
-	      || dwarf_frame_cfa (frame, &cfa_ops, &cfa_nops) != 0
-	      || ! expr_eval (state, NULL, cfa_ops, cfa_nops, &cfa, bias)
-	      || ! push (cfa))
+	  int cfa_res = -1;
+	  if (frame != NULL)
+	    {
+	      /* It interns the CFA expression in CFI.  */
+	      pthread_mutex_lock (&process->lock);
+	      cfa_res = dwarf_frame_cfa (frame, &cfa_ops, &cfa_nops);
+	      pthread_mutex_unlock (&process->lock);
+	    }
+	  if (cfa_res != 0
+	      || ! expr_eval (state, cfi, NULL, cfa_ops, cfa_nops,
+			      frame->cfa_rule == cfa_expr, &cfa, bias)
+	      || used == DWARF_EXPR_STACK_MAX)
 	    {
 	      __libdwfl_seterrno (DWFL_E_LIBDW);
-	      free (stack.addrs);
 	      return false;
 	    }
+	  push (cfa);
 	  is_location = true;
 	  break;
-	case DW_OP_stack_value:
+	case ec_stack_value:
 	  // Not used by CFI itself but it is synthetized by elfutils internation.
 	  is_location = false;
 	  break;
-	default:
-	  __libdwfl_seterrno (DWFL_E_INVALID_DWARF);
+	case ec_unsupported:
+	  __libdwfl_seterrno (DWFL_E_UNSUPPORTED_DWARF);
 	  return false;
-      }
-    }
-  if (! pop (result))
-    {
-      free (stack.addrs);
-      return false;
+	default:
+	  goto invalid;
+	}
     }
-  free (stack.addrs);
+  pop (*result);
   if (is_location)
     {
       if (process->callbacks->memory_read == NULL)
@@ -492,10 +538,58 @@ expr_eval (Dwfl_Frame *state, Dwarf_Frame *frame, const Dwarf_Op *ops,
 	return false;
     }
   return true;
+
+ invalid:
+  __libdwfl_seterrno (DWFL_E_INVALID_DWARF);
+  return false;
 #undef push
 #undef pop
 }
 
+/* Evaluate OPS from CFI.  If INTERNED, OPS is from its expr_tree and
+   the compiled code is kept.  Otherwise it is one of the few
+   operations dwarf_frame_register or dwarf_frame_cfa make up for
+   simple rules, which is compiled just for this evaluation.  */
+
+static bool
+expr_eval (Dwfl_Frame *state, Dwarf_CFI *cfi, Dwarf_Frame *frame,
+	   const Dwarf_Op *ops, size_t nops, bool interned,
+	   Dwarf_Addr *result, Dwarf_Addr bias)
+{
+  if (nops == 0)
+    {
+      __libdwfl_seterrno (DWFL_E_INVALID_DWARF);
+      return false;
+    }
+
+  if (interned)
+    {
+      Dwfl_Process *process = state->thread->process;
+      pthread_mutex_lock (&process->lock);
+      const struct expr_insn *insns = intern_expr_code (cfi, ops, nops);
+      pthread_mutex_unlock (&process->lock);
+      return (insns != NULL
+	      && expr_run (state, cfi, frame, insns, nops, result, bias));
+    }
+
+  struct expr_insn insns_mem[3];
+  struct expr_insn *insns = insns_mem;
+  if (nops > sizeof insns_mem / sizeof insns_mem[0])
+    {
+      insns = malloc (nops * sizeof insns[0]);
+      if (insns == NULL)
+	{
+	  __libdwfl_seterrno (DWFL_E_NOMEM);
+	  return false;
+	}
+    }
+  compile_expr (cfi, ops, nops, insns);
+  bool ok = expr_run (state, cfi, frame, insns, nops, result, bias);
+  if (insns != insns_mem)
+    free (insns);
+  return ok;
+}
+
 static Dwfl_Frame *
 new_unwound (Dwfl_Frame *state)
 {
@@ -505,13 +599,11 @@ new_unwound (Dwfl_Frame *state)
   Ebl *ebl = process->ebl;
   size_t nregs = ebl_frame_nregs (ebl);
   assert (nregs > 0);
-  Dwfl_Frame *unwound;
-  unwound = malloc (sizeof (*unwound) + sizeof (*unwound->regs) * nregs);
+  Dwfl_Frame *unwound = __libdwfl_frame_alloc (process);
   if (unlikely (unwound == NULL))
     return NULL;
   state->unwound = unwound;
   unwound->thread = thread;
-  unwound->unwound = NULL;
   unwound->signal_frame = false;
   unwound->initial_frame = false;
   unwound->pc_state = DWFL_FRAME_STATE_ERROR;
@@ -527,8 +619,12 @@ new_unwound (Dwfl_Frame *state)
 static void
 handle_cfi (Dwfl_Frame *state, Dwarf_Addr pc, Dwarf_CFI *cfi, Dwarf_Addr bias)
 {
+  Dwfl_Process *process = state->thread->process;
   Dwarf_Frame *frame;
-  if (INTUSE(dwarf_cfi_addrframe) (cfi, pc, &frame) != 0)
+  pthread_mutex_lock (&process->lock);
+  int err = __libdw_cfi_addrframe (cfi, pc, &frame, &process->spare_cfi_frame);
+  pthread_mutex_unlock (&process->lock);
+  if (err != 0)
     {
       __libdwfl_seterrno (DWFL_E_LIBDW);
       return;
@@ -538,12 +634,10 @@ handle_cfi (Dwfl_Frame *state, Dwarf_Addr pc, Dwarf_CFI *cfi, Dwarf_Addr bias)
   if (unwound == NULL)
     {
       __libdwfl_seterrno (DWFL_E_NOMEM);
-      return;
+      goto out;
     }
 
   unwound->signal_frame = frame->fde->cie->signal_frame;
-  Dwfl_Thread *thread = state->thread;
-  Dwfl_Process *process = thread->process;
   Ebl *ebl = process->ebl;
   size_t nregs = ebl_frame_nregs (ebl);
   assert (nregs > 0);
@@ -554,15 +648,19 @@ handle_cfi (Dwfl_Frame *state, Dwarf_Addr pc, Dwarf_CFI *cfi, Dwarf_Addr bias)
   if (! ebl_dwarf_to_regno (ebl, &ra))
     {
       __libdwfl_seterrno (DWFL_E_INVALID_REGISTER);
-      return;
+      goto out;
     }
 
   for (unsigned regno = 0; regno < nregs; regno++)
     {
       Dwarf_Op reg_ops_mem[3], *reg_ops;
       size_t reg_nops;
-      if (dwarf_frame_register (frame, regno, reg_ops_mem, &reg_ops,
-				&reg_nops) != 0)
+      /* It interns expressions in CFI.  */
+      pthread_mutex_lock (&process->lock);
+      err = dwarf_frame_register (frame, regno, reg_ops_mem, &reg_ops,
+				  &reg_nops);
+      pthread_mutex_unlock (&process->lock);
+      if (err != 0)
 	{
 	  __libdwfl_seterrno (DWFL_E_LIBDW);
 	  continue;
@@ -589,7 +687,8 @@ handle_cfi (Dwfl_Frame *state, Dwarf_Addr pc, Dwarf_CFI *cfi, Dwarf_Addr bias)
 	      continue;
 	    }
 	}
-      else if (! expr_eval (state, frame, reg_ops, reg_nops, &regval, bias))
+      else if (! expr_eval (state, cfi, frame, reg_ops, reg_nops,
+			    reg_ops != reg_ops_mem, &regval, bias))
 	{
 	  /* PPC32 vDSO has various invalid operations, ignore them.  The
 	     register will look as unset causing an error later, if used.
@@ -659,7 +758,14 @@ handle_cfi (Dwfl_Frame *state, Dwarf_Addr pc, Dwarf_CFI *cfi, Dwarf_Addr bias)
 	    unwound->pc_state = DWFL_FRAME_STATE_PC_UNDEFINED;
 	}
     }
-  free (frame);
+
+ out:
+  /* Keep FRAME for the next lookup to fill in.  */
+  pthread_mutex_lock (&process->lock);
+  Dwarf_Frame *old_frame = process->spare_cfi_frame;
+  process->spare_cfi_frame = frame;
+  pthread_mutex_unlock (&process->lock);
+  free (old_frame);
 }
 
 static bool
@@ -719,20 +825,28 @@ __libdwfl_frame_unwind (Dwfl_Frame *state)
      Then we need to unwind from the original, unadjusted PC.  */
   if (! state->initial_frame && ! state->signal_frame)
     pc--;
-  Dwfl_Module *mod = INTUSE(dwfl_addrmodule) (state->thread->process->dwfl, pc);
+  /* The modules, their files and CFI are loaded on first use.  */
+  Dwfl_Process *process = state->thread->process;
+  pthread_mutex_lock (&process->lock);
+  Dwfl_Module *mod = INTUSE(dwfl_addrmodule) (process->dwfl, pc);
+  Dwarf_Addr bias_eh;
+  Dwarf_CFI *cfi_eh = (mod == NULL ? NULL
+		       : INTUSE(dwfl_module_eh_cfi) (mod, &bias_eh));
+  pthread_mutex_unlock (&process->lock);
   if (mod == NULL)
     __libdwfl_seterrno (DWFL_E_NO_DWARF);
   else
     {
-      Dwarf_Addr bias;
-      Dwarf_CFI *cfi_eh = INTUSE(dwfl_module_eh_cfi) (mod, &bias);
       if (cfi_eh)
 	{
-	  handle_cfi (state, pc - bias, cfi_eh, bias);
+	  handle_cfi (state, pc - bias_eh, cfi_eh, bias_eh);
 	  if (state->unwound)
 	    return;
 	}
+      Dwarf_Addr bias;
+      pthread_mutex_lock (&process->lock);
       Dwarf_CFI *cfi_dwarf = INTUSE(dwfl_module_dwarf_cfi) (mod, &bias);
+      pthread_mutex_unlock (&process->lock);
       if (cfi_dwarf)
 	{
 	  handle_cfi (state, pc - bias, cfi_dwarf, bias);
@@ -741,8 +855,6 @@ __libdwfl_frame_unwind (Dwfl_Frame *state)
 	}
     }
   assert (state->unwound == NULL);
-  Dwfl_Thread *thread = state->thread;
-  Dwfl_Process *process = thread->process;
   Ebl *ebl = process->ebl;
   if (new_unwound (state) == NULL)
     {
@@ -757,7 +869,7 @@ __libdwfl_frame_unwind (Dwfl_Frame *state)
       // Discard the unwind attempt.  During next __libdwfl_frame_unwind call
       // we may have for example the appropriate Dwfl_Module already mapped.
       assert (state->unwound->unwound == NULL);
-      free (state->unwound);
+      __libdwfl_frame_free (process, state->unwound);
       state->unwound = NULL;
       // __libdwfl_seterrno has been called above.
       return;
@@ -365,6 +365,17 @@ extern int dwfl_linux_kernel_report_offline (Dwfl *dwfl, const char *release,
    errors.  */
 extern int dwfl_core_file_report (Dwfl *dwfl, Elf *elf, const char *executable);
 
+/* Like dwfl_core_file_report, but report just the ELF files mapped at
+   file offset zero in the NT_FILE note of the core file, as they are
+   found on disk (under the sysroot, if set).  The link_map chain and the
+   contents of the dumped segments are not looked at, so this is much
+   faster for cores with many modules, but it trusts the files on disk to
+   be the ones that were mapped and does not report the vDSO.  EXECUTABLE,
+   if not NULL, is used for the main program.  Without an NT_FILE note this
+   does the same as dwfl_core_file_report.  */
+extern int dwfl_core_file_report_nt_file (Dwfl *dwfl, Elf *elf,
+					  const char *executable);
+
 /* Call dwfl_report_module for each file mapped into the address space of PID.
    Returns zero on success, -1 if dwfl_report_module failed,
    or an errno code if opening the proc files failed.  */
@@ -476,6 +487,30 @@ extern const char *dwfl_module_getsym_info (Dwfl_Module *mod, int ndx,
 					    Elf **elfp, Dwarf_Addr *bias)
   __nonnull_attribute__ (3, 4);
 
+/* Find the symbol called NAME in the module's symbol tables.  Returns
+   its index as used by dwfl_module_getsym_info and fills in *SYM,
+   *ADDR, *SHNDXP, *ELFP and *BIAS as that does, or returns -1 if there
+   is no such symbol or on errors.  Undefined symbols and those for
+   sections and files are not considered.  If several symbols have the
+   name, a global one is preferred over a weak one over a local one.
+   Dynamic symbol tables are searched with their .gnu.hash or .hash
+   table, for other tables a hash table is built on first use.  */
+extern int dwfl_module_symbol_by_name (Dwfl_Module *mod, const char *name,
+				       GElf_Sym *sym, GElf_Addr *addr,
+				       GElf_Word *shndxp,
+				       Elf **elfp, Dwarf_Addr *bias)
+  __nonnull_attribute__ (2, 3);
+
+/* Find the N symbols NAMES[] as dwfl_module_symbol_by_name does.  Sets
+   NDX[I] to the index of symbol NAMES[I], or to -1 if there is none,
+   and ADDRS[I], if ADDRS is not NULL, to its address as the ADDR of
+   dwfl_module_getsym_info, or to zero.  Returns the number of symbols
+   found, or -1 on errors.  */
+extern int dwfl_module_symbols_by_name (Dwfl_Module *mod, size_t n,
+					const char *const names[], int ndx[],
+					GElf_Addr addrs[])
+  __nonnull_attribute__ (3, 4);
+
 /* Find the symbol that ADDRESS lies inside, and return its name.  */
 extern const char *dwfl_module_addrname (Dwfl_Module *mod, GElf_Addr address);
 
@@ -781,7 +816,13 @@ int dwfl_getthreads (Dwfl *dwfl,
    a zero.  Keeps calling the callback with the next frame while the callback
    returns DWARF_CB_OK, till there are no more frames.  On start will call the
    set_initial_registers callback and on return will call the detach_thread
-   callback of the Dwfl_Thread.  */
+   callback of the Dwfl_Thread.
+
+   Several threads may unwind threads of the same DWFL at the same time if
+   its thread callbacks allow it, as those of dwfl_core_file_attach do.
+   Those of dwfl_linux_proc_attach do not.  The DWFL must not be changed
+   meanwhile, and CALLBACK must not use DWFL other than through the
+   Dwfl_Frame and Dwfl_Thread functions.  */
 int dwfl_thread_getframes (Dwfl_Thread *thread,
 			   int (*callback) (Dwfl_Frame *state, void *arg),
 			   void *arg)
@@ -791,7 +832,9 @@ int dwfl_thread_getframes (Dwfl_Thread *thread,
    identifier number.  Returns zero if all frames have been processed
    by the callback, returns -1 on error (and when no thread with
    the given thread id number exists), or the value of the callback
-   when not DWARF_CB_OK.  -1 returned on error will set dwfl_errno ().  */
+   when not DWARF_CB_OK.  -1 returned on error will set dwfl_errno ().
+   It may be called by several threads at the same time as described for
+   dwfl_thread_getframes.  */
 int dwfl_getthread_frames (Dwfl *dwfl, pid_t tid,
 			   int (*callback) (Dwfl_Frame *thread, void *arg),
 			   void *arg)
@@ -811,6 +854,39 @@ bool dwfl_frame_pc (Dwfl_Frame *state, Dwarf_Addr *pc, bool *isactivation)
 int dwfl_frame_reg (Dwfl_Frame *state, unsigned regno, Dwarf_Word *val)
   __nonnull_attribute__ (1);
 
+/* One function in the chain of inlined functions at an address.  */
+typedef struct
+{
+  /* The DW_TAG_inlined_subroutine, DW_TAG_subprogram or
+     DW_TAG_entry_point DIE of the function.  */
+  Dwarf_Die die;
+  /* Its linkage name, or its name if it has none.  Might be NULL.  */
+  const char *name;
+  /* Where in the function we are: the source line of the address for
+     the first function, the call site of the function before for the
+     others.  FILE is NULL and LINE and COLUMN are zero if unknown.  */
+  const char *file;
+  int line;
+  int column;
+} Dwfl_Inline_Frame;
+
+/* Find the functions at module address PC, from the innermost inlined
+   function to the DW_TAG_subprogram it was inlined into, and store
+   them in *FRAMES.  The result is cached for the addresses around PC
+   in the same scope and source line, and stays valid as long as MOD.
+   It must not be changed or freed by the caller.  Returns the number
+   of functions, zero if there is no debug info for a function at PC,
+   or -1 on error.  */
+extern int dwfl_module_inline_chain (Dwfl_Module *mod, Dwarf_Addr pc,
+				     Dwfl_Inline_Frame **frames)
+  __nonnull_attribute__ (3);
+
+/* Like dwfl_module_inline_chain for the PC of frame STATE, less one
+   if STATE is not an activation, in the module that has it.  */
+extern int dwfl_frame_inline_chain (Dwfl_Frame *state,
+				    Dwfl_Inline_Frame **frames)
+  __nonnull_attribute__ (1, 2);
+
 /* Return the internal debuginfod-client connection handle for the DWFL session.
    When the client connection has not yet been initialized, it will be done on the
    first call to this function. If elfutils is compiled without support for debuginfod,
@@ -824,6 +900,14 @@ extern debuginfod_client *dwfl_get_debuginfod_client (Dwfl *dwfl);
 int dwfl_set_sysroot (Dwfl *dwfl, const char *sysroot)
   __nonnull_attribute__ (1);
 
+/* The minidebuginfo in the .gnu_debugdata section of a module is only
+   decompressed once per process, and shared between all Dwfl sessions.
+   Keep the decompressed images in the directory PATH too, where they
+   are found again by other processes.  Passing NULL turns this off,
+   which is the default.  Returns 0 on success, -1 and sets errno if
+   PATH is not a directory.  */
+extern int dwfl_set_debugdata_cache (const char *path);
+
 #ifdef __cplusplus
 }
 #endif
@@ -187,6 +187,11 @@ struct Dwfl_Module
   Elf_Data *aux_symstrdata;	/* Data for aux_sym string table.  */
   Elf_Data *symxndxdata;	/* Data in the extended section index table. */
   Elf_Data *aux_symxndxdata;	/* Data in the extended auxiliary table. */
+  struct dwfl_debugdata *aux_sym_data; /* Image aux_sym.elf reads.  */
+  Elf_Data *symhashdata;	/* .gnu.hash or .hash for a dynamic symdata.  */
+  bool symhash_gnu;		/* symhashdata is .gnu.hash.  */
+  struct dwfl_symhash *symhash;	/* Names of the other symbols, built by
+				   dwfl_module_symbol_by_name.  */
 
   char *elfpath;		/* The path where we found the main Elf.  */
 
@@ -216,6 +221,8 @@ struct Dwfl_Module
   Dwarf_CFI *dwarf_cfi;		/* Cached DWARF CFI for this module.  */
   Dwarf_CFI *eh_cfi;		/* Cached EH CFI for this module.  */
 
+  void *inline_chains;		/* Cached dwfl_module_inline_chain results.  */
+
   int segment;			/* Index of first segment table entry.  */
   bool gc;			/* Mark/sweep flag.  */
   bool is_executable;		/* Use Dwfl::executable_for_core?  */
@@ -232,6 +239,16 @@ struct Dwfl_Process
   void *callbacks_arg;
   struct ebl *ebl;
   bool ebl_close:1;
+  /* Frames no longer used, chained by their unwound field.  New frames
+     are taken from here before allocating them.  */
+  Dwfl_Frame *free_frames;
+  /* The Dwarf_Frame of the last CFI lookup, reused for the next.  */
+  Dwarf_Frame *spare_cfi_frame;
+  /* Several threads may unwind at the same time.  This protects the
+     fields above and everything the unwinder caches in the modules and
+     their Dwarf_CFI.  Memory reads and the frame callbacks run without
+     it.  */
+  pthread_mutex_t lock;
 };
 
 /* See its typedef in libdwfl.h.  */
@@ -550,6 +567,8 @@ extern int __libdwfl_open_by_build_id (Dwfl_Module *mod, bool debug,
 
 extern uint32_t __libdwfl_crc32 (uint32_t crc, unsigned char *buf, size_t len)
   attribute_hidden;
+extern uint32_t __libdwfl_crc32_combine (uint32_t crc1, uint32_t crc2,
+					 uint64_t len2) attribute_hidden;
 extern int __libdwfl_crc32_file (int fd, uint32_t *resp) attribute_hidden;
 
 
@@ -592,6 +611,15 @@ extern void __libdwfl_process_free (Dwfl_Process *process)
 extern void __libdwfl_frame_unwind (Dwfl_Frame *state)
   internal_function;
 
+/* Get a frame with room for the registers of PROCESS, reusing one from
+   its free_frames.  Only the thread and unwound fields are set.  */
+extern Dwfl_Frame *__libdwfl_frame_alloc (Dwfl_Process *process)
+  internal_function;
+
+/* Put STATE, which is no longer used, on the free_frames of PROCESS.  */
+extern void __libdwfl_frame_free (Dwfl_Process *process, Dwfl_Frame *state)
+  internal_function;
+
 /* Align segment START downwards or END upwards addresses according to DWFL.  */
 extern GElf_Addr __libdwfl_segment_start (Dwfl *dwfl, GElf_Addr start)
   internal_function;
@@ -616,6 +644,19 @@ extern Dwfl_Error __libdw_unzstd (int fd, off_t start_offset,
 				  void **whole, size_t *whole_size)
   internal_function;
 
+/* Get the decompressed image of the .gnu_debugdata section RAWDATA of
+   the main file of MOD, from the process-wide cache if possible.  Sets
+   *IMAGE and *SIZE, and *DATAP for __libdwfl_debugdata_release once
+   the image is no longer used.  */
+struct dwfl_debugdata;
+extern Dwfl_Error __libdwfl_debugdata_get (Dwfl_Module *mod,
+					   Elf_Data *rawdata,
+					   struct dwfl_debugdata **datap,
+					   void **image, size_t *size)
+  internal_function;
+extern void __libdwfl_debugdata_release (struct dwfl_debugdata *data)
+  internal_function;
+
 /* Skip the image header before a file image: updates *START_OFFSET.  */
 extern Dwfl_Error __libdw_image_header (int fd, off_t *start_offset,
 					void *mapped, size_t mapped_size)
@@ -690,6 +731,24 @@ struct r_debug_info_module
   char name[0];
 };
 
+/* One file mapping from the NT_FILE note of a core file.  */
+struct dwfl_file_mapping
+{
+  GElf_Addr start;
+  GElf_Addr end;
+  GElf_Off offset;		/* In bytes, not pages.  */
+  const char *name;		/* Points into the note.  */
+};
+
+/* Decode the NT_FILE note at NOTE_FILE of NOTE_FILE_SIZE bytes in format
+   EI_CLASS and EI_DATA.  Returns a malloc'd array of *COUNTP mappings,
+   sorted by address, or NULL if there are none or the note is bad.  */
+extern struct dwfl_file_mapping *
+__libdwfl_file_note_mappings (const void *note_file, size_t note_file_size,
+			      unsigned char ei_class, unsigned char ei_data,
+			      size_t *countp)
+  internal_function;
+
 /* Information gathered from DT_DEBUG by dwfl_link_map_report hinted to
    dwfl_segment_report_module.  */
 struct r_debug_info
@@ -706,8 +765,9 @@ extern int dwfl_segment_report_module (Dwfl *dwfl, int ndx, const char *name,
 				       Dwfl_Module_Callback *read_eagerly,
 				       void *read_eagerly_arg,
 				       size_t maxread,
-				       const void *note_file,
-				       size_t note_file_size,
+				       const struct dwfl_file_mapping
+				         *file_mappings,
+				       size_t nfile_mappings,
 				       const struct r_debug_info *r_debug_info);
 
 /* Report a module for entry in the dynamic linker's struct link_map list.
@@ -757,6 +817,7 @@ INTDECL (dwfl_module_getsym_info)
 INTDECL (dwfl_module_getsymtab)
 INTDECL (dwfl_module_getsymtab_first_global)
 INTDECL (dwfl_module_getsrc)
+INTDECL (dwfl_module_inline_chain)
 INTDECL (dwfl_module_report_build_id)
 INTDECL (dwfl_report_elf)
 INTDECL (dwfl_report_begin)
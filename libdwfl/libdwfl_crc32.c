@@ -30,5 +30,6 @@
 #endif
 
 #define crc32 attribute_hidden __libdwfl_crc32
+#define crc32_combine attribute_hidden __libdwfl_crc32_combine
 #include <libdwflP.h>
 #include "../lib/crc32.c"
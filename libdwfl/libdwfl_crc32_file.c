@@ -31,5 +31,6 @@
 
 #define crc32_file attribute_hidden __libdwfl_crc32_file
 #define crc32 __libdwfl_crc32
+#define crc32_combine __libdwfl_crc32_combine
 #include <libdwflP.h>
 #include "../lib/crc32_file.c"
@@ -37,13 +37,15 @@ Dwfl_Error
 internal_function
 __libdwfl_cu_getsrclines (struct dwfl_cu *cu)
 {
+  /* Even when we have our lines, libdw might have evicted its line
+     table for the memory budget.  Then this reads it again.  */
+  Dwarf_Lines *lines;
+  size_t nlines;
+  if (INTUSE(dwarf_getsrclines) (&cu->die, &lines, &nlines) != 0)
+    return DWFL_E_LIBDW;
+
   if (cu->lines == NULL)
     {
-      Dwarf_Lines *lines;
-      size_t nlines;
-      if (INTUSE(dwarf_getsrclines) (&cu->die, &lines, &nlines) != 0)
-	return DWFL_E_LIBDW;
-
       cu->lines = malloc (offsetof (struct Dwfl_Lines, idx[nlines]));
       if (cu->lines == NULL)
 	return DWFL_E_NOMEM;
@@ -36,18 +36,28 @@
 
 #include "memory-access.h"
 
+/* One NT_PRSTATUS note.  Its address is the thread_arg of the thread.  */
+struct core_thread
+{
+  pid_t tid;
+  size_t note_offset;
+};
+
 struct core_arg
 {
   Elf *core;
   Elf_Data *note_data;
-  size_t thread_note_offset;
   Ebl *ebl;
-};
 
-struct thread_arg
-{
-  struct core_arg *core_arg;
-  size_t note_offset;
+  /* The threads in note order, and sorted by TID for get_thread.
+     Nothing here changes after dwfl_core_file_attach.  */
+  struct core_thread *threads;
+  struct core_thread **threads_by_tid;
+  size_t nthreads;
+
+  /* elf_getdata_rawchunk caches its chunks in CORE, so memory reads
+     of threads unwound at the same time take turns.  */
+  pthread_mutex_t read_lock;
 };
 
 static bool
@@ -58,7 +68,7 @@ core_memory_read (Dwfl *dwfl, Dwarf_Addr addr, Dwarf_Word *result,
   struct core_arg *core_arg = dwfl_arg;
   Elf *core = core_arg->core;
   assert (core != NULL);
-  static size_t phnum;
+  size_t phnum;
   if (elf_getphdrnum (core, &phnum) < 0)
     {
       __libdwfl_seterrno (DWFL_E_LIBELF);
@@ -77,8 +87,10 @@ core_memory_read (Dwfl *dwfl, Dwarf_Addr addr, Dwarf_Word *result,
       if (addr < start || addr + bytes > end)
 	continue;
       Elf_Data *data;
+      pthread_mutex_lock (&core_arg->read_lock);
       data = elf_getdata_rawchunk (core, phdr->p_offset + addr - start,
 				   bytes, ELF_T_ADDR);
+      pthread_mutex_unlock (&core_arg->read_lock);
       if (data == NULL)
 	{
 	  __libdwfl_seterrno (DWFL_E_LIBELF);
@@ -100,77 +112,78 @@ core_next_thread (Dwfl *dwfl __attribute__ ((unused)), void *dwfl_arg,
 		  void **thread_argp)
 {
   struct core_arg *core_arg = dwfl_arg;
-  Elf *core = core_arg->core;
-  GElf_Nhdr nhdr;
-  size_t name_offset;
-  size_t desc_offset;
-  Elf_Data *note_data = core_arg->note_data;
-  size_t offset;
+  struct core_thread *thread = *thread_argp;
+  thread = thread == NULL ? core_arg->threads : thread + 1;
+  if (thread == core_arg->threads + core_arg->nthreads)
+    return 0;
+  *thread_argp = thread;
+  return thread->tid;
+}
+
+static int
+compare_core_thread (const void *a, const void *b)
+{
+  const struct core_thread *t1 = *(const struct core_thread **) a;
+  const struct core_thread *t2 = *(const struct core_thread **) b;
 
-  struct thread_arg *thread_arg;
-  if (*thread_argp == NULL)
+  if (t1->tid != t2->tid)
+    return t1->tid < t2->tid ? -1 : 1;
+  /* Keep the first note of a TID first.  */
+  return t1 < t2 ? -1 : t1 > t2;
+}
+
+static bool
+core_get_thread (Dwfl *dwfl __attribute__ ((unused)), pid_t tid,
+		 void *dwfl_arg, void **thread_argp)
+{
+  struct core_arg *core_arg = dwfl_arg;
+  size_t lo = 0;
+  size_t hi = core_arg->nthreads;
+  while (lo < hi)
     {
-      core_arg->thread_note_offset = 0;
-      thread_arg = malloc (sizeof (*thread_arg));
-      if (thread_arg == NULL)
-	{
-	  __libdwfl_seterrno (DWFL_E_NOMEM);
-	  return -1;
-	}
-      thread_arg->core_arg = core_arg;
-      *thread_argp = thread_arg;
+      size_t mid = (lo + hi) / 2;
+      if (core_arg->threads_by_tid[mid]->tid < tid)
+	lo = mid + 1;
+      else
+	hi = mid;
     }
-  else
-    thread_arg = (struct thread_arg *) *thread_argp;
-
-  while (offset = core_arg->thread_note_offset, offset < note_data->d_size
-	 && (core_arg->thread_note_offset = gelf_getnote (note_data, offset,
-							  &nhdr, &name_offset,
-							  &desc_offset)) > 0)
+  if (lo == core_arg->nthreads || core_arg->threads_by_tid[lo]->tid != tid)
     {
-      /* Do not check NAME for now, help broken Linux kernels.  */
-      const char *name = (nhdr.n_namesz == 0
-			  ? "" : note_data->d_buf + name_offset);
-      const char *desc = note_data->d_buf + desc_offset;
-      GElf_Word regs_offset;
-      size_t nregloc;
-      const Ebl_Register_Location *reglocs;
-      size_t nitems;
-      const Ebl_Core_Item *items;
-      if (! ebl_core_note (core_arg->ebl, &nhdr, name, desc,
-			   &regs_offset, &nregloc, &reglocs, &nitems, &items))
-	{
-	  /* This note may be just not recognized, skip it.  */
-	  continue;
-	}
-      if (nhdr.n_type != NT_PRSTATUS)
-	continue;
-      const Ebl_Core_Item *item;
-      for (item = items; item < items + nitems; item++)
-	if (strcmp (item->name, "pid") == 0)
-	  break;
-      if (item == items + nitems)
-	continue;
-      uint32_t val32 = read_4ubyte_unaligned_noncvt (desc + item->offset);
-      val32 = (elf_getident (core, NULL)[EI_DATA] == ELFDATA2MSB
-		? be32toh (val32) : le32toh (val32));
-      pid_t tid = (int32_t) val32;
-      eu_static_assert (sizeof val32 <= sizeof tid);
-      thread_arg->note_offset = offset;
-      return tid;
+      errno = ESRCH;
+      __libdwfl_seterrno (DWFL_E_ERRNO);
+      return false;
     }
+  *thread_argp = core_arg->threads_by_tid[lo];
+  return true;
+}
 
-  free (thread_arg);
-  return 0;
+/* Return the "pid" item of the NT_PRSTATUS or NT_PRPSINFO note at DESC,
+   or -1 if it has none.  */
+static pid_t
+core_note_pid (Elf *core, const char *desc,
+	       const Ebl_Core_Item *items, size_t nitems)
+{
+  const Ebl_Core_Item *item;
+  for (item = items; item < items + nitems; item++)
+    if (strcmp (item->name, "pid") == 0)
+      break;
+  if (item == items + nitems)
+    return -1;
+  uint32_t val32 = read_4ubyte_unaligned_noncvt (desc + item->offset);
+  val32 = (elf_getident (core, NULL)[EI_DATA] == ELFDATA2MSB
+	   ? be32toh (val32) : le32toh (val32));
+  pid_t pid = (int32_t) val32;
+  eu_static_assert (sizeof val32 <= sizeof pid);
+  return pid;
 }
 
 static bool
-core_set_initial_registers (Dwfl_Thread *thread, void *thread_arg_voidp)
+core_set_initial_registers (Dwfl_Thread *thread, void *thread_arg)
 {
-  struct thread_arg *thread_arg = thread_arg_voidp;
-  struct core_arg *core_arg = thread_arg->core_arg;
+  struct core_thread *core_thread = thread_arg;
+  struct core_arg *core_arg = thread->process->callbacks_arg;
   Elf *core = core_arg->core;
-  size_t offset = thread_arg->note_offset;
+  size_t offset = core_thread->note_offset;
   GElf_Nhdr nhdr;
   size_t name_offset;
   size_t desc_offset;
@@ -198,21 +211,10 @@ core_set_initial_registers (Dwfl_Thread *thread, void *thread_arg_voidp)
   /* __libdwfl_attach_state_for_core already verified the note is there.  */
   if (core_note_err == 0 || nhdr.n_type != NT_PRSTATUS)
     return false;
+  /* dwfl_core_file_attach already found this TID there.  */
+  assert (core_note_pid (core, desc, items, nitems)
+	  == INTUSE(dwfl_thread_tid) (thread));
   const Ebl_Core_Item *item;
-  for (item = items; item < items + nitems; item++)
-    if (strcmp (item->name, "pid") == 0)
-      break;
-  assert (item < items + nitems);
-  pid_t tid;
-  {
-    uint32_t val32 = read_4ubyte_unaligned_noncvt (desc + item->offset);
-    val32 = (elf_getident (core, NULL)[EI_DATA] == ELFDATA2MSB
-	     ? be32toh (val32) : le32toh (val32));
-    tid = (int32_t) val32;
-    eu_static_assert (sizeof val32 <= sizeof tid);
-  }
-  /* core_next_thread already found this TID there.  */
-  assert (tid == INTUSE(dwfl_thread_tid) (thread));
   for (item = items; item < items + nitems; item++)
     if (item->pc_register)
       break;
@@ -297,13 +299,16 @@ core_detach (Dwfl *dwfl __attribute__ ((unused)), void *dwfl_arg)
 {
   struct core_arg *core_arg = dwfl_arg;
   ebl_closebackend (core_arg->ebl);
+  free (core_arg->threads_by_tid);
+  free (core_arg->threads);
+  pthread_mutex_destroy (&core_arg->read_lock);
   free (core_arg);
 }
 
 static const Dwfl_Thread_Callbacks core_thread_callbacks =
 {
   core_next_thread,
-  NULL, /* get_thread */
+  core_get_thread,
   core_memory_read,
   core_set_initial_registers,
   core_detach,
@@ -368,11 +373,17 @@ dwfl_core_file_attach (Dwfl *dwfl, Elf *core)
       err = DWFL_E_LIBELF;
       goto fail;
     }
+  /* Index the NT_PRSTATUS notes in the same pass that finds the pid, so
+     that looking up a thread does not need to walk the notes again.  */
+  struct core_thread *threads = NULL;
+  size_t nthreads = 0;
+  size_t nthreads_alloc = 0;
   size_t offset = 0;
+  size_t note_offset;
   GElf_Nhdr nhdr;
   size_t name_offset;
   size_t desc_offset;
-  while (offset < note_data->d_size
+  while (note_offset = offset, offset < note_data->d_size
 	 && (offset = gelf_getnote (note_data, offset,
 				    &nhdr, &name_offset, &desc_offset)) > 0)
     {
@@ -385,46 +396,75 @@ dwfl_core_file_attach (Dwfl *dwfl, Elf *core)
       const Ebl_Register_Location *reglocs;
       size_t nitems;
       const Ebl_Core_Item *items;
+      if (nhdr.n_type != NT_PRPSINFO && nhdr.n_type != NT_PRSTATUS)
+	continue;
       if (! ebl_core_note (ebl, &nhdr, name, desc,
 			   &regs_offset, &nregloc, &reglocs, &nitems, &items))
 	{
 	  /* This note may be just not recognized, skip it.  */
 	  continue;
 	}
-      if (nhdr.n_type != NT_PRPSINFO)
+      pid_t note_pid = core_note_pid (core, desc, items, nitems);
+      if (note_pid == -1)
 	continue;
-      const Ebl_Core_Item *item;
-      for (item = items; item < items + nitems; item++)
-	if (strcmp (item->name, "pid") == 0)
-	  break;
-      if (item == items + nitems)
-	continue;
-      uint32_t val32 = read_4ubyte_unaligned_noncvt (desc + item->offset);
-      val32 = (elf_getident (core, NULL)[EI_DATA] == ELFDATA2MSB
-		? be32toh (val32) : le32toh (val32));
-      pid = (int32_t) val32;
-      eu_static_assert (sizeof val32 <= sizeof pid);
-      break;
+      if (nhdr.n_type == NT_PRPSINFO)
+	{
+	  if (pid == -1)
+	    pid = note_pid;
+	  continue;
+	}
+      if (nthreads == nthreads_alloc)
+	{
+	  nthreads_alloc = nthreads_alloc == 0 ? 16 : 2 * nthreads_alloc;
+	  struct core_thread *newthreads
+	    = realloc (threads, nthreads_alloc * sizeof threads[0]);
+	  if (newthreads == NULL)
+	    {
+	      free (threads);
+	      err = DWFL_E_NOMEM;
+	      goto fail;
+	    }
+	  threads = newthreads;
+	}
+      threads[nthreads].tid = note_pid;
+      threads[nthreads].note_offset = note_offset;
+      nthreads++;
     }
   if (pid == -1)
     {
       /* No valid NT_PRPSINFO recognized in this CORE.  */
+      free (threads);
       err = DWFL_E_BADELF;
       goto fail;
     }
+  struct core_thread **threads_by_tid = malloc ((nthreads ?: 1)
+						* sizeof threads_by_tid[0]);
   struct core_arg *core_arg = malloc (sizeof *core_arg);
-  if (core_arg == NULL)
+  if (threads_by_tid == NULL || core_arg == NULL
+      || pthread_mutex_init (&core_arg->read_lock, NULL) != 0)
     {
+      free (threads_by_tid);
+      free (core_arg);
+      free (threads);
       err = DWFL_E_NOMEM;
       goto fail;
     }
+  for (size_t i = 0; i < nthreads; i++)
+    threads_by_tid[i] = &threads[i];
+  qsort (threads_by_tid, nthreads, sizeof threads_by_tid[0],
+	 compare_core_thread);
   core_arg->core = core;
   core_arg->note_data = note_data;
-  core_arg->thread_note_offset = 0;
   core_arg->ebl = ebl;
+  core_arg->threads = threads;
+  core_arg->threads_by_tid = threads_by_tid;
+  core_arg->nthreads = nthreads;
   if (! INTUSE(dwfl_attach_state) (dwfl, core, pid, &core_thread_callbacks,
 				   core_arg))
     {
+      free (threads_by_tid);
+      free (threads);
+      pthread_mutex_destroy (&core_arg->read_lock);
       free (core_arg);
       ebl_closebackend (ebl);
       return -1;
@@ -37,6 +37,12 @@
 
 typedef uint8_t GElf_Byte;
 
+#if BYTE_ORDER == LITTLE_ENDIAN
+# define MY_ELFDATA	ELFDATA2LSB
+#else
+# define MY_ELFDATA	ELFDATA2MSB
+#endif
+
 /* Adjust *VALUE to add the load address of the SHNDX section.
    We update the section header in place to cache the result.  */
 
@@ -95,7 +101,15 @@ __libdwfl_relocate_value (Dwfl_Module *mod, Elf *elf, size_t *shstrndx,
 }
 
 
-/* Cache used by relocate_getsym.  */
+/* Value a symbol resolved to, see relocate_symval.  */
+struct reloc_symval
+{
+  GElf_Addr value;
+  Dwfl_Error error;
+  bool resolved;
+};
+
+/* Cache used by relocate_getsym and relocate_symval.  */
 struct reloc_symtab_cache
 {
   Elf *symelf;
@@ -104,10 +118,13 @@ struct reloc_symtab_cache
   Elf_Data *symstrdata;
   size_t symshstrndx;
   size_t strtabndx;
+  /* Indexed by symbol table index, NSYMVALS entries.  */
+  struct reloc_symval *symvals;
+  size_t nsymvals;
 };
 #define RELOC_SYMTAB_CACHE(cache)	\
   struct reloc_symtab_cache cache =	\
-    { NULL, NULL, NULL, NULL, SHN_UNDEF, SHN_UNDEF }
+    { NULL, NULL, NULL, NULL, SHN_UNDEF, SHN_UNDEF, NULL, 0 }
 
 /* This is just doing dwfl_module_getsym, except that we must always use
    the symbol table in RELOCATED itself when it has one, not MOD->symfile.  */
@@ -318,6 +335,74 @@ resolve_symbol (Dwfl_Module *referer, struct reloc_symtab_cache *symtab,
   return DWFL_E_RELUNDEF;
 }
 
+/* Resolve symbol SYMNDX to an absolute value.  Relocation sections
+   usually refer to the same few symbols over and over again, so the
+   result is remembered in RELOC_SYMTAB, including the failure to find
+   an undefined symbol, which relocate_section might skip.  */
+static Dwfl_Error
+relocate_symval (Dwfl_Module *mod, Elf *relocated,
+		 struct reloc_symtab_cache *reloc_symtab,
+		 int symndx, GElf_Addr *value)
+{
+  if (symndx == STN_UNDEF)
+    {
+      /* When strip removes a section symbol referring to a
+	 section moved into the debuginfo file, it replaces
+	 that symbol index in relocs with STN_UNDEF.  We
+	 don't actually need the symbol, because those relocs
+	 are always references relative to the nonallocated
+	 debugging sections, which start at zero.  */
+      *value = 0;
+      return DWFL_E_NOERROR;
+    }
+
+  if ((size_t) symndx < reloc_symtab->nsymvals
+      && reloc_symtab->symvals[symndx].resolved)
+    {
+      *value = reloc_symtab->symvals[symndx].value;
+      return reloc_symtab->symvals[symndx].error;
+    }
+
+  GElf_Sym sym;
+  GElf_Word shndx;
+  Dwfl_Error error = relocate_getsym (mod, relocated, reloc_symtab,
+				      symndx, &sym, &shndx);
+  if (unlikely (error != DWFL_E_NOERROR))
+    return error;
+
+  if (shndx == SHN_UNDEF || shndx == SHN_COMMON)
+    {
+      /* Maybe we can figure it out anyway.  */
+      error = resolve_symbol (mod, reloc_symtab, &sym, shndx);
+      if (error == DWFL_E_RELUNDEF && shndx == SHN_COMMON)
+	error = DWFL_E_NOERROR;
+      else if (error != DWFL_E_NOERROR && error != DWFL_E_RELUNDEF)
+	return error;
+    }
+
+  *value = sym.st_value;
+
+  if (reloc_symtab->symvals == NULL)
+    {
+      /* relocate_getsym has found the symbol table now.  If we cannot
+	 get the memory, we just go without the cache.  */
+      size_t nsyms = (reloc_symtab->symdata->d_size
+		      / gelf_fsize (reloc_symtab->symelf, ELF_T_SYM, 1,
+				    EV_CURRENT));
+      reloc_symtab->symvals = calloc (nsyms, sizeof (struct reloc_symval));
+      if (reloc_symtab->symvals != NULL)
+	reloc_symtab->nsymvals = nsyms;
+    }
+  if ((size_t) symndx < reloc_symtab->nsymvals)
+    {
+      reloc_symtab->symvals[symndx].value = *value;
+      reloc_symtab->symvals[symndx].error = error;
+      reloc_symtab->symvals[symndx].resolved = true;
+    }
+
+  return error;
+}
+
 /* Apply one relocation.  Returns true for any invalid data.  */
 static Dwfl_Error
 relocate (Dwfl_Module * const mod,
@@ -348,35 +433,10 @@ relocate (Dwfl_Module * const mod,
 
     /* First, resolve the symbol to an absolute value.  */
     GElf_Addr value;
-
-    if (symndx == STN_UNDEF)
-      /* When strip removes a section symbol referring to a
-	 section moved into the debuginfo file, it replaces
-	 that symbol index in relocs with STN_UNDEF.  We
-	 don't actually need the symbol, because those relocs
-	 are always references relative to the nonallocated
-	 debugging sections, which start at zero.  */
-      value = 0;
-    else
-      {
-	GElf_Sym sym;
-	GElf_Word shndx;
-	Dwfl_Error error = relocate_getsym (mod, relocated, reloc_symtab,
-					    symndx, &sym, &shndx);
-	if (unlikely (error != DWFL_E_NOERROR))
-	  return error;
-
-	if (shndx == SHN_UNDEF || shndx == SHN_COMMON)
-	  {
-	    /* Maybe we can figure it out anyway.  */
-	    error = resolve_symbol (mod, reloc_symtab, &sym, shndx);
-	    if (error != DWFL_E_NOERROR
-		&& !(error == DWFL_E_RELUNDEF && shndx == SHN_COMMON))
-	      return error;
-	  }
-
-	value = sym.st_value;
-      }
+    Dwfl_Error error = relocate_symval (mod, relocated, reloc_symtab,
+					symndx, &value);
+    if (unlikely (error != DWFL_E_NOERROR))
+      return error;
 
     /* These are the types we can relocate.  */
 #define TYPES		DO_TYPE (BYTE, Byte); DO_TYPE (HALF, Half);	\
@@ -498,6 +558,123 @@ check_badreltype (bool *first_badreltype,
      }
 }
 
+/* Apply the run of relocations starting at RELIDX which all have the
+   same type and symbol, when the file is in host byte order.  The
+   symbol is resolved once and every datum is updated directly in
+   TDATA, without going through gelf_xlatetom and gelf_xlatetof.  Only
+   relocations which store the symbol value, or add it to the datum in
+   the SHT_REL case, are done here.  Returns the number of relocations
+   applied.  Zero means the relocation at RELIDX must be left to
+   relocate, which also diagnoses any errors.  */
+static size_t
+relocate_run (Dwfl_Module *mod, Elf *relocated,
+	      struct reloc_symtab_cache *reloc_symtab,
+	      Elf_Data *tdata, Elf_Data *reldata,
+	      size_t relidx, size_t nrels)
+{
+  bool is64 = gelf_getclass (relocated) == ELFCLASS64;
+  bool is_rela = reldata->d_type == ELF_T_RELA;
+  size_t entsize = (is64
+		    ? (is_rela ? sizeof (Elf64_Rela) : sizeof (Elf64_Rel))
+		    : (is_rela ? sizeof (Elf32_Rela) : sizeof (Elf32_Rel)));
+  nrels = MIN (nrels, reldata->d_size / entsize);
+  if (relidx >= nrels)
+    return 0;
+
+  GElf_Xword info = (is64
+		     ? ((Elf64_Rel *) (reldata->d_buf + relidx * entsize))->r_info
+		     : ((Elf32_Rel *) (reldata->d_buf + relidx * entsize))->r_info);
+  int rtype = is64 ? ELF64_R_TYPE (info) : ELF32_R_TYPE (info);
+  int symndx = is64 ? ELF64_R_SYM (info) : ELF32_R_SYM (info);
+  if (rtype == 0)
+    return 0;
+
+  int addsub = 0;
+  size_t size;
+  switch (ebl_reloc_simple_type (mod->ebl, rtype, &addsub))
+    {
+#define DO_TYPE(NAME, Name)			\
+    case ELF_T_##NAME:				\
+      size = sizeof (GElf_##Name);		\
+      break
+      TYPES;
+#undef DO_TYPE
+    default:
+      return 0;
+    }
+  if (addsub != 0)
+    return 0;
+
+  GElf_Addr value;
+  if (relocate_symval (mod, relocated, reloc_symtab, symndx,
+		       &value) != DWFL_E_NOERROR)
+    return 0;
+
+  /* Stop at the first relocation with a different type or symbol, or
+     an invalid offset.  */
+  size_t n = relidx;
+#define RUN(Ent, ADDEND)						\
+  for (const Ent *r = (const Ent *) reldata->d_buf + relidx;		\
+       n < nrels && r->r_info == info; ++n, ++r)				\
+    {									\
+      if (unlikely (r->r_offset > tdata->d_size				\
+		    || tdata->d_size - r->r_offset < size))		\
+	break;								\
+      unsigned char *p = tdata->d_buf + r->r_offset;			\
+      switch (size)							\
+	{								\
+	case 1:								\
+	  *p = (ADDEND (*p)) + value;					\
+	  break;							\
+	case 2:								\
+	  {								\
+	    uint16_t v;							\
+	    memcpy (&v, p, sizeof v);					\
+	    v = (ADDEND (v)) + value;					\
+	    memcpy (p, &v, sizeof v);					\
+	  }								\
+	  break;							\
+	case 4:								\
+	  {								\
+	    uint32_t v;							\
+	    memcpy (&v, p, sizeof v);					\
+	    v = (ADDEND (v)) + value;					\
+	    memcpy (p, &v, sizeof v);					\
+	  }								\
+	  break;							\
+	default:							\
+	  {								\
+	    uint64_t v;							\
+	    memcpy (&v, p, sizeof v);					\
+	    v = (ADDEND (v)) + value;					\
+	    memcpy (p, &v, sizeof v);					\
+	  }								\
+	  break;							\
+	}								\
+    }
+  /* For SHT_RELA the datum is replaced, for SHT_REL it is the addend.  */
+#define RELA_ADDEND(v) r->r_addend
+#define REL_ADDEND(v) v
+  if (is64)
+    {
+      if (is_rela)
+	RUN (Elf64_Rela, RELA_ADDEND)
+      else
+	RUN (Elf64_Rel, REL_ADDEND)
+    }
+  else
+    {
+      if (is_rela)
+	RUN (Elf32_Rela, RELA_ADDEND)
+      else
+	RUN (Elf32_Rel, REL_ADDEND)
+    }
+#undef RELA_ADDEND
+#undef REL_ADDEND
+#undef RUN
+  return n - relidx;
+}
+
 static Dwfl_Error
 relocate_section (Dwfl_Module *mod, Elf *relocated, const GElf_Ehdr *ehdr,
 		  size_t shstrndx, struct reloc_symtab_cache *reloc_symtab,
@@ -627,68 +804,82 @@ relocate_section (Dwfl_Module *mod, Elf *relocated, const GElf_Ehdr *ehdr,
 		  1, EV_CURRENT);
   size_t nrels = shdr->sh_size / sh_entsize;
   size_t complete = 0;
-  if (shdr->sh_type == SHT_REL)
-    for (size_t relidx = 0; !result && relidx < nrels; ++relidx)
-      {
-	GElf_Rel rel_mem, *r = gelf_getrel (reldata, relidx, &rel_mem);
-	if (r == NULL)
-	  return DWFL_E_LIBELF;
-	result = relocate (mod, relocated, reloc_symtab, tdata, ehdr,
-			   r->r_offset, NULL,
-			   GELF_R_TYPE (r->r_info),
-			   GELF_R_SYM (r->r_info));
-	check_badreltype (&first_badreltype, mod, &result);
-	if (partial)
-	  switch (result)
+  /* Indices of the relocations we skipped, which have to be kept.  */
+  size_t *skipped = NULL;
+  size_t nskipped = 0;
+  size_t maxskipped = 0;
+  /* When the data is in our byte order, apply runs of simple
+     relocations directly.  */
+  bool native = ehdr->e_ident[EI_DATA] == MY_ELFDATA;
+  for (size_t relidx = 0; !result && relidx < nrels; ++relidx)
+    {
+      size_t n = (native
+		  ? relocate_run (mod, relocated, reloc_symtab, tdata,
+				  reldata, relidx, nrels)
+		  : 0);
+      if (n > 0)
+	{
+	  complete += n;
+	  relidx += n - 1;
+	  continue;
+	}
+
+      if (shdr->sh_type == SHT_REL)
+	{
+	  GElf_Rel rel_mem, *r = gelf_getrel (reldata, relidx, &rel_mem);
+	  if (r == NULL)
 	    {
-	    case DWFL_E_NOERROR:
-	      /* We applied the relocation.  Elide it.  */
-	      memset (&rel_mem, 0, sizeof rel_mem);
-	      if (unlikely (gelf_update_rel (reldata, relidx, &rel_mem) == 0))
-		return DWFL_E_LIBELF;
-	      ++complete;
-	      break;
-	    case DWFL_E_BADRELTYPE:
-	    case DWFL_E_RELUNDEF:
-	      /* We couldn't handle this relocation.  Skip it.  */
-	      result = DWFL_E_NOERROR;
-	      break;
-	    default:
+	      result = DWFL_E_LIBELF;
 	      break;
 	    }
-      }
-  else
-    for (size_t relidx = 0; !result && relidx < nrels; ++relidx)
-      {
-	GElf_Rela rela_mem, *r = gelf_getrela (reldata, relidx,
-					       &rela_mem);
-	if (r == NULL)
-	  return DWFL_E_LIBELF;
-	result = relocate (mod, relocated, reloc_symtab, tdata, ehdr,
-			   r->r_offset, &r->r_addend,
-			   GELF_R_TYPE (r->r_info),
-			   GELF_R_SYM (r->r_info));
-	check_badreltype (&first_badreltype, mod, &result);
-	if (partial)
-	  switch (result)
+	  result = relocate (mod, relocated, reloc_symtab, tdata, ehdr,
+			     r->r_offset, NULL,
+			     GELF_R_TYPE (r->r_info),
+			     GELF_R_SYM (r->r_info));
+	}
+      else
+	{
+	  GElf_Rela rela_mem, *r = gelf_getrela (reldata, relidx,
+						 &rela_mem);
+	  if (r == NULL)
 	    {
-	    case DWFL_E_NOERROR:
-	      /* We applied the relocation.  Elide it.  */
-	      memset (&rela_mem, 0, sizeof rela_mem);
-	      if (unlikely (gelf_update_rela (reldata, relidx,
-					      &rela_mem) == 0))
-		return DWFL_E_LIBELF;
-	      ++complete;
-	      break;
-	    case DWFL_E_BADRELTYPE:
-	    case DWFL_E_RELUNDEF:
-	      /* We couldn't handle this relocation.  Skip it.  */
-	      result = DWFL_E_NOERROR;
-	      break;
-	    default:
+	      result = DWFL_E_LIBELF;
 	      break;
 	    }
-      }
+	  result = relocate (mod, relocated, reloc_symtab, tdata, ehdr,
+			     r->r_offset, &r->r_addend,
+			     GELF_R_TYPE (r->r_info),
+			     GELF_R_SYM (r->r_info));
+	}
+      check_badreltype (&first_badreltype, mod, &result);
+      if (partial)
+	switch (result)
+	  {
+	  case DWFL_E_NOERROR:
+	    ++complete;
+	    break;
+	  case DWFL_E_BADRELTYPE:
+	  case DWFL_E_RELUNDEF:
+	    /* We couldn't handle this relocation.  Skip it, but
+	       remember to keep it in the section.  */
+	    result = DWFL_E_NOERROR;
+	    if (nskipped == maxskipped)
+	      {
+		maxskipped = MAX (2 * maxskipped, 16);
+		size_t *newp = realloc (skipped, maxskipped * sizeof *skipped);
+		if (unlikely (newp == NULL))
+		  {
+		    result = DWFL_E_NOMEM;
+		    break;
+		  }
+		skipped = newp;
+	      }
+	    skipped[nskipped++] = relidx;
+	    break;
+	  default:
+	    break;
+	  }
+    }
 
   if (likely (result == DWFL_E_NOERROR))
     {
@@ -701,48 +892,41 @@ relocate_section (Dwfl_Module *mod, Elf *relocated, const GElf_Ehdr *ehdr,
       else if (complete != 0)
 	{
 	  /* We handled some of the relocations but not all.
-	     We've zeroed out the ones we processed.
-	     Now remove them from the section.  */
-
-	  size_t next = 0;
-	  if (shdr->sh_type == SHT_REL)
-	    for (size_t relidx = 0; relidx < nrels; ++relidx)
-	      {
-		GElf_Rel rel_mem;
-		GElf_Rel *r = gelf_getrel (reldata, relidx, &rel_mem);
-		if (unlikely (r == NULL))
-		  return DWFL_E_LIBELF;
-		if (r->r_info != 0 || r->r_offset != 0)
-		  {
-		    if (next != relidx)
-		      if (unlikely (gelf_update_rel (reldata, next, r) == 0))
-			return DWFL_E_LIBELF;
-		    ++next;
-		  }
-	      }
-	  else
-	    for (size_t relidx = 0; relidx < nrels; ++relidx)
-	      {
-		GElf_Rela rela_mem;
-		GElf_Rela *r = gelf_getrela (reldata, relidx, &rela_mem);
-		if (unlikely (r == NULL))
-		  return DWFL_E_LIBELF;
-		if (r->r_info != 0 || r->r_offset != 0 || r->r_addend != 0)
-		  {
-		    if (next != relidx)
-		      if (unlikely (gelf_update_rela (reldata, next, r) == 0))
-			return DWFL_E_LIBELF;
-		    ++next;
-		  }
-	      }
-	  nrels = next;
+	     Now remove them from the section, moving the ones we
+	     skipped to the front.  */
+	  for (size_t i = 0; result == DWFL_E_NOERROR && i < nskipped; ++i)
+	    {
+	      if (skipped[i] == i)
+		continue;
+	      if (shdr->sh_type == SHT_REL)
+		{
+		  GElf_Rel rel_mem;
+		  GElf_Rel *r = gelf_getrel (reldata, skipped[i], &rel_mem);
+		  if (unlikely (r == NULL)
+		      || unlikely (gelf_update_rel (reldata, i, r) == 0))
+		    result = DWFL_E_LIBELF;
+		}
+	      else
+		{
+		  GElf_Rela rela_mem;
+		  GElf_Rela *r = gelf_getrela (reldata, skipped[i], &rela_mem);
+		  if (unlikely (r == NULL)
+		      || unlikely (gelf_update_rela (reldata, i, r) == 0))
+		    result = DWFL_E_LIBELF;
+		}
+	    }
+	  nrels = nskipped;
 	}
 
-      shdr->sh_size = reldata->d_size = nrels * sh_entsize;
-      if (unlikely (gelf_update_shdr (scn, shdr) == 0))
-	return DWFL_E_LIBELF;
+      if (likely (result == DWFL_E_NOERROR))
+	{
+	  shdr->sh_size = reldata->d_size = nrels * sh_entsize;
+	  if (unlikely (gelf_update_shdr (scn, shdr) == 0))
+	    result = DWFL_E_LIBELF;
+	}
     }
 
+  free (skipped);
   return result;
 }
 
@@ -773,7 +957,10 @@ __libdwfl_relocate (Dwfl_Module *mod, Elf *debugfile, bool debug)
       GElf_Shdr shdr_mem;
       GElf_Shdr *shdr = gelf_getshdr (scn, &shdr_mem);
       if (unlikely (shdr == NULL))
-	return DWFL_E_LIBELF;
+	{
+	  result = DWFL_E_LIBELF;
+	  break;
+	}
 
       if ((shdr->sh_type == SHT_REL || shdr->sh_type == SHT_RELA)
 	  && shdr->sh_size != 0)
@@ -790,6 +977,7 @@ __libdwfl_relocate (Dwfl_Module *mod, Elf *debugfile, bool debug)
 	}
     }
 
+  free (reloc_symtab.symvals);
   return result;
 }
 
@@ -819,6 +1007,8 @@ __libdwfl_relocate_section (Dwfl_Module *mod, Elf *relocated,
   if (unlikely (shdr == NULL))
     return DWFL_E_LIBELF;
 
-  return relocate_section (mod, relocated, ehdr, shstrndx, &reloc_symtab,
-			   relocscn, shdr, tscn, false, partial);
+  result = relocate_section (mod, relocated, ehdr, shstrndx, &reloc_symtab,
+			     relocscn, shdr, tscn, false, partial);
+  free (reloc_symtab.symvals);
+  return result;
 }
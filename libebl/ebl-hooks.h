@@ -147,6 +147,11 @@ int EBLHOOK(disasm) (Ebl *ebl, const uint8_t **startp, const uint8_t *end,
 		     GElf_Addr addr, const char *fmt, DisasmOutputCB_t outcb,
 		     DisasmGetSymCB_t symcb, void *outcbarg, void *symcbarg);
 
+/* Decode a single instruction without formatting it.  */
+int EBLHOOK(disasm_decode) (Ebl *ebl, const uint8_t **startp,
+			    const uint8_t *end, GElf_Addr addr,
+			    DisasmInsn *insn);
+
 /* Supply the machine-specific state of CFI before CIE initial programs.
    Function returns 0 on success and -1 on error.  */
 int EBLHOOK(abi_cfi) (Ebl *ebl, Dwarf_CIE *abi_info);
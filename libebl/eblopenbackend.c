@@ -38,6 +38,7 @@
 #include <stdio.h>
 
 #include <system.h>
+#include <atomics.h>
 #include <libeblP.h>
 
 Ebl *i386_init (Elf *, GElf_Half, Ebl *);
@@ -164,6 +165,42 @@ static const struct
 /* No machine prefix should be larger than this.  */
 #define MAX_PREFIX_LEN 16
 
+/* machine_index[EM] is one more than the index of the first entry of
+   machines for EM, or zero if there is none.  Machines with a bigger
+   number are searched for linearly.  */
+#define MACHINE_INDEX_SIZE 512
+static unsigned char machine_index[MACHINE_INDEX_SIZE];
+
+/* Initialized backends, see struct ebl_cache.  They are only added,
+   never removed, until the library is unloaded.  A process normally
+   uses only one or two kinds, if more are needed the rest is not
+   cached.  */
+#define EBL_CACHE_SIZE 16
+static atomic_uintptr_t ebl_cache[EBL_CACHE_SIZE];
+
+static void __attribute__ ((constructor))
+init_machine_index (void)
+{
+  for (size_t cnt = nmachines; cnt-- > 0; )
+    if (machines[cnt].em < MACHINE_INDEX_SIZE)
+      machine_index[machines[cnt].em] = cnt + 1;
+}
+
+static void __attribute__ ((destructor))
+free_ebl_cache (void)
+{
+  for (size_t i = 0; i < EBL_CACHE_SIZE; ++i)
+    {
+      struct ebl_cache *cache = (struct ebl_cache *)
+	atomic_load_explicit (&ebl_cache[i], memory_order_relaxed);
+      if (cache == NULL)
+	break;
+      free (cache->regs);
+      free (cache->names);
+      free (cache);
+    }
+}
+
 /* Default callbacks.  Mostly they just return the error value.  */
 static const char *default_reloc_type_name (int ignore, char *buf, size_t len);
 static bool default_reloc_type_check (int ignore);
@@ -266,17 +303,141 @@ fill_defaults (Ebl *result)
   result->check_object_attribute = default_check_object_attribute;
   result->check_reloc_target_type = default_check_reloc_target_type;
   result->disasm = NULL;
+  result->disasm_decode = NULL;
   result->abi_cfi = default_abi_cfi;
   result->destr = default_destr;
   result->sysvhash_entrysize = sizeof (Elf32_Word);
 }
 
+/* Look for a cached backend.  */
+static const struct ebl_cache *
+find_cache (GElf_Half machine, unsigned char class, unsigned char data)
+{
+  for (size_t i = 0; i < EBL_CACHE_SIZE; ++i)
+    {
+      const struct ebl_cache *cache = (const struct ebl_cache *)
+	atomic_load_explicit (&ebl_cache[i], memory_order_acquire);
+      if (cache == NULL)
+	break;
+      if (cache->ebl.machine == machine && cache->ebl.class == class
+	  && cache->ebl.data == data)
+	return cache;
+    }
+  return NULL;
+}
+
+/* Add the freshly initialized backend EBL to the cache and return the
+   cache entry, or NULL if that is not possible.  */
+static const struct ebl_cache *
+add_cache (const Ebl *ebl)
+{
+  struct ebl_cache *cache = calloc (1, sizeof *cache);
+  if (cache == NULL)
+    return NULL;
+  cache->ebl = *ebl;
+  cache->ebl.elf = NULL;
+  cache->ebl.cache = cache;
+
+  for (int reloc = 0; reloc < EBL_CACHE_NRELOC; ++reloc)
+    {
+      int addsub = 0;
+      cache->reloc_simple[reloc].type
+	= ebl->reloc_simple_type (&cache->ebl, reloc, &addsub);
+      cache->reloc_simple[reloc].addsub = addsub;
+    }
+
+  /* Collect the register names, first into a buffer big enough for
+     any of them.  */
+  char name[64];
+  const char *prefix;
+  const char *setname;
+  int bits;
+  int type;
+  ssize_t nregs = ebl->register_info (&cache->ebl, 0, NULL, 0, NULL, NULL,
+				      NULL, NULL);
+  if (nregs > 0)
+    {
+      size_t namesize = 0;
+      cache->regs = calloc (nregs, sizeof cache->regs[0]);
+      if (cache->regs == NULL)
+	goto fail;
+      for (int regno = 0; regno < nregs; ++regno)
+	{
+	  struct ebl_cache_reg *reg = &cache->regs[regno];
+	  reg->len = ebl->register_info (&cache->ebl, regno, name,
+					 sizeof name, &prefix, &setname,
+					 &bits, &type);
+	  if (reg->len > 0)
+	    {
+	      reg->prefix = prefix;
+	      reg->setname = setname;
+	      reg->bits = bits;
+	      reg->type = type;
+	      namesize += reg->len;
+	    }
+	}
+      cache->names = malloc (namesize ?: 1);
+      if (cache->names == NULL)
+	goto fail;
+      char *cp = cache->names;
+      for (int regno = 0; regno < nregs; ++regno)
+	if (cache->regs[regno].len > 0)
+	  {
+	    ebl->register_info (&cache->ebl, regno, name, sizeof name,
+				&prefix, &setname, &bits, &type);
+	    cache->regs[regno].name = cp;
+	    cp = mempcpy (cp, name, cache->regs[regno].len);
+	  }
+      cache->nregs = nregs;
+    }
+
+  for (size_t i = 0; i < EBL_CACHE_SIZE; ++i)
+    {
+      uintptr_t expected = 0;
+      if (atomic_compare_exchange_strong_explicit (&ebl_cache[i], &expected,
+						   (uintptr_t) cache,
+						   memory_order_release,
+						   memory_order_acquire))
+	return cache;
+
+      /* Another thread might have added the same backend.  */
+      const struct ebl_cache *other = (const struct ebl_cache *) expected;
+      if (other->ebl.machine == ebl->machine
+	  && other->ebl.class == ebl->class && other->ebl.data == ebl->data)
+	{
+	  free (cache->regs);
+	  free (cache->names);
+	  free (cache);
+	  return other;
+	}
+    }
+
+ fail:
+  free (cache->regs);
+  free (cache->names);
+  free (cache);
+  return NULL;
+}
+
+/* Find the first entry of machines for MACHINE, or -1.  */
+static ssize_t
+find_machine (GElf_Half machine)
+{
+  if (machine < MACHINE_INDEX_SIZE)
+    return (ssize_t) machine_index[machine] - 1;
+
+  for (size_t cnt = 0; cnt < nmachines; ++cnt)
+    if (machines[cnt].em == machine)
+      return cnt;
+  return -1;
+}
+
 /* Find an appropriate backend for the file associated with ELF.  */
 static Ebl *
 openbackend (Elf *elf, const char *emulation, GElf_Half machine)
 {
   Ebl *result;
-  size_t cnt;
+  size_t cnt = 0;
 
   /* First allocate the data structure for the result.  We do this
      here since this assures that the structure is always large
@@ -289,6 +450,31 @@ openbackend (Elf *elf, const char *emulation, GElf_Half machine)
       return NULL;
     }
 
+  /* Without an emulation name only the first entry for the machine
+     can match.  If its backend was initialized before just copy it.  */
+  if (emulation == NULL)
+    {
+      ssize_t first = find_machine (machine);
+      if (first < 0)
+	cnt = nmachines;
+      else
+	{
+	  cnt = first;
+	  const struct ebl_cache *cache
+	    = (elf == NULL
+	       ? find_cache (machine, machines[cnt].class, machines[cnt].data)
+	       : find_cache (elf->state.elf32.ehdr->e_machine,
+			     elf->state.elf32.ehdr->e_ident[EI_CLASS],
+			     elf->state.elf32.ehdr->e_ident[EI_DATA]));
+	  if (cache != NULL)
+	    {
+	      *result = cache->ebl;
+	      result->elf = elf;
+	      return result;
+	    }
+	}
+    }
+
   /* Fill in the default callbacks.  The initializer for the machine
      specific module can overwrite the values.  */
   fill_defaults (result);
@@ -302,7 +488,7 @@ openbackend (Elf *elf, const char *emulation, GElf_Half machine)
      will be tried in sequence.  The lookup process will only stop
      when a module which can handle the machine type is found or all
      available matching modules are tried.  */
-  for (cnt = 0; cnt < nmachines; ++cnt)
+  for (; cnt < nmachines; ++cnt)
     if ((emulation != NULL && strcmp (emulation, machines[cnt].emulation) == 0)
 	|| (emulation == NULL && machines[cnt].em == machine))
       {
@@ -335,9 +521,15 @@ openbackend (Elf *elf, const char *emulation, GElf_Half machine)
         if (machines[cnt].init &&
             machines[cnt].init (elf, machine, result))
           {
-            result->elf = elf;
             /* A few entries are mandatory.  */
             assert (result->destr != NULL);
+	    if (emulation == NULL && ! result->per_elf)
+	      {
+		const struct ebl_cache *cache = add_cache (result);
+		if (cache != NULL)
+		  result->cache = cache;
+	      }
+            result->elf = elf;
             return result;
           }
 
@@ -31,6 +31,7 @@
 #endif
 
 #include <inttypes.h>
+#include <string.h>
 #include <libeblP.h>
 
 
@@ -39,6 +40,28 @@ ebl_register_info (Ebl *ebl, int regno, char *name, size_t namelen,
 		   const char **prefix, const char **setname,
 		   int *bits, int *type)
 {
-  return ebl == NULL ? -1 : ebl->register_info (ebl, regno, name, namelen,
-						prefix, setname, bits, type);
+  if (ebl == NULL)
+    return -1;
+
+  /* Anything out of range is left to the backend.  */
+  const struct ebl_cache *cache = ebl->cache;
+  if (cache != NULL && cache->nregs > 0 && name == NULL)
+    return cache->nregs;
+  if (cache != NULL && regno >= 0 && regno < cache->nregs)
+    {
+      const struct ebl_cache_reg *reg = &cache->regs[regno];
+      if (reg->len <= 0)
+	return reg->len;
+      if (namelen < (size_t) reg->len)
+	return -1;
+      memcpy (name, reg->name, reg->len);
+      *prefix = reg->prefix;
+      *setname = reg->setname;
+      *bits = reg->bits;
+      *type = reg->type;
+      return reg->len;
+    }
+
+  return ebl->register_info (ebl, regno, name, namelen,
+			     prefix, setname, bits, type);
 }
@@ -36,5 +36,15 @@
 Elf_Type
 ebl_reloc_simple_type (Ebl *ebl, int reloc, int *addsub)
 {
-  return ebl != NULL ? ebl->reloc_simple_type (ebl, reloc, addsub) : ELF_T_NUM;
+  if (ebl == NULL)
+    return ELF_T_NUM;
+
+  if (ebl->cache != NULL && reloc >= 0 && reloc < EBL_CACHE_NRELOC)
+    {
+      if (ebl->cache->reloc_simple[reloc].addsub != 0)
+	*addsub = ebl->cache->reloc_simple[reloc].addsub;
+      return ebl->cache->reloc_simple[reloc].type;
+    }
+
+  return ebl->reloc_simple_type (ebl, reloc, addsub);
 }
@@ -76,6 +76,55 @@ struct ebl
      ebl_resolve_sym_value if available for this arch.  */
   GElf_Addr fd_addr;
   Elf_Data *fd_data;
+
+  /* Set by the backend initialization function if it looks at the
+     ELF file for more than its machine, class and data encoding.  It
+     must be set whether or not there is a file this time.  The handle
+     is then not shared through the backend cache.  */
+  bool per_elf;
+
+  /* The backend cache entry this handle was copied from, or NULL.  */
+  const struct ebl_cache *cache;
+};
+
+
+/* Relocation types below this value have their reloc_simple_type
+   result in the backend cache.  */
+#define EBL_CACHE_NRELOC 1024
+
+/* Result of register_info for one register.  LEN is the return value,
+   the strings are only valid if it is positive.  */
+struct ebl_cache_reg
+{
+  ssize_t len;
+  const char *name;
+  const char *prefix;
+  const char *setname;
+  int bits;
+  int type;
+};
+
+/* An initialized backend for one machine, class and data encoding,
+   shared by all handles for it and never changed once it is built.
+   EBL is copied into every new handle.  The lookup tables let the
+   hottest hooks be answered without calling into the backend.  */
+struct ebl_cache
+{
+  Ebl ebl;
+
+  /* reloc_simple_type result and the value it stores in *ADDSUB, or
+     zero if it leaves it alone.  */
+  struct
+  {
+    unsigned char type;
+    signed char addsub;
+  } reloc_simple[EBL_CACHE_NRELOC];
+
+  /* register_info for every register number below NREGS.  NAMES
+     holds the register names.  */
+  ssize_t nregs;
+  struct ebl_cache_reg *regs;
+  char *names;
 };
 
 
@@ -282,6 +282,140 @@ __libelf_compress_zstd (Elf_Scn *scn, size_t hsize, int ei_data,
   *new_size = used;
   return out_buf;
 }
+
+static void
+write_le32 (char *p, uint32_t v)
+{
+  v = htole32 (v);
+  memcpy (p, &v, sizeof v);
+}
+
+/* Like __libelf_compress_zstd, but compress every
+   ZSTD_SEEKABLE_FRAME_SIZE bytes as an independent frame and add a
+   seek table, so elf_compressed_range can decompress single frames.  */
+static
+void *
+__libelf_compress_zstd_seekable (Elf_Scn *scn, size_t hsize, int ei_data,
+				 size_t *orig_size, size_t *orig_addralign,
+				 size_t *new_size, bool force,
+				 Elf_Data *data, Elf_Data *next_data,
+				 void *out_buf)
+{
+  /* The frames don't line up with the data buffers, so first collect
+     all (raw) data in one buffer.  Not needed in the common case of
+     one buffer that doesn't need converting.  */
+  char *in_buf = NULL;
+  const char *in = data->d_buf;
+  if (next_data != NULL || (ei_data != MY_ELFDATA && data->d_size > 0))
+    {
+      for (Elf_Data *d = next_data; d != NULL; d = elf_getdata (scn, d))
+	{
+	  *orig_addralign = MAX (*orig_addralign, d->d_align);
+	  *orig_size += d->d_size;
+	}
+
+      in_buf = malloc (*orig_size ?: 1);
+      if (in_buf == NULL)
+	{
+	  __libelf_seterrno (ELF_E_NOMEM);
+	  free (out_buf);
+	  return NULL;
+	}
+
+      size_t off = 0;
+      for (Elf_Data *d = data; d != NULL; d = elf_getdata (scn, d))
+	{
+	  Elf_Data cdata = *d;
+	  cdata.d_buf = in_buf + off;
+	  if (ei_data != MY_ELFDATA && d->d_size > 0)
+	    {
+	      if (gelf_xlatetof (scn->elf, &cdata, d, ei_data) == NULL)
+		{
+		  free (in_buf);
+		  free (out_buf);
+		  return NULL;
+		}
+	    }
+	  else
+	    memcpy (cdata.d_buf, d->d_buf, d->d_size);
+	  off += d->d_size;
+	}
+      in = in_buf;
+    }
+
+  size_t size = *orig_size;
+  size_t nframes = MAX ((size + ZSTD_SEEKABLE_FRAME_SIZE - 1)
+			/ ZSTD_SEEKABLE_FRAME_SIZE, 1);
+  size_t tablesize = 8 + nframes * 8 + ZSTD_SEEKABLE_FOOTER_SIZE;
+  size_t out_size = (hsize + size
+		     + nframes * (ZSTD_compressBound (ZSTD_SEEKABLE_FRAME_SIZE)
+				  - ZSTD_SEEKABLE_FRAME_SIZE)
+		     + tablesize);
+  uint32_t *sizes = malloc (nframes * sizeof (uint32_t));
+  void *bigger = realloc (out_buf, out_size);
+  ZSTD_CCtx* const cctx = ZSTD_createCCtx();
+  if (sizes == NULL || bigger == NULL || cctx == NULL)
+    {
+      __libelf_seterrno (ELF_E_NOMEM);
+    fail:
+      ZSTD_freeCCtx (cctx);
+      free (sizes);
+      free (bigger ?: out_buf);
+      free (in_buf);
+      return NULL;
+    }
+  out_buf = bigger;
+
+  /* Caller gets to fill in the header at the start.  Just skip it here.  */
+  size_t used = hsize;
+  for (size_t i = 0; i < nframes; ++i)
+    {
+      size_t off = i * ZSTD_SEEKABLE_FRAME_SIZE;
+      size_t len = MIN (size - off, (size_t) ZSTD_SEEKABLE_FRAME_SIZE);
+      size_t ret = ZSTD_compress2 (cctx, out_buf + used, out_size - used,
+				   in + off, len);
+      if (ZSTD_isError (ret))
+	{
+	  __libelf_seterrno (ELF_E_COMPRESS_ERROR);
+	  goto fail;
+	}
+      sizes[i] = ret;
+      used += ret;
+    }
+
+  /* The seek table, in a skippable frame.  No checksums.  */
+  char *table = out_buf + used;
+  write_le32 (table, ZSTD_SEEKABLE_SKIPPABLE_MAGIC);
+  write_le32 (table + 4, tablesize - 8);
+  for (size_t i = 0; i < nframes; ++i)
+    {
+      write_le32 (table + 8 + i * 8, sizes[i]);
+      write_le32 (table + 8 + i * 8 + 4,
+		  MIN (size - i * ZSTD_SEEKABLE_FRAME_SIZE,
+		       (size_t) ZSTD_SEEKABLE_FRAME_SIZE));
+    }
+  char *footer = table + tablesize - ZSTD_SEEKABLE_FOOTER_SIZE;
+  write_le32 (footer, nframes);
+  footer[4] = 0;
+  write_le32 (footer + 5, ZSTD_SEEKABLE_MAGIC);
+  used += tablesize;
+
+  ZSTD_freeCCtx (cctx);
+  free (sizes);
+  free (in_buf);
+
+  /* Bail out if we are sure the user doesn't want the compression
+     forced and we are using more compressed data than original
+     data.  */
+  if (!force && used >= *orig_size)
+    {
+      free (out_buf);
+      return (void *) -1;
+    }
+
+  *new_size = used;
+  return out_buf;
+}
 #endif
 
 /* Given a section, uses the (in-memory) Elf_Data to extract the
@@ -295,7 +429,8 @@ void *
 internal_function
 __libelf_compress (Elf_Scn *scn, size_t hsize, int ei_data,
 		   size_t *orig_size, size_t *orig_addralign,
-		   size_t *new_size, bool force, bool use_zstd)
+		   size_t *new_size, bool force, bool use_zstd,
+		   bool seekable)
 {
   /* The compressed data is the on-disk data.  We simplify the
      implementation a bit by asking for the (converted) in-memory
@@ -335,11 +470,17 @@ __libelf_compress (Elf_Scn *scn, size_t hsize, int ei_data,
   if (use_zstd)
     {
 #ifdef USE_ZSTD_COMPRESS
+      if (seekable)
+	return __libelf_compress_zstd_seekable (scn, hsize, ei_data,
+						orig_size, orig_addralign,
+						new_size, force, data,
+						next_data, out_buf);
       return __libelf_compress_zstd (scn, hsize, ei_data, orig_size,
 				   orig_addralign, new_size, force,
 				   data, next_data, out_buf, out_size,
 				   block);
 #else
+    (void) seekable;
     __libelf_seterrno (ELF_E_UNKNOWN_COMPRESSION_TYPE);
     return NULL;
 #endif
@@ -511,6 +652,9 @@ internal_function
 __libelf_reset_rawdata (Elf_Scn *scn, void *buf, size_t size, size_t align,
 			Elf_Type type)
 {
+  /* The data from elf_compressed_data might refer to the old data.  */
+  __libelf_stale_compressed_data (scn);
+
   /* This is the new raw data, replace and possibly free old data.  */
   scn->rawdata.d.d_off = 0;
   scn->rawdata.d.d_version = EV_CURRENT;
@@ -555,13 +699,15 @@ elf_compress (Elf_Scn *scn, int type, unsigned int flags)
   if (scn == NULL)
     return -1;
 
-  if ((flags & ~ELF_CHF_FORCE) != 0)
+  if ((flags & ~(ELF_CHF_FORCE | ELF_CHF_SEEKABLE)) != 0
+      || ((flags & ELF_CHF_SEEKABLE) != 0 && type != ELFCOMPRESS_ZSTD))
     {
       __libelf_seterrno (ELF_E_INVALID_OPERAND);
       return -1;
     }
 
   bool force = (flags & ELF_CHF_FORCE) != 0;
+  bool seekable = (flags & ELF_CHF_SEEKABLE) != 0;
 
   Elf *elf = scn->elf;
   GElf_Ehdr ehdr;
@@ -623,7 +769,7 @@ elf_compress (Elf_Scn *scn, int type, unsigned int flags)
       void *out_buf = __libelf_compress (scn, hsize, elfdata,
 					 &orig_size, &orig_addralign,
 					 &new_size, force,
-					 type == ELFCOMPRESS_ZSTD);
+					 type == ELFCOMPRESS_ZSTD, seekable);
 
       /* Compression would make section larger, don't change anything.  */
       if (out_buf == (void *) -1)
@@ -104,7 +104,8 @@ elf_compress_gnu (Elf_Scn *scn, int inflate, unsigned int flags)
       void *out_buf = __libelf_compress (scn, hsize, elfdata,
 					 &orig_size, &orig_addralign,
 					 &new_size, force,
-					 /* use_zstd */ false);
+					 /* use_zstd */ false,
+					 /* seekable */ false);
 
       /* Compression would make section larger, don't change anything.  */
       if (out_buf == (void *) -1)
@@ -0,0 +1,301 @@
+/* Get the uncompressed data of a section, decompressing it in parts.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of either
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at
+       your option) any later version
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at
+       your option) any later version
+
+   or both in parallel, as here.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <libelf.h>
+#include "libelfP.h"
+#include "common.h"
+
+#include <endian.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef USE_ZSTD
+#include <zstd.h>
+#endif
+
+
+#ifdef USE_ZSTD
+static uint32_t
+read_le32 (const char *p)
+{
+  uint32_t v;
+  memcpy (&v, p, sizeof v);
+  return le32toh (v);
+}
+
+/* Parse the seek table at the end of the SIZE bytes of zstd frames in
+   BUF.  Returns false if there is none, or it doesn't describe
+   exactly the frames in BUF decompressing to DSIZE bytes.  */
+static bool
+read_seek_table (Elf_Compressed_Data *cdata, const char *buf, size_t size,
+		 size_t dsize)
+{
+  if (size < ZSTD_SEEKABLE_FOOTER_SIZE + 8)
+    return false;
+
+  const char *footer = buf + size - ZSTD_SEEKABLE_FOOTER_SIZE;
+  if (read_le32 (footer + 5) != ZSTD_SEEKABLE_MAGIC)
+    return false;
+
+  /* Bit 7 says whether the entries have checksums, the bits below
+     bit 2 are unused and the others reserved.  */
+  uint8_t descriptor = footer[4];
+  if ((descriptor & 0x7c) != 0)
+    return false;
+  size_t entsize = (descriptor & 0x80) != 0 ? 12 : 8;
+
+  size_t nframes = read_le32 (footer);
+  if (nframes == 0
+      || nframes > ((size - ZSTD_SEEKABLE_FOOTER_SIZE - 8) / entsize))
+    return false;
+
+  size_t tablesize = 8 + nframes * entsize + ZSTD_SEEKABLE_FOOTER_SIZE;
+  const char *table = buf + size - tablesize;
+  if (read_le32 (table) != ZSTD_SEEKABLE_SKIPPABLE_MAGIC
+      || read_le32 (table + 4) != tablesize - 8)
+    return false;
+
+  uint64_t *coffs = malloc (2 * (nframes + 1) * sizeof (uint64_t));
+  unsigned char *done = calloc (nframes, 1);
+  if (coffs == NULL || done == NULL)
+    {
+      free (coffs);
+      free (done);
+      return false;
+    }
+  uint64_t *doffs = coffs + nframes + 1;
+
+  coffs[0] = 0;
+  doffs[0] = 0;
+  const char *entry = table + 8;
+  for (size_t i = 0; i < nframes; ++i, entry += entsize)
+    {
+      coffs[i + 1] = coffs[i] + read_le32 (entry);
+      doffs[i + 1] = doffs[i] + read_le32 (entry + 4);
+    }
+
+  if (coffs[nframes] != size - tablesize || doffs[nframes] != dsize)
+    {
+      free (coffs);
+      free (done);
+      return false;
+    }
+
+  cdata->cbuf = buf;
+  cdata->nframes = nframes;
+  cdata->coffs = coffs;
+  cdata->doffs = doffs;
+  cdata->done = done;
+  return true;
+}
+#endif
+
+Elf_Data *
+elf_compressed_data (Elf_Scn *scn)
+{
+  if (scn == NULL)
+    return NULL;
+
+  if (scn->cdata != NULL && ! scn->cdata->stale)
+    return &scn->cdata->d.d;
+
+  GElf_Chdr chdr;
+  if (gelf_getchdr (scn, &chdr) == NULL)
+    return NULL;
+
+  if (chdr.ch_type != ELFCOMPRESS_ZLIB
+#ifdef USE_ZSTD
+      && chdr.ch_type != ELFCOMPRESS_ZSTD
+#endif
+      )
+    {
+      __libelf_seterrno (ELF_E_UNKNOWN_COMPRESSION_TYPE);
+      return NULL;
+    }
+
+  if (! powerof2 (chdr.ch_addralign))
+    {
+      __libelf_seterrno (ELF_E_INVALID_ALIGN);
+      return NULL;
+    }
+
+  /* Like __libelf_decompress_elf take the in-memory representation.  */
+  Elf_Data *data = elf_getdata (scn, NULL);
+  if (data == NULL)
+    return NULL;
+
+  size_t hsize = (scn->elf->class == ELFCLASS32
+		  ? sizeof (Elf32_Chdr) : sizeof (Elf64_Chdr));
+  char *buf_in = (char *) data->d_buf + hsize;
+  size_t size_in = data->d_size - hsize;
+
+  Elf_Compressed_Data *cdata = calloc (1, sizeof *cdata);
+  if (cdata == NULL)
+    {
+      __libelf_seterrno (ELF_E_NOMEM);
+      return NULL;
+    }
+
+  void *buf_out = NULL;
+#ifdef USE_ZSTD
+  if (chdr.ch_type == ELFCOMPRESS_ZSTD
+      && read_seek_table (cdata, buf_in, size_in, chdr.ch_size))
+    {
+      /* Only allocate the buffer.  The pages of the frames never
+	 decompressed are never touched.  */
+      buf_out = malloc (chdr.ch_size ?: 1);
+      cdata->dctx = ZSTD_createDCtx ();
+      if (buf_out == NULL || cdata->dctx == NULL)
+	{
+	  free (buf_out);
+	  ZSTD_freeDCtx (cdata->dctx);
+	  free (cdata->coffs);
+	  free (cdata->done);
+	  free (cdata);
+	  __libelf_seterrno (ELF_E_NOMEM);
+	  return NULL;
+	}
+    }
+  else
+#endif
+    {
+      buf_out = __libelf_decompress (chdr.ch_type, buf_in, size_in,
+				     chdr.ch_size);
+      if (buf_out == NULL)
+	{
+	  free (cdata);
+	  return NULL;
+	}
+    }
+
+  cdata->d.s = scn;
+  cdata->d.d.d_buf = buf_out;
+  cdata->d.d.d_type = ELF_T_BYTE;
+  cdata->d.d.d_version = EV_CURRENT;
+  cdata->d.d.d_size = chdr.ch_size;
+  cdata->d.d.d_off = 0;
+  cdata->d.d.d_align = chdr.ch_addralign;
+  cdata->next = scn->cdata;
+  scn->cdata = cdata;
+
+  return &cdata->d.d;
+}
+
+int
+elf_compressed_range (Elf_Scn *scn, size_t offset, size_t size)
+{
+  if (scn == NULL)
+    return -1;
+
+  Elf_Compressed_Data *cdata = scn->cdata;
+  if (cdata == NULL)
+    {
+      __libelf_seterrno (ELF_E_INVALID_OPERAND);
+      return -1;
+    }
+
+#ifdef USE_ZSTD
+  size_t dsize = cdata->d.d.d_size;
+  if (cdata->nframes == 0 || cdata->stale || offset >= dsize)
+    return 0;
+  size_t end = size > dsize - offset ? dsize : offset + size;
+
+  /* Find the last frame starting at or before OFFSET.  */
+  size_t lo = 0;
+  size_t hi = cdata->nframes;
+  while (hi - lo > 1)
+    {
+      size_t mid = (lo + hi) / 2;
+      if (cdata->doffs[mid] <= offset)
+	lo = mid;
+      else
+	hi = mid;
+    }
+
+  for (size_t i = lo; i < cdata->nframes && cdata->doffs[i] < end; ++i)
+    if (! cdata->done[i])
+      {
+	char *dst = (char *) cdata->d.d.d_buf + cdata->doffs[i];
+	size_t fsize = cdata->doffs[i + 1] - cdata->doffs[i];
+	const char *src = cdata->cbuf + cdata->coffs[i];
+	size_t csize = cdata->coffs[i + 1] - cdata->coffs[i];
+	size_t ret = ZSTD_decompressDCtx (cdata->dctx, dst, fsize, src, csize);
+	if (unlikely (ZSTD_isError (ret)) || unlikely (ret != fsize))
+	  {
+	    __libelf_seterrno (ELF_E_DECOMPRESS_ERROR);
+	    return -1;
+	  }
+	cdata->done[i] = 1;
+      }
+#else
+  (void) offset;
+  (void) size;
+#endif
+
+  return 0;
+}
+
+/* Called before the section data changes.  Any data handed out must
+   stay valid until elf_end, so decompress the rest of it while the
+   compressed data is still there.  */
+void
+internal_function
+__libelf_stale_compressed_data (Elf_Scn *scn)
+{
+  Elf_Compressed_Data *cdata = scn->cdata;
+  if (cdata == NULL || cdata->stale)
+    return;
+
+  /* Nothing we can do about errors.  The frames were already corrupt
+     and the user would have gotten an error when asking for them.  */
+  elf_compressed_range (scn, 0, cdata->d.d.d_size);
+  cdata->stale = true;
+}
+
+void
+internal_function
+__libelf_free_compressed_data (Elf_Scn *scn)
+{
+  Elf_Compressed_Data *cdata = scn->cdata;
+  while (cdata != NULL)
+    {
+      Elf_Compressed_Data *next = cdata->next;
+#ifdef USE_ZSTD
+      ZSTD_freeDCtx (cdata->dctx);
+#endif
+      free (cdata->coffs);
+      free (cdata->done);
+      free (cdata->d.d.d_buf);
+      free (cdata);
+      cdata = next;
+    }
+  scn->cdata = NULL;
+}
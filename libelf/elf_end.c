@@ -156,6 +156,8 @@ elf_end (Elf *elf)
 		  /* It doesn't matter which pointer.  */
 		  free (scn->shdr.e32);
 
+		__libelf_free_compressed_data (scn);
+
 		/* Free zdata if uncompressed, but not yet used as
 		   rawdata_base.  If it is already used it will be
 		   freed below.  */
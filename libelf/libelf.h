@@ -193,8 +193,10 @@ enum
 /* Flags for elf_compress[_gnu].  */
 enum
 {
-  ELF_CHF_FORCE = 0x1
+  ELF_CHF_FORCE = 0x1,
 #define ELF_CHF_FORCE ELF_CHF_FORCE
+  ELF_CHF_SEEKABLE = 0x2
+#define ELF_CHF_SEEKABLE ELF_CHF_SEEKABLE
 };
 
 /* Identification values for recognized object files.  */
@@ -376,7 +378,12 @@ extern Elf64_Chdr *elf64_getchdr (Elf_Scn *__scn);
    ELF_CHF_FORCE then it will always compress the section, even if
    that would not reduce the size of the data section (including the
    header).  Otherwise elf_compress and elf_compress_gnu will compress
-   the section only if the total data size is reduced.
+   the section only if the total data size is reduced.  For
+   elf_compress with ELFCOMPRESS_ZSTD FLAGS can also contain
+   ELF_CHF_SEEKABLE.  Then the data is compressed as independent zstd
+   frames followed by a seek table in the zstd seekable format, so
+   elf_compressed_range can decompress parts of it.  This is still a
+   valid zstd stream for any reader.
 
    On successful compression or decompression the function returns
    one.  If (not forced) compression is requested and the data section
@@ -409,6 +416,24 @@ extern Elf64_Chdr *elf64_getchdr (Elf_Scn *__scn);
 extern int elf_compress (Elf_Scn *scn, int type, unsigned int flags);
 extern int elf_compress_gnu (Elf_Scn *scn, int compress, unsigned int flags);
 
+/* Return the uncompressed data of the SHF_COMPRESSED section SCN
+   without changing the section, unlike elf_compress.  If the section
+   was compressed with ELF_CHF_SEEKABLE only the buffer for the data
+   is allocated, and the parts of it needed have to be decompressed
+   with elf_compressed_range before they are accessed.  Otherwise all
+   data is decompressed immediately.  The returned data stays valid
+   until elf_end or until the section data is changed.  Returns NULL
+   and sets elf_errno on error.  */
+extern Elf_Data *elf_compressed_data (Elf_Scn *scn);
+
+/* Make sure the SIZE bytes at OFFSET in the data returned by
+   elf_compressed_data for SCN are decompressed.  Only the frames of a
+   section compressed with ELF_CHF_SEEKABLE covering the range that
+   were not decompressed before are decompressed, each frame at most
+   once.  The range is clipped to the size of the data.  Returns zero
+   on success, -1 and sets elf_errno on error.  */
+extern int elf_compressed_range (Elf_Scn *scn, size_t offset, size_t size);
+
 /* Set or clear flags for ELF file.  */
 extern unsigned int elf_flagelf (Elf *__elf, Elf_Cmd __cmd,
 				 unsigned int __flags);
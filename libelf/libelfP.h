@@ -169,6 +169,34 @@ typedef struct Elf_Data_List
 } Elf_Data_List;
 
 
+/* The uncompressed data of a SHF_COMPRESSED section as returned by
+   elf_compressed_data.  If the section was compressed as several zstd
+   frames with a seek table (ELF_CHF_SEEKABLE) nframes is nonzero and
+   the frames are only decompressed by elf_compressed_range.  */
+typedef struct Elf_Compressed_Data
+{
+  Elf_Data_Scn d;		/* The uncompressed data.  */
+  const char *cbuf;		/* The compressed frames.  */
+  size_t nframes;		/* Number of frames, zero if d is complete.  */
+  uint64_t *coffs;		/* Start of each frame in cbuf, nframes + 1.  */
+  uint64_t *doffs;		/* Start of each frame in d, nframes + 1.  */
+  unsigned char *done;		/* Whether each frame is decompressed.  */
+  void *dctx;			/* The ZSTD_DCtx used for the frames.  */
+  bool stale;			/* Section data changed since.  */
+  struct Elf_Compressed_Data *next; /* Earlier stale data.  */
+} Elf_Compressed_Data;
+
+/* The zstd seekable format ends with a skippable frame containing a
+   table with the compressed and decompressed size of each frame and
+   this many bytes of footer.  */
+#define ZSTD_SEEKABLE_SKIPPABLE_MAGIC	0x184D2A5E
+#define ZSTD_SEEKABLE_MAGIC		0x8F92EAB1
+#define ZSTD_SEEKABLE_FOOTER_SIZE	9
+
+/* The size of the data compressed in one frame by ELF_CHF_SEEKABLE.  */
+#define ZSTD_SEEKABLE_FRAME_SIZE	(256 * 1024)
+
+
 /* Descriptor for ELF section.  */
 struct Elf_Scn
 {
@@ -246,6 +274,9 @@ struct Elf_Scn
   size_t zdata_size;		/* If zdata_base != NULL, the size of data.  */
   size_t zdata_align;		/* If zdata_base != NULL, the addralign.  */
 
+  struct Elf_Compressed_Data *cdata; /* The data returned by
+				   elf_compressed_data.  */
+
   struct Elf_ScnList *list;	/* Pointer to the section list element the
 				   data is in.  */
 };
@@ -574,10 +605,13 @@ extern GElf_Sym *__gelf_getsym_internal (Elf_Data *__data, int __ndx,
 
 extern uint32_t __libelf_crc32 (uint32_t crc, unsigned char *buf, size_t len)
      attribute_hidden;
+extern uint32_t __libelf_crc32_combine (uint32_t crc1, uint32_t crc2,
+					uint64_t len2) attribute_hidden;
 
 extern void * __libelf_compress (Elf_Scn *scn, size_t hsize, int ei_data,
 				 size_t *orig_size, size_t *orig_addralign,
-				 size_t *size, bool force, bool use_zstd)
+				 size_t *size, bool force, bool use_zstd,
+				 bool seekable)
      internal_function;
 
 extern void * __libelf_decompress (int chtype, void *buf_in, size_t size_in,
@@ -591,6 +625,9 @@ extern void __libelf_reset_rawdata (Elf_Scn *scn, void *buf, size_t size,
 				    size_t align, Elf_Type type)
      internal_function;
 
+extern void __libelf_stale_compressed_data (Elf_Scn *scn) internal_function;
+extern void __libelf_free_compressed_data (Elf_Scn *scn) internal_function;
+
 
 /* We often have to update a flag iff a value changed.  Make this
    convenient.  */
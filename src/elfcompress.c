@@ -67,6 +67,9 @@ enum ch_type
 
 static enum ch_type type = UNSET;
 
+/* Whether ZSTD compression uses independent frames with a seek table.  */
+static bool seekable = false;
+
 struct section_pattern
 {
   char *pattern;
@@ -145,6 +148,15 @@ parse_opt (int key, char *arg __attribute__ ((unused)),
 	type = ZSTD;
 #else
 	argp_error (state, N_("ZSTD support is not enabled"));
+#endif
+      else if (strcmp ("zstd-seekable", arg) == 0)
+#ifdef USE_ZSTD_COMPRESS
+	{
+	  type = ZSTD;
+	  seekable = true;
+	}
+#else
+	argp_error (state, N_("ZSTD support is not enabled"));
 #endif
       else
 	argp_error (state, N_("unknown compression type '%s'"), arg);
@@ -224,6 +236,8 @@ compress_section (Elf_Scn *scn, size_t orig_size, const char *name,
 
   int res;
   unsigned int flags = compress && force ? ELF_CHF_FORCE : 0;
+  if (dchtype == ZSTD && seekable)
+    flags |= ELF_CHF_SEEKABLE;
   if (schtype == ZLIB_GNU || dchtype == ZLIB_GNU)
     res = elf_compress_gnu (scn, compress ? 1 : 0, flags);
   else
@@ -1409,7 +1423,7 @@ main (int argc, char **argv)
 	0 },
       { "type", 't', "TYPE", 0,
 	N_("What type of compression to apply. TYPE can be 'none' (decompress), 'zlib' (ELF ZLIB compression, the default, 'zlib-gabi' is an alias), "
-	   "'zlib-gnu' (.zdebug GNU style compression, 'gnu' is an alias) or 'zstd' (ELF ZSTD compression)"),
+	   "'zlib-gnu' (.zdebug GNU style compression, 'gnu' is an alias), 'zstd' (ELF ZSTD compression) or 'zstd-seekable' (ELF ZSTD compression in independently decompressible frames)"),
 	0 },
       { "name", 'n', "SECTION", 0,
 	N_("SECTION name to (de)compress, SECTION is an extended wildcard pattern (defaults to '.?(z)debug*')"),
@@ -4201,8 +4201,9 @@ get_debug_elf_data (Dwarf *dbg, Ebl *ebl, int idx, Elf_Scn *scn)
   /* We prefer to get the section data from the Dwarf because that
      might have been relocated already.  Note this is subtly wrong if
      there are multiple sections with the same .debug name.  */
-  if (dbg->sectiondata[idx] != NULL)
-    return dbg->sectiondata[idx];
+  Elf_Data *data = __libdw_sectiondata (dbg, idx);
+  if (data != NULL)
+    return data;
 
   GElf_Shdr shdr_mem;
   GElf_Shdr *shdr = gelf_getshdr (scn, &shdr_mem);
@@ -4217,7 +4218,7 @@ get_debug_elf_data (Dwarf *dbg, Ebl *ebl, int idx, Elf_Scn *scn)
 	}
     }
 
-  Elf_Data *data = elf_getdata (scn, NULL);
+  data = elf_getdata (scn, NULL);
   if (data == NULL)
     error (0, 0, "%s [%zd] '%s': %s\n",
 	   _("Couldn't get data from section"),
@@ -4798,7 +4799,7 @@ get_indexed_addr (Dwarf_CU *cu, Dwarf_Word idx, Dwarf_Addr *addr)
   if (cu == NULL)
     return -1;
 
-  Elf_Data *debug_addr = cu->dbg->sectiondata[IDX_debug_addr];
+  Elf_Data *debug_addr = __libdw_sectiondata (cu->dbg, IDX_debug_addr);
   if (debug_addr == NULL)
     return -1;
 
@@ -8328,7 +8329,8 @@ print_debug_units (Dwfl_Module *dwflmod,
   if (debug_types)
     {
       cu_mem.dbg = dbg;
-      cu_mem.end = dbg->sectiondata[IDX_debug_info]->d_size;
+      Elf_Data *info = __libdw_sectiondata (dbg, IDX_debug_info);
+      cu_mem.end = info != NULL ? info->d_size : 0;
       cu_mem.sec_idx = IDX_debug_info;
       cu = &cu_mem;
     }
@@ -8836,13 +8838,13 @@ print_form_data (Dwarf *dbg, int form, const unsigned char *readp,
       else
 	val = read_4ubyte_unaligned_inc (dbg, readp);
       if (form == DW_FORM_strp)
-	data = dbg->sectiondata[IDX_debug_str];
+	data = __libdw_sectiondata (dbg, IDX_debug_str);
       else if (form == DW_FORM_line_strp)
-	data = dbg->sectiondata[IDX_debug_line_str];
+	data = __libdw_sectiondata (dbg, IDX_debug_line_str);
       else /* form == DW_FORM_strp_sup */
 	{
 	  Dwarf *alt = dwarf_getalt (dbg);
-	  data = alt != NULL ? alt->sectiondata[IDX_debug_str] : NULL;
+	  data = alt != NULL ? __libdw_sectiondata (alt, IDX_debug_str) : NULL;
 	}
       if (data == NULL || val >= data->d_size
 	  || memchr (data->d_buf + val, '\0', data->d_size - val) == NULL)
@@ -8868,7 +8870,7 @@ print_form_data (Dwarf *dbg, int form, const unsigned char *readp,
 	goto invalid_data;
       get_uleb128 (val, readp, readendp);
     strx_val:
-      data = dbg->sectiondata[IDX_debug_str_offsets];
+      data = __libdw_sectiondata (dbg, IDX_debug_str_offsets);
       if (data == NULL
 	  || data->d_size - str_offsets_base < val * offset_len)
 	str = "???";
@@ -8887,7 +8889,7 @@ print_form_data (Dwarf *dbg, int form, const unsigned char *readp,
 	      else
 		idx = read_4ubyte_unaligned (dbg, strreadp);
 
-	      data = dbg->sectiondata[IDX_debug_str];
+	      data = __libdw_sectiondata (dbg, IDX_debug_str);
 	      if (data == NULL || idx >= data->d_size
 		  || memchr (data->d_buf + idx, '\0',
 			     data->d_size - idx) == NULL)
@@ -9491,7 +9493,7 @@ print_debug_line_section (Dwfl_Module *dwflmod, Ebl *ebl, GElf_Ehdr *ehdr,
 		    get_uleb128 (function_name, linep, lineendp);
 		    function_name += debug_str_offset;
 
-		    Elf_Data *str_data = dbg->sectiondata[IDX_debug_str];
+		    Elf_Data *str_data = __libdw_sectiondata (dbg, IDX_debug_str);
 		    char *function_str;
 		    if (str_data == NULL || function_name >= str_data->d_size
 			|| memchr (str_data->d_buf + function_name, '\0',
@@ -9515,7 +9517,7 @@ print_debug_line_section (Dwfl_Module *dwflmod, Ebl *ebl, GElf_Ehdr *ehdr,
 		    get_uleb128 (function_name, linep, lineendp);
 		    function_name += debug_str_offset;
 
-		    Elf_Data *str_data = dbg->sectiondata[IDX_debug_str];
+		    Elf_Data *str_data = __libdw_sectiondata (dbg, IDX_debug_str);
 		    char *function_str;
 		    if (str_data == NULL || function_name >= str_data->d_size
 			|| memchr (str_data->d_buf + function_name, '\0',
@@ -200,28 +200,10 @@ frame_callback (Dwfl_Frame *state, void *arg)
   return DWARF_CB_OK;
 }
 
-static const char*
-die_name (Dwarf_Die *die)
-{
-  Dwarf_Attribute attr;
-  const char *name;
-  name = dwarf_formstring (dwarf_attr_integrate (die,
-						 DW_AT_MIPS_linkage_name,
-						 &attr)
-			   ?: dwarf_attr_integrate (die,
-						    DW_AT_linkage_name,
-						    &attr));
-  if (name == NULL)
-    name = dwarf_diename (die);
-
-  return name;
-}
-
 static void
 print_frame (int nr, Dwarf_Addr pc, bool isactivation,
 	     Dwarf_Addr pc_adjusted, Dwfl_Module *mod,
-	     const char *symname, Dwarf_Die *cudie,
-	     Dwarf_Die *die)
+	     const char *symname, const Dwfl_Inline_Frame *inline_frame)
 {
   int width = get_addr_width (mod);
   printf ("#%-2u 0x%0*" PRIx64, nr, width, (uint64_t) pc);
@@ -277,27 +259,11 @@ print_frame (int nr, Dwarf_Addr pc, bool isactivation,
       const char* sname;
       line = col = -1;
       sname = NULL;
-      if (die != NULL)
+      if (inline_frame != NULL)
 	{
-	  Dwarf_Files *files;
-	  if (dwarf_getsrcfiles (cudie, &files, NULL) == 0)
-	    {
-	      Dwarf_Attribute attr;
-	      Dwarf_Word val;
-	      if (dwarf_formudata (dwarf_attr (die, DW_AT_call_file, &attr),
-				   &val) == 0)
-		{
-		  sname = dwarf_filesrc (files, val, NULL, NULL);
-		  if (dwarf_formudata (dwarf_attr (die, DW_AT_call_line,
-						   &attr), &val) == 0)
-		    {
-		      line = val;
-		      if (dwarf_formudata (dwarf_attr (die, DW_AT_call_column,
-						       &attr), &val) == 0)
-			col = val;
-		    }
-		}
-	    }
+	  sname = inline_frame->file;
+	  line = inline_frame->line;
+	  col = inline_frame->column;
 	}
       else
 	{
@@ -323,42 +289,13 @@ print_frame (int nr, Dwarf_Addr pc, bool isactivation,
 static void
 print_inline_frames (int *nr, Dwarf_Addr pc, bool isactivation,
 		     Dwarf_Addr pc_adjusted, Dwfl_Module *mod,
-		     const char *symname, Dwarf_Die *cudie, Dwarf_Die *die)
+		     const Dwfl_Inline_Frame *chain, int nchain)
 {
-  Dwarf_Die *scopes = NULL;
-  int nscopes = dwarf_getscopes_die (die, &scopes);
-  if (nscopes > 0)
-    {
-      /* scopes[0] == die, the lowest level, for which we already have
-	 the name.  This is the actual source location where it
-	 happened.  */
-      print_frame ((*nr)++, pc, isactivation, pc_adjusted, mod, symname,
-		   NULL, NULL);
-
-      /* last_scope is the source location where the next frame/function
-	 call was done. */
-      Dwarf_Die *last_scope = &scopes[0];
-      for (int i = 1; i < nscopes && (maxframes == 0 || *nr < maxframes); i++)
-	{
-	  Dwarf_Die *scope = &scopes[i];
-	  int tag = dwarf_tag (scope);
-	  if (tag != DW_TAG_inlined_subroutine
-	      && tag != DW_TAG_entry_point
-	      && tag != DW_TAG_subprogram)
-	    continue;
-
-	  symname = die_name (scope);
-	  print_frame ((*nr)++, pc, isactivation, pc_adjusted, mod, symname,
-		       cudie, last_scope);
-
-	  /* Found the "top-level" in which everything was inlined?  */
-	  if (tag == DW_TAG_subprogram)
-	    break;
-
-	  last_scope = scope;
-	}
-    }
-  free (scopes);
+  /* chain[0] is the lowest level, the actual source location where it
+     happened.  Each next one is where the one before was inlined.  */
+  for (int i = 0; i < nchain && (maxframes == 0 || *nr < maxframes); i++)
+    print_frame ((*nr)++, pc, isactivation, pc_adjusted, mod,
+		 chain[i].name, &chain[i]);
 }
 
 static void
@@ -379,48 +316,27 @@ print_frames (struct frames *frames, pid_t tid, int dwflerr, const char *what)
       /* Get PC->SYMNAME.  */
       Dwfl_Module *mod = dwfl_addrmodule (dwfl, pc_adjusted);
       const char *symname = NULL;
-      Dwarf_Die die_mem;
-      Dwarf_Die *die = NULL;
-      Dwarf_Die *cudie = NULL;
+      Dwfl_Inline_Frame *chain = NULL;
+      int nchain = 0;
       if (mod && ! show_quiet)
 	{
 	  if (show_debugname)
 	    {
-	      Dwarf_Addr bias = 0;
-	      Dwarf_Die *scopes = NULL;
-	      cudie = dwfl_module_addrdie (mod, pc_adjusted, &bias);
-	      int nscopes = dwarf_getscopes (cudie, pc_adjusted - bias,
-					     &scopes);
-
-	      /* Find the first function-like DIE with a name in scope.  */
-	      for (int i = 0; symname == NULL && i < nscopes; i++)
-		{
-		  Dwarf_Die *scope = &scopes[i];
-		  int tag = dwarf_tag (scope);
-		  if (tag == DW_TAG_subprogram
-		      || tag == DW_TAG_inlined_subroutine
-		      || tag == DW_TAG_entry_point)
-		    symname = die_name (scope);
-
-		  if (symname != NULL)
-		    {
-		      die_mem = *scope;
-		      die = &die_mem;
-		    }
-		}
-	      free (scopes);
+	      nchain = dwfl_module_inline_chain (mod, pc_adjusted, &chain);
+	      if (nchain > 0)
+		symname = chain[0].name;
 	    }
 
 	  if (symname == NULL)
 	    symname = dwfl_module_addrname (mod, pc_adjusted);
 	}
 
-      if (show_inlines && die != NULL)
+      if (show_inlines && nchain > 0 && chain[0].name != NULL)
 	print_inline_frames (&frame_nr, pc, isactivation, pc_adjusted, mod,
-			     symname, cudie, die);
+			     chain, nchain);
       else
 	print_frame (frame_nr++, pc, isactivation, pc_adjusted, mod, symname,
-		     NULL, NULL);
+		     NULL);
     }
 
   if (frames->frames > 0 && frame_nr == maxframes)
@@ -0,0 +1,205 @@
+/* Test the bulk append, reserve and flush functions of libasm.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <fcntl.h>
+#include ELFUTILS_HEADER(asm)
+#include ELFUTILS_HEADER(ebl)
+#include <gelf.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+
+static const char fname[] = "asm-tst10-out.o";
+
+static const uint16_t vals16[3] = { 0x0102, 0x0304, 0x0506 };
+static const uint32_t vals32[4] = { 0x0a0b0c0d, 1, 2, 0xffffffff };
+static const uint64_t vals64[2] = { 0x1122334455667788ull, 42 };
+static const char bytes[] = "0123456789abcdef";
+
+
+/* Append VAL with SIZE bytes in the byte order selected by MSB.  */
+static size_t
+put (unsigned char *buf, size_t off, uint64_t val, int size, bool msb)
+{
+  for (int i = 0; i < size; ++i)
+    buf[off + i] = val >> (8 * (msb ? size - 1 - i : i));
+  return off + size;
+}
+
+
+static int
+check_scn (Elf *elf, const char *name, const unsigned char *expect,
+	   size_t len)
+{
+  size_t shstrndx;
+  if (elf_getshdrstrndx (elf, &shstrndx) != 0)
+    return 1;
+
+  Elf_Scn *scn = NULL;
+  while ((scn = elf_nextscn (elf, scn)) != NULL)
+    {
+      GElf_Shdr shdr_mem;
+      GElf_Shdr *shdr = gelf_getshdr (scn, &shdr_mem);
+      if (shdr == NULL
+	  || strcmp (elf_strptr (elf, shstrndx, shdr->sh_name), name) != 0)
+	continue;
+
+      Elf_Data *data = elf_rawdata (scn, NULL);
+      if (data == NULL || data->d_size != len
+	  || memcmp (data->d_buf, expect, len) != 0)
+	{
+	  printf ("wrong content in section %s\n", name);
+	  return 1;
+	}
+      return 0;
+    }
+
+  printf ("section %s not found\n", name);
+  return 1;
+}
+
+
+static int
+test (int machine)
+{
+  Ebl *ebl = ebl_openbackend_machine (machine);
+  if (ebl == NULL)
+    {
+      puts ("cannot open backend library");
+      return 1;
+    }
+  bool msb = ebl_get_elfdata (ebl) == ELFDATA2MSB;
+
+  AsmCtx_t *ctx = asm_begin (fname, ebl, false);
+  if (ctx == NULL)
+    {
+      printf ("cannot create assembler context: %s\n", asm_errmsg (-1));
+      return 1;
+    }
+
+  AsmScn_t *text = asm_newscn (ctx, ".text", SHT_PROGBITS,
+			       SHF_ALLOC | SHF_EXECINSTR);
+  AsmScn_t *data = asm_newscn (ctx, ".data", SHT_PROGBITS,
+			       SHF_ALLOC | SHF_WRITE);
+  AsmScn_t *data1 = asm_newsubscn (data, 1);
+  AsmScn_t *bss = asm_newscn (ctx, ".bss", SHT_NOBITS,
+			      SHF_ALLOC | SHF_WRITE);
+  if (text == NULL || data == NULL || data1 == NULL || bss == NULL)
+    {
+      printf ("cannot create sections: %s\n", asm_errmsg (-1));
+      asm_abort (ctx);
+      return 1;
+    }
+
+  static const uint32_t zeros[4];
+  /* Only the first block of the content may carry the alignment.  */
+  if (asm_align (text, 16) != 0
+      || asm_reserve (text, 4096) != 0
+      || asm_addbytes (text, bytes, 16) != 0
+      || asm_adduint32v (text, vals32, 4) != 0
+      || asm_flushscn (text) != 0
+      || asm_adduint16v (text, vals16, 3) != 0
+      || asm_addbytes (text, bytes, 5) != 0
+      || asm_flushscn (text) != 0
+      || asm_flushscn (text) != 0
+      || asm_adduint64v (text, vals64, 2) != 0
+      || asm_adduint64v (data1, vals64, 2) != 0
+      || asm_addbytes (data, bytes, 3) != 0
+      || asm_flushscn (data1) != 0
+      || asm_addbytes (data1, bytes, 2) != 0
+      || asm_adduint32v (bss, zeros, 4) != 0
+      || asm_flushscn (bss) != 0)
+    {
+      printf ("cannot add content: %s\n", asm_errmsg (-1));
+      asm_abort (ctx);
+      return 1;
+    }
+
+  /* Only zeros can go into a NOBITS section.  */
+  if (asm_adduint32v (bss, vals32, 4) == 0)
+    {
+      puts ("nonzero content accepted for .bss");
+      asm_abort (ctx);
+      return 1;
+    }
+
+  if (asm_end (ctx) != 0)
+    {
+      printf ("cannot create output file: %s\n", asm_errmsg (-1));
+      asm_abort (ctx);
+      return 1;
+    }
+
+  unsigned char expect_text[128];
+  size_t len = 0;
+  memcpy (expect_text, bytes, 16);
+  len = 16;
+  for (int i = 0; i < 4; ++i)
+    len = put (expect_text, len, vals32[i], 4, msb);
+  for (int i = 0; i < 3; ++i)
+    len = put (expect_text, len, vals16[i], 2, msb);
+  memcpy (expect_text + len, bytes, 5);
+  len += 5;
+  for (int i = 0; i < 2; ++i)
+    len = put (expect_text, len, vals64[i], 8, msb);
+  size_t text_len = len;
+
+  /* Subsection 1 follows subsection 0 without alignment.  */
+  unsigned char expect_data[128];
+  memcpy (expect_data, bytes, 3);
+  len = 3;
+  for (int i = 0; i < 2; ++i)
+    len = put (expect_data, len, vals64[i], 8, msb);
+  memcpy (expect_data + len, bytes, 2);
+  len += 2;
+  size_t data_len = len;
+
+  int fd = open (fname, O_RDONLY);
+  Elf *elf = elf_begin (fd, ELF_C_READ, NULL);
+  if (elf == NULL)
+    {
+      printf ("cannot read output file: %s\n", elf_errmsg (-1));
+      return 1;
+    }
+  int result = (check_scn (elf, ".text", expect_text, text_len)
+		| check_scn (elf, ".data", expect_data, data_len));
+  elf_end (elf);
+  close (fd);
+
+  if (result == 0)
+    result = WEXITSTATUS (system ("../src/elflint -q asm-tst10-out.o"));
+
+  unlink (fname);
+  ebl_closebackend (ebl);
+
+  return result;
+}
+
+
+int
+main (void)
+{
+  elf_version (EV_CURRENT);
+
+  return test (EM_X86_64) | test (EM_PPC64);
+}
@@ -0,0 +1,388 @@
+/* Measure how fast libdwfl unwinds a deep stack.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+/* Usage: backtrace-bench [ITERATIONS]
+
+   Like backtrace-data, a forked child stops itself under ptrace, but
+   only after recursing DEPTH levels.  Its stack is copied once, so the
+   memory_read callback is cheap and the time goes to the unwinder.
+   The stack is unwound ITERATIONS (default 2000) times with
+   dwfl_getthreads and the frames per second are printed.  Every
+   unwind must give the same PCs as the first.  */
+
+#include <config.h>
+#include <assert.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <unistd.h>
+#include <dwarf.h>
+#if defined(__x86_64__) && defined(__linux__)
+#include <sys/ptrace.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/user.h>
+#include <fcntl.h>
+#include <string.h>
+#include <time.h>
+#include ELFUTILS_HEADER(dwfl)
+#endif
+#include "system.h"
+
+#if !defined(__x86_64__) || !defined(__linux__)
+
+int
+main (int argc __attribute__ ((unused)), char **argv)
+{
+  fprintf (stderr, "%s: x86_64 linux only test\n",
+          argv[0]);
+  return 77;
+}
+
+#else /* __x86_64__ && __linux__ */
+
+/* How deep the child recurses before it stops.  */
+#define DEPTH 64
+
+/* More frames than that are not compared.  */
+#define MAX_FRAMES (DEPTH + 32)
+
+/* The registers of the stopped child.  */
+static struct user_regs_struct user_regs;
+
+/* Copy of the [stack] mapping of the child.  */
+static Dwarf_Addr stack_start;
+static Dwarf_Addr stack_end;
+static unsigned char *stack_copy;
+
+/* The PCs of the first unwind and of the current one.  */
+static Dwarf_Addr first_pcs[MAX_FRAMES];
+static size_t nfirst;
+static Dwarf_Addr pcs[MAX_FRAMES];
+static size_t npcs;
+
+static size_t total_frames;
+
+static volatile int sink;
+
+static __attribute__ ((noinline)) int
+recurse (int n)
+{
+  if (n == 0)
+    {
+      long l = ptrace (PTRACE_TRACEME, 0, NULL, NULL);
+      assert (l == 0);
+      raise (SIGUSR1);
+      return 0;
+    }
+  /* Not a tail call.  */
+  return recurse (n - 1) + sink;
+}
+
+static int
+find_elf (Dwfl_Module *mod __attribute__ ((unused)),
+	  void **userdata __attribute__ ((unused)),
+	  const char *modname __attribute__ ((unused)),
+	  Dwarf_Addr base __attribute__ ((unused)),
+	  char **file_name __attribute__ ((unused)),
+	  Elf **elfp __attribute__ ((unused)))
+{
+  /* Not used as modules are reported explicitly.  */
+  assert (0);
+}
+
+static bool
+memory_read (Dwfl *dwfl, Dwarf_Addr addr, Dwarf_Word *result,
+	     void *dwfl_arg __attribute__ ((unused)))
+{
+  if (addr >= stack_start && addr + sizeof *result <= stack_end)
+    {
+      memcpy (result, stack_copy + (addr - stack_start), sizeof *result);
+      return true;
+    }
+
+  errno = 0;
+  long l = ptrace (PTRACE_PEEKDATA, dwfl_pid (dwfl),
+		   (void *) (uintptr_t) addr, NULL);
+  /* The unwinder can ask for an invalid address.  */
+  if (errno != 0)
+    {
+      errno = 0;
+      return false;
+    }
+  *result = l;
+  return true;
+}
+
+/* Return filename and VMA address *BASEP where its mapping starts which
+   contains ADDR.  Also remember where the stack is.  */
+
+static char *
+maps_lookup (pid_t pid, Dwarf_Addr addr, GElf_Addr *basep)
+{
+  char *fname;
+  int i = asprintf (&fname, "/proc/%ld/maps", (long) pid);
+  assert (i > 0);
+  FILE *f = fopen (fname, "r");
+  assert (f);
+  free (fname);
+  char *line = NULL;
+  size_t linesize = 0;
+  char *result = NULL;
+  *basep = 0;
+  while (getline (&line, &linesize, f) > 0)
+    {
+      unsigned long start, end, offset;
+      int n;
+      if (sscanf (line, "%lx-%lx %*s %lx %*x:%*x %*u%n",
+		  &start, &end, &offset, &n) != 3)
+	break;
+      char *filename = line + n;
+      filename += strspn (filename, " ");
+      filename[strcspn (filename, "\n")] = '\0';
+      if (strcmp (filename, "[stack]") == 0)
+	{
+	  stack_start = start;
+	  stack_end = end;
+	}
+      if (result == NULL && start <= addr && addr < end)
+	{
+	  *basep = start - offset;
+	  result = strdup (filename);
+	  assert (result);
+	}
+    }
+  free (line);
+  fclose (f);
+  return result;
+}
+
+static Dwfl_Module *
+report_module (Dwfl *dwfl, pid_t child, Dwarf_Addr addr)
+{
+  GElf_Addr base;
+  char *long_name = maps_lookup (child, addr, &base);
+  if (!long_name)
+      return NULL; // not found
+  Dwfl_Module *mod = dwfl_report_elf (dwfl, long_name, long_name, -1,
+				      base, false /* add_p_vaddr */);
+  assert (mod);
+  free (long_name);
+  assert (dwfl_addrmodule (dwfl, addr) == mod);
+  return mod;
+}
+
+static void
+copy_stack (pid_t child)
+{
+  GElf_Addr base;
+  free (maps_lookup (child, 0, &base));
+  assert (stack_end > stack_start);
+  stack_copy = malloc (stack_end - stack_start);
+  assert (stack_copy);
+
+  char *fname;
+  int i = asprintf (&fname, "/proc/%ld/mem", (long) child);
+  assert (i > 0);
+  int fd = open (fname, O_RDONLY);
+  assert (fd >= 0);
+  free (fname);
+  ssize_t n = pread_retry (fd, stack_copy, stack_end - stack_start,
+			   stack_start);
+  assert (n == (ssize_t) (stack_end - stack_start));
+  close (fd);
+}
+
+static pid_t
+next_thread (Dwfl *dwfl, void *dwfl_arg __attribute__ ((unused)),
+	     void **thread_argp)
+{
+  if (*thread_argp != NULL)
+    return 0;
+  /* Put arbitrary non-NULL value into *THREAD_ARGP as a marker so that this
+     function returns non-zero PID only once.  */
+  *thread_argp = thread_argp;
+  return dwfl_pid (dwfl);
+}
+
+static bool
+set_initial_registers (Dwfl_Thread *thread,
+		       void *thread_arg __attribute__ ((unused)))
+{
+  Dwarf_Word dwarf_regs[17];
+  dwarf_regs[0] = user_regs.rax;
+  dwarf_regs[1] = user_regs.rdx;
+  dwarf_regs[2] = user_regs.rcx;
+  dwarf_regs[3] = user_regs.rbx;
+  dwarf_regs[4] = user_regs.rsi;
+  dwarf_regs[5] = user_regs.rdi;
+  dwarf_regs[6] = user_regs.rbp;
+  dwarf_regs[7] = user_regs.rsp;
+  dwarf_regs[8] = user_regs.r8;
+  dwarf_regs[9] = user_regs.r9;
+  dwarf_regs[10] = user_regs.r10;
+  dwarf_regs[11] = user_regs.r11;
+  dwarf_regs[12] = user_regs.r12;
+  dwarf_regs[13] = user_regs.r13;
+  dwarf_regs[14] = user_regs.r14;
+  dwarf_regs[15] = user_regs.r15;
+  dwarf_regs[16] = user_regs.rip;
+  bool ok = dwfl_thread_state_registers (thread, 0, 17, dwarf_regs);
+  assert (ok);
+  return true;
+}
+
+static const Dwfl_Thread_Callbacks callbacks =
+{
+  next_thread,
+  NULL, /* get_thread */
+  memory_read,
+  set_initial_registers,
+  NULL, /* detach */
+  NULL, /* thread_detach */
+};
+
+static int
+frame_callback (Dwfl_Frame *state, void *arg __attribute__ ((unused)))
+{
+  Dwarf_Addr pc;
+  bool isactivation;
+  if (! dwfl_frame_pc (state, &pc, &isactivation))
+    error (1, 0, "%s", dwfl_errmsg (-1));
+  Dwarf_Addr pc_adjusted = pc - (isactivation ? 0 : 1);
+
+  /* Only the first unwind reports modules.  */
+  Dwfl *dwfl = dwfl_thread_dwfl (dwfl_frame_thread (state));
+  if (dwfl_addrmodule (dwfl, pc_adjusted) == NULL)
+    report_module (dwfl, dwfl_pid (dwfl), pc_adjusted);
+
+  total_frames++;
+  if (npcs == MAX_FRAMES)
+    return DWARF_CB_ABORT;
+  pcs[npcs++] = pc;
+  return DWARF_CB_OK;
+}
+
+static int
+thread_callback (Dwfl_Thread *thread, void *thread_arg __attribute__ ((unused)))
+{
+  npcs = 0;
+  /* The unwind might end with an error below the entry point, which
+     is no problem as long as all of the recursion got unwound.  */
+  dwfl_thread_getframes (thread, frame_callback, NULL);
+  return DWARF_CB_OK;
+}
+
+static double
+elapsed (struct timespec *start)
+{
+  struct timespec now;
+  clock_gettime (CLOCK_MONOTONIC, &now);
+  return ((now.tv_sec - start->tv_sec)
+	  + (now.tv_nsec - start->tv_nsec) / 1e9);
+}
+
+int
+main (int argc, char **argv)
+{
+  if (argc > 2)
+    {
+      fprintf (stderr, "usage: %s [ITERATIONS]\n", argv[0]);
+      return 1;
+    }
+  unsigned long iterations = argc == 2 ? strtoul (argv[1], NULL, 0) : 2000;
+
+  elf_version (EV_CURRENT);
+
+  pid_t child = fork ();
+  switch (child)
+  {
+    case -1:
+      assert (0);
+      break;
+    case 0:
+      return recurse (DEPTH);
+    default:
+      break;
+  }
+
+  int status;
+  pid_t pid = waitpid (child, &status, 0);
+  assert (pid == child);
+  assert (WIFSTOPPED (status));
+  assert (WSTOPSIG (status) == SIGUSR1);
+
+  long l = ptrace (PTRACE_GETREGS, child, NULL, &user_regs);
+  assert (l == 0);
+  copy_stack (child);
+
+  static char *debuginfo_path;
+  static const Dwfl_Callbacks offline_callbacks =
+    {
+      .find_debuginfo = dwfl_standard_find_debuginfo,
+      .debuginfo_path = &debuginfo_path,
+      .section_address = dwfl_offline_section_address,
+      .find_elf = find_elf,
+    };
+  Dwfl *dwfl = dwfl_begin (&offline_callbacks);
+  assert (dwfl);
+  report_module (dwfl, child, user_regs.rip);
+
+  bool ok = dwfl_attach_state (dwfl, EM_NONE, child, &callbacks, NULL);
+  assert (ok);
+
+  /* The first unwind loads the modules and their CFI.  */
+  int err = dwfl_getthreads (dwfl, thread_callback, NULL);
+  assert (! err);
+  nfirst = npcs;
+  memcpy (first_pcs, pcs, npcs * sizeof pcs[0]);
+  if (nfirst < DEPTH)
+    error (1, 0, "only %zu frames unwound: %s", nfirst, dwfl_errmsg (-1));
+
+  int result = 0;
+  total_frames = 0;
+  struct timespec start;
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  for (unsigned long i = 0; i < iterations; ++i)
+    {
+      err = dwfl_getthreads (dwfl, thread_callback, NULL);
+      assert (! err);
+      if (npcs != nfirst
+	  || memcmp (pcs, first_pcs, npcs * sizeof pcs[0]) != 0)
+	{
+	  printf ("unwind %lu differs from the first\n", i);
+	  result = 1;
+	  break;
+	}
+    }
+  double secs = elapsed (&start);
+  printf ("%zu frames in %.3f s, %.0f frames/s\n", total_frames, secs,
+	  secs > 0 ? total_frames / secs : 0);
+
+  dwfl_end (dwfl);
+  free (stack_copy);
+  kill (child, SIGKILL);
+  pid = waitpid (child, &status, 0);
+  assert (pid == child);
+  assert (WIFSIGNALED (status));
+  assert (WTERMSIG (status) == SIGKILL);
+
+  return result;
+}
+
+#endif /* x86_64 */
@@ -0,0 +1,163 @@
+/* Check and measure the crc32 implementation used for .gnu_debuglink.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+/* Usage: crc32-bench [-f] [SIZE]
+
+   Compares crc32 and crc32_combine with a bitwise reference for all
+   short lengths and alignments, then times the reference and crc32 on
+   SIZE (default 64 MiB) bytes of random data.  With -f the data is
+   also written to a temporary file whose checksum is computed with
+   crc32_file, which uses several threads for big files.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "system.h"
+#include "libeu.h"
+
+
+static uint32_t
+crc32_ref (uint32_t crc, const unsigned char *buf, size_t len)
+{
+  crc = ~crc;
+  while (len-- > 0)
+    {
+      crc ^= *buf++;
+      for (int k = 0; k < 8; ++k)
+	crc = crc & 1 ? (crc >> 1) ^ 0xedb88320 : crc >> 1;
+    }
+  return ~crc;
+}
+
+
+static double
+elapsed (struct timespec *start)
+{
+  struct timespec now;
+  clock_gettime (CLOCK_MONOTONIC, &now);
+  double res = ((now.tv_sec - start->tv_sec)
+		+ (now.tv_nsec - start->tv_nsec) / 1e9);
+  *start = now;
+  return res;
+}
+
+
+int
+main (int argc, char *argv[])
+{
+  bool file = argc > 1 && strcmp (argv[1], "-f") == 0;
+  if (file)
+    {
+      --argc;
+      ++argv;
+    }
+  if (argc > 2)
+    {
+      fprintf (stderr, "usage: %s [-f] [SIZE]\n", argv[0]);
+      return 1;
+    }
+  size_t size = argc == 2 ? strtoul (argv[1], NULL, 0) : 64 * 1024 * 1024;
+
+  /* Some slack for the alignment checks.  */
+  size_t bufsize = MAX (size, 1024);
+  unsigned char *buf = malloc (bufsize);
+  if (buf == NULL)
+    {
+      puts ("out of memory");
+      return 1;
+    }
+  srandom (42);
+  for (size_t i = 0; i < bufsize; ++i)
+    buf[i] = random ();
+
+  int result = 0;
+  for (size_t align = 0; align < 16; ++align)
+    for (size_t len = 0; len <= 512; ++len)
+      {
+	uint32_t want = crc32_ref (align, buf + align, len);
+	uint32_t got = crc32 (align, buf + align, len);
+	if (got != want)
+	  {
+	    printf ("crc32 of %zu bytes at offset %zu is %#x, expected %#x\n",
+		    len, align, got, want);
+	    result = 1;
+	  }
+	size_t split = len / 3;
+	got = crc32_combine (crc32 (align, buf + align, split),
+			     crc32 (0, buf + align + split, len - split),
+			     len - split);
+	if (got != want)
+	  {
+	    printf ("combined crc32 of %zu bytes at offset %zu is %#x,"
+		    " expected %#x\n", len, align, got, want);
+	    result = 1;
+	  }
+      }
+
+  struct timespec start;
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  uint32_t want = crc32_ref (0, buf, size);
+  double reftime = elapsed (&start);
+  uint32_t got = crc32 (0, buf, size);
+  double crctime = elapsed (&start);
+  if (got != want)
+    {
+      printf ("crc32 of %zu bytes is %#x, expected %#x\n", size, got, want);
+      result = 1;
+    }
+  printf ("%zu bytes, reference: %.3f s, crc32: %.3f s\n",
+	  size, reftime, crctime);
+
+  if (file)
+    {
+      char fname[] = "crc32-bench.XXXXXX";
+      int fd = mkstemp (fname);
+      if (fd < 0)
+	{
+	  puts ("cannot create temporary file");
+	  return 1;
+	}
+      unlink (fname);
+      if (write_retry (fd, buf, size) != (ssize_t) size)
+	{
+	  puts ("cannot write temporary file");
+	  return 1;
+	}
+      clock_gettime (CLOCK_MONOTONIC, &start);
+      if (crc32_file (fd, &got) != 0)
+	{
+	  puts ("crc32_file failed");
+	  result = 1;
+	}
+      else if (got != want)
+	{
+	  printf ("crc32_file is %#x, expected %#x\n", got, want);
+	  result = 1;
+	}
+      printf ("crc32_file: %.3f s\n", elapsed (&start));
+      close (fd);
+    }
+
+  free (buf);
+  return result;
+}
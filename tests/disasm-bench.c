@@ -0,0 +1,153 @@
+/* Measure disassembler throughput on the code sections of a file.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+/* Usage: disasm-bench [-d] FILE [REPEAT]
+
+   Disassembles every SHF_EXECINSTR section of FILE REPEAT times (default
+   one) with the same format string eu-objdump uses and prints the number
+   of instructions per second.  The output is discarded, so this measures
+   instruction matching and formatting only.  With -d the instructions
+   are decoded with disasm_decode instead, without any formatting.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <fcntl.h>
+#include ELFUTILS_HEADER(asm)
+#include ELFUTILS_HEADER(ebl)
+#include <gelf.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+
+static int
+count_insn (char *buf __attribute__ ((unused)),
+	    size_t len __attribute__ ((unused)), void *arg)
+{
+  ++*(size_t *) arg;
+  return 0;
+}
+
+
+int
+main (int argc, char *argv[])
+{
+  bool decode = argc > 1 && strcmp (argv[1], "-d") == 0;
+  if (decode)
+    {
+      --argc;
+      ++argv;
+    }
+  if (argc < 2 || argc > 3)
+    {
+      fprintf (stderr, "usage: %s [-d] FILE [REPEAT]\n", argv[0]);
+      return 1;
+    }
+  int repeat = argc == 3 ? atoi (argv[2]) : 1;
+
+  elf_version (EV_CURRENT);
+
+  int fd = open (argv[1], O_RDONLY);
+  if (fd == -1)
+    {
+      printf ("cannot open '%s': %m\n", argv[1]);
+      return 1;
+    }
+
+  Elf *elf = elf_begin (fd, ELF_C_READ_MMAP, NULL);
+  if (elf == NULL)
+    {
+      printf ("cannot create ELF descriptor: %s\n", elf_errmsg (-1));
+      return 1;
+    }
+
+  Ebl *ebl = ebl_openbackend (elf);
+  if (ebl == NULL)
+    {
+      puts ("cannot open backend library");
+      return 1;
+    }
+
+  DisasmCtx_t *ctx = disasm_begin (ebl, elf, NULL);
+  if (ctx == NULL)
+    {
+      puts ("cannot create disassembler context");
+      return 1;
+    }
+
+  static const char fmt[] = "%7m %.1o,%.2o,%.3o,%.4o,%.5o%34a %l";
+  size_t ninsn = 0;
+  size_t nbytes = 0;
+  struct timespec start;
+  struct timespec stop;
+  clock_gettime (CLOCK_MONOTONIC, &start);
+
+  for (int i = 0; i < repeat; ++i)
+    {
+      Elf_Scn *scn = NULL;
+      while ((scn = elf_nextscn (elf, scn)) != NULL)
+	{
+	  GElf_Shdr shdr_mem;
+	  GElf_Shdr *shdr = gelf_getshdr (scn, &shdr_mem);
+	  if (shdr == NULL || shdr->sh_type != SHT_PROGBITS
+	      || (shdr->sh_flags & SHF_EXECINSTR) == 0)
+	    continue;
+
+	  Elf_Data *data = elf_getdata (scn, NULL);
+	  if (data == NULL)
+	    continue;
+
+	  const uint8_t *cur = data->d_buf;
+	  const uint8_t *end = cur + data->d_size;
+	  nbytes += data->d_size;
+	  if (decode)
+	    {
+	      DisasmInsn insn;
+	      GElf_Addr addr = shdr->sh_addr;
+	      while (cur < end)
+		{
+		  const uint8_t *prev = cur;
+		  if (disasm_decode (ctx, &cur, end, addr, &insn) != 0)
+		    break;
+		  addr += cur - prev;
+		  ++ninsn;
+		}
+	    }
+	  else
+	    disasm_cb (ctx, &cur, end, shdr->sh_addr, fmt,
+		       count_insn, &ninsn, NULL);
+	}
+    }
+
+  clock_gettime (CLOCK_MONOTONIC, &stop);
+  double secs = ((stop.tv_sec - start.tv_sec)
+		 + (stop.tv_nsec - start.tv_nsec) / 1e9);
+
+  printf ("%zu instructions, %zu bytes in %.3f s: %.0f insns/s, %.1f MB/s\n",
+	  ninsn, nbytes, secs, secs > 0 ? ninsn / secs : 0.0,
+	  secs > 0 ? nbytes / secs / 1e6 : 0.0);
+
+  disasm_end (ctx);
+  ebl_closebackend (ebl);
+  elf_end (elf);
+  close (fd);
+
+  return 0;
+}
@@ -0,0 +1,182 @@
+/* Check disasm_decode against disasm_cb.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+/* Decodes every instruction in the code sections of the given file and
+   checks the length against what disasm_cb consumes for the same
+   instruction.  For x86 the mnemonic and branch target must match the
+   text as well.  Prints how many instructions of each class were
+   found.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <fcntl.h>
+#include ELFUTILS_HEADER(asm)
+#include ELFUTILS_HEADER(ebl)
+#include <gelf.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+
+struct text
+{
+  char buf[512];
+};
+
+
+static int
+one_insn (char *buf, size_t len, void *arg)
+{
+  struct text *text = arg;
+  if (len >= sizeof (text->buf))
+    len = sizeof (text->buf) - 1;
+  memcpy (text->buf, buf, len);
+  text->buf[len] = '\0';
+
+  /* Stop after the first instruction.  */
+  return 1;
+}
+
+
+int
+main (int argc, char *argv[])
+{
+  if (argc != 2)
+    {
+      fprintf (stderr, "usage: %s FILE\n", argv[0]);
+      return 1;
+    }
+
+  elf_version (EV_CURRENT);
+
+  int fd = open (argv[1], O_RDONLY);
+  if (fd == -1)
+    {
+      printf ("cannot open '%s': %m\n", argv[1]);
+      return 1;
+    }
+
+  Elf *elf = elf_begin (fd, ELF_C_READ_MMAP, NULL);
+  if (elf == NULL)
+    {
+      printf ("cannot create ELF descriptor: %s\n", elf_errmsg (-1));
+      return 1;
+    }
+
+  Ebl *ebl = ebl_openbackend (elf);
+  if (ebl == NULL)
+    {
+      puts ("cannot open backend library");
+      return 1;
+    }
+
+  DisasmCtx_t *ctx = disasm_begin (ebl, elf, NULL);
+  if (ctx == NULL)
+    {
+      puts ("cannot create disassembler context");
+      return 1;
+    }
+
+  GElf_Ehdr ehdr_mem;
+  GElf_Ehdr *ehdr = gelf_getehdr (elf, &ehdr_mem);
+  bool x86 = ehdr->e_machine == EM_386 || ehdr->e_machine == EM_X86_64;
+
+  size_t count[DISASM_INSN_INVALID + 1] = { 0 };
+  size_t ntarget = 0;
+  size_t nmemop = 0;
+  int result = 0;
+
+  Elf_Scn *scn = NULL;
+  while ((scn = elf_nextscn (elf, scn)) != NULL)
+    {
+      GElf_Shdr shdr_mem;
+      GElf_Shdr *shdr = gelf_getshdr (scn, &shdr_mem);
+      if (shdr == NULL || shdr->sh_type != SHT_PROGBITS
+	  || (shdr->sh_flags & SHF_EXECINSTR) == 0)
+	continue;
+
+      Elf_Data *data = elf_getdata (scn, NULL);
+      if (data == NULL)
+	continue;
+
+      const uint8_t *start = data->d_buf;
+      const uint8_t *end = start + data->d_size;
+      const uint8_t *cur = start;
+      while (cur < end)
+	{
+	  const uint8_t *insn_start = cur;
+	  GElf_Addr addr = shdr->sh_addr + (cur - start);
+	  const uint8_t *dcur = cur;
+	  DisasmInsn insn;
+	  if (disasm_decode (ctx, &dcur, end, addr, &insn) != 0)
+	    break;
+
+	  struct text text;
+	  text.buf[0] = '\0';
+	  disasm_cb (ctx, &cur, end, addr, "%m %.1o,%.2o,%.3o", one_insn,
+		     &text, NULL);
+
+	  if (dcur != cur || insn.length != (size_t) (dcur - insn_start))
+	    {
+	      printf ("%#" PRIx64 ": length %u, disasm_cb used %td: %s\n",
+		      addr, insn.length, cur - insn_start, text.buf);
+	      result = 1;
+	      cur = dcur;
+	    }
+
+	  if (x86)
+	    {
+	      const char *mne = strstr (text.buf, insn.mnemonic);
+	      char hex[32];
+	      snprintf (hex, sizeof hex, "0x%" PRIx64, insn.target);
+	      if (mne == NULL
+		  || (mne[strlen (insn.mnemonic)] != ' '
+		      && mne[strlen (insn.mnemonic)] != '\0'))
+		{
+		  printf ("%#" PRIx64 ": mnemonic %s: %s\n", addr,
+			  insn.mnemonic, text.buf);
+		  result = 1;
+		}
+	      else if (insn.has_target && strstr (text.buf, hex) == NULL)
+		{
+		  printf ("%#" PRIx64 ": target %s: %s\n", addr, hex, text.buf);
+		  result = 1;
+		}
+	    }
+
+	  ++count[insn.insn_class];
+	  ntarget += insn.has_target;
+	  nmemop += insn.has_memop;
+	}
+    }
+
+  printf ("other %zu jump %zu cond %zu call %zu return %zu invalid %zu\n",
+	  count[DISASM_INSN_OTHER], count[DISASM_INSN_JUMP],
+	  count[DISASM_INSN_COND_JUMP], count[DISASM_INSN_CALL],
+	  count[DISASM_INSN_RETURN], count[DISASM_INSN_INVALID]);
+  printf ("targets %zu memory operands %zu\n", ntarget, nmemop);
+
+  disasm_end (ctx);
+  ebl_closebackend (ebl);
+  elf_end (elf);
+  close (fd);
+
+  return result;
+}
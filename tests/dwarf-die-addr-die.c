@@ -22,6 +22,7 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <stdio.h>
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <assert.h>
@@ -33,6 +34,10 @@
 /* The main Dwarf file.  */
 static Dwarf *dwarf;
 
+/* Whether to check the type units before anything reads .debug_info,
+   which then is not even decompressed yet.  */
+static bool types_first;
+
 int
 check_die (Dwarf_Die *die)
 {
@@ -77,8 +82,8 @@ check_die (Dwarf_Die *die)
   return res;
 }
 
-int
-check_dbg (Dwarf *dbg)
+static int
+check_cus (Dwarf *dbg)
 {
   int res = 0;
   Dwarf_Off off = 0;
@@ -100,12 +105,23 @@ check_dbg (Dwarf *dbg)
       old_off = off;
     }
 
-  // Same for type...
+  return res;
+}
+
+// Same for type...
+static int
+check_tus (Dwarf *dbg)
+{
+  int res = 0;
+  Dwarf_Off off = 0;
+  Dwarf_Off old_off = 0;
+  size_t hsize;
+  Dwarf_Off abbrev;
+  uint8_t addresssize;
+  uint8_t offsetsize;
   Dwarf_Half version;
   uint64_t typesig;
   Dwarf_Off typeoff;
-  off = 0;
-  old_off = 0;
   while (dwarf_next_unit (dbg, off, &off, &hsize, &version, &abbrev,
 			  &addresssize, &offsetsize, &typesig, &typeoff) == 0)
     {
@@ -127,6 +143,24 @@ check_dbg (Dwarf *dbg)
       old_off = off;
     }
 
+  return res;
+}
+
+int
+check_dbg (Dwarf *dbg)
+{
+  int res = 0;
+  if (types_first)
+    {
+      res |= check_tus (dbg);
+      res |= check_cus (dbg);
+    }
+  else
+    {
+      res |= check_cus (dbg);
+      res |= check_tus (dbg);
+    }
+
   Dwarf *alt = dwarf_getalt (dbg);
   if (alt != NULL)
     {
@@ -154,6 +188,13 @@ check_dbg (Dwarf *dbg)
 int
 main (int argc, char *argv[])
 {
+  if (argc > 1 && strcmp (argv[1], "--types-first") == 0)
+    {
+      types_first = true;
+      argv++;
+      argc--;
+    }
+
   if (argc < 2)
     {
       printf ("No file given.\n");
@@ -177,6 +218,18 @@ main (int argc, char *argv[])
     }
 
   printf ("checking %s\n", name);
+
+  /* An address outside any DWARF section is looked up in the main,
+     alt and split files, none of which has been read yet.  */
+  Dwarf_Die die;
+  if (types_first && dwarf_die_addr_die (dwarf, &die, &die) != NULL)
+    {
+      printf ("Found a die at a bad addr\n");
+      dwarf_end (dwarf);
+      close (fd);
+      return -1;
+    }
+
   int res = check_dbg (dwarf);
 
   dwarf_end (dwarf);
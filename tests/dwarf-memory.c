@@ -0,0 +1,155 @@
+/* Test dwarf_memory_usage, dwarf_set_memory_budget and dwarf_trim_memory.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include ELFUTILS_HEADER(dw)
+
+
+static const char *fname;
+static int result;
+
+#define check(cond)							\
+  do									\
+    if (! (cond))							\
+      {									\
+	printf ("%s: %s:%d: %s\n", fname, __FILE__, __LINE__, #cond);	\
+	result = 1;							\
+      }									\
+  while (0)
+
+
+/* Read the line tables of all CUs and return a hash of them.  Also
+   returns the size of the biggest one in *MAXSIZE.  */
+static uint64_t
+read_lines (Dwarf *dbg, size_t *maxsize)
+{
+  uint64_t hash = 0;
+  *maxsize = 0;
+  Dwarf_CU *cu = NULL;
+  Dwarf_Die cudie;
+  while (dwarf_get_units (dbg, cu, &cu, NULL, NULL, &cudie, NULL) == 0)
+    {
+      Dwarf_Lines *lines;
+      size_t nlines;
+      if (dwarf_getsrclines (&cudie, &lines, &nlines) != 0)
+	continue;
+
+      size_t size = nlines * 64;
+      if (size > *maxsize)
+	*maxsize = size;
+      for (size_t i = 0; i < nlines; ++i)
+	{
+	  Dwarf_Line *line = dwarf_onesrcline (lines, i);
+	  Dwarf_Addr addr;
+	  int lineno;
+	  dwarf_lineaddr (line, &addr);
+	  dwarf_lineno (line, &lineno);
+	  hash = hash * 31 + addr + lineno;
+	}
+      hash = hash * 31 + nlines;
+    }
+  return hash;
+}
+
+
+int
+main (int argc, char *argv[])
+{
+  if (argc != 2)
+    {
+      fprintf (stderr, "usage: %s FILE\n", argv[0]);
+      return 1;
+    }
+  fname = argv[1];
+
+  int fd = open (fname, O_RDONLY);
+  if (fd < 0)
+    {
+      perror (fname);
+      return 1;
+    }
+  Dwarf *dbg = dwarf_begin (fd, DWARF_C_READ);
+  if (dbg == NULL)
+    {
+      printf ("%s: %s\n", fname, dwarf_errmsg (-1));
+      return 1;
+    }
+
+  check (dwarf_memory_usage (NULL) >= dwarf_memory_usage (dbg));
+
+  /* Everything read is accounted for.  */
+  size_t maxsize;
+  size_t before = dwarf_memory_usage (dbg);
+  uint64_t hash = read_lines (dbg, &maxsize);
+  size_t after = dwarf_memory_usage (dbg);
+  check (after > before);
+
+  /* Evicting frees at least the line tables, which are read again
+     with the same contents.  */
+  size_t freed = dwarf_trim_memory (dbg, 0);
+  check (freed > 0);
+  check (dwarf_memory_usage (dbg) == after - freed);
+  check (dwarf_trim_memory (dbg, 0) == 0);
+  check (read_lines (dbg, &maxsize) == hash);
+  check (dwarf_memory_usage (dbg) == after);
+
+  /* A budget too small for all line tables evicts nothing by itself,
+     dwarf_trim_memory then enforces it.  */
+  size_t budget = after - freed / 2;
+  dwarf_trim_memory (dbg, 0);
+  check (dwarf_set_memory_budget (dbg, budget) == 0);
+  check (read_lines (dbg, &maxsize) == hash);
+  check (dwarf_memory_usage (dbg) == after);
+  check (dwarf_trim_memory (dbg, SIZE_MAX) > 0);
+  check (dwarf_memory_usage (dbg) <= budget);
+  check (dwarf_set_memory_budget (dbg, 0) == budget);
+
+  /* The same with a global budget.  */
+  dwarf_trim_memory (dbg, 0);
+  budget = dwarf_memory_usage (NULL) + freed / 2;
+  check (dwarf_set_memory_budget (NULL, budget) == 0);
+  check (read_lines (dbg, &maxsize) == hash);
+  check (dwarf_memory_usage (dbg) == after);
+  check (dwarf_trim_memory (dbg, SIZE_MAX) > 0);
+  check (dwarf_memory_usage (NULL) <= budget);
+  check (dwarf_set_memory_budget (NULL, 0) == budget);
+
+  /* Getting lines by file name evicts nothing either.  */
+  dwarf_trim_memory (dbg, 0);
+  dwarf_set_memory_budget (dbg, 1);
+  Dwarf_Line **srcs = NULL;
+  size_t nsrcs = 0;
+  if (dwarf_getsrc_file (dbg, "dwarf-memory-none.c", 0, 0,
+			 &srcs, &nsrcs) == 0)
+    free (srcs);
+  check (dwarf_memory_usage (dbg) == after);
+  dwarf_set_memory_budget (dbg, 0);
+
+  size_t total = dwarf_memory_usage (NULL) - dwarf_memory_usage (dbg);
+  dwarf_end (dbg);
+  check (dwarf_memory_usage (NULL) == total);
+  close (fd);
+
+  return result;
+}
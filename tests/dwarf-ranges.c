@@ -51,6 +51,34 @@ main (int argc, char *argv[])
       fprintf (stderr, "%"PRIx64"..%"PRIx64" (base %"PRIx64")\n",
 	       start, end, base);
 
+  /* Check dwarf_haspc at the bounds of each range against the
+     ranges.  The list is decoded already, so this also reads the
+     ranges a second time.  */
+  Dwarf_Addr ranges[64][2];
+  size_t nranges = 0;
+  for (ptrdiff_t off = 0;
+       nranges < 64
+       && (off = dwarf_ranges (cudie, off, &base, &start, &end)) > 0; )
+    {
+      ranges[nranges][0] = start;
+      ranges[nranges][1] = end;
+      ++nranges;
+    }
+  for (size_t i = 0; i < nranges; ++i)
+    {
+      Dwarf_Addr pcs[] = { ranges[i][0] - 1, ranges[i][0],
+			   ranges[i][1] - 1, ranges[i][1] };
+      for (size_t j = 0; j < sizeof pcs / sizeof pcs[0]; ++j)
+	{
+	  int expect = 0;
+	  for (size_t k = 0; k < nranges; ++k)
+	    if (pcs[j] >= ranges[k][0] && pcs[j] < ranges[k][1])
+	      expect = 1;
+	  if (dwarf_haspc (cudie, pcs[j]) != expect)
+	    printf ("dwarf_haspc %"PRIx64" is not %d\n", pcs[j], expect);
+	}
+    }
+
   dwarf_end (dbg);
 
   return 0;
@@ -0,0 +1,161 @@
+/* Test dwarf_getscopes and dwarf_getscopes_die with the scope tree.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+/* Every CU is asked for the scopes of many addresses from its line
+   table, so after the first query the tree is used.  Each result is
+   compared to what a new Dwarf, which has to walk the DIEs, says.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <dwarf.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include ELFUTILS_HEADER(dw)
+
+
+/* How many addresses to try per CU.  */
+#define NPCS 16
+
+static const char *fname;
+static int result;
+
+#define check(cond)							\
+  do									\
+    if (! (cond))							\
+      {									\
+	printf ("%s: %s:%d: %s\n", fname, __FILE__, __LINE__, #cond);	\
+	result = 1;							\
+      }									\
+  while (0)
+
+
+static bool
+same_scopes (Dwarf_Die *s1, int n1, Dwarf_Die *s2, int n2)
+{
+  if (n1 != n2)
+    return false;
+  for (int i = 0; i < n1; ++i)
+    if (dwarf_dieoffset (&s1[i]) != dwarf_dieoffset (&s2[i]))
+      return false;
+  return true;
+}
+
+/* Returns the CU DIE at OFFSET of a new Dwarf for ELF.  */
+static Dwarf *
+fresh_cudie (Elf *elf, Dwarf_Off offset, Dwarf_Die *cudie)
+{
+  Dwarf *dbg = dwarf_begin_elf (elf, DWARF_C_READ, NULL);
+  if (dbg == NULL || dwarf_offdie (dbg, offset, cudie) == NULL)
+    {
+      printf ("%s: cannot get CU: %s\n", fname, dwarf_errmsg (-1));
+      exit (1);
+    }
+  return dbg;
+}
+
+static void
+check_pc (Dwarf_Die *cudie, Elf *elf, Dwarf_Addr pc)
+{
+  Dwarf_Off offset = dwarf_dieoffset (cudie);
+
+  Dwarf_Die *scopes = NULL;
+  int n = dwarf_getscopes (cudie, pc, &scopes);
+
+  Dwarf_Die fresh;
+  Dwarf *dbg = fresh_cudie (elf, offset, &fresh);
+  Dwarf_Die *walked = NULL;
+  int nwalked = dwarf_getscopes (&fresh, pc, &walked);
+  check (same_scopes (scopes, n, walked, nwalked));
+  dwarf_end (dbg);
+  free (walked);
+
+  if (n > 0)
+    {
+      Dwarf_Die *die_scopes;
+      int ndie = dwarf_getscopes_die (&scopes[0], &die_scopes);
+
+      dbg = fresh_cudie (elf, offset, &fresh);
+      Dwarf_Die die;
+      check (dwarf_offdie (dbg, dwarf_dieoffset (&scopes[0]), &die) != NULL);
+      int nwalked_die = dwarf_getscopes_die (&die, &walked);
+      check (same_scopes (die_scopes, ndie, walked, nwalked_die));
+      dwarf_end (dbg);
+      if (ndie > 0)
+	free (die_scopes);
+      if (nwalked_die > 0)
+	free (walked);
+    }
+  free (scopes);
+}
+
+
+int
+main (int argc, char *argv[])
+{
+  if (argc != 2)
+    {
+      fprintf (stderr, "usage: %s FILE\n", argv[0]);
+      return 1;
+    }
+  fname = argv[1];
+
+  int fd = open (fname, O_RDONLY);
+  if (fd < 0)
+    {
+      perror (fname);
+      return 1;
+    }
+  elf_version (EV_CURRENT);
+  Elf *elf = elf_begin (fd, ELF_C_READ, NULL);
+  Dwarf *dbg = dwarf_begin_elf (elf, DWARF_C_READ, NULL);
+  if (dbg == NULL)
+    {
+      /* No DWARF, nothing to check.  */
+      elf_end (elf);
+      close (fd);
+      return 0;
+    }
+
+  Dwarf_CU *cu = NULL;
+  Dwarf_Die cudie;
+  uint8_t unit_type;
+  while (dwarf_get_units (dbg, cu, &cu, NULL, &unit_type, &cudie, NULL) == 0)
+    {
+      Dwarf_Lines *lines;
+      size_t nlines;
+      if (unit_type != DW_UT_compile
+	  || dwarf_getsrclines (&cudie, &lines, &nlines) != 0
+	  || nlines == 0)
+	continue;
+
+      for (size_t i = 0; i < nlines; i += (nlines + NPCS - 1) / NPCS)
+	{
+	  Dwarf_Addr pc;
+	  if (dwarf_lineaddr (dwarf_onesrcline (lines, i), &pc) == 0)
+	    check_pc (&cudie, elf, pc);
+	}
+    }
+
+  dwarf_end (dbg);
+  elf_end (elf);
+  close (fd);
+  return result;
+}
@@ -0,0 +1,108 @@
+/* Test dwfl_core_file_report_nt_file.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+/* Usage: dwfl-core-nt-file CORE SYSROOT
+
+   The modules found by dwfl_core_file_report are looked up in the ones
+   dwfl_core_file_report_nt_file reports, which must be at the same
+   address and have the same build ID.  The names of those not found
+   are printed.  */
+
+#include <config.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include ELFUTILS_HEADER(dwfl)
+#include "system.h"
+
+static const Dwfl_Callbacks callbacks =
+{
+  .find_elf = dwfl_build_id_find_elf,
+  .find_debuginfo = dwfl_standard_find_debuginfo,
+};
+
+static int result;
+
+static Dwfl *
+report (Elf *core, const char *sysroot, bool nt_file)
+{
+  Dwfl *dwfl = dwfl_begin (&callbacks);
+  if (dwfl == NULL || dwfl_set_sysroot (dwfl, sysroot) != 0)
+    error (EXIT_FAILURE, 0, "dwfl_begin: %s", dwfl_errmsg (-1));
+  dwfl_report_begin (dwfl);
+  int n = (nt_file
+	   ? dwfl_core_file_report_nt_file (dwfl, core, NULL)
+	   : dwfl_core_file_report (dwfl, core, NULL));
+  if (n <= 0)
+    error (EXIT_FAILURE, 0, "dwfl_core_file_report%s: %s",
+	   nt_file ? "_nt_file" : "", dwfl_errmsg (-1));
+  dwfl_report_end (dwfl, NULL, NULL);
+  return dwfl;
+}
+
+static int
+check_module (Dwfl_Module *mod, void **userdata __attribute__ ((unused)),
+	      const char *name, Dwarf_Addr start, void *arg)
+{
+  Dwfl *nt_dwfl = arg;
+  Dwfl_Module *nt_mod = dwfl_addrmodule (nt_dwfl, start);
+  Dwarf_Addr nt_start;
+  if (nt_mod == NULL
+      || (dwfl_module_info (nt_mod, NULL, &nt_start, NULL,
+			    NULL, NULL, NULL, NULL), nt_start != start))
+    {
+      printf ("not in NT_FILE: %s\n", name);
+      return DWARF_CB_OK;
+    }
+
+  const unsigned char *id, *nt_id;
+  GElf_Addr vaddr;
+  int len = dwfl_module_build_id (mod, &id, &vaddr);
+  int nt_len = dwfl_module_build_id (nt_mod, &nt_id, &vaddr);
+  if (len <= 0 || len != nt_len || memcmp (id, nt_id, len) != 0)
+    {
+      printf ("%s: build ID differs\n", name);
+      result = 1;
+    }
+  return DWARF_CB_OK;
+}
+
+int
+main (int argc, char **argv)
+{
+  if (argc != 3)
+    error (EXIT_FAILURE, 0, "usage: %s CORE SYSROOT", argv[0]);
+
+  elf_version (EV_CURRENT);
+  int fd = open (argv[1], O_RDONLY);
+  if (fd < 0)
+    error (EXIT_FAILURE, errno, "open %s", argv[1]);
+  Elf *core = elf_begin (fd, ELF_C_READ_MMAP, NULL);
+  if (core == NULL)
+    error (EXIT_FAILURE, 0, "elf_begin: %s", elf_errmsg (-1));
+
+  Dwfl *dwfl = report (core, argv[2], false);
+  Dwfl *nt_dwfl = report (core, argv[2], true);
+  dwfl_getmodules (dwfl, check_module, nt_dwfl, 0);
+
+  dwfl_end (nt_dwfl);
+  dwfl_end (dwfl);
+  elf_end (core);
+  close (fd);
+  return result;
+}
@@ -0,0 +1,225 @@
+/* Test looking up the threads of a core file by TID.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+/* Usage: dwfl-core-threads CORE [EXEC]
+
+   Prints the TID and PC of each thread dwfl_getthreads finds, then
+   checks dwfl_getthread_frames finds the same ones, in reverse order,
+   and fails for a TID that is not there.  Last unwinds all threads with
+   a fresh Dwfl from several threads at once and checks that each gets
+   the backtraces one thread got.  */
+
+#include <config.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include ELFUTILS_HEADER(dwfl)
+#include "system.h"
+
+#define MAX_THREADS 64
+#define MAX_FRAMES 64
+#define NWORKERS 8
+#define ITERATIONS 20
+
+static const Dwfl_Callbacks callbacks =
+{
+  .find_elf = dwfl_build_id_find_elf,
+  .find_debuginfo = dwfl_standard_find_debuginfo,
+};
+
+static pid_t tids[MAX_THREADS];
+static Dwarf_Addr pcs[MAX_THREADS];
+static int nthreads;
+
+struct backtrace
+{
+  int nframes;
+  int result;
+  Dwarf_Addr pcs[MAX_FRAMES];
+};
+
+static struct backtrace expected[MAX_THREADS];
+
+static int
+first_frame (Dwfl_Frame *state, void *arg)
+{
+  Dwarf_Addr *pc = arg;
+  if (! dwfl_frame_pc (state, pc, NULL))
+    error (EXIT_FAILURE, 0, "dwfl_frame_pc: %s", dwfl_errmsg (-1));
+  return DWARF_CB_ABORT;
+}
+
+static int
+thread_callback (Dwfl_Thread *thread, void *arg __attribute__ ((unused)))
+{
+  if (nthreads == MAX_THREADS)
+    error (EXIT_FAILURE, 0, "too many threads");
+  tids[nthreads] = dwfl_thread_tid (thread);
+  if (dwfl_thread_getframes (thread, first_frame, &pcs[nthreads])
+      != DWARF_CB_ABORT)
+    error (EXIT_FAILURE, 0, "dwfl_thread_getframes: %s", dwfl_errmsg (-1));
+  printf ("TID %d: %#" PRIx64 "\n", (int) tids[nthreads], pcs[nthreads]);
+  nthreads++;
+  return DWARF_CB_OK;
+}
+
+static int
+all_frames (Dwfl_Frame *state, void *arg)
+{
+  struct backtrace *bt = arg;
+  if (bt->nframes == MAX_FRAMES)
+    return DWARF_CB_ABORT;
+  if (! dwfl_frame_pc (state, &bt->pcs[bt->nframes], NULL))
+    return DWARF_CB_ABORT;
+  bt->nframes++;
+  return DWARF_CB_OK;
+}
+
+static void
+get_backtrace (Dwfl *dwfl, pid_t tid, struct backtrace *bt)
+{
+  bt->nframes = 0;
+  bt->result = dwfl_getthread_frames (dwfl, tid, all_frames, bt);
+}
+
+static Dwfl *
+attach (Elf *core, const char *exec)
+{
+  Dwfl *dwfl = dwfl_begin (&callbacks);
+  if (dwfl == NULL)
+    error (EXIT_FAILURE, 0, "dwfl_begin: %s", dwfl_errmsg (-1));
+  if (dwfl_core_file_report (dwfl, core, exec) < 0)
+    error (EXIT_FAILURE, 0, "dwfl_core_file_report: %s", dwfl_errmsg (-1));
+  if (dwfl_report_end (dwfl, NULL, NULL) != 0)
+    error (EXIT_FAILURE, 0, "dwfl_report_end: %s", dwfl_errmsg (-1));
+  if (dwfl_core_file_attach (dwfl, core) < 0)
+    error (EXIT_FAILURE, 0, "dwfl_core_file_attach: %s", dwfl_errmsg (-1));
+  return dwfl;
+}
+
+struct worker
+{
+  pthread_t thread;
+  Dwfl *dwfl;
+  int n;
+  int result;
+};
+
+/* Unwind all threads, each worker starting with another one.  */
+static void *
+worker_run (void *arg)
+{
+  struct worker *w = arg;
+  for (int iter = 0; iter < ITERATIONS; iter++)
+    for (int j = 0; j < nthreads; j++)
+      {
+	int i = (w->n + j) % nthreads;
+	struct backtrace bt;
+	get_backtrace (w->dwfl, tids[i], &bt);
+	if (bt.result != expected[i].result
+	    || bt.nframes != expected[i].nframes
+	    || memcmp (bt.pcs, expected[i].pcs,
+		       bt.nframes * sizeof bt.pcs[0]) != 0)
+	  {
+	    printf ("worker %d: TID %d: backtrace differs\n", w->n,
+		    (int) tids[i]);
+	    w->result = 1;
+	    return NULL;
+	  }
+      }
+  return NULL;
+}
+
+int
+main (int argc, char **argv)
+{
+  if (argc != 2 && argc != 3)
+    error (EXIT_FAILURE, 0, "usage: %s CORE [EXEC]", argv[0]);
+  const char *exec = argc == 3 ? argv[2] : NULL;
+
+  elf_version (EV_CURRENT);
+  int fd = open (argv[1], O_RDONLY);
+  if (fd < 0)
+    error (EXIT_FAILURE, errno, "open %s", argv[1]);
+  Elf *core = elf_begin (fd, ELF_C_READ_MMAP, NULL);
+  if (core == NULL)
+    error (EXIT_FAILURE, 0, "elf_begin: %s", elf_errmsg (-1));
+  Dwfl *dwfl = attach (core, exec);
+
+  if (dwfl_getthreads (dwfl, thread_callback, NULL) != 0)
+    error (EXIT_FAILURE, 0, "dwfl_getthreads: %s", dwfl_errmsg (-1));
+
+  int result = 0;
+  pid_t max_tid = 0;
+  for (int i = nthreads - 1; i >= 0; i--)
+    {
+      Dwarf_Addr pc;
+      if (dwfl_getthread_frames (dwfl, tids[i], first_frame, &pc)
+	  != DWARF_CB_ABORT)
+	error (EXIT_FAILURE, 0, "dwfl_getthread_frames %d: %s",
+	       (int) tids[i], dwfl_errmsg (-1));
+      if (pc != pcs[i])
+	{
+	  printf ("TID %d: dwfl_getthread_frames PC %#" PRIx64 "\n",
+		  (int) tids[i], pc);
+	  result = 1;
+	}
+      max_tid = MAX (max_tid, tids[i]);
+    }
+
+  Dwarf_Addr pc;
+  if (dwfl_getthread_frames (dwfl, max_tid + 1, first_frame, &pc) != -1)
+    {
+      printf ("TID %d found\n", (int) max_tid + 1);
+      result = 1;
+    }
+
+  for (int i = 0; i < nthreads; i++)
+    {
+      get_backtrace (dwfl, tids[i], &expected[i]);
+      printf ("TID %d: %d frames\n", (int) tids[i], expected[i].nframes);
+    }
+  dwfl_end (dwfl);
+
+  /* Nothing is loaded yet in the new Dwfl, so the workers also race to
+     load the modules and their CFI.  */
+  dwfl = attach (core, exec);
+  struct worker workers[NWORKERS];
+  for (int n = 0; n < NWORKERS; n++)
+    {
+      workers[n].dwfl = dwfl;
+      workers[n].n = n;
+      workers[n].result = 0;
+      int err = pthread_create (&workers[n].thread, NULL, worker_run,
+				&workers[n]);
+      if (err != 0)
+	error (EXIT_FAILURE, err, "pthread_create");
+    }
+  for (int n = 0; n < NWORKERS; n++)
+    {
+      pthread_join (workers[n].thread, NULL);
+      result |= workers[n].result;
+    }
+
+  dwfl_end (dwfl);
+  elf_end (core);
+  close (fd);
+  return result;
+}
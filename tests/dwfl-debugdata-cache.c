@@ -0,0 +1,104 @@
+/* Test the .gnu_debugdata cache of libdwfl.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+/* Usage: dwfl-debugdata-cache CACHEDIR FILE
+
+   Reports FILE in two Dwfl sessions at the same time and prints the
+   symbols of the first one.  The symbols of both must be the same, and
+   those from .gnu_debugdata must come from the same image.  */
+
+#include <config.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include ELFUTILS_HEADER(dwfl)
+#include "system.h"
+
+static const char *debuginfo_path = "";
+static const Dwfl_Callbacks callbacks =
+  {
+    .find_elf = dwfl_build_id_find_elf,
+    .find_debuginfo = dwfl_standard_find_debuginfo,
+    .section_address = dwfl_offline_section_address,
+    .debuginfo_path = (char **) &debuginfo_path,
+  };
+
+static Dwfl_Module *
+report (Dwfl **dwflp, const char *file)
+{
+  Dwfl *dwfl = dwfl_begin (&callbacks);
+  if (dwfl == NULL)
+    error (EXIT_FAILURE, 0, "dwfl_begin: %s", dwfl_errmsg (-1));
+  Dwfl_Module *mod = dwfl_report_offline (dwfl, file, file, -1);
+  if (mod == NULL)
+    error (EXIT_FAILURE, 0, "dwfl_report_offline: %s", dwfl_errmsg (-1));
+  dwfl_report_end (dwfl, NULL, NULL);
+  *dwflp = dwfl;
+  return mod;
+}
+
+int
+main (int argc, char **argv)
+{
+  if (argc != 3)
+    error (EXIT_FAILURE, 0, "usage: %s CACHEDIR FILE", argv[0]);
+
+  if (dwfl_set_debugdata_cache (argv[1]) != 0)
+    error (EXIT_FAILURE, errno, "dwfl_set_debugdata_cache");
+
+  Dwfl *dwfl1, *dwfl2;
+  Dwfl_Module *mod1 = report (&dwfl1, argv[2]);
+  Dwfl_Module *mod2 = report (&dwfl2, argv[2]);
+
+  int n = dwfl_module_getsymtab (mod1);
+  if (n <= 0 || dwfl_module_getsymtab (mod2) != n)
+    error (EXIT_FAILURE, 0, "dwfl_module_getsymtab: %s", dwfl_errmsg (-1));
+
+  int result = 0;
+  int shared = 0;
+  for (int i = 0; i < n; i++)
+    {
+      GElf_Sym sym1, sym2;
+      GElf_Addr addr1, addr2;
+      const char *name1 = dwfl_module_getsym_info (mod1, i, &sym1, &addr1,
+						   NULL, NULL, NULL);
+      const char *name2 = dwfl_module_getsym_info (mod2, i, &sym2, &addr2,
+						   NULL, NULL, NULL);
+      if (name1 == NULL || name2 == NULL)
+	error (EXIT_FAILURE, 0, "dwfl_module_getsym_info: %s",
+	       dwfl_errmsg (-1));
+      printf ("%2d: %s %#" PRIx64 "\n", i, name1, addr1);
+
+      if (strcmp (name1, name2) != 0 || addr1 != addr2)
+	{
+	  printf ("symbol %d differs: %s %#" PRIx64 "\n", i, name2, addr2);
+	  result = 1;
+	}
+      if (name1 == name2)
+	shared++;
+    }
+
+  if (shared == 0)
+    {
+      puts (".gnu_debugdata not shared");
+      result = 1;
+    }
+
+  dwfl_end (dwfl1);
+  dwfl_end (dwfl2);
+  return result;
+}
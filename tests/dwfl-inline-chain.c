@@ -0,0 +1,222 @@
+/* Test dwfl_module_inline_chain.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+/* The chain at every address of the line tables, and the one after, is
+   compared to what dwarf_getscopes and dwarf_getscopes_die say.  The
+   second time around the chains come from the cache.  */
+
+#include <config.h>
+#include <assert.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdio_ext.h>
+#include <stdlib.h>
+#include <string.h>
+#include <locale.h>
+#include <argp.h>
+#include ELFUTILS_HEADER(dwfl)
+#include <dwarf.h>
+#include "system.h"
+
+static int result;
+static size_t nframes;
+
+static bool
+is_function (Dwarf_Die *die)
+{
+  int tag = dwarf_tag (die);
+  return (tag == DW_TAG_subprogram
+	  || tag == DW_TAG_inlined_subroutine
+	  || tag == DW_TAG_entry_point);
+}
+
+static const char *
+die_name (Dwarf_Die *die)
+{
+  Dwarf_Attribute attr;
+  const char *name;
+  name = dwarf_formstring (dwarf_attr_integrate (die,
+						 DW_AT_MIPS_linkage_name,
+						 &attr)
+			   ?: dwarf_attr_integrate (die,
+						    DW_AT_linkage_name,
+						    &attr));
+  if (name == NULL)
+    name = dwarf_diename (die);
+  return name;
+}
+
+static bool
+same_string (const char *s1, const char *s2)
+{
+  return s1 == s2 || (s1 != NULL && s2 != NULL && strcmp (s1, s2) == 0);
+}
+
+static void
+fail (Dwarf_Addr pc, const char *what, int i)
+{
+  printf ("%#" PRIx64 ": frame %d: %s differs\n", pc, i, what);
+  result = 1;
+}
+
+/* Walk the scopes like eu-stack --inlines did.  */
+static void
+check_pc (Dwfl_Module *mod, Dwarf_Addr pc)
+{
+  Dwfl_Inline_Frame *chain;
+  int n = dwfl_module_inline_chain (mod, pc, &chain);
+  if (n < 0)
+    {
+      printf ("%#" PRIx64 ": %s\n", pc, dwfl_errmsg (-1));
+      result = 1;
+      return;
+    }
+  nframes += n;
+
+  Dwarf_Addr bias;
+  Dwarf_Die *cudie = dwfl_module_addrdie (mod, pc, &bias);
+  Dwarf_Die *scopes = NULL;
+  int nscopes = cudie == NULL ? 0 : dwarf_getscopes (cudie, pc - bias,
+						      &scopes);
+  int first = 0;
+  while (first < nscopes && ! is_function (&scopes[first]))
+    first++;
+  if (first >= nscopes)
+    {
+      if (n != 0)
+	fail (pc, "count", 0);
+      free (scopes);
+      return;
+    }
+
+  Dwarf_Die *die_scopes;
+  int ndie = dwarf_getscopes_die (&scopes[first], &die_scopes);
+  free (scopes);
+  assert (ndie > 0);
+
+  Dwarf_Files *files = NULL;
+  dwarf_getsrcfiles (cudie, &files, NULL);
+
+  int i = 0;
+  Dwarf_Die *callee = NULL;
+  for (int s = 0; s < ndie; s++)
+    {
+      Dwarf_Die *scope = &die_scopes[s];
+      if (! is_function (scope))
+	continue;
+      if (i >= n)
+	{
+	  fail (pc, "count", i);
+	  break;
+	}
+
+      const char *file = NULL;
+      int line = 0;
+      int col = 0;
+      if (callee == NULL)
+	{
+	  Dwfl_Line *lineobj = dwfl_module_getsrc (mod, pc);
+	  if (lineobj != NULL)
+	    file = dwfl_lineinfo (lineobj, NULL, &line, &col, NULL, NULL);
+	}
+      else
+	{
+	  Dwarf_Attribute attr;
+	  Dwarf_Word val;
+	  if (files != NULL
+	      && dwarf_formudata (dwarf_attr (callee, DW_AT_call_file, &attr),
+				  &val) == 0)
+	    file = dwarf_filesrc (files, val, NULL, NULL);
+	  if (dwarf_formudata (dwarf_attr (callee, DW_AT_call_line, &attr),
+			       &val) == 0)
+	    line = val;
+	  if (dwarf_formudata (dwarf_attr (callee, DW_AT_call_column, &attr),
+			       &val) == 0)
+	    col = val;
+	}
+
+      if (dwarf_dieoffset (&chain[i].die) != dwarf_dieoffset (scope))
+	fail (pc, "die", i);
+      if (! same_string (chain[i].name, die_name (scope)))
+	fail (pc, "name", i);
+      if (! same_string (chain[i].file, file))
+	fail (pc, "file", i);
+      if (chain[i].line != line || chain[i].column != col)
+	fail (pc, "line", i);
+      i++;
+
+      if (dwarf_tag (scope) == DW_TAG_subprogram)
+	break;
+      callee = scope;
+    }
+  if (i != n)
+    fail (pc, "count", i);
+  free (die_scopes);
+}
+
+static int
+check_module (Dwfl_Module *mod, void **userdata __attribute__ ((unused)),
+	      const char *name __attribute__ ((unused)),
+	      Dwarf_Addr start __attribute__ ((unused)),
+	      void *arg __attribute__ ((unused)))
+{
+  Dwarf_Addr bias;
+  Dwarf_Die *cu = NULL;
+  while ((cu = dwfl_module_nextcu (mod, cu, &bias)) != NULL)
+    {
+      Dwfl_Line *lineobj;
+      for (size_t i = 0; (lineobj = dwfl_onesrcline (cu, i)) != NULL; ++i)
+	{
+	  Dwarf_Addr addr;
+	  if (dwfl_lineinfo (lineobj, &addr, NULL, NULL, NULL, NULL) == NULL)
+	    continue;
+	  check_pc (mod, addr);
+	  check_pc (mod, addr + 1);
+	}
+    }
+  return DWARF_CB_OK;
+}
+
+int
+main (int argc, char **argv)
+{
+  /* We use no threads here which can interfere with handling a stream.  */
+  (void) __fsetlocking (stdout, FSETLOCKING_BYCALLER);
+
+  /* Set locale.  */
+  (void) setlocale (LC_ALL, "");
+
+  int remaining;
+  Dwfl *dwfl = NULL;
+  (void) argp_parse (dwfl_standard_argp (), argc, argv, 0, &remaining, &dwfl);
+  assert (dwfl != NULL);
+
+  /* Once filling the cache, once from it.  */
+  for (int pass = 0; pass < 2; pass++)
+    {
+      nframes = 0;
+      if (dwfl_getmodules (dwfl, check_module, NULL, 0) != 0)
+	error (EXIT_FAILURE, 0, "dwfl_getmodules: %s", dwfl_errmsg (-1));
+    }
+  if (nframes == 0)
+    {
+      puts ("no frames found");
+      result = 1;
+    }
+
+  dwfl_end (dwfl);
+  return result;
+}
@@ -0,0 +1,164 @@
+/* Test dwfl_module_symbol_by_name and dwfl_module_symbols_by_name.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+/* Usage: dwfl-symbol-by-name FILE [NAME...]
+
+   Looks up the name of every symbol of FILE and checks the result
+   against a linear search, then prints what is found for each NAME.  */
+
+#include <config.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include ELFUTILS_HEADER(dwfl)
+#include "system.h"
+
+static const char *debuginfo_path = "";
+static const Dwfl_Callbacks callbacks =
+  {
+    .find_elf = dwfl_build_id_find_elf,
+    .find_debuginfo = dwfl_standard_find_debuginfo,
+    .section_address = dwfl_offline_section_address,
+    .debuginfo_path = (char **) &debuginfo_path,
+  };
+
+/* The preference of dwfl_module_symbol_by_name.  */
+static int
+rank (const GElf_Sym *sym)
+{
+  if (sym->st_shndx == SHN_UNDEF
+      || GELF_ST_TYPE (sym->st_info) == STT_SECTION
+      || GELF_ST_TYPE (sym->st_info) == STT_FILE)
+    return 0;
+  switch (GELF_ST_BIND (sym->st_info))
+    {
+    case STB_GLOBAL:
+    case STB_GNU_UNIQUE:
+      return 3;
+    case STB_WEAK:
+      return 2;
+    default:
+      return 1;
+    }
+}
+
+/* What a linear search finds for NAME.  */
+static int
+linear_search (Dwfl_Module *mod, int n, const char *name)
+{
+  int best = -1;
+  int best_rank = 0;
+  for (int i = 0; i < n; i++)
+    {
+      GElf_Sym sym;
+      GElf_Addr addr;
+      const char *symname = dwfl_module_getsym_info (mod, i, &sym, &addr,
+						     NULL, NULL, NULL);
+      if (symname != NULL && strcmp (symname, name) == 0
+	  && rank (&sym) > best_rank)
+	{
+	  best = i;
+	  best_rank = rank (&sym);
+	}
+    }
+  return best;
+}
+
+int
+main (int argc, char **argv)
+{
+  if (argc < 2)
+    error (EXIT_FAILURE, 0, "usage: %s FILE [NAME...]", argv[0]);
+
+  Dwfl *dwfl = dwfl_begin (&callbacks);
+  if (dwfl == NULL)
+    error (EXIT_FAILURE, 0, "dwfl_begin: %s", dwfl_errmsg (-1));
+  Dwfl_Module *mod = dwfl_report_offline (dwfl, argv[1], argv[1], -1);
+  if (mod == NULL)
+    error (EXIT_FAILURE, 0, "dwfl_report_offline: %s", dwfl_errmsg (-1));
+  dwfl_report_end (dwfl, NULL, NULL);
+
+  int n = dwfl_module_getsymtab (mod);
+  if (n <= 0)
+    error (EXIT_FAILURE, 0, "dwfl_module_getsymtab: %s", dwfl_errmsg (-1));
+
+  int result = 0;
+  const char **names = malloc (n * sizeof *names);
+  int *ndx = malloc (n * sizeof *ndx);
+  GElf_Addr *addrs = malloc (n * sizeof *addrs);
+  if (names == NULL || ndx == NULL || addrs == NULL)
+    error (EXIT_FAILURE, errno, "malloc");
+  for (int i = 0; i < n; i++)
+    {
+      GElf_Sym sym;
+      GElf_Addr addr;
+      names[i] = dwfl_module_getsym_info (mod, i, &sym, &addr,
+					  NULL, NULL, NULL);
+      if (names[i] == NULL)
+	error (EXIT_FAILURE, 0, "dwfl_module_getsym_info: %s",
+	       dwfl_errmsg (-1));
+
+      int expect = linear_search (mod, n, names[i]);
+      int found = dwfl_module_symbol_by_name (mod, names[i], &sym, &addr,
+					      NULL, NULL, NULL);
+      if (found != expect)
+	{
+	  printf ("%s: found %d, expected %d\n", names[i], found, expect);
+	  result = 1;
+	}
+    }
+
+  /* All at once.  */
+  int found = dwfl_module_symbols_by_name (mod, n, names, ndx, addrs);
+  if (found < 0)
+    error (EXIT_FAILURE, 0, "dwfl_module_symbols_by_name: %s",
+	   dwfl_errmsg (-1));
+  for (int i = 0; i < n; i++)
+    {
+      GElf_Sym sym;
+      GElf_Addr addr = 0;
+      if (dwfl_module_symbol_by_name (mod, names[i], &sym, &addr,
+				      NULL, NULL, NULL) != ndx[i]
+	  || addr != addrs[i])
+	{
+	  printf ("%s: batch found %d %#" PRIx64 "\n", names[i], ndx[i],
+		  addrs[i]);
+	  result = 1;
+	}
+    }
+
+  for (int i = 2; i < argc; i++)
+    {
+      GElf_Sym sym;
+      GElf_Addr addr;
+      int symndx = dwfl_module_symbol_by_name (mod, argv[i], &sym, &addr,
+					       NULL, NULL, NULL);
+      if (symndx < 0)
+	printf ("%s: not found\n", argv[i]);
+      else
+	printf ("%s: %d %#" PRIx64 " %s\n", argv[i], symndx, addr,
+		(GELF_ST_BIND (sym.st_info) == STB_LOCAL ? "LOCAL"
+		 : GELF_ST_BIND (sym.st_info) == STB_WEAK ? "WEAK"
+		 : "GLOBAL"));
+    }
+
+  free (names);
+  free (ndx);
+  free (addrs);
+  dwfl_end (dwfl);
+  return result;
+}
@@ -0,0 +1,312 @@
+/* Compare the variants of the concurrent hash table.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+/* Usage: dynhash-bench [MAXTHREADS [SCALE]]
+
+   Runs two workloads with 1, 2, 4, ... up to MAXTHREADS (default 64)
+   threads on the prime sized table used by default and on the SWISS
+   variant, and prints the time each took.
+
+   abbrev: like the abbreviation tables of a program with many CUs.
+   Many small tables which are looked up by all threads, each missing
+   code being inserted by the first thread which needs it.
+
+   sig8: like the type unit signature table.  One table which starts
+   small and gets all signatures inserted while other threads look them
+   up.
+
+   SCALE (default 1) multiplies the number of operations.  Every
+   lookup result is checked.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* The SWISS variant is instantiated in dynhash-bench-swiss.c.  */
+#define NAME Swiss_Hash
+#define TYPE void *
+#define SWISS
+#include <dynamicsizehash_concurrent.h>
+
+#define NAME Prime_Hash
+#define TYPE void *
+#define NO_UNDEF
+#include <dynamicsizehash_concurrent.h>
+#undef NO_UNDEF
+#include <dynamicsizehash_concurrent.c>
+
+
+#define NCUS 2000
+#define MAXCODES 300
+#define NSIGS 200000
+
+/* The value stored for a key.  */
+#define VALUE(cu, code) ((void *) (((uintptr_t) (cu) << 16) | (code)))
+
+struct workload
+{
+  bool swiss;
+  unsigned int nthreads;
+  size_t ops;
+  /* For abbrev.  */
+  Prime_Hash *prime_cus;
+  Swiss_Hash *swiss_cus;
+  unsigned int *ncodes;
+  /* For sig8.  */
+  Prime_Hash prime_sigs;
+  Swiss_Hash swiss_sigs;
+  uint64_t *sigs;
+  bool failed;
+};
+
+struct thread
+{
+  struct workload *w;
+  unsigned int id;
+  pthread_t thread;
+};
+
+
+static uint64_t
+rnd (uint64_t *seed)
+{
+  *seed = *seed * 6364136223846793005ul + 1442695040888963407ul;
+  return *seed >> 11;
+}
+
+
+static void *
+abbrev_thread (void *arg)
+{
+  struct thread *th = arg;
+  struct workload *w = th->w;
+  uint64_t seed = th->id + 1;
+
+  for (size_t i = 0; i < w->ops; ++i)
+    {
+      unsigned int cu = rnd (&seed) % NCUS;
+      unsigned long int code = 1 + rnd (&seed) % w->ncodes[cu];
+      void *val;
+      if (w->swiss)
+	{
+	  val = Swiss_Hash_find (&w->swiss_cus[cu], code);
+	  if (val == NULL)
+	    {
+	      Swiss_Hash_insert (&w->swiss_cus[cu], code, VALUE (cu, code));
+	      val = Swiss_Hash_find (&w->swiss_cus[cu], code);
+	    }
+	}
+      else
+	{
+	  val = Prime_Hash_find (&w->prime_cus[cu], code);
+	  if (val == NULL)
+	    {
+	      Prime_Hash_insert (&w->prime_cus[cu], code, VALUE (cu, code));
+	      val = Prime_Hash_find (&w->prime_cus[cu], code);
+	    }
+	}
+      if (val != VALUE (cu, code))
+	w->failed = true;
+    }
+  return NULL;
+}
+
+
+static void *
+sig8_thread (void *arg)
+{
+  struct thread *th = arg;
+  struct workload *w = th->w;
+  uint64_t seed = th->id + 1;
+
+  /* Each thread inserts its share of the signatures and looks up
+     random ones, which might not be inserted yet.  */
+  size_t lookups = w->ops * w->nthreads / NSIGS;
+  for (size_t i = th->id; i < NSIGS; i += w->nthreads)
+    {
+      if (w->swiss)
+	Swiss_Hash_insert (&w->swiss_sigs, w->sigs[i], &w->sigs[i]);
+      else
+	Prime_Hash_insert (&w->prime_sigs, w->sigs[i], &w->sigs[i]);
+      for (size_t j = 0; j < lookups; ++j)
+	{
+	  size_t k = rnd (&seed) % NSIGS;
+	  void *val = (w->swiss
+		       ? Swiss_Hash_find (&w->swiss_sigs, w->sigs[k])
+		       : Prime_Hash_find (&w->prime_sigs, w->sigs[k]));
+	  if (val != NULL && val != &w->sigs[k])
+	    w->failed = true;
+	}
+    }
+  return NULL;
+}
+
+
+static double
+run (struct workload *w, void *(*fn) (void *))
+{
+  struct thread *threads = malloc (w->nthreads * sizeof threads[0]);
+  if (threads == NULL)
+    {
+      puts ("out of memory");
+      exit (1);
+    }
+
+  struct timespec start, end;
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  for (unsigned int i = 0; i < w->nthreads; ++i)
+    {
+      threads[i].w = w;
+      threads[i].id = i;
+      if (pthread_create (&threads[i].thread, NULL, fn, &threads[i]) != 0)
+	{
+	  puts ("cannot create thread");
+	  exit (1);
+	}
+    }
+  for (unsigned int i = 0; i < w->nthreads; ++i)
+    pthread_join (threads[i].thread, NULL);
+  clock_gettime (CLOCK_MONOTONIC, &end);
+
+  free (threads);
+  return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+
+static double
+abbrev (struct workload *w, unsigned int *ncodes)
+{
+  w->ncodes = ncodes;
+  for (unsigned int cu = 0; cu < NCUS; ++cu)
+    if (w->swiss
+	? Swiss_Hash_init (&w->swiss_cus[cu], 41) != 0
+	: Prime_Hash_init (&w->prime_cus[cu], 41) != 0)
+      {
+	puts ("cannot create table");
+	exit (1);
+      }
+
+  double time = run (w, abbrev_thread);
+
+  for (unsigned int cu = 0; cu < NCUS; ++cu)
+    if (w->swiss)
+      Swiss_Hash_free (&w->swiss_cus[cu]);
+    else
+      Prime_Hash_free (&w->prime_cus[cu]);
+  return time;
+}
+
+
+static double
+sig8 (struct workload *w)
+{
+  if (w->swiss
+      ? Swiss_Hash_init (&w->swiss_sigs, 11) != 0
+      : Prime_Hash_init (&w->prime_sigs, 11) != 0)
+    {
+      puts ("cannot create table");
+      exit (1);
+    }
+
+  double time = run (w, sig8_thread);
+
+  /* Now everything must be there.  */
+  for (size_t i = 0; i < NSIGS; ++i)
+    if ((w->swiss
+	 ? Swiss_Hash_find (&w->swiss_sigs, w->sigs[i])
+	 : Prime_Hash_find (&w->prime_sigs, w->sigs[i])) != &w->sigs[i])
+      {
+	w->failed = true;
+	break;
+      }
+
+  if (w->swiss)
+    Swiss_Hash_free (&w->swiss_sigs);
+  else
+    Prime_Hash_free (&w->prime_sigs);
+  return time;
+}
+
+
+int
+main (int argc, char *argv[])
+{
+  if (argc > 3)
+    {
+      fprintf (stderr, "usage: %s [MAXTHREADS [SCALE]]\n", argv[0]);
+      return 1;
+    }
+  unsigned int maxthreads = argc > 1 ? atoi (argv[1]) : 64;
+  size_t scale = argc > 2 ? strtoul (argv[2], NULL, 0) : 1;
+
+  struct workload w;
+  memset (&w, 0, sizeof w);
+  unsigned int *ncodes = malloc (NCUS * sizeof ncodes[0]);
+  w.prime_cus = malloc (NCUS * sizeof w.prime_cus[0]);
+  w.swiss_cus = malloc (NCUS * sizeof w.swiss_cus[0]);
+  w.sigs = malloc (NSIGS * sizeof w.sigs[0]);
+  if (ncodes == NULL || w.prime_cus == NULL || w.swiss_cus == NULL
+      || w.sigs == NULL)
+    {
+      puts ("out of memory");
+      return 1;
+    }
+
+  uint64_t seed = 42;
+  for (unsigned int cu = 0; cu < NCUS; ++cu)
+    ncodes[cu] = 10 + rnd (&seed) % (MAXCODES - 10);
+  for (size_t i = 0; i < NSIGS; ++i)
+    /* Signatures are nonzero and distinct.  */
+    w.sigs[i] = (rnd (&seed) << 20) | (i + 1);
+
+  int result = 0;
+  for (unsigned int nthreads = 1; nthreads <= maxthreads; nthreads *= 2)
+    {
+      double times[2][2];
+      for (int swiss = 0; swiss < 2; ++swiss)
+	{
+	  w.swiss = swiss;
+	  w.nthreads = nthreads;
+	  w.ops = scale * 1000000 / nthreads;
+	  times[swiss][0] = abbrev (&w, ncodes);
+	  times[swiss][1] = sig8 (&w);
+	  if (w.failed)
+	    {
+	      printf ("wrong result with %s table and %u threads\n",
+		      swiss ? "swiss" : "prime", nthreads);
+	      result = 1;
+	      w.failed = false;
+	    }
+	}
+      printf ("%2u threads  abbrev: prime %.3f s, swiss %.3f s"
+	      "  sig8: prime %.3f s, swiss %.3f s\n", nthreads,
+	      times[0][0], times[1][0], times[0][1], times[1][1]);
+    }
+
+  free (ncodes);
+  free (w.prime_cus);
+  free (w.swiss_cus);
+  free (w.sigs);
+  return result;
+}
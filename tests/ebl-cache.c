@@ -0,0 +1,199 @@
+/* Test the libebl backend cache.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+/* Usage: ebl-cache PPC64-FILE
+
+   Compares the reloc_simple_type and register_info answers of cached
+   backends with those of uncached ones, then checks that the function
+   descriptors of PPC64-FILE are resolved even though a ppc64 backend
+   without a file was opened first.  */
+
+#include <config.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include ELFUTILS_HEADER(ebl)
+#include <gelf.h>
+#include "system.h"
+
+static const struct
+{
+  GElf_Half machine;
+  const char *emulation;
+} backends[] =
+  {
+    { EM_386, "elf_i386" },
+    { EM_X86_64, "elf_x86_64" },
+    { EM_PPC, "elf_ppc" },
+    { EM_PPC64, "elf_ppc64" },
+    { EM_ARM, "ebl_arm" },
+    { EM_S390, "ebl_s390" },
+    { EM_AARCH64, "elf_aarch64" },
+    { EM_68K, "elf_m68k" },
+    { EM_LOONGARCH, "elf_loongarch" },
+  };
+
+/* Compare the backend for MACHINE, opened through the backend cache,
+   with the uncached one for EMULATION.  */
+static int
+check_backend (GElf_Half machine, const char *emulation)
+{
+  /* The second handle is copied from the cache the first one filled.  */
+  Ebl *first = ebl_openbackend_machine (machine);
+  Ebl *cached = ebl_openbackend_machine (machine);
+  Ebl *uncached = ebl_openbackend_emulation (emulation);
+  if (first == NULL || cached == NULL || uncached == NULL)
+    error (EXIT_FAILURE, 0, "cannot open backend %s", emulation);
+
+  int result = 0;
+  for (int reloc = -1; reloc <= 1100; reloc++)
+    {
+      int addsub1 = 0, addsub2 = 0;
+      Elf_Type type1 = ebl_reloc_simple_type (cached, reloc, &addsub1);
+      Elf_Type type2 = ebl_reloc_simple_type (uncached, reloc, &addsub2);
+      if (type1 != type2 || addsub1 != addsub2)
+	{
+	  printf ("%s: reloc %d: %d %d, expected %d %d\n", emulation,
+		  reloc, type1, addsub1, type2, addsub2);
+	  result = 1;
+	}
+    }
+
+  ssize_t nregs = ebl_register_info (uncached, -1, NULL, 0,
+				     NULL, NULL, NULL, NULL);
+  if (ebl_register_info (cached, -1, NULL, 0, NULL, NULL, NULL, NULL)
+      != nregs)
+    {
+      printf ("%s: number of registers differs\n", emulation);
+      result = 1;
+    }
+
+  for (int regno = -1; regno <= nregs; regno++)
+    {
+      char name1[32], name2[32];
+      const char *prefix1 = NULL, *prefix2 = NULL;
+      const char *setname1 = NULL, *setname2 = NULL;
+      int bits1 = 0, bits2 = 0, type1 = 0, type2 = 0;
+      ssize_t len1 = ebl_register_info (cached, regno, name1, sizeof name1,
+					&prefix1, &setname1, &bits1, &type1);
+      ssize_t len2 = ebl_register_info (uncached, regno, name2, sizeof name2,
+					&prefix2, &setname2, &bits2, &type2);
+      if (len1 != len2
+	  || (len1 > 0
+	      && (memcmp (name1, name2, len1) != 0
+		  || strcmp (prefix1, prefix2) != 0
+		  || strcmp (setname1, setname2) != 0
+		  || bits1 != bits2 || type1 != type2)))
+	{
+	  printf ("%s: register %d differs\n", emulation, regno);
+	  result = 1;
+	}
+    }
+
+  ebl_closebackend (first);
+  ebl_closebackend (cached);
+  ebl_closebackend (uncached);
+  return result;
+}
+
+/* Check that every function symbol of ELF in .opd is resolved to its
+   entry point.  */
+static int
+check_opd (Elf *elf, Ebl *ebl)
+{
+  size_t shstrndx;
+  if (elf_getshdrstrndx (elf, &shstrndx) != 0)
+    error (EXIT_FAILURE, 0, "elf_getshdrstrndx: %s", elf_errmsg (-1));
+
+  GElf_Shdr opd_mem, *opd = NULL;
+  Elf_Scn *symscn = NULL;
+  GElf_Word strndx = 0;
+  Elf_Scn *scn = NULL;
+  while ((scn = elf_nextscn (elf, scn)) != NULL)
+    {
+      GElf_Shdr shdr_mem, *shdr = gelf_getshdr (scn, &shdr_mem);
+      if (shdr == NULL)
+	continue;
+      const char *name = elf_strptr (elf, shstrndx, shdr->sh_name);
+      if (name != NULL && strcmp (name, ".opd") == 0)
+	opd = memcpy (&opd_mem, shdr, sizeof opd_mem);
+      else if (shdr->sh_type == SHT_SYMTAB)
+	{
+	  symscn = scn;
+	  strndx = shdr->sh_link;
+	}
+    }
+  if (opd == NULL || symscn == NULL)
+    error (EXIT_FAILURE, 0, "no .opd or .symtab");
+
+  Elf_Data *symdata = elf_getdata (symscn, NULL);
+  int nfuncs = 0, nresolved = 0;
+  GElf_Sym sym_mem, *sym;
+  for (int i = 0; (sym = gelf_getsym (symdata, i, &sym_mem)) != NULL; i++)
+    if (GELF_ST_TYPE (sym->st_info) == STT_FUNC
+	&& sym->st_value >= opd->sh_addr
+	&& sym->st_value < opd->sh_addr + opd->sh_size)
+      {
+	nfuncs++;
+	GElf_Addr addr = sym->st_value;
+	if (ebl_resolve_sym_value (ebl, &addr))
+	  nresolved++;
+	else
+	  printf ("%s not resolved\n", elf_strptr (elf, strndx, sym->st_name));
+      }
+
+  printf ("resolved %d of %d function descriptors\n", nresolved, nfuncs);
+  return nfuncs == 0 || nresolved != nfuncs;
+}
+
+int
+main (int argc, char **argv)
+{
+  if (argc != 2)
+    error (EXIT_FAILURE, 0, "usage: %s PPC64-FILE", argv[0]);
+
+  elf_version (EV_CURRENT);
+
+  /* Without a file first, then for a file with .opd.  */
+  Ebl *machine_ebl = ebl_openbackend_machine (EM_PPC64);
+  if (machine_ebl == NULL)
+    error (EXIT_FAILURE, 0, "cannot open ppc64 backend");
+
+  int fd = open (argv[1], O_RDONLY);
+  if (fd < 0)
+    error (EXIT_FAILURE, errno, "cannot open %s", argv[1]);
+  Elf *elf = elf_begin (fd, ELF_C_READ, NULL);
+  if (elf == NULL)
+    error (EXIT_FAILURE, 0, "elf_begin: %s", elf_errmsg (-1));
+  Ebl *ebl = ebl_openbackend (elf);
+  if (ebl == NULL)
+    error (EXIT_FAILURE, 0, "cannot open backend for %s", argv[1]);
+
+  int result = check_opd (elf, ebl);
+
+  ebl_closebackend (ebl);
+  ebl_closebackend (machine_ebl);
+  elf_end (elf);
+  close (fd);
+
+  for (size_t i = 0; i < sizeof backends / sizeof backends[0]; i++)
+    result |= check_backend (backends[i].machine, backends[i].emulation);
+
+  return result;
+}
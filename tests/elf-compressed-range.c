@@ -0,0 +1,149 @@
+/* Test elf_compressed_data and elf_compressed_range.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+/* Usage: elf-compressed-range PLAIN SEEKABLE
+
+   SEEKABLE must be PLAIN with .debug_info compressed by elfcompress -t
+   zstd-seekable.  Decompresses only the range of the last CU and checks
+   that the other frames were left alone, then decompresses the rest.
+   The buffer is filled with a pattern first, so that the bytes not
+   decompressed can be told apart.  */
+
+#include <config.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include ELFUTILS_HEADER(dw)
+#include <gelf.h>
+#include "system.h"
+
+#define PATTERN 0xa5
+
+static Elf *
+open_elf (const char *fname)
+{
+  int fd = open (fname, O_RDONLY);
+  if (fd < 0)
+    error (EXIT_FAILURE, errno, "cannot open %s", fname);
+  Elf *elf = elf_begin (fd, ELF_C_READ, NULL);
+  if (elf == NULL)
+    error (EXIT_FAILURE, 0, "elf_begin %s: %s", fname, elf_errmsg (-1));
+  return elf;
+}
+
+static Elf_Scn *
+find_debug_info (Elf *elf)
+{
+  size_t shstrndx;
+  if (elf_getshdrstrndx (elf, &shstrndx) != 0)
+    error (EXIT_FAILURE, 0, "elf_getshdrstrndx: %s", elf_errmsg (-1));
+
+  Elf_Scn *scn = NULL;
+  while ((scn = elf_nextscn (elf, scn)) != NULL)
+    {
+      GElf_Shdr shdr_mem, *shdr = gelf_getshdr (scn, &shdr_mem);
+      const char *name = (shdr == NULL ? NULL
+			  : elf_strptr (elf, shstrndx, shdr->sh_name));
+      if (name != NULL && strcmp (name, ".debug_info") == 0)
+	return scn;
+    }
+  error (EXIT_FAILURE, 0, "no .debug_info");
+  return NULL;
+}
+
+int
+main (int argc, char **argv)
+{
+  if (argc != 3)
+    error (EXIT_FAILURE, 0, "usage: %s PLAIN SEEKABLE", argv[0]);
+
+  elf_version (EV_CURRENT);
+
+  Elf *plain_elf = open_elf (argv[1]);
+  Elf_Data *plain = elf_getdata (find_debug_info (plain_elf), NULL);
+  if (plain == NULL)
+    error (EXIT_FAILURE, 0, "elf_getdata: %s", elf_errmsg (-1));
+
+  /* The range of the last CU.  */
+  Dwarf *dbg = dwarf_begin_elf (plain_elf, DWARF_C_READ, NULL);
+  if (dbg == NULL)
+    error (EXIT_FAILURE, 0, "dwarf_begin_elf: %s", dwarf_errmsg (-1));
+  Dwarf_Off off = 0, next, cu_off = 0;
+  size_t hsize;
+  while (dwarf_next_unit (dbg, off, &next, &hsize, NULL, NULL, NULL,
+			  NULL, NULL, NULL) == 0)
+    {
+      cu_off = off;
+      off = next;
+    }
+  size_t cu_size = off - cu_off;
+  dwarf_end (dbg);
+
+  Elf *elf = open_elf (argv[2]);
+  Elf_Scn *scn = find_debug_info (elf);
+  Elf_Data *data = elf_compressed_data (scn);
+  if (data == NULL)
+    error (EXIT_FAILURE, 0, "elf_compressed_data: %s", elf_errmsg (-1));
+  if (data->d_size != plain->d_size || off != plain->d_size)
+    error (EXIT_FAILURE, 0, "size %zd, expected %zd", data->d_size,
+	   plain->d_size);
+
+  int result = 0;
+  unsigned char *buf = data->d_buf;
+  const unsigned char *expect = plain->d_buf;
+  memset (buf, PATTERN, data->d_size);
+
+  if (elf_compressed_range (scn, cu_off, cu_size) != 0)
+    error (EXIT_FAILURE, 0, "elf_compressed_range: %s", elf_errmsg (-1));
+  if (memcmp (buf + cu_off, expect + cu_off, cu_size) != 0)
+    {
+      puts ("last CU differs");
+      result = 1;
+    }
+
+  size_t untouched = 0;
+  for (size_t i = 0; i < cu_off; i++)
+    untouched += buf[i] == PATTERN && expect[i] != PATTERN;
+  if (untouched == 0)
+    {
+      puts ("all frames before the last CU were decompressed");
+      result = 1;
+    }
+
+  /* Each frame is decompressed only once, the rest of the data now.  */
+  memset (buf + cu_off, PATTERN, cu_size);
+  if (elf_compressed_range (scn, 0, SIZE_MAX) != 0)
+    error (EXIT_FAILURE, 0, "elf_compressed_range: %s", elf_errmsg (-1));
+  if (memcmp (buf, expect, cu_off) != 0)
+    {
+      puts ("data before the last CU differs");
+      result = 1;
+    }
+  for (size_t i = cu_off; i < cu_off + cu_size; i++)
+    if (buf[i] != PATTERN)
+      {
+	puts ("last CU decompressed twice");
+	result = 1;
+	break;
+      }
+
+  elf_end (elf);
+  elf_end (plain_elf);
+  return result;
+}
@@ -0,0 +1,418 @@
+/* Measure relocation of the debug sections of a big ET_REL file.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+/* Usage: reloc-bench [COUNT]
+
+   Writes an x86_64 ET_REL file like a kernel module built with debug
+   info, with a .debug_info section that has COUNT (default 2000000)
+   relocations in .rela.debug_info.  Like in real DWARF they come in
+   runs against the same symbol: 32-bit references to .debug_str and
+   .debug_abbrev, and 64-bit addresses in .text.  The file is written
+   once in little and once in big endian byte order, so one of them is
+   relocated in host byte order and the other is not.  Both are loaded
+   with dwfl_report_offline, relocated by dwfl_module_getelf and the
+   time that took is printed.  Every relocated datum is checked.  A
+   few R_X86_64_PC32 relocations, which libdwfl does not handle, are
+   mixed in; they must be all that is left in .rela.debug_info.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include ELFUTILS_HEADER(dwfl)
+#include <fcntl.h>
+#include <gelf.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "system.h"
+
+
+static const char shstrtab[] =
+  "\0.text\0.debug_abbrev\0.debug_str\0.debug_info\0.rela.debug_info"
+  "\0.symtab\0.strtab\0.shstrtab";
+/* Offsets of the names in shstrtab.  */
+enum { N_TEXT = 1, N_ABBREV = 7, N_STR = 21, N_INFO = 32, N_RELA = 44,
+       N_SYMTAB = 61, N_STRTAB = 69, N_SHSTRTAB = 77 };
+
+/* Section indices.  */
+enum { S_TEXT = 1, S_ABBREV, S_STR, S_INFO, S_RELA, S_SYMTAB, S_STRTAB,
+       S_SHSTRTAB };
+
+static const char strtab[] = "\0init_module";
+
+#define TEXT_SIZE 0x10000
+#define FUNC_VALUE 0x40
+
+/* Symbol indices: the section symbols and one function.  */
+enum { SYM_TEXT = 1, SYM_ABBREV, SYM_STR, SYM_FUNC, NSYMS };
+
+
+struct reloc
+{
+  uint64_t offset;
+  uint32_t type;
+  uint32_t sym;
+  int64_t addend;
+};
+
+static unsigned long int seed = 1;
+
+static unsigned int
+rnd (unsigned int n)
+{
+  seed = seed * 6364136223846793005ul + 1442695040888963407ul;
+  return (seed >> 33) % n;
+}
+
+
+static Elf_Scn *
+add_section (Elf *elf, Elf64_Word name, Elf64_Word type, Elf64_Xword flags,
+	     void *buf, size_t size, Elf_Type dtype, Elf64_Word link,
+	     Elf64_Word info, Elf64_Xword entsize)
+{
+  Elf_Scn *scn = elf_newscn (elf);
+  Elf_Data *data = scn == NULL ? NULL : elf_newdata (scn);
+  GElf_Shdr shdr_mem, *shdr = scn == NULL ? NULL : gelf_getshdr (scn,
+								  &shdr_mem);
+  if (data == NULL || shdr == NULL)
+    {
+      printf ("cannot create section: %s\n", elf_errmsg (-1));
+      exit (1);
+    }
+  data->d_buf = buf;
+  data->d_size = size;
+  data->d_type = dtype;
+  data->d_align = dtype == ELF_T_BYTE ? 1 : 8;
+  shdr->sh_name = name;
+  shdr->sh_type = type;
+  shdr->sh_flags = flags;
+  shdr->sh_link = link;
+  shdr->sh_info = info;
+  shdr->sh_entsize = entsize;
+  shdr->sh_addralign = data->d_align;
+  if (gelf_update_shdr (scn, shdr) == 0)
+    {
+      printf ("cannot update section header: %s\n", elf_errmsg (-1));
+      exit (1);
+    }
+  return scn;
+}
+
+
+static void
+write_file (const char *fname, int ei_data, const struct reloc *rels,
+	    size_t nrels, size_t info_size)
+{
+  int fd = open (fname, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0)
+    {
+      printf ("cannot create %s\n", fname);
+      exit (1);
+    }
+  Elf *elf = elf_begin (fd, ELF_C_WRITE, NULL);
+  if (elf == NULL || gelf_newehdr (elf, ELFCLASS64) == 0)
+    {
+      printf ("cannot create ELF file: %s\n", elf_errmsg (-1));
+      exit (1);
+    }
+  GElf_Ehdr ehdr_mem, *ehdr = gelf_getehdr (elf, &ehdr_mem);
+  ehdr->e_ident[EI_DATA] = ei_data;
+  ehdr->e_type = ET_REL;
+  ehdr->e_machine = EM_X86_64;
+  ehdr->e_version = EV_CURRENT;
+  ehdr->e_shstrndx = S_SHSTRTAB;
+  if (gelf_update_ehdr (elf, ehdr) == 0)
+    {
+      printf ("cannot update ELF header: %s\n", elf_errmsg (-1));
+      exit (1);
+    }
+
+  static unsigned char text[TEXT_SIZE];
+  static unsigned char abbrev[256];
+  static unsigned char str[4096];
+  /* The addends are all in the relocations.  */
+  unsigned char *info = calloc (info_size, 1);
+  Elf64_Rela *rela = malloc (nrels * sizeof rela[0]);
+  if (info == NULL || rela == NULL)
+    {
+      puts ("out of memory");
+      exit (1);
+    }
+  for (size_t i = 0; i < nrels; ++i)
+    {
+      rela[i].r_offset = rels[i].offset;
+      rela[i].r_info = ELF64_R_INFO (rels[i].sym, rels[i].type);
+      rela[i].r_addend = rels[i].addend;
+    }
+
+  Elf64_Sym syms[NSYMS];
+  memset (syms, 0, sizeof syms);
+  syms[SYM_TEXT].st_info = ELF64_ST_INFO (STB_LOCAL, STT_SECTION);
+  syms[SYM_TEXT].st_shndx = S_TEXT;
+  syms[SYM_ABBREV].st_info = ELF64_ST_INFO (STB_LOCAL, STT_SECTION);
+  syms[SYM_ABBREV].st_shndx = S_ABBREV;
+  syms[SYM_STR].st_info = ELF64_ST_INFO (STB_LOCAL, STT_SECTION);
+  syms[SYM_STR].st_shndx = S_STR;
+  syms[SYM_FUNC].st_name = 1;
+  syms[SYM_FUNC].st_info = ELF64_ST_INFO (STB_GLOBAL, STT_FUNC);
+  syms[SYM_FUNC].st_shndx = S_TEXT;
+  syms[SYM_FUNC].st_value = FUNC_VALUE;
+  syms[SYM_FUNC].st_size = 16;
+
+  add_section (elf, N_TEXT, SHT_PROGBITS, SHF_ALLOC | SHF_EXECINSTR,
+	       text, sizeof text, ELF_T_BYTE, 0, 0, 0);
+  add_section (elf, N_ABBREV, SHT_PROGBITS, 0,
+	       abbrev, sizeof abbrev, ELF_T_BYTE, 0, 0, 0);
+  add_section (elf, N_STR, SHT_PROGBITS, SHF_MERGE | SHF_STRINGS,
+	       str, sizeof str, ELF_T_BYTE, 0, 0, 1);
+  add_section (elf, N_INFO, SHT_PROGBITS, 0,
+	       info, info_size, ELF_T_BYTE, 0, 0, 0);
+  add_section (elf, N_RELA, SHT_RELA, SHF_INFO_LINK,
+	       rela, nrels * sizeof rela[0], ELF_T_RELA, S_SYMTAB, S_INFO,
+	       sizeof rela[0]);
+  add_section (elf, N_SYMTAB, SHT_SYMTAB, 0,
+	       syms, sizeof syms, ELF_T_SYM, S_STRTAB, SYM_FUNC,
+	       sizeof syms[0]);
+  add_section (elf, N_STRTAB, SHT_STRTAB, 0,
+	       (void *) strtab, sizeof strtab, ELF_T_BYTE, 0, 0, 0);
+  add_section (elf, N_SHSTRTAB, SHT_STRTAB, 0,
+	       (void *) shstrtab, sizeof shstrtab, ELF_T_BYTE, 0, 0, 0);
+
+  if (elf_update (elf, ELF_C_WRITE) < 0)
+    {
+      printf ("cannot write %s: %s\n", fname, elf_errmsg (-1));
+      exit (1);
+    }
+  elf_end (elf);
+  close (fd);
+  free (info);
+  free (rela);
+}
+
+
+static uint64_t
+get (const unsigned char *p, size_t size, int ei_data)
+{
+  uint64_t v = 0;
+  for (size_t i = 0; i < size; ++i)
+    v |= (uint64_t) p[ei_data == ELFDATA2LSB ? i : size - 1 - i] << (8 * i);
+  return v;
+}
+
+
+static double
+elapsed (struct timespec *start)
+{
+  struct timespec now;
+  clock_gettime (CLOCK_MONOTONIC, &now);
+  double res = ((now.tv_sec - start->tv_sec)
+		+ (now.tv_nsec - start->tv_nsec) / 1e9);
+  *start = now;
+  return res;
+}
+
+
+static const Dwfl_Callbacks offline_callbacks =
+  {
+    .find_debuginfo = dwfl_standard_find_debuginfo,
+    .section_address = dwfl_offline_section_address,
+  };
+
+/* Relocate FNAME and check the result.  Returns the time relocation
+   took, or -1.0 for a wrong result.  */
+static double
+check_file (const char *fname, int ei_data, const struct reloc *rels,
+	    size_t nrels)
+{
+  Dwfl *dwfl = dwfl_begin (&offline_callbacks);
+  Dwfl_Module *mod = (dwfl == NULL ? NULL
+		      : dwfl_report_offline (dwfl, fname, fname, -1));
+  if (mod == NULL || dwfl_report_end (dwfl, NULL, NULL) != 0)
+    {
+      printf ("cannot report %s: %s\n", fname, dwfl_errmsg (-1));
+      exit (1);
+    }
+
+  struct timespec start;
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  GElf_Addr bias;
+  Elf *elf = dwfl_module_getelf (mod, &bias);
+  double time = elapsed (&start);
+  if (elf == NULL)
+    {
+      printf ("cannot relocate %s: %s\n", fname, dwfl_errmsg (-1));
+      exit (1);
+    }
+
+  /* Where the offline module put .text.  */
+  GElf_Addr text = 0;
+  GElf_Sym sym;
+  if (dwfl_module_getsym_info (mod, SYM_FUNC, &sym, &text, NULL, NULL,
+			       NULL) == NULL)
+    {
+      printf ("cannot get symbol: %s\n", dwfl_errmsg (-1));
+      exit (1);
+    }
+  text -= FUNC_VALUE;
+
+  Elf_Data *data = elf_rawdata (elf_getscn (elf, S_INFO), NULL);
+  if (data == NULL)
+    {
+      printf ("cannot get .debug_info: %s\n", elf_errmsg (-1));
+      exit (1);
+    }
+
+  Elf_Data *reldata = elf_getdata (elf_getscn (elf, S_RELA), NULL);
+  if (reldata == NULL)
+    {
+      printf ("cannot get .rela.debug_info: %s\n", elf_errmsg (-1));
+      exit (1);
+    }
+  size_t left = 0;
+  for (size_t i = 0; i < nrels; ++i)
+    {
+      size_t size = rels[i].type == R_X86_64_64 ? 8 : 4;
+      uint64_t want = rels[i].addend;
+      if (rels[i].type == R_X86_64_PC32)
+	{
+	  GElf_Rela rela_mem, *rela = gelf_getrela (reldata, left++,
+						    &rela_mem);
+	  if (rela == NULL || rela->r_offset != rels[i].offset)
+	    {
+	      printf ("%s: relocation %zu was not left\n", fname, i);
+	      time = -1.0;
+	      break;
+	    }
+	  want = 0;
+	}
+      else if (rels[i].sym == SYM_TEXT)
+	want += text;
+      else if (rels[i].sym == SYM_FUNC)
+	want += text + FUNC_VALUE;
+      if (size == 4)
+	want = (uint32_t) want;
+      uint64_t got = get (data->d_buf + rels[i].offset, size, ei_data);
+      if (got != want)
+	{
+	  printf ("%s: relocation %zu gives %#" PRIx64 ", expected %#"
+		  PRIx64 "\n", fname, i, got, want);
+	  time = -1.0;
+	  break;
+	}
+    }
+  if (time >= 0 && left != reldata->d_size / sizeof (Elf64_Rela))
+    {
+      printf ("%s: %zu relocations left, expected %zu\n", fname,
+	      reldata->d_size / sizeof (Elf64_Rela), left);
+      time = -1.0;
+    }
+
+  dwfl_end (dwfl);
+  return time;
+}
+
+
+int
+main (int argc, char *argv[])
+{
+  if (argc > 2)
+    {
+      fprintf (stderr, "usage: %s [COUNT]\n", argv[0]);
+      return 1;
+    }
+  size_t count = argc == 2 ? strtoul (argv[1], NULL, 0) : 2000000;
+
+  elf_version (EV_CURRENT);
+
+  struct reloc *rels = malloc (count * sizeof rels[0]);
+  if (rels == NULL)
+    {
+      puts ("out of memory");
+      return 1;
+    }
+
+  /* Lay out the relocations like the DIEs of many CUs: a reference
+     to the abbreviations, then runs of names and addresses.  */
+  uint64_t offset = 0;
+  for (size_t i = 0; i < count; )
+    {
+      unsigned int kind = rnd (8);
+      size_t run = MIN (1 + rnd (8), count - i);
+      for (size_t j = 0; j < run; ++j, ++i)
+	{
+	  offset += rnd (4);
+	  switch (kind)
+	    {
+	    case 0:
+	      rels[i].type = R_X86_64_32;
+	      rels[i].sym = SYM_ABBREV;
+	      rels[i].addend = rnd (256);
+	      break;
+	    case 1:
+	    case 2:
+	      rels[i].type = R_X86_64_64;
+	      rels[i].sym = SYM_TEXT;
+	      rels[i].addend = rnd (TEXT_SIZE);
+	      break;
+	    case 3:
+	      rels[i].type = R_X86_64_64;
+	      rels[i].sym = SYM_FUNC;
+	      rels[i].addend = rnd (16);
+	      break;
+	    default:
+	      rels[i].type = R_X86_64_32;
+	      rels[i].sym = SYM_STR;
+	      rels[i].addend = rnd (4096);
+	      break;
+	    }
+	  if (rnd (1000) == 0)
+	    rels[i].type = R_X86_64_PC32;
+	  rels[i].offset = offset;
+	  offset += rels[i].type == R_X86_64_64 ? 8 : 4;
+	}
+    }
+
+  char lsb[] = "reloc-bench-lsb.XXXXXX";
+  char msb[] = "reloc-bench-msb.XXXXXX";
+  int fd1 = mkstemp (lsb);
+  int fd2 = mkstemp (msb);
+  if (fd1 < 0 || fd2 < 0)
+    {
+      puts ("cannot create temporary file");
+      return 1;
+    }
+  close (fd1);
+  close (fd2);
+  write_file (lsb, ELFDATA2LSB, rels, count, offset);
+  write_file (msb, ELFDATA2MSB, rels, count, offset);
+
+  double lsbtime = check_file (lsb, ELFDATA2LSB, rels, count);
+  double msbtime = check_file (msb, ELFDATA2MSB, rels, count);
+  unlink (lsb);
+  unlink (msb);
+  free (rels);
+
+  if (lsbtime < 0 || msbtime < 0)
+    return 1;
+  printf ("%zu relocations, little endian: %.3f s, big endian: %.3f s\n",
+	  count, lsbtime, msbtime);
+  return 0;
+}
@@ -0,0 +1,27 @@
+#! /bin/sh
+# This file is part of elfutils.
+#
+# This file is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# elfutils is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. $srcdir/test-subr.sh
+
+# Unwind a deep stack of a stopped child many times.  Every unwind
+# must give the same frames, reusing the frames of the one before.
+
+# Like backtrace-data, this cannot be run under valgrind.
+unset VALGRIND_CMD
+
+testrun ${abs_builddir}/backtrace-bench 200
+
+exit 0
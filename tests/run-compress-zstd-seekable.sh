@@ -0,0 +1,64 @@
+#! /bin/sh
+# This file is part of elfutils.
+#
+# This file is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# elfutils is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. $srcdir/test-subr.sh
+
+if test -z "$ELFUTILS_ZSTD"; then
+  echo "elfutils built without zstd compression support"
+  exit 77
+fi
+
+# Our own readelf has a .debug_info section big enough for several
+# seekable frames.
+infile=${abs_top_builddir}/src/readelf
+if ! testrun ${abs_top_builddir}/src/readelf -S $infile \
+     | grep -q '\.debug_info'; then
+  echo "$infile has no .debug_info"
+  exit 77
+fi
+
+tempfiles readelf.seekable readelf.plain readelf.out.plain readelf.out.seekable
+
+testrun ${abs_top_builddir}/src/elfcompress -q -t none -o readelf.plain $infile
+testrun ${abs_top_builddir}/src/elfcompress -v -t zstd-seekable \
+  -o readelf.seekable readelf.plain
+testrun ${abs_top_builddir}/src/elflint --gnu-ld readelf.seekable
+testrun ${abs_top_builddir}/src/elfcmp readelf.plain readelf.seekable
+testrun ${abs_top_builddir}/src/readelf -Sz readelf.seekable \
+  | grep "ELF ZSTD" >/dev/null
+
+# elf_compressed_range only decompresses the frames of the range.
+testrun ${abs_builddir}/elf-compressed-range readelf.plain readelf.seekable
+
+# libdw only decompresses the frames of .debug_info it needs.  Reading
+# all units must give the same result as the uncompressed data, except
+# for the section offsets.
+for f in plain seekable; do
+  testrun ${abs_top_builddir}/src/readelf -N --debug-dump=info \
+    --debug-dump=line readelf.$f > readelf.out.$f
+  sed -i -e 's/ at offset 0x[0-9a-f]*:$//' readelf.out.$f
+done
+testrun_compare cat readelf.out.plain < readelf.out.seekable
+
+# Looking up a single address, and decompressing the section fully
+# after libdw got a partial view of it.
+testrun_compare ${abs_top_builddir}/src/addr2line -e readelf.seekable main <<EOF2
+$(testrun ${abs_top_builddir}/src/addr2line -e readelf.plain main)
+EOF2
+testrun ${abs_top_builddir}/src/readelf --debug-dump=info -z \
+  -x .debug_info readelf.seekable > readelf.out.seekable
+
+exit 0
@@ -0,0 +1,105 @@
+#!/usr/bin/env bash
+#
+# This file is part of elfutils.
+#
+# This file is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# elfutils is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. $srcdir/debuginfod-subr.sh
+
+# for test case debugging, uncomment:
+set -x
+unset VALGRIND_CMD
+
+# The packages are rebuilt with other data.tar compressions and containers.
+for tool in ar bsdtar xz gzip; do
+    if ! type $tool > /dev/null 2>&1; then
+        echo "need $tool"
+        exit 77
+    fi
+done
+
+# This variable is essential and ensures no time-race for claiming ports occurs
+# set base to a unique multiple of 100 not used in any other 'run-debuginfod-*' test
+base=14400
+get_ports
+DB=${PWD}/.debuginfod_tmp.sqlite
+tempfiles $DB
+export DEBUGINFOD_CACHE_PATH=${PWD}/.client_cache
+
+DEB=${abs_srcdir}/debuginfod-debs/hithere_1.0-1_amd64.deb
+DDEB=${abs_srcdir}/debuginfod-debs/hithere-dbgsym_1.0-1_amd64.ddeb
+BUILDID=f17a29b5a25bd4960531d82aa6b07c8abe84fa66
+
+# Unpack the members, with data.tar uncompressed.
+mkdir deb ddeb
+(cd deb && ar x $DEB && xz -d data.tar.xz)
+(cd ddeb && ar x $DDEB && xz -d data.tar.xz)
+
+# Each package goes in a directory of its own, since they all have the
+# same build id.
+mkdir P P/xz P/gz P/ipk P/ddeb-xz P/ddeb-gz
+cp $DEB P/xz/hithere.deb
+cp $DDEB P/ddeb-xz/hithere-dbgsym.ddeb
+(cd deb && gzip -n -c data.tar > data.tar.gz &&
+ ar rc ../P/gz/hithere.deb debian-binary control.tar.xz data.tar.gz)
+(cd ddeb && gzip -n -c data.tar > data.tar.gz &&
+ ar rc ../P/ddeb-gz/hithere-dbgsym.ddeb debian-binary control.tar.xz data.tar.gz)
+# An opkg package is a gzip'd tar, not an ar file.
+(cd deb && bsdtar -czf ../P/ipk/hithere.ipk ./debian-binary ./control.tar.xz ./data.tar.gz)
+if [ "$zstd" != "false" ] && type zstd > /dev/null 2>&1; then
+    mkdir P/zst P/ddeb-zst
+    (cd deb && zstd -q data.tar -o data.tar.zst &&
+     ar rc ../P/zst/hithere.deb debian-binary control.tar.xz data.tar.zst)
+    (cd ddeb && zstd -q data.tar -o data.tar.zst &&
+     ar rc ../P/ddeb-zst/hithere-dbgsym.ddeb debian-binary control.tar.xz data.tar.zst)
+fi
+
+for dir in P/*; do
+    pkg=$(echo $dir/*)
+    case $pkg in
+        *.ddeb) type=debuginfo; member=./usr/lib/debug/.build-id/f1/7a29b5a25bd4960531d82aa6b07c8abe84fa66.debug ;;
+        *) type=executable; member=./usr/bin/hithere ;;
+    esac
+
+    # What the data.tar member extracted by bsdtar, the old -U decoder, has.
+    bsdtar -O -x -f - 'data.tar*' < $pkg | bsdtar -O -x -f - $member > expected
+
+    rm -rf $DB* $DEBUGINFOD_CACHE_PATH
+    env LD_LIBRARY_PATH=$ldpath ${abs_builddir}/../debuginfod/debuginfod $VERBOSE -U -p $PORT1 -d $DB -t0 -g0 -v $dir > vlog$PORT1 2>&1 &
+    PID1=$!
+    tempfiles vlog$PORT1
+    errfiles vlog$PORT1
+    wait_ready $PORT1 'ready' 1
+    wait_ready $PORT1 'thread_work_total{role="traverse"}' 1
+    wait_ready $PORT1 'thread_work_pending{role="scan"}' 0
+    wait_ready $PORT1 'thread_busy{role="scan"}' 0
+    wait_ready $PORT1 "scanned_files_total{source=\".${pkg##*.} archive\"}" 1
+
+    export DEBUGINFOD_URLS=http://127.0.0.1:$PORT1
+    filename=$(testrun ${abs_top_builddir}/debuginfod/debuginfod-find $type $BUILDID)
+    cmp expected $filename
+
+    # The scan and the extraction both read the package in-process.
+    wait_ready $PORT1 'archive_open_total{decoder="data.tar member"}' 2
+    if curl -s http://127.0.0.1:$PORT1/metrics | grep 'archive_open_total{decoder="pipe"}'; then
+        err
+    fi
+
+    kill $PID1
+    wait $PID1
+    PID1=0
+done
+
+rm -rf deb ddeb P expected
+exit 0
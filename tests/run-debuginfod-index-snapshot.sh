@@ -0,0 +1,130 @@
+#!/usr/bin/env bash
+#
+# This file is part of elfutils.
+#
+# This file is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# elfutils is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. $srcdir/debuginfod-subr.sh
+
+# for test case debugging, uncomment:
+set -x
+unset VALGRIND_CMD
+
+mkdir R
+cp -rvp ${abs_srcdir}/debuginfod-rpms R
+if [ "$zstd" = "false" ]; then  # nuke the zstd fedora 31 ones
+    rm -vrf R/debuginfod-rpms/fedora31
+fi
+rpms=$(find R -name \*rpm | wc -l)
+
+# This variable is essential and ensures no time-race for claiming ports occurs
+# set base to a unique multiple of 100 not used in any other 'run-debuginfod-*' test
+base=14200
+get_ports
+DB=${PWD}/.debuginfod_tmp.sqlite
+DB2=${PWD}/.debuginfod_tmp2.sqlite
+DB3=${PWD}/.debuginfod_tmp3.sqlite
+SNAPSHOT=${PWD}/snapshot.sqlite
+SNAPSHOT2=${PWD}/snapshot2.sqlite
+tempfiles $DB $DB2 $DB2.shard1 $DB2.shard2 $DB3 $SNAPSHOT $SNAPSHOT2
+export DEBUGINFOD_CACHE_PATH=${PWD}/.client_cache
+
+# Index R fully.
+env LD_LIBRARY_PATH=$ldpath ${abs_builddir}/../debuginfod/debuginfod $VERBOSE -R -p $PORT1 -d $DB -t0 -g0 -v R > vlog$PORT1 2>&1 &
+PID1=$!
+tempfiles vlog$PORT1
+errfiles vlog$PORT1
+wait_ready $PORT1 'ready' 1
+wait_ready $PORT1 'thread_work_total{role="traverse"}' 1
+wait_ready $PORT1 'thread_work_pending{role="scan"}' 0
+wait_ready $PORT1 'thread_busy{role="scan"}' 0
+wait_ready $PORT1 'scanned_files_total{source=".rpm archive"}' $rpms
+kill $PID1
+wait $PID1
+PID1=0
+
+# Snapshot it, relative to R.
+env LD_LIBRARY_PATH=$ldpath ${abs_builddir}/../debuginfod/debuginfod $VERBOSE -d $DB --export-index=$SNAPSHOT -R R
+test -s $SNAPSHOT
+
+# And relative to two directories with files of the same names.
+env LD_LIBRARY_PATH=$ldpath ${abs_builddir}/../debuginfod/debuginfod $VERBOSE -d $DB --export-index=$SNAPSHOT2 -R R/debuginfod-rpms/fedora30 R/debuginfod-rpms/rhel7
+test -s $SNAPSHOT2
+
+# A replica of R at another place, with the mtime of one file changed
+# after the export.
+cp -rp R R2
+touch -d '2001-01-01 00:00' R2/debuginfod-rpms/rhel7/hello2-debuginfo-1.0-2.x86_64.rpm
+
+# The importer has a different shard count than the exporter.
+env LD_LIBRARY_PATH=$ldpath ${abs_builddir}/../debuginfod/debuginfod $VERBOSE -R -p $PORT2 -d $DB2 --shards=3 -t0 -g0 -v --import-index=$SNAPSHOT R2 > vlog$PORT2 2>&1 &
+PID2=$!
+tempfiles vlog$PORT2
+errfiles vlog$PORT2
+wait_ready $PORT2 'ready' 1
+wait_ready $PORT2 'index_import_files_total{result="imported"}' $((rpms - 1))
+wait_ready $PORT2 'index_import_files_total{result="mismatched"}' 1
+wait_ready $PORT2 'thread_work_total{role="traverse"}' 1
+wait_ready $PORT2 'thread_work_pending{role="scan"}' 0
+wait_ready $PORT2 'thread_busy{role="scan"}' 0
+# Only the changed file was scanned again.
+wait_ready $PORT2 'scanned_files_total{source=".rpm archive"}' 1
+test -s $DB2.shard1
+test -s $DB2.shard2
+
+export DEBUGINFOD_URLS='http://127.0.0.1:'$PORT2
+
+# common source file sha1
+SHA=f4a1a8062be998ae93b8f1cd744a398c6de6dbb1
+# fedora30, imported
+archive_test c36708a78618d597dee15d0dc989f093ca5f9120 /usr/src/debug/hello2-1.0-2.x86_64/hello.c $SHA
+archive_test 41a236eb667c362a1c4196018cc4581e09722b1b /usr/src/debug/hello2-1.0-2.x86_64/hello.c $SHA
+# rhel7, the debuginfo rescanned
+archive_test bc1febfd03ca05e030f0d205f7659db29f8a4b30 /usr/src/debug/hello-1.0/hello.c $SHA
+archive_test f0aa15b8aba4f3c28cac3c2a73801fefa644a9f2 /usr/src/debug/hello-1.0/hello.c $SHA
+
+# The content comes from R2, not from R.
+rm -rf R
+rm -rf $DEBUGINFOD_CACHE_PATH
+archive_test c36708a78618d597dee15d0dc989f093ca5f9120 /usr/src/debug/hello2-1.0-2.x86_64/hello.c $SHA
+archive_test f0aa15b8aba4f3c28cac3c2a73801fefa644a9f2 /usr/src/debug/hello-1.0/hello.c $SHA
+
+kill $PID2
+wait $PID2
+PID2=0
+
+# Each file is matched under the directory at the same position, so the
+# rhel7 packages do not get the fedora30 entries of the same name.
+fedora30=$(find R2/debuginfod-rpms/fedora30 -name \*rpm | wc -l)
+rhel7=$(find R2/debuginfod-rpms/rhel7 -name \*rpm | wc -l)
+rm -rf $DEBUGINFOD_CACHE_PATH
+env LD_LIBRARY_PATH=$ldpath ${abs_builddir}/../debuginfod/debuginfod $VERBOSE -R -p $PORT1 -d $DB3 -t0 -g0 -v --import-index=$SNAPSHOT2 R2/debuginfod-rpms/fedora30 R2/debuginfod-rpms/rhel7 > vlog$PORT1 2>&1 &
+PID1=$!
+wait_ready $PORT1 'ready' 1
+wait_ready $PORT1 'index_import_files_total{result="imported"}' $((fedora30 + rhel7 - 1))
+wait_ready $PORT1 'index_import_files_total{result="mismatched"}' 1
+wait_ready $PORT1 'thread_work_total{role="traverse"}' 1
+wait_ready $PORT1 'thread_work_pending{role="scan"}' 0
+wait_ready $PORT1 'thread_busy{role="scan"}' 0
+wait_ready $PORT1 'scanned_files_total{source=".rpm archive"}' 1
+export DEBUGINFOD_URLS='http://127.0.0.1:'$PORT1
+archive_test c36708a78618d597dee15d0dc989f093ca5f9120 /usr/src/debug/hello2-1.0-2.x86_64/hello.c $SHA
+archive_test bc1febfd03ca05e030f0d205f7659db29f8a4b30 /usr/src/debug/hello-1.0/hello.c $SHA
+archive_test f0aa15b8aba4f3c28cac3c2a73801fefa644a9f2 /usr/src/debug/hello-1.0/hello.c $SHA
+kill $PID1
+wait $PID1
+PID1=0
+
+rm -rf R2
+exit 0
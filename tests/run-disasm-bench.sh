@@ -0,0 +1,48 @@
+#! /bin/sh
+# This file is part of elfutils.
+#
+# This file is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# elfutils is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. $srcdir/test-subr.sh
+
+# disasm-bench prints the number of instructions, which must be the
+# same for the formatting and the decode-only disassembler.  The
+# timings are dropped.
+
+testfiles testfile-riscv64-dis1.o
+tempfiles disasm-bench.out
+
+for mode in "" -d; do
+  testrun ${abs_builddir}/disasm-bench $mode testfile-riscv64-dis1.o 3 \
+    | sed -e 's/ in .*$//' > disasm-bench.out
+  testrun_compare cat disasm-bench.out <<\EOF
+1503 instructions, 4788 bytes
+EOF
+done
+
+# The same for x86-64, where both share the matching code.
+case "`uname -m`" in
+  x86_64)
+    tempfiles testfile45.o disasm-bench.decode
+    testfiles testfile45.S
+    ${CC} -m64 -c -o testfile45.o testfile45.S
+    testrun ${abs_builddir}/disasm-bench testfile45.o \
+      | sed -e 's/ in .*$//' > disasm-bench.out
+    testrun ${abs_builddir}/disasm-bench -d testfile45.o \
+      | sed -e 's/ in .*$//' > disasm-bench.decode
+    testrun_compare cat disasm-bench.out < disasm-bench.decode
+    ;;
+esac
+
+exit 0
@@ -0,0 +1,34 @@
+#! /bin/sh
+# This file is part of elfutils.
+#
+# This file is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# elfutils is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. $srcdir/test-subr.sh
+
+# disasm-decode checks that disasm_decode and disasm_cb agree on every
+# instruction and prints a summary of the decoded instruction classes.
+
+testfiles testfile-bpf-dis1.o testfile-riscv64-dis1.o
+
+testrun_compare ${abs_builddir}/disasm-decode testfile-bpf-dis1.o <<\EOF
+other 73 jump 1 cond 22 call 1 return 1 invalid 158
+targets 23 memory operands 20
+EOF
+
+testrun_compare ${abs_builddir}/disasm-decode testfile-riscv64-dis1.o <<\EOF
+other 439 jump 14 cond 24 call 24 return 0 invalid 0
+targets 57 memory operands 122
+EOF
+
+exit 0
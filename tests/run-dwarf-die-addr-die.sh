@@ -46,6 +46,17 @@ testrun ${abs_builddir}/dwarf-die-addr-die testfile-world4.dwo
 testrun ${abs_builddir}/dwarf-die-addr-die testfile-hello5.dwo
 testrun ${abs_builddir}/dwarf-die-addr-die testfile-world5.dwo
 
+# The same with compressed sections, which are only decompressed when
+# first used.  Check the type units before anything reads .debug_info.
+testrun ${abs_top_builddir}/src/elfcompress -q -t zlib testfile-debug-types
+testrun ${abs_builddir}/dwarf-die-addr-die --types-first testfile-debug-types
+
+testrun ${abs_top_builddir}/src/elfcompress -q -f -t zlib \
+  -n .debug_info -n .gnu_debugaltlink testfile_multi_main
+testrun ${abs_top_builddir}/src/elfcompress -q -t zlib testfile_multi.dwz
+testrun ${abs_builddir}/dwarf-die-addr-die --types-first testfile_multi_main \
+  | grep "checking alt debug"
+
 # Self test
 testrun_on_self ${abs_builddir}/dwarf-die-addr-die
 
@@ -0,0 +1,31 @@
+#! /bin/sh
+# This file is part of elfutils.
+#
+# This file is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# elfutils is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. $srcdir/test-subr.sh
+
+tmpdir="$(mktemp -d)"
+trap "rm -rf -- ${tmpdir}" EXIT
+
+# See run-sysroot.sh.
+tar xjf "${abs_srcdir}/testfile-sysroot.tar.bz2" -C "${tmpdir}"
+
+# All but the vDSO come from the NT_FILE note.
+testrun_compare ${abs_builddir}/dwfl-core-nt-file "${tmpdir}/core.bash" \
+	"${tmpdir}/sysroot" <<\EOF
+not in NT_FILE: linux-vdso.so.1
+EOF
+
+exit_cleanup
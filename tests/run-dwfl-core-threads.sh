@@ -0,0 +1,39 @@
+#! /bin/sh
+# This file is part of elfutils.
+#
+# This file is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# elfutils is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. $srcdir/test-subr.sh
+
+# See run-backtrace-core-x86_64.sh and run-backtrace-core-aarch64.sh.
+testfiles backtrace.x86_64.core backtrace.x86_64.exec
+testfiles backtrace.aarch64.core backtrace.aarch64.exec
+
+testrun_compare ${abs_builddir}/dwfl-core-threads backtrace.x86_64.core \
+	backtrace.x86_64.exec <<\EOF
+TID 23097: 0x40a62b
+TID 23096: 0x404880
+TID 23097: 7 frames
+TID 23096: 4 frames
+EOF
+
+testrun_compare ${abs_builddir}/dwfl-core-threads backtrace.aarch64.core \
+	backtrace.aarch64.exec <<\EOF
+TID 24044: 0x40c6d0
+TID 24043: 0x4048bc
+TID 24044: 7 frames
+TID 24043: 5 frames
+EOF
+
+exit 0
@@ -0,0 +1,41 @@
+#! /bin/sh
+# This file is part of elfutils.
+#
+# This file is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# elfutils is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. $srcdir/test-subr.sh
+
+# Without LZMA support there is no .gnu_debugdata to cache.
+grep -q "#define USE_LZMA 1" ${abs_top_builddir}/config.h || exit 77
+
+# See run-dwflsyms.sh for how these were made.
+testfiles testfilebazmin testfilebasmin
+
+mkdir cache
+for file in testfilebazmin testfilebasmin; do
+  tempfiles $file.out1 $file.out2
+
+  # Decompressed, and written to the cache.
+  testrun ${abs_builddir}/dwfl-debugdata-cache cache $file > $file.out1
+  ls cache/*.debugdata
+
+  # Read from the cache.
+  testrun ${abs_builddir}/dwfl-debugdata-cache cache $file > $file.out2
+  cmp $file.out1 $file.out2
+done
+
+test $(ls cache | wc -l) -eq 2
+rm -rf cache
+
+exit 0
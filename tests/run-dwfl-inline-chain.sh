@@ -0,0 +1,30 @@
+#! /bin/sh
+# This file is part of elfutils.
+#
+# This file is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# elfutils is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. $srcdir/test-subr.sh
+
+# See run-addr2line-i-test.sh, run-addr2line-i-lex-test.sh and
+# run-stack-d-test.sh for the sources.
+testfiles testfile-inlines testfile-lex-inlines testfiledwarfinlines
+
+for file in testfile-inlines testfile-lex-inlines testfiledwarfinlines; do
+  testrun ${abs_builddir}/dwfl-inline-chain -e $file
+done
+
+# And something built with optimization.
+testrun ${abs_builddir}/dwfl-inline-chain -e ${abs_builddir}/dwfl-inline-chain
+
+exit 0
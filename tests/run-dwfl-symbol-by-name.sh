@@ -0,0 +1,76 @@
+#! /bin/sh
+# This file is part of elfutils.
+#
+# This file is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# elfutils is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. $srcdir/test-subr.sh
+
+# Tests dwfl_module_symbol_by_name and dwfl_module_symbols_by_name.
+# See run-dwflsyms.sh for the testfilebaz* files.
+
+# .symtab
+testfiles testfilebaztab
+testrun_compare ${abs_builddir}/dwfl-symbol-by-name testfilebaztab \
+  main foo bar _init printf nonexistent <<\EOF
+main: 70 0x107f0 GLOBAL
+foo: 45 0x10814 LOCAL
+bar: 58 0x10828 GLOBAL
+_init: 75 0x10680 GLOBAL
+printf: not found
+nonexistent: not found
+EOF
+
+# .dynsym with .gnu.hash
+testfiles testfilebazdyn
+testrun_compare ${abs_builddir}/dwfl-symbol-by-name testfilebazdyn \
+  main foo _init nonexistent <<\EOF
+main: 12 0x107f0 GLOBAL
+foo: not found
+_init: not found
+nonexistent: not found
+EOF
+
+# .dynsym with .gnu.hash and .gnu_debugdata
+testfiles testfilebazmin
+testrun_compare ${abs_builddir}/dwfl-symbol-by-name testfilebazmin \
+  main foo bar _init printf nonexistent <<\EOF
+main: 47 0x107f0 GLOBAL
+foo: 8 0x10814 LOCAL
+bar: 49 0x10828 GLOBAL
+_init: 52 0x10680 GLOBAL
+printf: not found
+nonexistent: not found
+EOF
+
+# Only .gnu_debugdata
+testfiles testfilebasmin
+testrun_compare ${abs_builddir}/dwfl-symbol-by-name testfilebasmin \
+  main foo bar _start nonexistent <<\EOF
+main: 7 0x400144 GLOBAL
+foo: 1 0x400168 LOCAL
+bar: 8 0x40017a GLOBAL
+_start: 6 0x4001a8 GLOBAL
+nonexistent: not found
+EOF
+
+# .dynsym with .hash
+testfiles testfile13
+testrun_compare ${abs_builddir}/dwfl-symbol-by-name testfile13 \
+  _init _end main <<\EOF
+_init: 24 0x10878 GLOBAL
+_end: 31 0x100cb8 GLOBAL
+main: not found
+EOF
+
+exit 0
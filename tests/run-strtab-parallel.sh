@@ -0,0 +1,26 @@
+#! /bin/sh
+# This file is part of elfutils.
+#
+# This file is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# elfutils is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. $srcdir/test-subr.sh
+
+# strtab-bench -j checks that dwelf_strtab_finalize_parallel produces
+# the same table as dwelf_strtab_finalize and that every offset is
+# right.  The tables need enough strings to be finalized in parallel.
+
+testrun ${abs_builddir}/strtab-bench -j 4 100000
+testrun ${abs_builddir}/strtab-bench -s -j 3 100000
+
+exit 0
@@ -0,0 +1,285 @@
+/* Measure string table construction with C++ symbol names.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+/* Usage: strtab-bench [-s] [-j THREADS] [COUNT]
+
+   Generates COUNT (default 1000000) mangled C++ names the way a large
+   C++ program has them: nested names from a common set of namespaces
+   and classes, thunks and clones which share the tail of other names,
+   and repeated names.  They are added to a Dwelf_Strtab, which is then
+   finalized, and the time both steps take is printed.  With -s the
+   names are added in order of their reversed strings, which is the
+   worst case for a table kept as an unbalanced search tree.  With -j
+   the table is finalized with dwelf_strtab_finalize_parallel using
+   THREADS threads, zero meaning one per CPU, and the result is
+   compared with that of dwelf_strtab_finalize.  Every offset is
+   checked against the finalized table.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include ELFUTILS_HEADER(dwelf)
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+
+static const char *idents[] =
+  {
+    "std", "__cxx11", "detail", "impl", "llvm", "clang", "boost", "mozilla",
+    "vector", "basic_string", "allocator", "char_traits", "unique_ptr",
+    "shared_ptr", "map", "unordered_map", "function", "optional",
+    "Parser", "Lexer", "Sema", "Module", "Function", "BasicBlock",
+    "Instruction", "Value", "Type", "Context", "Builder", "Visitor",
+    "getName", "setName", "create", "destroy", "visit", "run", "reset",
+    "operator()", "begin", "end", "size", "push_back", "emplace_back",
+  };
+#define NIDENTS (sizeof idents / sizeof idents[0])
+
+static const char *params[] =
+  {
+    "v", "i", "j", "m", "b", "PKc", "RKS_", "RKS0_", "S1_", "PvS_",
+    "RKNSt7__cxx1112basic_stringIcSt11char_traitsIcESaIcEEE",
+    "St16initializer_listIiE", "OS_", "mm",
+  };
+#define NPARAMS (sizeof params / sizeof params[0])
+
+static const char *clones[] =
+  {
+    ".cold", ".constprop.0", ".isra.0", ".part.0",
+  };
+#define NCLONES (sizeof clones / sizeof clones[0])
+
+
+static unsigned long int seed = 1;
+
+static unsigned int
+rnd (unsigned int n)
+{
+  seed = seed * 6364136223846793005ul + 1442695040888963407ul;
+  return (seed >> 33) % n;
+}
+
+
+static char *
+mangle (void)
+{
+  char buf[512];
+  char *cp = buf;
+
+  cp = stpcpy (cp, rnd (8) == 0 ? "_ZNK" : "_ZN");
+  unsigned int depth = 1 + rnd (4);
+  for (unsigned int i = 0; i < depth; ++i)
+    {
+      const char *id = idents[rnd (NIDENTS)];
+      if (rnd (3) == 0)
+	{
+	  /* Make most of the inner names unique.  */
+	  char tmp[64];
+	  int n = snprintf (tmp, sizeof tmp, "%s%u", id, rnd (100000));
+	  cp += sprintf (cp, "%d%s", n, tmp);
+	}
+      else
+	cp += sprintf (cp, "%zu%s", strlen (id), id);
+    }
+  *cp++ = 'E';
+  unsigned int nparams = 1 + rnd (3);
+  for (unsigned int i = 0; i < nparams; ++i)
+    cp = stpcpy (cp, params[rnd (NPARAMS)]);
+  if (rnd (10) == 0)
+    cp = stpcpy (cp, clones[rnd (NCLONES)]);
+  *cp = '\0';
+
+  return strdup (buf);
+}
+
+
+static int
+revcmp (const void *p1, const void *p2)
+{
+  const char *s1 = *(const char **) p1;
+  const char *s2 = *(const char **) p2;
+  size_t l1 = strlen (s1);
+  size_t l2 = strlen (s2);
+  while (l1 > 0 && l2 > 0)
+    {
+      int c = (unsigned char) s1[--l1] - (unsigned char) s2[--l2];
+      if (c != 0)
+	return c;
+    }
+  return (l1 > 0) - (l2 > 0);
+}
+
+
+static double
+elapsed (struct timespec *start)
+{
+  struct timespec now;
+  clock_gettime (CLOCK_MONOTONIC, &now);
+  double res = ((now.tv_sec - start->tv_sec)
+		+ (now.tv_nsec - start->tv_nsec) / 1e9);
+  *start = now;
+  return res;
+}
+
+
+int
+main (int argc, char *argv[])
+{
+  bool sorted = argc > 1 && strcmp (argv[1], "-s") == 0;
+  if (sorted)
+    {
+      --argc;
+      ++argv;
+    }
+  bool parallel = argc > 2 && strcmp (argv[1], "-j") == 0;
+  unsigned int nthreads = 0;
+  if (parallel)
+    {
+      nthreads = atoi (argv[2]);
+      argc -= 2;
+      argv += 2;
+    }
+  if (argc > 2)
+    {
+      fprintf (stderr, "usage: %s [-s] [-j THREADS] [COUNT]\n", argv[0]);
+      return 1;
+    }
+  size_t count = argc == 2 ? strtoul (argv[1], NULL, 0) : 1000000;
+
+  char **names = malloc (count * sizeof (char *));
+  Dwelf_Strent **ents = malloc (count * sizeof (Dwelf_Strent *));
+  if (names == NULL || ents == NULL)
+    {
+      puts ("out of memory");
+      return 1;
+    }
+
+  size_t inbytes = 0;
+  for (size_t i = 0; i < count; ++i)
+    {
+      unsigned int kind = rnd (20);
+      if (kind == 0 && i > 0)
+	/* The same name again, e.g. from another symbol table.  */
+	names[i] = strdup (names[rnd (i)]);
+      else if (kind == 1 && i > 0)
+	{
+	  /* A virtual or covariant thunk for an earlier function.  */
+	  const char *target = names[rnd (i)];
+	  if (strncmp (target, "_Z", 2) == 0)
+	    target += 2;
+	  if (asprintf (&names[i], "_ZThn%u_%s", 8 * (1 + rnd (4)),
+			target) < 0)
+	    names[i] = NULL;
+	}
+      else
+	names[i] = mangle ();
+      if (names[i] == NULL)
+	{
+	  puts ("out of memory");
+	  return 1;
+	}
+      inbytes += strlen (names[i]) + 1;
+    }
+
+  if (sorted)
+    qsort (names, count, sizeof (char *), revcmp);
+
+  struct timespec start;
+  clock_gettime (CLOCK_MONOTONIC, &start);
+
+  Dwelf_Strtab *st = dwelf_strtab_init (true);
+  if (st == NULL)
+    {
+      puts ("cannot create string table");
+      return 1;
+    }
+  for (size_t i = 0; i < count; ++i)
+    if ((ents[i] = dwelf_strtab_add (st, names[i])) == NULL)
+      {
+	puts ("cannot add string");
+	return 1;
+      }
+  double addtime = elapsed (&start);
+
+  Elf_Data data;
+  if ((parallel
+       ? dwelf_strtab_finalize_parallel (st, &data, nthreads)
+       : dwelf_strtab_finalize (st, &data)) == NULL)
+    {
+      puts ("cannot finalize string table");
+      return 1;
+    }
+  double fintime = elapsed (&start);
+
+  int result = 0;
+  if (parallel)
+    {
+      /* The same table finalized by a single thread.  */
+      Dwelf_Strtab *st1 = dwelf_strtab_init (true);
+      if (st1 == NULL)
+	{
+	  puts ("cannot create string table");
+	  return 1;
+	}
+      for (size_t i = 0; i < count; ++i)
+	if (dwelf_strtab_add (st1, names[i]) == NULL)
+	  {
+	    puts ("cannot add string");
+	    return 1;
+	  }
+      Elf_Data data1;
+      if (dwelf_strtab_finalize (st1, &data1) == NULL)
+	{
+	  puts ("cannot finalize string table");
+	  return 1;
+	}
+      if (data1.d_size != data.d_size
+	  || memcmp (data1.d_buf, data.d_buf, data.d_size) != 0)
+	{
+	  puts ("parallel and serial tables differ");
+	  result = 1;
+	}
+      free (data1.d_buf);
+      dwelf_strtab_free (st1);
+    }
+
+  for (size_t i = 0; i < count; ++i)
+    {
+      size_t off = dwelf_strent_off (ents[i]);
+      if (off >= data.d_size
+	  || strcmp ((char *) data.d_buf + off, names[i]) != 0)
+	{
+	  printf ("wrong offset %zu for \"%s\"\n", off, names[i]);
+	  result = 1;
+	  break;
+	}
+    }
+
+  printf ("%zu names, %zu bytes -> %zu bytes\n", count, inbytes, data.d_size);
+  printf ("add: %.3f s, finalize: %.3f s\n", addtime, fintime);
+
+  free (data.d_buf);
+  dwelf_strtab_free (st);
+  for (size_t i = 0; i < count; ++i)
+    free (names[i]);
+  free (names);
+  free (ents);
+
+  return result;
+}